@@ -0,0 +1,271 @@
+// Finding overlapping pairs among 10k-50k moving physics bodies, three ways:
+// the incremental sweep-and-prune of broadphase.h, a full sort-and-sweep on
+// one axis every step, and once per size, the all-pairs AABB test that
+// platformer.cpp's checkCollision implies. Bodies carry game01.cpp's
+// collider shapes (sphere, box, capsule) and bounce around a closed box;
+// each step some respawn elsewhere, exercising adds
+// and removes. The incremental pairs must match the full sweep's, or the
+// run fails.
+//
+//   bench_broadphase [--bodies N] [--steps N] [--respawn per-step] [--speed m/s]
+//
+// Without --bodies it runs 10000, 25000 and 50000. --speed is the fastest a
+// body moves along each axis (default 4); the incremental sort's work grows
+// with it, the full sweep's doesn't.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "broadphase.h"
+#include "rng.h"
+#include "timing.h"
+
+enum ColliderType {
+    COLLIDER_SPHERE,
+    COLLIDER_BOX,
+    COLLIDER_CAPSULE,
+};
+
+struct Body {
+    float position[3];
+    float velocity[3];
+    ColliderType type;
+    float size[3]; // sphere: radius; box: half extents; capsule: radius, height along y
+};
+
+struct Box {
+    float min[3];
+    float max[3];
+};
+
+const float DELTA_TIME = 1.0f / 60.0f;
+// World volume per body: about one neighbour each at these collider sizes
+const float VOLUME_PER_BODY = 40.0f;
+// Steps between comparisons of the two pair lists
+const int CHECK_EVERY = 10;
+
+static Box bodyBox(const Body& body) {
+    float half[3];
+    switch (body.type) {
+    case COLLIDER_SPHERE:
+        half[0] = half[1] = half[2] = body.size[0];
+        break;
+    case COLLIDER_BOX:
+        half[0] = body.size[0];
+        half[1] = body.size[1];
+        half[2] = body.size[2];
+        break;
+    case COLLIDER_CAPSULE:
+        half[0] = half[2] = body.size[0];
+        half[1] = body.size[0] + body.size[1] * 0.5f;
+        break;
+    }
+    Box box;
+    for (int axis = 0; axis < 3; axis++) {
+        box.min[axis] = body.position[axis] - half[axis];
+        box.max[axis] = body.position[axis] + half[axis];
+    }
+    return box;
+}
+
+static void placeBody(Body& body, Rng& rng, float extent, float speed) {
+    for (int axis = 0; axis < 3; axis++) {
+        body.position[axis] = rngFloat(rng) * extent;
+        body.velocity[axis] = (rngFloat(rng) * 2.0f - 1.0f) * speed;
+    }
+}
+
+static Body makeBody(Rng& rng, float extent, float speed) {
+    Body body;
+    placeBody(body, rng, extent, speed);
+    body.type = (ColliderType)rngRange(rng, 3);
+    body.size[0] = 0.3f + rngFloat(rng) * 0.9f;
+    body.size[1] = 0.3f + rngFloat(rng) * 0.9f;
+    body.size[2] = 0.3f + rngFloat(rng) * 0.9f;
+    return body;
+}
+
+static void moveBodies(std::vector<Body>& bodies, float extent) {
+    for (Body& body : bodies) {
+        for (int axis = 0; axis < 3; axis++) {
+            body.position[axis] += body.velocity[axis] * DELTA_TIME;
+            if (body.position[axis] < 0.0f || body.position[axis] > extent) {
+                body.velocity[axis] = -body.velocity[axis];
+                body.position[axis] = std::min(std::max(body.position[axis], 0.0f), extent);
+            }
+        }
+    }
+}
+
+static bool boxesOverlap(const Box& a, const Box& b) {
+    return a.min[0] <= b.max[0] && b.min[0] <= a.max[0] && a.min[1] <= b.max[1] && b.min[1] <= a.max[1] &&
+           a.min[2] <= b.max[2] && b.min[2] <= a.max[2];
+}
+
+static uint64_t pairKey(uint32_t a, uint32_t b) {
+    return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+// Sorts by min x afresh and sweeps; `order` and `pairs` are reused
+static void sweepPairs(const std::vector<Box>& boxes, std::vector<uint32_t>& order, std::vector<uint64_t>& pairs) {
+    order.resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++) {
+        order[i] = (uint32_t)i;
+    }
+    std::sort(order.begin(), order.end(),
+              [&boxes](uint32_t a, uint32_t b) { return boxes[a].min[0] < boxes[b].min[0]; });
+    pairs.clear();
+    for (size_t i = 0; i < order.size(); i++) {
+        const Box& box = boxes[order[i]];
+        for (size_t j = i + 1; j < order.size() && boxes[order[j]].min[0] <= box.max[0]; j++) {
+            if (boxesOverlap(box, boxes[order[j]])) pairs.push_back(pairKey(order[i], order[j]));
+        }
+    }
+}
+
+static size_t bruteForcePairs(const std::vector<Box>& boxes) {
+    size_t pairs = 0;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        for (size_t j = i + 1; j < boxes.size(); j++) {
+            pairs += boxesOverlap(boxes[i], boxes[j]);
+        }
+    }
+    return pairs;
+}
+
+struct Result {
+    size_t bodies = 0;
+    double pairs = 0.0; // mean per step
+    double incremental = 0.0;
+    double incrementalBest = 1e30;
+    double swaps = 0.0;
+    double changes = 0.0; // pairs added plus removed
+    double sweep = 0.0;
+    double sweepBest = 1e30;
+    double bruteForce = 0.0;
+    bool matched = true;
+};
+
+static Result run(size_t count, int steps, int respawn, float speed) {
+    Result result;
+    result.bodies = count;
+    float extent = cbrtf(VOLUME_PER_BODY * (float)count);
+    Rng rng;
+    rngSeed(rng, 25, count);
+
+    std::vector<Body> bodies(count);
+    std::vector<Box> boxes(count);
+    std::vector<uint32_t> ids(count);     // body -> broadphase id
+    std::vector<uint32_t> owners(count);  // broadphase id -> body
+    Broadphase broadphase;
+    for (size_t i = 0; i < count; i++) {
+        bodies[i] = makeBody(rng, extent, speed);
+        boxes[i] = bodyBox(bodies[i]);
+        ids[i] = broadphaseAdd(broadphase, boxes[i].min, boxes[i].max);
+        owners[ids[i]] = (uint32_t)i;
+    }
+    broadphaseUpdate(broadphase);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t bruteForce = bruteForcePairs(boxes);
+    result.bruteForce = seconds(start);
+    result.matched = bruteForce == broadphase.pairs.size();
+
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> swept, found;
+    for (int step = 0; step < steps; step++) {
+        moveBodies(bodies, extent);
+        for (size_t i = 0; i < count; i++) {
+            boxes[i] = bodyBox(bodies[i]);
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < respawn; r++) {
+            uint32_t body = (uint32_t)rngRange(rng, (int)count);
+            if (ids[body] == BROADPHASE_NONE) continue;
+            placeBody(bodies[body], rng, extent, speed);
+            boxes[body] = bodyBox(bodies[body]);
+            broadphaseRemove(broadphase, ids[body]);
+            ids[body] = BROADPHASE_NONE;
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (ids[i] != BROADPHASE_NONE) {
+                broadphaseMove(broadphase, ids[i], boxes[i].min, boxes[i].max);
+            } else {
+                ids[i] = broadphaseAdd(broadphase, boxes[i].min, boxes[i].max);
+                if (ids[i] >= owners.size()) owners.resize(ids[i] + 1);
+                owners[ids[i]] = (uint32_t)i;
+            }
+        }
+        broadphaseUpdate(broadphase);
+        double elapsed = seconds(start);
+        result.incremental += elapsed;
+        result.incrementalBest = std::min(result.incrementalBest, elapsed);
+        result.swaps += broadphase.stats.swaps;
+        result.changes += broadphase.stats.pairsAdded + broadphase.stats.pairsRemoved;
+        result.pairs += broadphase.pairs.size();
+
+        start = std::chrono::steady_clock::now();
+        sweepPairs(boxes, order, swept);
+        elapsed = seconds(start);
+        result.sweep += elapsed;
+        result.sweepBest = std::min(result.sweepBest, elapsed);
+
+        if (step % CHECK_EVERY == 0 || step == steps - 1) {
+            found.clear();
+            for (const BroadphasePair& pair : broadphase.pairs) {
+                found.push_back(pairKey(owners[pair.a], owners[pair.b]));
+            }
+            std::sort(found.begin(), found.end());
+            std::sort(swept.begin(), swept.end());
+            result.matched = result.matched && found == swept;
+        }
+    }
+    result.incremental /= steps;
+    result.sweep /= steps;
+    result.swaps /= steps;
+    result.changes /= steps;
+    result.pairs /= steps;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> counts = {10000, 25000, 50000};
+    int steps = 120;
+    int respawn = 20;
+    float speed = 4.0f;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bodies") == 0 && i + 1 < argc) {
+            counts.assign(1, (size_t)atol(argv[++i]));
+        } else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            steps = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--respawn") == 0 && i + 1 < argc) {
+            respawn = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = (float)atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--bodies N] [--steps N] [--respawn per-step] [--speed m/s]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    printf("%d steps, %d respawns a step, up to %.1f m/s, ms per step\n", steps, respawn, speed);
+    printf("  %7s %8s %10s %10s %9s %9s %10s %10s %8s %12s\n", "bodies", "pairs", "sap mean", "sap best", "swaps",
+           "changes", "sweep mean", "sweep best", "speedup", "all pairs");
+    bool ok = true;
+    for (size_t count : counts) {
+        Result result = run(count, steps, respawn, speed);
+        printf("  %7zu %8.0f %10.3f %10.3f %9.0f %9.0f %10.3f %10.3f %7.2fx %12.1f\n", result.bodies, result.pairs,
+               result.incremental * 1000.0, result.incrementalBest * 1000.0, result.swaps, result.changes,
+               result.sweep * 1000.0, result.sweepBest * 1000.0, result.sweep / result.incremental,
+               result.bruteForce * 1000.0);
+        ok = ok && result.matched;
+    }
+    printf("%s\n", ok ? "pairs match" : "PAIRS DIFFER");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+// Frustum culling of a scene's draws through a bounding volume hierarchy
+// (scene_bvh.h) against testing every draw's box: build, refit and
+// per-frame cull times for cameras walking through a field of props and one
+// looking down on all of it. Every frame's visible set is compared with
+// glm_aabb_frustum over all draws, so a tree that drops or adds a draw fails
+// the run.
+//
+//   bench_bvh [--nodes N] [--cameras N] [file.glb ...]
+//
+// A generated field of `nodes` props is always run; each file is also
+// replicated until it has about `nodes` draws.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <cglm/box.h>
+#include <cglm/cam.h>
+#include <cglm/frustum.h>
+#include <cglm/mat4.h>
+
+#include "rng.h"
+#include "scene_bvh.h"
+#include "scene_loader.h"
+#include "timing.h"
+
+// Props of a few shapes and sizes, from crates to towers, scattered over a
+// square at about one per 40 square units, each turned and scaled at random
+static void buildField(Scene& scene, int nodes, Rng& rng) {
+    const float shapes[][3] = {{0.5f, 0.5f, 0.5f}, {1.0f, 2.0f, 1.0f}, {4.0f, 3.0f, 6.0f}, {0.3f, 6.0f, 0.3f},
+                               {8.0f, 20.0f, 8.0f}, {2.0f, 1.0f, 4.0f}, {12.0f, 0.5f, 12.0f}, {1.5f, 1.5f, 1.5f}};
+    scene = Scene();
+    for (const float* shape : shapes) {
+        SceneMesh mesh = {};
+        for (int k = 0; k < 3; k++) {
+            mesh.boundsMin[k] = k == 1 ? 0.0f : -shape[k] * 0.5f;
+            mesh.boundsMax[k] = k == 1 ? shape[k] : shape[k] * 0.5f;
+        }
+        scene.meshes.push_back(mesh);
+    }
+
+    float side = sqrtf(nodes * 40.0f);
+    scene.draws.resize(nodes);
+    for (int i = 0; i < nodes; i++) {
+        SceneDraw& draw = scene.draws[i];
+        draw.mesh = (uint32_t)rngRange(rng, (int)scene.meshes.size());
+        draw.node = (uint32_t)i;
+        float angle = rngFloat(rng) * 2.0f * (float)M_PI;
+        float scale = 0.5f + rngFloat(rng) * 1.5f;
+        float world[16] = {cosf(angle) * scale, 0, -sinf(angle) * scale, 0, 0, scale, 0, 0,
+                           sinf(angle) * scale, 0, cosf(angle) * scale, 0,
+                           (rngFloat(rng) - 0.5f) * side, 0, (rngFloat(rng) - 0.5f) * side, 1};
+        memcpy(draw.world, world, sizeof(world));
+    }
+    SceneView view = sceneView(scene);
+    for (size_t d = 0; d < view.drawCount; d++) {
+        float boundsMin[3], boundsMax[3];
+        sceneDrawBounds(view, d, boundsMin, boundsMax);
+        for (int k = 0; k < 3; k++) {
+            scene.boundsMin[k] = d ? std::min(scene.boundsMin[k], boundsMin[k]) : boundsMin[k];
+            scene.boundsMax[k] = d ? std::max(scene.boundsMax[k], boundsMax[k]) : boundsMax[k];
+        }
+    }
+}
+
+static void viewProjection(const float eye[3], const float target[3], float far, float out[16]) {
+    mat4 projection, view, clip;
+    vec3 from = {eye[0], eye[1], eye[2]};
+    vec3 to = {target[0], target[1], target[2]};
+    vec3 up = {0.0f, 1.0f, 0.0f};
+    glm_perspective(glm_rad(60.0f), 16.0f / 9.0f, 0.1f, far, projection);
+    glm_lookat(from, to, up, view);
+    glm_mat4_mul(projection, view, clip);
+    memcpy(out, clip, sizeof(clip));
+}
+
+// Cameras standing in the field at head height looking along it, and one
+// high above looking down at the whole of it
+static void makeCameras(const SceneView& view, int count, Rng& rng, std::vector<std::array<float, 16>>& walk,
+                        std::array<float, 16>& overview) {
+    float center[3], extent = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        center[k] = (view.boundsMin[k] + view.boundsMax[k]) * 0.5f;
+        extent = std::max(extent, view.boundsMax[k] - view.boundsMin[k]);
+    }
+    walk.resize(count);
+    for (int c = 0; c < count; c++) {
+        float eye[3] = {view.boundsMin[0] + rngFloat(rng) * (view.boundsMax[0] - view.boundsMin[0]),
+                        view.boundsMin[1] + 2.0f,
+                        view.boundsMin[2] + rngFloat(rng) * (view.boundsMax[2] - view.boundsMin[2])};
+        float angle = rngFloat(rng) * 2.0f * (float)M_PI;
+        float target[3] = {eye[0] + cosf(angle), eye[1] - 0.05f, eye[2] + sinf(angle)};
+        viewProjection(eye, target, extent * 0.5f, walk[c].data());
+    }
+    float eye[3] = {center[0], center[1] + extent * 1.2f, center[2] + extent * 0.01f};
+    viewProjection(eye, center, extent * 4.0f, overview.data());
+}
+
+// Reference: every draw's box through glm_aabb_frustum, in draw order
+static void cullLinear(const std::vector<float>& boxes, const float clip[16], std::vector<uint32_t>& visible) {
+    mat4 m;
+    memcpy(m, clip, sizeof(m));
+    vec4 planes[6];
+    glm_frustum_planes(m, planes);
+    visible.clear();
+    for (size_t d = 0; d < boxes.size() / 6; d++) {
+        if (glm_aabb_frustum((vec3*)&boxes[d * 6], planes)) visible.push_back((uint32_t)d);
+    }
+}
+
+static void drawBoxes(const SceneView& view, std::vector<float>& boxes) {
+    boxes.resize(view.drawCount * 6);
+    for (size_t d = 0; d < view.drawCount; d++) {
+        sceneDrawBounds(view, d, &boxes[d * 6], &boxes[d * 6 + 3]);
+    }
+}
+
+// Times both paths over the cameras, and checks the tree's visible set
+// against the reference. Each frame is culled a few times; the worst camera
+// is the slowest one's best time, so a stray context switch doesn't count.
+static bool benchCameras(const char* label, const SceneView& view, const SceneBvh& bvh,
+                         const std::vector<float>& boxes, const std::vector<std::array<float, 16>>& cameras) {
+    const int repeats = 8;
+    std::vector<uint32_t> visible, reference;
+    BvhCullStats stats, total;
+    double bvhTime = 0.0, worst = 0.0, linearTime = 0.0;
+    bool match = true;
+    for (const std::array<float, 16>& clip : cameras) {
+        double best = 1e9;
+        for (int r = 0; r < repeats; r++) {
+            auto start = std::chrono::steady_clock::now();
+            sceneBvhCull(bvh, clip.data(), visible, stats);
+            double elapsed = seconds(start);
+            bvhTime += elapsed;
+            best = std::min(best, elapsed);
+        }
+        worst = std::max(worst, best);
+        auto start = std::chrono::steady_clock::now();
+        cullLinear(boxes, clip.data(), reference);
+        linearTime += seconds(start);
+
+        total.nodesVisited += stats.nodesVisited;
+        total.nodesAccepted += stats.nodesAccepted;
+        total.leavesTested += stats.leavesTested;
+        total.boxesTested += stats.boxesTested;
+        total.visible += stats.visible;
+        std::sort(visible.begin(), visible.end());
+        match = match && visible == reference;
+    }
+    double frames = (double)cameras.size();
+    double bvhFrame = bvhTime / (frames * repeats);
+    double linearFrame = linearTime / frames;
+    printf("  %-10s %8.1f%% %9.0f %8.0f %9.0f %9.0f %8.3f %8.3f %9.3f %7.1fx  %s\n", label,
+           100.0 * total.visible / frames / view.drawCount, total.nodesVisited / frames,
+           total.nodesAccepted / frames, total.leavesTested / frames, total.boxesTested / frames,
+           bvhFrame * 1000.0, worst * 1000.0, linearFrame * 1000.0, linearFrame / bvhFrame,
+           match ? "same draws" : "DRAWS DIFFER");
+    return match;
+}
+
+static bool benchScene(const char* name, Scene& scene, int cameraCount, Rng& rng) {
+    SceneView view = sceneView(scene);
+    SceneBvh bvh;
+    auto start = std::chrono::steady_clock::now();
+    sceneBvhBuild(bvh, view);
+    double buildTime = seconds(start);
+    printf("%s: %zu draws, SAH build %.2f ms, %zu nodes (%zu leaves of up to %d), cost %.1f\n", name,
+           view.drawCount, buildTime * 1000.0, bvh.nodes.size(), bvh.leafBoxes.size() / (6 * BVH_LEAF_SIZE),
+           BVH_LEAF_SIZE, bvh.builtCost);
+
+    std::vector<std::array<float, 16>> walk;
+    std::array<float, 16> overview;
+    makeCameras(view, cameraCount, rng, walk, overview);
+    std::vector<float> boxes;
+    drawBoxes(view, boxes);
+    printf("  %-10s %9s %9s %8s %9s %9s %8s %8s %9s %8s\n", "cameras", "visible", "nodes", "inside", "leaves",
+           "boxes", "bvh ms", "worst", "linear ms", "speedup");
+    bool ok = benchCameras("walk", view, bvh, boxes, walk);
+    ok = benchCameras("overview", view, bvh, boxes, {overview}) && ok;
+
+    // A tenth of the draws wander a little every frame: refitting keeps up
+    // without a rebuild. Then everything moves somewhere else at once, which
+    // should trip the rebuild.
+    std::vector<uint32_t> moving;
+    for (size_t d = 0; d < scene.draws.size(); d += 10) moving.push_back((uint32_t)d);
+    const int frames = 16;
+    double refitTime = 0.0;
+    size_t rebuilds = 0;
+    for (int f = 0; f < frames; f++) {
+        for (uint32_t d : moving) {
+            scene.draws[d].world[12] += (rngFloat(rng) - 0.5f) * 2.0f;
+            scene.draws[d].world[14] += (rngFloat(rng) - 0.5f) * 2.0f;
+        }
+        start = std::chrono::steady_clock::now();
+        rebuilds += sceneBvhRefitDraws(bvh, view, moving.data(), moving.size());
+        refitTime += seconds(start);
+    }
+    drawBoxes(view, boxes);
+    ok = benchCameras("refitted", view, bvh, boxes, walk) && ok;
+    printf("  refit %.3f ms/frame with %zu draws moving, cost %.1f (%.2fx built), %zu rebuilds\n",
+           refitTime / frames * 1000.0, moving.size(), sceneBvhCost(bvh), sceneBvhCost(bvh) / bvh.builtCost,
+           rebuilds);
+
+    std::vector<SceneDraw> shuffled = scene.draws;
+    for (size_t d = 0; d < shuffled.size(); d++) {
+        size_t other = (size_t)rngRange(rng, (int)shuffled.size());
+        std::swap(shuffled[d].world[12], shuffled[other].world[12]);
+        std::swap(shuffled[d].world[14], shuffled[other].world[14]);
+    }
+    scene.draws = shuffled;
+    view = sceneView(scene);
+    start = std::chrono::steady_clock::now();
+    bool rebuilt = sceneBvhRefit(bvh, view);
+    double scatterTime = seconds(start);
+    drawBoxes(view, boxes);
+    ok = benchCameras("scattered", view, bvh, boxes, walk) && ok;
+    printf("  every draw moved: refit %s in %.2f ms, cost %.1f\n", rebuilt ? "rebuilt the tree" : "kept the tree",
+           scatterTime * 1000.0, sceneBvhCost(bvh));
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int nodes = 100000;
+    int cameras = 64;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            nodes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cameras") == 0 && i + 1 < argc) {
+            cameras = atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [--nodes N] [--cameras N] [file.glb ...]\n", argv[0]);
+            return -1;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    bool ok = true;
+    Rng rng;
+    Scene scene;
+    buildField(scene, nodes, rng);
+    ok = benchScene("prop field", scene, cameras, rng) && ok;
+    for (const char* path : files) {
+        if (!sceneLoadGltf(scene, path) || scene.draws.empty()) {
+            fprintf(stderr, "Can't load %s\n", path);
+            ok = false;
+            continue;
+        }
+        sceneReplicate(scene, std::max(1, nodes / (int)scene.draws.size()));
+        ok = benchScene(path, scene, cameras, rng) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,328 @@
+// Component iteration at a million entities (entity_world.h): the flat layout
+// game01.cpp sketches, an Entity { id, component_mask } array beside one
+// array per component type indexed by entity, against archetype chunks.
+// Three systems that each touch two or three components run over both, and
+// a few entities gain or lose a rigid body every frame. Both layouts must end
+// with the same component values, or the run fails.
+//
+//   bench_ecs [--entities N] [--frames N] [--churn permille]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "entity_world.h"
+#include "rng.h"
+#include "timing.h"
+
+// Components as game01.cpp lays them out
+struct Transform {
+    float position[3];
+    float rotation[4];
+    float scale[3];
+    float world[16];
+    int32_t parent;
+    int32_t child;
+    int32_t nextSibling;
+    int32_t prevSibling;
+};
+
+struct ModelComponent {
+    uint32_t mesh;
+    uint32_t material;
+    int32_t transform;
+    int32_t drawOrder;
+};
+
+struct Light {
+    uint32_t type;
+    float color[3];
+    float intensity;
+    float range;
+    float innerCone;
+    float outerCone;
+    int32_t transform;
+};
+
+struct RigidBody {
+    float linearVelocity[3];
+    float angularVelocity[3];
+    float mass;
+    float restitution;
+    float friction;
+    int32_t collider;
+};
+
+enum {
+    TRANSFORM,
+    MODEL,
+    LIGHT,
+    RIGID_BODY,
+};
+
+const ComponentMask HAS_TRANSFORM = 1u << TRANSFORM;
+const ComponentMask HAS_MODEL = 1u << MODEL;
+const ComponentMask HAS_LIGHT = 1u << LIGHT;
+const ComponentMask HAS_RIGID_BODY = 1u << RIGID_BODY;
+
+const float DELTA_TIME = 1.0f / 60.0f;
+
+struct Entity {
+    int id;
+    unsigned int component_mask;
+};
+
+struct FlatScene {
+    std::vector<Entity> entities;
+    std::vector<Transform> transforms;
+    std::vector<ModelComponent> models;
+    std::vector<Light> lights;
+    std::vector<RigidBody> bodies;
+};
+
+// What the light and model systems gather, compared across layouts
+struct FrameSums {
+    double light = 0.0;
+    double model = 0.0;
+};
+
+static void integrate(Transform& transform, RigidBody& body) {
+    body.linearVelocity[1] -= 9.8f * DELTA_TIME;
+    for (int k = 0; k < 3; k++) {
+        transform.position[k] += body.linearVelocity[k] * DELTA_TIME;
+        transform.world[12 + k] = transform.position[k];
+    }
+}
+
+static double lightContribution(const Transform& transform, const Light& light) {
+    float distance = fabsf(transform.position[0]) + fabsf(transform.position[2]);
+    return light.intensity * (light.color[0] + light.color[1] + light.color[2]) / (1.0f + distance);
+}
+
+static double modelKey(const Transform& transform, const ModelComponent& model) {
+    return transform.world[14] * 0.001 + model.drawOrder;
+}
+
+static void runFlat(FlatScene& scene, FrameSums& sums, double times[3]) {
+    size_t count = scene.entities.size();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        unsigned int mask = scene.entities[i].component_mask;
+        if ((mask & (HAS_TRANSFORM | HAS_RIGID_BODY)) != (HAS_TRANSFORM | HAS_RIGID_BODY)) continue;
+        integrate(scene.transforms[i], scene.bodies[i]);
+    }
+    times[0] += seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        unsigned int mask = scene.entities[i].component_mask;
+        if ((mask & (HAS_TRANSFORM | HAS_LIGHT)) != (HAS_TRANSFORM | HAS_LIGHT)) continue;
+        sums.light += lightContribution(scene.transforms[i], scene.lights[i]);
+    }
+    times[1] += seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        unsigned int mask = scene.entities[i].component_mask;
+        if ((mask & (HAS_TRANSFORM | HAS_MODEL)) != (HAS_TRANSFORM | HAS_MODEL)) continue;
+        sums.model += modelKey(scene.transforms[i], scene.models[i]);
+    }
+    times[2] += seconds(start);
+}
+
+static void runChunks(EntityWorld& world, FrameSums& sums, double times[3]) {
+    auto start = std::chrono::steady_clock::now();
+    entityEachChunk(world, HAS_TRANSFORM | HAS_RIGID_BODY, 0, [](const Archetype& archetype, EntityChunk& chunk) {
+        Transform* transforms = entityColumn<Transform>(archetype, chunk, TRANSFORM);
+        RigidBody* bodies = entityColumn<RigidBody>(archetype, chunk, RIGID_BODY);
+        for (uint32_t i = 0; i < chunk.count; i++) {
+            integrate(transforms[i], bodies[i]);
+        }
+    });
+    times[0] += seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    entityEachChunk(world, HAS_TRANSFORM | HAS_LIGHT, 0, [&](const Archetype& archetype, EntityChunk& chunk) {
+        const Transform* transforms = entityColumn<Transform>(archetype, chunk, TRANSFORM);
+        const Light* lights = entityColumn<Light>(archetype, chunk, LIGHT);
+        for (uint32_t i = 0; i < chunk.count; i++) {
+            sums.light += lightContribution(transforms[i], lights[i]);
+        }
+    });
+    times[1] += seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    entityEachChunk(world, HAS_TRANSFORM | HAS_MODEL, 0, [&](const Archetype& archetype, EntityChunk& chunk) {
+        const Transform* transforms = entityColumn<Transform>(archetype, chunk, TRANSFORM);
+        const ModelComponent* models = entityColumn<ModelComponent>(archetype, chunk, MODEL);
+        for (uint32_t i = 0; i < chunk.count; i++) {
+            sums.model += modelKey(transforms[i], models[i]);
+        }
+    });
+    times[2] += seconds(start);
+}
+
+static float randomFloat(Rng& rng) {
+    return (rngNext(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Every component in both layouts must match, entity by entity. `handles`
+// maps the flat layout's ids to the world's.
+static bool compareLayouts(const FlatScene& scene, EntityWorld& world, const std::vector<EntityId>& handles) {
+    for (size_t i = 0; i < scene.entities.size(); i++) {
+        EntityId entity = handles[i];
+        unsigned int mask = scene.entities[i].component_mask;
+        if (entityMask(world, entity) != mask) return false;
+        const void* components[] = {&scene.transforms[i], &scene.models[i], &scene.lights[i], &scene.bodies[i]};
+        const size_t sizes[] = {sizeof(Transform), sizeof(ModelComponent), sizeof(Light), sizeof(RigidBody)};
+        for (uint32_t c = 0; c < 4; c++) {
+            if (!(mask & (1u << c))) continue;
+            if (memcmp(entityGet(world, entity, c), components[c], sizes[c]) != 0) return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    size_t entityCount = 1000000;
+    int frames = 32;
+    int churnPermille = 5;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--entities") == 0 && i + 1 < argc) {
+            entityCount = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--churn") == 0 && i + 1 < argc) {
+            churnPermille = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--entities N] [--frames N] [--churn permille]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    // Every entity has a transform; 70% draw a model, 25% are rigid bodies
+    // and 1% are lights
+    FlatScene scene;
+    scene.entities.resize(entityCount);
+    scene.transforms.assign(entityCount, Transform());
+    scene.models.assign(entityCount, ModelComponent());
+    scene.lights.assign(entityCount, Light());
+    scene.bodies.assign(entityCount, RigidBody());
+    Rng rng;
+    rngSeed(rng, 21, 0);
+    for (size_t i = 0; i < entityCount; i++) {
+        unsigned int mask = HAS_TRANSFORM;
+        uint32_t roll = rngNext(rng) % 100;
+        if (roll < 70) mask |= HAS_MODEL;
+        if (roll >= 50 && roll < 75) mask |= HAS_RIGID_BODY;
+        if (rngNext(rng) % 100 == 0) mask |= HAS_LIGHT;
+        scene.entities[i] = {(int)i, mask};
+
+        Transform& transform = scene.transforms[i];
+        for (int k = 0; k < 3; k++) {
+            transform.position[k] = randomFloat(rng) * 1000.0f - 500.0f;
+            transform.scale[k] = 1.0f;
+            transform.world[k * 5] = 1.0f;
+            transform.world[12 + k] = transform.position[k];
+        }
+        transform.rotation[3] = 1.0f;
+        transform.world[15] = 1.0f;
+        transform.parent = transform.child = transform.nextSibling = transform.prevSibling = -1;
+        if (mask & HAS_MODEL) scene.models[i] = {rngNext(rng) % 64, rngNext(rng) % 16, (int32_t)i, (int32_t)(i % 8)};
+        if (mask & HAS_LIGHT) {
+            scene.lights[i] = {1, {randomFloat(rng), randomFloat(rng), randomFloat(rng)}, 10.0f, 50.0f, 0.3f, 0.5f,
+                               (int32_t)i};
+        }
+        if (mask & HAS_RIGID_BODY) {
+            RigidBody& body = scene.bodies[i];
+            for (int k = 0; k < 3; k++) {
+                body.linearVelocity[k] = randomFloat(rng) * 10.0f - 5.0f;
+            }
+            body.mass = 1.0f;
+            body.restitution = 0.5f;
+            body.friction = 0.8f;
+            body.collider = -1;
+        }
+    }
+
+    EntityWorld world;
+    entityRegisterComponent(world, sizeof(Transform), alignof(Transform));
+    entityRegisterComponent(world, sizeof(ModelComponent), alignof(ModelComponent));
+    entityRegisterComponent(world, sizeof(Light), alignof(Light));
+    entityRegisterComponent(world, sizeof(RigidBody), alignof(RigidBody));
+    std::vector<EntityId> handles(entityCount);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < entityCount; i++) {
+        unsigned int mask = scene.entities[i].component_mask;
+        EntityId entity = entityCreate(world, mask);
+        handles[i] = entity;
+        const void* components[] = {&scene.transforms[i], &scene.models[i], &scene.lights[i], &scene.bodies[i]};
+        const size_t sizes[] = {sizeof(Transform), sizeof(ModelComponent), sizeof(Light), sizeof(RigidBody)};
+        for (uint32_t c = 0; c < 4; c++) {
+            if (mask & (1u << c)) memcpy(entityGet(world, entity, c), components[c], sizes[c]);
+        }
+    }
+    double createTime = seconds(start);
+
+    size_t chunkCount = 0;
+    for (const Archetype& archetype : world.archetypes) {
+        chunkCount += archetype.chunks.size();
+    }
+    size_t flatBytes = entityCount * (sizeof(Entity) + sizeof(Transform) + sizeof(ModelComponent) + sizeof(Light) +
+                                      sizeof(RigidBody));
+    printf("%zu entities, %zu archetypes, %zu chunks of %zu KB: %.1f MB against %.1f MB flat, created in %.1f ms\n",
+           entityCount, world.archetypes.size(), chunkCount, ENTITY_CHUNK_BYTES / 1024,
+           chunkCount * ENTITY_CHUNK_BYTES / 1048576.0, flatBytes / 1048576.0, createTime * 1000.0);
+
+    // Rigid bodies come and go on the same entities in both layouts; a body
+    // gained starts zeroed, as entitySetMask leaves it
+    size_t churnCount = entityCount * churnPermille / 1000;
+    std::vector<uint32_t> churned(churnCount);
+    double flatTimes[3] = {}, chunkTimes[3] = {}, flatChurn = 0.0, chunkChurn = 0.0;
+    FrameSums flatSums, chunkSums;
+    for (int frame = 0; frame < frames; frame++) {
+        runFlat(scene, flatSums, flatTimes);
+        runChunks(world, chunkSums, chunkTimes);
+
+        for (uint32_t& entity : churned) {
+            entity = rngNext(rng) % (uint32_t)entityCount;
+        }
+        start = std::chrono::steady_clock::now();
+        for (uint32_t entity : churned) {
+            scene.entities[entity].component_mask ^= HAS_RIGID_BODY;
+            if (scene.entities[entity].component_mask & HAS_RIGID_BODY) scene.bodies[entity] = RigidBody();
+        }
+        flatChurn += seconds(start);
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i : churned) {
+            entitySetMask(world, handles[i], entityMask(world, handles[i]) ^ HAS_RIGID_BODY);
+        }
+        chunkChurn += seconds(start);
+    }
+
+    const char* systems[] = {"physics (transform, body)", "lights (transform, light)", "models (transform, model)"};
+    printf("  %-28s %10s %10s %8s\n", "per frame", "flat ms", "chunks ms", "speedup");
+    double flatTotal = 0.0, chunkTotal = 0.0;
+    for (int s = 0; s < 3; s++) {
+        printf("  %-28s %10.3f %10.3f %7.2fx\n", systems[s], flatTimes[s] / frames * 1000.0,
+               chunkTimes[s] / frames * 1000.0, flatTimes[s] / chunkTimes[s]);
+        flatTotal += flatTimes[s];
+        chunkTotal += chunkTimes[s];
+    }
+    printf("  %-28s %10.3f %10.3f %7.2fx\n", "all systems", flatTotal / frames * 1000.0,
+           chunkTotal / frames * 1000.0, flatTotal / chunkTotal);
+    printf("  %-28s %10.3f %10.3f   %zu bodies toggled, %.0f ns each in chunks\n", "body churn",
+           flatChurn / frames * 1000.0, chunkChurn / frames * 1000.0, churnCount,
+           chunkChurn / frames / std::max<size_t>(churnCount, 1) * 1e9);
+
+    bool sumsMatch = fabs(flatSums.light - chunkSums.light) <= 1e-9 * fabs(flatSums.light) + 1e-9 &&
+                     fabs(flatSums.model - chunkSums.model) <= 1e-9 * fabs(flatSums.model) + 1e-9;
+    bool ok = sumsMatch && compareLayouts(scene, world, handles);
+    printf("  layouts %s\n", ok ? "match" : "DIFFER");
+    entityWorldFree(world);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+// Level-start import of many glTF files: the serial loader against the job
+// pipeline in scene_import.h on pools of growing size, plus one .gltf with an
+// external buffer per mesh to show reads and unpacking of a single file
+// spreading over the pool.
+//
+//   bench_import [--dir work_dir] [--files N] [--meshes N] [--segments N] [--threads T,T,...]
+//
+// Files are generated into work_dir; timings are with them in the page cache.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_scenes.h"
+#include "scene_import.h"
+#include "scene_loader.h"
+#include "thread_pool.h"
+#include "timing.h"
+
+static bool sameScene(const Scene& a, const Scene& b) {
+    return a.vertices.size() == b.vertices.size() && a.indices.size() == b.indices.size() &&
+           a.meshlets.size() == b.meshlets.size() && a.meshes.size() == b.meshes.size() &&
+           a.draws.size() == b.draws.size() &&
+           memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(SceneVertex)) == 0 &&
+           memcmp(a.indices.data(), b.indices.data(), a.indices.size() * sizeof(uint32_t)) == 0 &&
+           memcmp(a.meshlets.data(), b.meshlets.data(), a.meshlets.size() * sizeof(Meshlet)) == 0 &&
+           memcmp(a.meshes.data(), b.meshes.data(), a.meshes.size() * sizeof(SceneMesh)) == 0 &&
+           memcmp(a.draws.data(), b.draws.data(), a.draws.size() * sizeof(SceneDraw)) == 0 &&
+           memcmp(a.boundsMin, b.boundsMin, sizeof(a.boundsMin)) == 0 &&
+           memcmp(a.boundsMax, b.boundsMax, sizeof(a.boundsMax)) == 0;
+}
+
+struct BatchTiming {
+    double total = 1e9;
+    double firstReady = 1e9;
+    bool identical = true;
+};
+
+// Best of `runs`, popping the way a GL thread would before uploading
+static BatchTiming timeBatch(ThreadPool& pool, const std::vector<std::string>& paths,
+                             const std::vector<Scene>& reference, int runs) {
+    BatchTiming timing;
+    for (int run = 0; run < runs; run++) {
+        SceneBatch batch;
+        auto start = std::chrono::steady_clock::now();
+        sceneBatchStart(batch, pool, paths);
+        size_t index;
+        bool first = true;
+        while (sceneBatchPop(batch, index, true)) {
+            if (first) {
+                timing.firstReady = std::min(timing.firstReady, seconds(start));
+                first = false;
+            }
+            const SceneImport& import = *batch.imports[index];
+            timing.identical = timing.identical && import.ok && sameScene(import.scene, reference[index]);
+        }
+        timing.total = std::min(timing.total, seconds(start));
+    }
+    return timing;
+}
+
+int main(int argc, char** argv) {
+    std::string dir = "import_work";
+    int files = 32;
+    int meshes = 64;
+    int segments = 24;
+    std::vector<unsigned> threadCounts;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "--files") == 0 && i + 1 < argc) {
+            files = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--meshes") == 0 && i + 1 < argc) {
+            meshes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--segments") == 0 && i + 1 < argc) {
+            segments = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            for (char* item = strtok(argv[++i], ","); item; item = strtok(nullptr, ",")) {
+                threadCounts.push_back((unsigned)atoi(item));
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--dir work_dir] [--files N] [--meshes N] [--segments N] [--threads T,T,...]\n",
+                    argv[0]);
+            return -1;
+        }
+    }
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    if (threadCounts.empty()) {
+        for (unsigned threads = 1; threads <= std::max(4u, hardware); threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error) {
+        fprintf(stderr, "Can't create %s: %s\n", dir.c_str(), error.message().c_str());
+        return 1;
+    }
+    std::vector<std::string> paths;
+    for (int i = 0; i < files; i++) {
+        paths.push_back(dir + "/level_" + std::to_string(i) + ".glb");
+    }
+    std::string bigPath = dir + "/external.gltf";
+    for (const std::string& path : paths) {
+        if (!writeSphereScene(path, meshes, segments)) {
+            fprintf(stderr, "Can't write %s\n", path.c_str());
+            return 1;
+        }
+    }
+    if (!writeSphereScene(bigPath, meshes * 4, segments)) {
+        fprintf(stderr, "Can't write %s\n", bigPath.c_str());
+        return 1;
+    }
+
+    const int runs = 3;
+    std::vector<Scene> reference(paths.size());
+    double serialTime = 1e9;
+    size_t vertices = 0;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        vertices = 0;
+        for (size_t i = 0; i < paths.size(); i++) {
+            sceneLoadGltf(reference[i], paths[i].c_str());
+            vertices += reference[i].vertices.size();
+        }
+        serialTime = std::min(serialTime, seconds(start));
+    }
+    std::vector<Scene> bigReference(1);
+    double bigSerialTime = 1e9;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        sceneLoadGltf(bigReference[0], bigPath.c_str());
+        bigSerialTime = std::min(bigSerialTime, seconds(start));
+    }
+
+    printf("%d files x %d meshes, %zu vertices; external.gltf: %d meshes in %d .bin files; %u hardware threads\n",
+           files, meshes, vertices, meshes * 4, meshes * 4, hardware);
+    printf("%-20s %10s %12s %9s %14s %9s\n", "", "files ms", "first ready", "speedup", "external ms", "speedup");
+    printf("%-20s %10.2f %12s %8.2fx %14.2f %8.2fx\n", "serial sceneLoadGltf", serialTime * 1000.0, "-", 1.0,
+           bigSerialTime * 1000.0, 1.0);
+
+    bool identical = true;
+    for (unsigned threads : threadCounts) {
+        ThreadPool pool;
+        threadPoolInit(pool, threads);
+        BatchTiming batch = timeBatch(pool, paths, reference, runs);
+        BatchTiming big = timeBatch(pool, {bigPath}, bigReference, runs);
+        threadPoolShutdown(pool);
+        identical = identical && batch.identical && big.identical;
+
+        char label[32];
+        snprintf(label, sizeof(label), "pool, %u thread%s", threads, threads == 1 ? "" : "s");
+        printf("%-20s %10.2f %10.2fms %8.2fx %14.2f %8.2fx\n", label, batch.total * 1000.0,
+               batch.firstReady * 1000.0, serialTime / batch.total, big.total * 1000.0,
+               bigSerialTime / big.total);
+    }
+    printf("scenes %s the serial import\n", identical ? "identical to" : "DIFFER from");
+    if (hardware < threadCounts.back()) {
+        printf("note: only %u hardware thread%s, larger pools can't scale here\n", hardware,
+               hardware == 1 ? "" : "s");
+    }
+    return identical ? 0 : 1;
+}
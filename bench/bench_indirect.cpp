@@ -0,0 +1,248 @@
+// CPU cost of submitting a large scene: one glUniformMatrix4fv plus
+// glDrawElementsBaseVertex per draw against a single
+// glMultiDrawElementsIndirect reading transforms from an SSBO. The scene is
+// the benchmark model replicated on a grid, 10k copies by default.
+//
+//   bench_indirect [--copies N] [--frames N] [file.glb]
+//
+// "submit" is the time spent issuing the frame's GL calls, "frame" adds a
+// glFinish so it includes the driver and GPU work the calls queued up.
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "indirect_renderer.h"
+#include "scene_loader.h"
+#include "timing.h"
+
+static const char* perDrawVertexSource = R"glsl(
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+uniform mat4 model;
+uniform mat4 viewProjection;
+out vec3 normal;
+void main() {
+    normal = mat3(model) * aNormal;
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
+}
+)glsl";
+
+static const char* indirectVertexSource = R"glsl(
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (std430, binding = 0) readonly buffer Transforms {
+    mat4 transforms[];
+};
+uniform mat4 viewProjection;
+out vec3 normal;
+void main() {
+    mat4 model = transforms[gl_DrawIDARB];
+    normal = mat3(model) * aNormal;
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
+}
+)glsl";
+
+static const char* fragmentSource = R"glsl(
+#version 430 core
+in vec3 normal;
+out vec4 FragColor;
+void main() {
+    float light = 0.3 + 0.7 * max(dot(normalize(normal), normalize(vec3(0.3, 0.5, 1.0))), 0.0);
+    FragColor = vec4(vec3(0.8) * light, 1.0);
+}
+)glsl";
+
+static GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        fprintf(stderr, "Shader compilation error: %s\n", infoLog);
+    }
+    return shader;
+}
+
+static GLuint createProgram(const char* vertexSource) {
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        fprintf(stderr, "Shader linking error: %s\n", infoLog);
+    }
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    return program;
+}
+
+// Looks straight down at the XZ grid: x maps to x, z to y and y to depth
+static void topDownProjection(const Scene& scene, float* out) {
+    float center[3];
+    float half[3];
+    for (int k = 0; k < 3; k++) {
+        center[k] = (scene.boundsMin[k] + scene.boundsMax[k]) * 0.5f;
+        half[k] = (scene.boundsMax[k] - scene.boundsMin[k]) * 0.5f + 0.001f;
+    }
+    memset(out, 0, 16 * sizeof(float));
+    out[0] = 1.0f / half[0];
+    out[9] = 1.0f / half[2];
+    out[6] = -1.0f / half[1];
+    out[12] = -center[0] / half[0];
+    out[13] = -center[2] / half[2];
+    out[14] = center[1] / half[1];
+    out[15] = 1.0f;
+}
+
+struct Timing {
+    double submit = 0.0;
+    double frame = 0.0;
+    int drawCalls = 0;
+};
+
+// Average per frame over `frames` frames after a few warm-up ones
+static Timing measure(GLFWwindow* window, IndirectRenderer& renderer, const SceneView& scene, GLuint program,
+                      bool indirect, int frames) {
+    GLint modelLocation = glGetUniformLocation(program, "model");
+    Timing timing;
+    const int warmup = 5;
+
+    for (int frame = 0; frame < warmup + frames; frame++) {
+        FrameStats stats;
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glFinish();
+
+        auto start = std::chrono::steady_clock::now();
+        glUseProgram(program);
+        if (indirect) {
+            indirectRendererDraw(renderer, stats);
+        } else {
+            indirectRendererDrawEach(renderer, scene, modelLocation, stats);
+        }
+        double submit = seconds(start);
+        glFinish();
+        double total = seconds(start);
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+
+        if (frame >= warmup) {
+            timing.submit += submit;
+            timing.frame += total;
+            timing.drawCalls = stats.drawCalls;
+        }
+    }
+    timing.submit /= frames;
+    timing.frame /= frames;
+    return timing;
+}
+
+int main(int argc, char** argv) {
+    int copies = 10000;
+    int frames = 200;
+    const char* path = "../res/assets/bench_01.glb";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--copies") == 0 && i + 1 < argc) {
+            copies = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [--copies N] [--frames N] [file.glb]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    Scene scene;
+    if (!sceneLoadGltf(scene, path) || scene.draws.empty()) {
+        fprintf(stderr, "No drawable meshes in %s\n", path);
+        return 1;
+    }
+    sceneReplicate(scene, copies);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(1280, 720, "bench_indirect", NULL, NULL);
+    if (!window) {
+        fprintf(stderr, "Failed to create a GL 4.3 context\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK || !indirectRendererSupported()) {
+        fprintf(stderr, "GL 4.3 with ARB_shader_draw_parameters required\n");
+        glfwTerminate();
+        return 1;
+    }
+    printf("%s: %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+    size_t triangles = 0;
+    for (const SceneDraw& draw : scene.draws) {
+        triangles += scene.meshes[draw.mesh].indexCount / 3;
+    }
+    printf("%s x %d: %zu draws, %zu triangles per frame\n", path, copies, scene.draws.size(), triangles);
+
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+
+    float viewProjection[16];
+    topDownProjection(scene, viewProjection);
+    GLuint perDrawProgram = createProgram(perDrawVertexSource);
+    GLuint indirectProgram = createProgram(indirectVertexSource);
+    for (GLuint program : {perDrawProgram, indirectProgram}) {
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "viewProjection"), 1, GL_FALSE, viewProjection);
+    }
+
+    FrameStats setupStats;
+    IndirectRenderer renderer;
+    SceneView view = sceneView(scene);
+    indirectRendererInit(renderer, view, setupStats);
+    auto start = std::chrono::steady_clock::now();
+    indirectRendererSetDraws(renderer, view, setupStats);
+    glFinish();
+    double setupTime = seconds(start);
+
+    Timing perDraw = measure(window, renderer, view, perDrawProgram, false, frames);
+    Timing indirect = measure(window, renderer, view, indirectProgram, true, frames);
+
+    printf("%-28s %10s %10s %12s %10s\n", "", "draw calls", "submit ms", "submit/draw", "frame ms");
+    printf("%-28s %10d %10.3f %10.1fns %10.3f\n", "glDrawElementsBaseVertex", perDraw.drawCalls,
+           perDraw.submit * 1000.0, perDraw.submit * 1e9 / scene.draws.size(), perDraw.frame * 1000.0);
+    printf("%-28s %10d %10.3f %10.1fns %10.3f\n", "glMultiDrawElementsIndirect", indirect.drawCalls,
+           indirect.submit * 1000.0, indirect.submit * 1e9 / scene.draws.size(), indirect.frame * 1000.0);
+    printf("submit speedup %.1fx, frame speedup %.2fx, command + transform upload %.3f ms once\n",
+           perDraw.submit / indirect.submit, perDraw.frame / indirect.frame, setupTime * 1000.0);
+
+    indirectRendererDestroy(renderer);
+    glDeleteProgram(perDrawProgram);
+    glDeleteProgram(indirectProgram);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
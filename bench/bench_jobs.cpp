@@ -0,0 +1,280 @@
+// Scaling of the work-stealing job system (job_system.h) from one thread up
+// to every core on synthetic workloads, against the shared-queue ThreadPool:
+//
+//   uniform  every item costs the same arithmetic
+//   uneven   item cost varies up to 64x in runs, so even splits leave threads idle
+//   memory   a streaming pass over a buffer larger than the caches
+//
+// Also measures the cost of an empty job and checks a chain of stages held
+// back with jobSubmitAfter. Every parallel result must match the serial one,
+// or the run fails.
+//
+//   bench_jobs [--threads-max N] [--items N] [--megabytes N] [--reps N] [--pin]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "job_system.h"
+#include "thread_pool.h"
+#include "timing.h"
+
+// A few hundred cycles of integer mixing that the compiler can't skip
+static uint32_t mix(uint32_t value, uint32_t rounds) {
+    for (uint32_t r = 0; r < rounds; r++) {
+        value ^= value >> 15;
+        value *= 0x2c1b3c6dU;
+        value ^= value >> 12;
+        value *= 0x297a2d39U;
+    }
+    return value;
+}
+
+const uint32_t UNIFORM_ROUNDS = 64;
+
+// Runs of 256 items share a cost; one run in eight is 64x the cheapest
+static uint32_t unevenRounds(size_t item) {
+    uint32_t run = mix((uint32_t)(item >> 8), 1);
+    return (run & 7) == 0 ? 256 : 4 + (run & 3) * 4;
+}
+
+struct Workload {
+    const char* name;
+    size_t count;
+    // Writes one result per item of [begin, end), checksummed afterwards
+    void (*body)(void* data, size_t begin, size_t end);
+    void* data;
+};
+
+struct ComputeData {
+    std::vector<uint32_t> results;
+};
+
+struct MemoryData {
+    std::vector<uint32_t> source;
+    std::vector<uint32_t> results; // one per 4 KB block
+};
+
+const size_t MEMORY_BLOCK = 1024;
+
+static void uniformBody(void* data, size_t begin, size_t end) {
+    ComputeData& compute = *(ComputeData*)data;
+    for (size_t i = begin; i < end; i++) {
+        compute.results[i] = mix((uint32_t)i, UNIFORM_ROUNDS);
+    }
+}
+
+static void unevenBody(void* data, size_t begin, size_t end) {
+    ComputeData& compute = *(ComputeData*)data;
+    for (size_t i = begin; i < end; i++) {
+        compute.results[i] = mix((uint32_t)i, unevenRounds(i));
+    }
+}
+
+static void memoryBody(void* data, size_t begin, size_t end) {
+    MemoryData& memory = *(MemoryData*)data;
+    for (size_t block = begin; block < end; block++) {
+        const uint32_t* words = memory.source.data() + block * MEMORY_BLOCK;
+        uint32_t sum = 0;
+        for (size_t w = 0; w < MEMORY_BLOCK; w++) {
+            sum += words[w] * 3 + 1;
+        }
+        memory.results[block] = sum;
+    }
+}
+
+static uint64_t checksum(const std::vector<uint32_t>& results) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        sum = sum * 31 + results[i];
+    }
+    return sum;
+}
+
+static std::vector<uint32_t>& resultsOf(const Workload& workload) {
+    if (workload.body == memoryBody) return ((MemoryData*)workload.data)->results;
+    return ((ComputeData*)workload.data)->results;
+}
+
+// Best of `reps` runs
+template <typename Run>
+static double best(int reps, Run run) {
+    double fastest = 1e30;
+    for (int r = 0; r < reps; r++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        fastest = std::min(fastest, seconds(start));
+    }
+    return fastest;
+}
+
+// Stages of a chain: each stage's jobs check the previous stage finished
+// entirely before they started
+const size_t CHAIN_STAGES = 64;
+const size_t CHAIN_WIDTH = 16;
+
+struct Chain {
+    std::atomic<uint32_t> finished[CHAIN_STAGES];
+    std::atomic<uint32_t> violations{0};
+};
+
+static void chainJob(void* data, size_t stage, size_t) {
+    Chain& chain = *(Chain*)data;
+    if (stage > 0 && chain.finished[stage - 1].load(std::memory_order_acquire) != CHAIN_WIDTH) {
+        chain.violations.fetch_add(1, std::memory_order_relaxed);
+    }
+    mix((uint32_t)stage, UNIFORM_ROUNDS);
+    chain.finished[stage].fetch_add(1, std::memory_order_release);
+}
+
+static bool runChain(JobSystem& system) {
+    Chain chain;
+    for (size_t s = 0; s < CHAIN_STAGES; s++) {
+        chain.finished[s].store(0, std::memory_order_relaxed);
+    }
+    std::vector<JobCounter> counters(CHAIN_STAGES);
+    for (size_t s = 0; s < CHAIN_STAGES; s++) {
+        for (size_t j = 0; j < CHAIN_WIDTH; j++) {
+            Job job = {chainJob, &chain, s, s + 1, nullptr};
+            if (s == 0) {
+                jobSubmit(system, job, &counters[s]);
+            } else {
+                jobSubmitAfter(system, counters[s - 1], job, &counters[s]);
+            }
+        }
+    }
+    for (JobCounter& counter : counters) {
+        jobWait(system, counter);
+    }
+    return chain.violations.load() == 0 && chain.finished[CHAIN_STAGES - 1].load() == CHAIN_WIDTH;
+}
+
+static void emptyJob(void*, size_t, size_t) {}
+
+int main(int argc, char** argv) {
+    unsigned threadsMax = std::max(1u, std::thread::hardware_concurrency());
+    size_t items = 1 << 20;
+    size_t megabytes = 256;
+    int reps = 5;
+    bool pin = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads-max") == 0 && i + 1 < argc) {
+            threadsMax = (unsigned)std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--items") == 0 && i + 1 < argc) {
+            items = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--megabytes") == 0 && i + 1 < argc) {
+            megabytes = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pin = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--threads-max N] [--items N] [--megabytes N] [--reps N] [--pin]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    ComputeData uniform, uneven;
+    uniform.results.assign(items, 0);
+    uneven.results.assign(items, 0);
+    MemoryData memory;
+    memory.source.resize(megabytes * 1024 * 1024 / sizeof(uint32_t));
+    for (size_t i = 0; i < memory.source.size(); i++) {
+        memory.source[i] = (uint32_t)i * 2654435761U;
+    }
+    memory.results.assign(memory.source.size() / MEMORY_BLOCK, 0);
+    Workload workloads[] = {
+        {"uniform", items, uniformBody, &uniform},
+        {"uneven", items, unevenBody, &uneven},
+        {"memory", memory.results.size(), memoryBody, &memory},
+    };
+    const size_t workloadCount = sizeof(workloads) / sizeof(workloads[0]);
+
+    // Serial references
+    double serialTimes[workloadCount];
+    uint64_t expected[workloadCount];
+    for (size_t w = 0; w < workloadCount; w++) {
+        Workload& workload = workloads[w];
+        serialTimes[w] = best(reps, [&] { workload.body(workload.data, 0, workload.count); });
+        expected[w] = checksum(resultsOf(workload));
+    }
+
+    printf("%zu items, %zu MB streamed, best of %d, %s\n", items, megabytes, reps, pin ? "pinned" : "unpinned");
+    printf("  %-8s %7s %10s %8s %10s %8s %10s %8s\n", "workload", "threads", "jobs ms", "speedup", "pool ms",
+           "speedup", "stolen", "inlined");
+    bool ok = true;
+    for (size_t w = 0; w < workloadCount; w++) {
+        printf("  %-8s %7s %10.3f\n", workloads[w].name, "serial", serialTimes[w] * 1000.0);
+    }
+    for (unsigned threads = 1; threads <= threadsMax; threads++) {
+        JobSystem system;
+        jobSystemInit(system, threads, pin);
+        ThreadPool pool;
+        threadPoolInit(pool, threads);
+        for (size_t w = 0; w < workloadCount; w++) {
+            Workload& workload = workloads[w];
+            std::function<void(size_t, size_t)> body = [&workload](size_t begin, size_t end) {
+                workload.body(workload.data, begin, end);
+            };
+            uint64_t stolen = system.stats.stolen.load();
+            uint64_t inlined = system.stats.inlined.load();
+            std::fill(resultsOf(workload).begin(), resultsOf(workload).end(), 0);
+            double jobTime = best(reps, [&] { jobParallelFor(system, workload.count, 0, body); });
+            ok = ok && checksum(resultsOf(workload)) == expected[w];
+
+            // The pool gets the grain jobParallelFor picks for itself
+            size_t grain = std::max<size_t>(1, workload.count / (threads * JOB_RANGES_PER_THREAD));
+            std::fill(resultsOf(workload).begin(), resultsOf(workload).end(), 0);
+            double poolTime = best(reps, [&] { threadPoolParallelFor(pool, workload.count, grain, body); });
+            ok = ok && checksum(resultsOf(workload)) == expected[w];
+
+            printf("  %-8s %7u %10.3f %7.2fx %10.3f %7.2fx %10llu %8llu\n", workload.name, threads, jobTime * 1000.0,
+                   serialTimes[w] / jobTime, poolTime * 1000.0, serialTimes[w] / poolTime,
+                   (unsigned long long)(system.stats.stolen.load() - stolen),
+                   (unsigned long long)(system.stats.inlined.load() - inlined));
+        }
+        threadPoolShutdown(pool);
+        jobSystemShutdown(system);
+    }
+
+    // Submitting, running and retiring an empty job, on the full thread count.
+    // Batches fit a deque, so none run inline.
+    const size_t emptyBatches = 25;
+    const size_t emptyJobs = emptyBatches * JOB_DEQUE_CAPACITY;
+    JobSystem system;
+    jobSystemInit(system, threadsMax, pin);
+    ThreadPool pool;
+    threadPoolInit(pool, threadsMax);
+    double jobOverhead = best(reps, [&] {
+        for (size_t b = 0; b < emptyBatches; b++) {
+            JobCounter counter;
+            for (size_t j = 0; j < JOB_DEQUE_CAPACITY; j++) {
+                jobSubmit(system, {emptyJob, nullptr, 0, 0, nullptr}, &counter);
+            }
+            jobWait(system, counter);
+        }
+    });
+    double poolOverhead = best(reps, [&] {
+        for (size_t j = 0; j < emptyJobs; j++) {
+            threadPoolSubmit(pool, [] {});
+        }
+        threadPoolWait(pool);
+    });
+    printf("  empty job, %u threads: %.0f ns job system, %.0f ns thread pool\n", threadsMax,
+           jobOverhead / emptyJobs * 1e9, poolOverhead / emptyJobs * 1e9);
+
+    bool chained = runChain(system);
+    printf("  %zu-stage chain of %zu jobs a stage: %s\n", CHAIN_STAGES, CHAIN_WIDTH,
+           chained ? "in order" : "OUT OF ORDER");
+    threadPoolShutdown(pool);
+    jobSystemShutdown(system);
+
+    ok = ok && chained;
+    printf("%s\n", ok ? "results match" : "RESULTS DIFFER");
+    return ok ? 0 : 1;
+}
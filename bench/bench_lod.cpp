@@ -0,0 +1,293 @@
+// Level-of-detail chains built at import (mesh_simplify.h) and picked per
+// frame by projected error (lod_select.h): how far each level shrinks the
+// meshes and at what estimated error, how that estimate compares with the
+// distance measured from the full surface, what the chain costs to build,
+// that it comes back from the cooked cache, and how many triangles a field
+// of props needs from a camera walking through it.
+//
+//   bench_lod [--dir work_dir] [--copies N] [--segments N] [--pixels N] [file.glb ...]
+//
+// A dense generated sphere is always run; each file is copied into work_dir
+// so its cache is written there, then replicated `copies` times on a grid.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "bench_scenes.h"
+#include "lod_select.h"
+#include "mesh_cache.h"
+#include "scene_loader.h"
+#include "timing.h"
+
+// Distance from p to the triangle abc (Ericson, "Real-Time Collision
+// Detection", 5.1.5)
+static float pointTriangleDistance(const float* p, const float* a, const float* b, const float* c) {
+    float ab[3], ac[3], ap[3], closest[3];
+    for (int k = 0; k < 3; k++) {
+        ab[k] = b[k] - a[k];
+        ac[k] = c[k] - a[k];
+        ap[k] = p[k] - a[k];
+    }
+    auto dot = [](const float* x, const float* y) { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; };
+    float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    float bp[3] = {p[0] - b[0], p[1] - b[1], p[2] - b[2]};
+    float cp[3] = {p[0] - c[0], p[1] - c[1], p[2] - c[2]};
+    float d3 = dot(ab, bp), d4 = dot(ac, bp), d5 = dot(ab, cp), d6 = dot(ac, cp);
+    float va = d3 * d6 - d5 * d4, vb = d5 * d2 - d1 * d6, vc = d1 * d4 - d3 * d2;
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        memcpy(closest, a, sizeof(closest));
+    } else if (d3 >= 0.0f && d4 <= d3) {
+        memcpy(closest, b, sizeof(closest));
+    } else if (d6 >= 0.0f && d5 <= d6) {
+        memcpy(closest, c, sizeof(closest));
+    } else if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        float v = d1 / (d1 - d3);
+        for (int k = 0; k < 3; k++) closest[k] = a[k] + v * ab[k];
+    } else if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        float w = d2 / (d2 - d6);
+        for (int k = 0; k < 3; k++) closest[k] = a[k] + w * ac[k];
+    } else if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        for (int k = 0; k < 3; k++) closest[k] = b[k] + w * (c[k] - b[k]);
+    } else {
+        float denom = 1.0f / (va + vb + vc);
+        float v = vb * denom, w = vc * denom;
+        for (int k = 0; k < 3; k++) closest[k] = a[k] + ab[k] * v + ac[k] * w;
+    }
+    float d[3] = {p[0] - closest[0], p[1] - closest[1], p[2] - closest[2]};
+    return sqrtf(dot(d, d));
+}
+
+// Largest distance from a sample of the full mesh's vertices to the level's
+// surface. The level's vertices are full-mesh vertices, so this is the
+// direction simplification can get wrong.
+static float measureError(const SceneView& scene, const SceneMesh& mesh, const SceneLod& lod) {
+    const SceneVertex* vertices = scene.vertices + mesh.baseVertex;
+    const uint32_t* indices = scene.indices + lod.firstIndex;
+    size_t samples = std::min<size_t>(mesh.vertexCount, std::max<size_t>(50, 40000000 / lod.indexCount));
+    float worst = 0.0f;
+    for (size_t s = 0; s < samples; s++) {
+        const float* p = vertices[s * mesh.vertexCount / samples].position;
+        float nearest = INFINITY;
+        for (size_t i = 0; i < lod.indexCount && nearest > worst; i += 3) {
+            nearest = std::min(nearest, pointTriangleDistance(p, vertices[indices[i]].position,
+                                                              vertices[indices[i + 1]].position,
+                                                              vertices[indices[i + 2]].position));
+        }
+        worst = std::max(worst, nearest);
+    }
+    return worst;
+}
+
+struct LevelReport {
+    size_t meshes = 0;      // with this level
+    size_t triangles = 0;
+    size_t fullTriangles = 0; // of the same meshes at level 0
+    float error = 0.0f;     // largest, relative to the mesh's extent
+    float measured = 0.0f;  // first mesh with the level, relative to its extent
+    float estimated = 0.0f;
+};
+
+// Index ranges in bounds, no degenerate triangles, every level smaller than
+// the one before and its error no smaller
+static bool checkLods(const SceneView& scene) {
+    for (size_t m = 0; m < scene.meshCount; m++) {
+        const SceneMesh& mesh = scene.meshes[m];
+        if (mesh.lodCount < 1 || mesh.lodCount > SCENE_MAX_LODS || mesh.lods[0].firstIndex != mesh.firstIndex ||
+            mesh.lods[0].indexCount != mesh.indexCount) {
+            return false;
+        }
+        for (uint32_t level = 0; level < mesh.lodCount; level++) {
+            const SceneLod& lod = mesh.lods[level];
+            if (lod.firstIndex + (size_t)lod.indexCount > scene.indexCount || lod.indexCount % 3) return false;
+            if (level > 0 && (lod.indexCount >= mesh.lods[level - 1].indexCount ||
+                              lod.error < mesh.lods[level - 1].error)) {
+                return false;
+            }
+            const uint32_t* indices = scene.indices + lod.firstIndex;
+            for (size_t i = 0; i < lod.indexCount; i += 3) {
+                if (indices[i] >= mesh.vertexCount || indices[i + 1] >= mesh.vertexCount ||
+                    indices[i + 2] >= mesh.vertexCount) {
+                    return false;
+                }
+                if (level > 0 && (indices[i] == indices[i + 1] || indices[i + 1] == indices[i + 2] ||
+                                  indices[i + 2] == indices[i])) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// The chain again, as the importer builds it, for its throughput
+static double chainTrianglesPerSecond(const SceneView& scene) {
+    size_t triangles = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t m = 0; m < scene.meshCount; m++) {
+        SceneMesh mesh = scene.meshes[m];
+        std::vector<uint32_t> indices(scene.indices + mesh.firstIndex,
+                                      scene.indices + mesh.firstIndex + mesh.indexCount);
+        sceneBuildLods(mesh, indices, mesh.vertexCount, scene.vertices[mesh.baseVertex].position,
+                       sizeof(SceneVertex));
+        triangles += mesh.indexCount / 3;
+    }
+    return triangles / seconds(start);
+}
+
+static bool benchScene(const char* name, const std::string& path, int copies, float maxPixels) {
+    // Cold load imports, simplifies and cooks; the warm one maps the cache
+    std::remove(meshCachePath(path.c_str()).c_str());
+    MeshCache cache;
+    if (!meshCacheLoad(cache, path.c_str()) || cache.view.drawCount == 0) {
+        fprintf(stderr, "Can't load %s\n", path.c_str());
+        return false;
+    }
+    double coldTime = cache.stats.seconds;
+    std::vector<SceneMesh> cooked(cache.view.meshes, cache.view.meshes + cache.view.meshCount);
+    meshCacheLoad(cache, path.c_str());
+    bool persisted = cache.stats.hit && cache.view.meshCount == cooked.size() &&
+                     memcmp(cache.view.meshes, cooked.data(), cooked.size() * sizeof(SceneMesh)) == 0;
+    double warmTime = cache.stats.seconds;
+
+    const SceneView& view = cache.view;
+    bool valid = checkLods(view);
+    LevelReport levels[SCENE_MAX_LODS];
+    for (size_t m = 0; m < view.meshCount; m++) {
+        const SceneMesh& mesh = view.meshes[m];
+        float extent = 0.0f;
+        for (int k = 0; k < 3; k++) extent = std::max(extent, mesh.boundsMax[k] - mesh.boundsMin[k]);
+        for (uint32_t level = 0; level < mesh.lodCount; level++) {
+            LevelReport& report = levels[level];
+            if (level > 0 && report.meshes == 0) {
+                report.measured = measureError(view, mesh, mesh.lods[level]) / extent;
+                report.estimated = mesh.lods[level].error / extent;
+            }
+            report.meshes++;
+            report.triangles += mesh.lods[level].indexCount / 3;
+            report.fullTriangles += mesh.indexCount / 3;
+            report.error = std::max(report.error, mesh.lods[level].error / extent);
+        }
+    }
+    printf("%s: %zu meshes, chain built at %.2f Mtri/s, cold load %.1f ms, cached %.2f ms, %s, %s\n", name,
+           view.meshCount, chainTrianglesPerSecond(view) / 1e6, coldTime * 1000.0, warmTime * 1000.0,
+           persisted ? "levels persisted" : "LEVELS NOT PERSISTED", valid ? "levels valid" : "LEVELS INVALID");
+    printf("  %-6s %8s %12s %8s %12s %12s %12s\n", "level", "meshes", "triangles", "ratio", "max error",
+           "estimated", "measured");
+    for (uint32_t level = 0; level < SCENE_MAX_LODS && levels[level].meshes; level++) {
+        const LevelReport& report = levels[level];
+        printf("  %-6u %8zu %12zu %7.1f%% %11.4f%%", level, report.meshes, report.triangles,
+               100.0 * report.triangles / report.fullTriangles, 100.0 * report.error);
+        if (level > 0) {
+            printf(" %11.4f%% %11.4f%%", 100.0 * report.estimated, 100.0 * report.measured);
+        }
+        printf("\n");
+    }
+
+    // The model alone, backed off until its bounding sphere spans a given
+    // number of pixels
+    float pixelsPerUnit = lodPixelsPerUnit(60.0f * (float)M_PI / 180.0f, 1080.0f);
+    std::vector<uint8_t> selected;
+    LodSelectStats stats, total;
+    float diameter = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        diameter += (view.boundsMax[k] - view.boundsMin[k]) * (view.boundsMax[k] - view.boundsMin[k]);
+    }
+    diameter = sqrtf(diameter);
+    printf("  on screen:");
+    for (float size : {1000.0f, 300.0f, 100.0f, 30.0f, 10.0f, 3.0f}) {
+        float eye[3];
+        for (int k = 0; k < 3; k++) eye[k] = (view.boundsMin[k] + view.boundsMax[k]) * 0.5f;
+        eye[2] += diameter * pixelsPerUnit / size;
+        selectLods(selected, view, eye, pixelsPerUnit, maxPixels, stats);
+        printf(" %.0f px %.1f%%", size, 100.0 * stats.selectedTriangles / stats.triangles);
+    }
+    printf(" of the triangles\n");
+
+    // A camera at twice the props' height walks a line across the field
+    // towards its far corner, 1080p with a 60 degree field of view
+    Scene scene;
+    if (!sceneLoadGltf(scene, path.c_str())) return false;
+    sceneReplicate(scene, copies);
+    SceneView field = sceneView(scene);
+    float height = field.boundsMax[1] - field.boundsMin[1];
+    const int cameras = 16;
+    double selectTime = 0.0;
+    for (int c = 0; c < cameras; c++) {
+        float along = (c + 0.5f) / cameras;
+        float eye[3] = {field.boundsMin[0] + (field.boundsMax[0] - field.boundsMin[0]) * along,
+                        field.boundsMax[1] + height, field.boundsMin[2] +
+                        (field.boundsMax[2] - field.boundsMin[2]) * along * 0.5f};
+        auto start = std::chrono::steady_clock::now();
+        selectLods(selected, field, eye, pixelsPerUnit, maxPixels, stats);
+        selectTime += seconds(start);
+        total.draws += stats.draws;
+        total.triangles += stats.triangles;
+        total.selectedTriangles += stats.selectedTriangles;
+        for (uint32_t level = 0; level < SCENE_MAX_LODS; level++) {
+            total.drawsAtLevel[level] += stats.drawsAtLevel[level];
+        }
+    }
+    printf("  %d copies, %zu draws at %.1f px: draws per level", copies, field.drawCount, maxPixels);
+    for (uint32_t level = 0; level < SCENE_MAX_LODS; level++) {
+        printf(" %.1f%%", 100.0 * total.drawsAtLevel[level] / total.draws);
+    }
+    printf("\n  submitted %.1f%% of %zu triangles, select %.3f ms/frame (%.1f Mdraw/s)\n",
+           100.0 * total.selectedTriangles / total.triangles, total.triangles / cameras,
+           selectTime / cameras * 1000.0, total.draws / selectTime / 1e6);
+    meshCacheClose(cache);
+    return persisted && valid;
+}
+
+int main(int argc, char** argv) {
+    std::string dir = "lod_work";
+    int copies = 1000;
+    int segments = 256;
+    float maxPixels = 1.0f;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "--copies") == 0 && i + 1 < argc) {
+            copies = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--segments") == 0 && i + 1 < argc) {
+            segments = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pixels") == 0 && i + 1 < argc) {
+            maxPixels = (float)atof(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [--dir work_dir] [--copies N] [--segments N] [--pixels N] [file.glb ...]\n",
+                    argv[0]);
+            return -1;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    std::string spherePath = dir + "/dense_sphere.glb";
+    if (error || !writeSphereScene(spherePath, 1, segments)) {
+        fprintf(stderr, "Can't write %s\n", spherePath.c_str());
+        return 1;
+    }
+
+    bool ok = benchScene("dense sphere", spherePath, copies, maxPixels);
+    for (const char* path : files) {
+        std::string copy = dir + "/" + std::filesystem::path(path).filename().string();
+        std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing, error);
+        if (error) {
+            fprintf(stderr, "Can't copy %s\n", path);
+            ok = false;
+            continue;
+        }
+        ok = benchScene(path, copy, copies, maxPixels) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+// Load time of a scene through the cooked mesh cache against parsing the
+// glTF file every run: the repo's assets plus generated scenes of many
+// distinct UV spheres.
+//
+//   bench_mesh_cache [--dir work_dir] [--meshes N,N,...] [--segments N]
+//
+// Everything is copied or generated into work_dir so the caches are written
+// there and not next to the repo's assets. Timings are with the files in the
+// page cache; a cold disk adds the read to both sides.
+
+#include <sys/stat.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "bench_scenes.h"
+#include "mesh_cache.h"
+#include "scene_loader.h"
+#include "timing.h"
+
+// Reads every byte the GL upload would, so lazily mapped pages are paid for
+static uint64_t touch(const SceneView& view) {
+    uint64_t sum = 0;
+    const uint8_t* vertices = (const uint8_t*)view.vertices;
+    for (size_t i = 0; i < view.vertexCount * sizeof(SceneVertex); i += 64) sum += vertices[i];
+    const uint8_t* indices = (const uint8_t*)view.indices;
+    for (size_t i = 0; i < view.indexCount * sizeof(uint32_t); i += 64) sum += indices[i];
+    return sum;
+}
+
+static bool sameScene(const Scene& scene, const SceneView& view) {
+    return view.vertexCount == scene.vertices.size() && view.indexCount == scene.indices.size() &&
+           view.meshletCount == scene.meshlets.size() && view.meshCount == scene.meshes.size() &&
+           view.drawCount == scene.draws.size() &&
+           memcmp(view.vertices, scene.vertices.data(), view.vertexCount * sizeof(SceneVertex)) == 0 &&
+           memcmp(view.indices, scene.indices.data(), view.indexCount * sizeof(uint32_t)) == 0 &&
+           memcmp(view.meshlets, scene.meshlets.data(), view.meshletCount * sizeof(Meshlet)) == 0 &&
+           memcmp(view.meshes, scene.meshes.data(), view.meshCount * sizeof(SceneMesh)) == 0 &&
+           memcmp(view.draws, scene.draws.data(), view.drawCount * sizeof(SceneDraw)) == 0;
+}
+
+static void benchScene(const std::string& path, const char* name) {
+    const int runs = 5;
+    uint64_t sink = 0;
+
+    double importTime = 1e9;
+    Scene scene;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        sceneLoadGltf(scene, path.c_str());
+        importTime = std::min(importTime, seconds(start));
+    }
+
+    std::string cachePath = meshCachePath(path.c_str());
+    std::remove(cachePath.c_str());
+    MeshCache cache;
+    meshCacheLoad(cache, path.c_str());
+    MeshCacheStats cold = cache.stats;
+
+    double warmTime = 1e9;
+    double readTime = 1e9;
+    bool hits = true;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        meshCacheLoad(cache, path.c_str());
+        warmTime = std::min(warmTime, seconds(start));
+        sink += touch(cache.view);
+        readTime = std::min(readTime, seconds(start));
+        hits = hits && cache.stats.hit && !cache.stats.hashed;
+    }
+    bool identical = sameScene(scene, cache.view);
+
+    // A touched but unchanged source validates by content hash
+    utime(path.c_str(), nullptr);
+    meshCacheLoad(cache, path.c_str());
+    MeshCacheStats rehash = cache.stats;
+    hits = hits && rehash.hit && rehash.hashed;
+    meshCacheClose(cache);
+
+    struct stat source, cooked;
+    stat(path.c_str(), &source);
+    stat(cachePath.c_str(), &cooked);
+    printf("%-14s %8.1f %8.1f %8zu %9.2f %9.2f %9.3f %9.3f %9.2f %8.0fx %s%s\n", name,
+           source.st_size / 1048576.0, cooked.st_size / 1048576.0, scene.vertices.size(),
+           importTime * 1000.0, cold.seconds * 1000.0, warmTime * 1000.0, readTime * 1000.0,
+           rehash.seconds * 1000.0, importTime / readTime, identical ? "identical" : "MISMATCH",
+           hits ? "" : " (unexpected miss)");
+    if (sink == 1) printf("\n");
+}
+
+int main(int argc, char** argv) {
+    std::string dir = "mesh_cache_work";
+    std::vector<int> meshCounts = {64, 1024};
+    int segments = 32;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "--meshes") == 0 && i + 1 < argc) {
+            meshCounts.clear();
+            for (char* item = strtok(argv[++i], ","); item; item = strtok(nullptr, ",")) {
+                meshCounts.push_back(atoi(item));
+            }
+        } else if (strcmp(argv[i], "--segments") == 0 && i + 1 < argc) {
+            segments = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--dir work_dir] [--meshes N,N,...] [--segments N]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error) {
+        fprintf(stderr, "Can't create %s: %s\n", dir.c_str(), error.message().c_str());
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, std::string>> scenes;
+    for (const char* asset : {"bench.glb", "bench_01.glb"}) {
+        for (const char* root : {"../res/assets/", "res/assets/"}) {
+            std::string source = std::string(root) + asset;
+            if (std::filesystem::exists(source)) {
+                std::filesystem::copy_file(source, dir + "/" + asset,
+                                           std::filesystem::copy_options::overwrite_existing, error);
+                scenes.push_back({dir + "/" + asset, asset});
+                break;
+            }
+        }
+    }
+    for (int meshes : meshCounts) {
+        std::string name = "spheres_" + std::to_string(meshes);
+        std::string path = dir + "/" + name + ".glb";
+        if (!writeSphereScene(path.c_str(), meshes, segments)) {
+            fprintf(stderr, "Can't write %s\n", path.c_str());
+            return 1;
+        }
+        scenes.push_back({path, name});
+    }
+
+    printf("%-14s %8s %8s %8s %9s %9s %9s %9s %9s %9s\n", "", "src MB", "cache MB", "vertices", "import ms",
+           "cold ms", "warm ms", "+read ms", "rehash ms", "speedup");
+    for (const auto& scene : scenes) {
+        benchScene(scene.first, scene.second.c_str());
+    }
+    printf("cold: import + hash + cache write + map; warm: stat + map; +read: warm plus reading\n"
+           "every vertex and index page; rehash: warm after touching the source; speedup: import / +read\n");
+    return 0;
+}
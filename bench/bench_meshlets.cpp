@@ -0,0 +1,288 @@
+// Meshlet building at import and per-frame cluster culling (meshlet.h,
+// meshlet_cull.h): how full the meshlets are, what grouping them costs the
+// vertex cache, and how many triangles frustum and cone culling keep from a
+// ring of cameras around the scene. Every culled meshlet is checked triangle
+// by triangle, so culling that drops something visible fails the run.
+//
+//   bench_meshlets [--dir work_dir] [--copies N] [--segments N] [file.glb ...]
+//
+// A dense generated sphere is always run; each file is also replicated
+// `copies` times on a grid, like many props placed around a level.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "bench_scenes.h"
+#include "meshlet.h"
+#include "meshlet_cull.h"
+#include "scene_loader.h"
+#include "timing.h"
+
+// Column-major, like the scene's matrices
+static void multiply(const float* a, const float* b, float* out) {
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) sum += a[k * 4 + row] * b[col * 4 + k];
+            out[col * 4 + row] = sum;
+        }
+    }
+}
+
+static void transformPoint(const float* m, const float* p, float* out) {
+    for (int row = 0; row < 4; row++) {
+        out[row] = m[row] * p[0] + m[4 + row] * p[1] + m[8 + row] * p[2] + m[12 + row];
+    }
+}
+
+// Perspective camera at `eye` looking at `target`, Y up, GL clip space
+static void viewProjection(const float eye[3], const float target[3], float fovY, float aspect, float near,
+                           float far, float out[16]) {
+    float f[3] = {target[0] - eye[0], target[1] - eye[1], target[2] - eye[2]};
+    float length = sqrtf(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    for (int k = 0; k < 3; k++) f[k] /= length;
+    float s[3] = {-f[2], 0.0f, f[0]}; // f x up
+    length = sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    for (int k = 0; k < 3; k++) s[k] /= length;
+    float u[3] = {s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0]};
+    float view[16] = {s[0], u[0], -f[0], 0, s[1], u[1], -f[1], 0, s[2], u[2], -f[2], 0,
+                      -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]),
+                      -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]),
+                      f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2], 1};
+    float t = 1.0f / tanf(fovY * 0.5f);
+    float projection[16] = {t / aspect, 0, 0, 0, 0, t, 0, 0, 0, 0, (far + near) / (near - far), -1,
+                            0, 0, 2.0f * far * near / (near - far), 0};
+    multiply(projection, view, out);
+}
+
+// True when some triangle of a culled meshlet faces the camera and isn't
+// wholly outside one clip plane
+static bool culledVisibleTriangle(const SceneView& scene, const SceneDraw& draw, const Meshlet& meshlet,
+                                  const float clip[16], const float camera[3]) {
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+        const uint32_t* tri = &scene.indices[meshlet.firstIndex + t * 3];
+        const SceneMesh& mesh = scene.meshes[draw.mesh];
+        float world[3][4];
+        float clipped[3][4];
+        for (int k = 0; k < 3; k++) {
+            transformPoint(draw.world, scene.vertices[mesh.baseVertex + tri[k]].position, world[k]);
+            transformPoint(clip, world[k], clipped[k]);
+        }
+        bool outside = false;
+        for (int axis = 0; axis < 3 && !outside; axis++) {
+            bool below = true, above = true;
+            for (int k = 0; k < 3; k++) {
+                below = below && clipped[k][axis] < -clipped[k][3];
+                above = above && clipped[k][axis] > clipped[k][3];
+            }
+            outside = below || above;
+        }
+        if (outside) continue;
+        float e1[3], e2[3], toEye[3];
+        for (int k = 0; k < 3; k++) {
+            e1[k] = world[1][k] - world[0][k];
+            e2[k] = world[2][k] - world[0][k];
+            toEye[k] = camera[k] - world[0][k];
+        }
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        float facing = n[0] * toEye[0] + n[1] * toEye[1] + n[2] * toEye[2];
+        float scale = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) *
+                      sqrtf(toEye[0] * toEye[0] + toEye[1] * toEye[1] + toEye[2] * toEye[2]);
+        if (facing > 1e-4f * scale) return true;
+    }
+    return false;
+}
+
+struct MeshletReport {
+    size_t meshlets = 0;
+    size_t vertices = 0;
+    size_t triangles = 0;
+    bool withinLimits = true;
+    bool contiguous = true; // each mesh's meshlets tile its index range in order
+};
+
+static MeshletReport checkMeshlets(const SceneView& scene) {
+    MeshletReport report;
+    for (size_t m = 0; m < scene.meshCount; m++) {
+        const SceneMesh& mesh = scene.meshes[m];
+        uint32_t next = mesh.firstIndex;
+        for (uint32_t i = mesh.firstMeshlet; i < mesh.firstMeshlet + mesh.meshletCount; i++) {
+            const Meshlet& meshlet = scene.meshlets[i];
+            report.meshlets++;
+            report.vertices += meshlet.vertexCount;
+            report.triangles += meshlet.triangleCount;
+            report.withinLimits = report.withinLimits && meshlet.vertexCount <= MESHLET_MAX_VERTICES &&
+                                  meshlet.triangleCount <= MESHLET_MAX_TRIANGLES;
+            report.contiguous = report.contiguous && meshlet.firstIndex == next;
+            next = meshlet.firstIndex + meshlet.triangleCount * 3;
+        }
+        report.contiguous = report.contiguous && next == mesh.firstIndex + mesh.indexCount;
+    }
+    return report;
+}
+
+// Each triangle as its three indices rotated to start at the smallest one,
+// so equal triangles compare equal without changing their winding
+static std::vector<std::array<uint32_t, 3>> triangleSet(const uint32_t* indices, size_t indexCount) {
+    std::vector<std::array<uint32_t, 3>> set(indexCount / 3);
+    for (size_t t = 0; t < set.size(); t++) {
+        const uint32_t* tri = &indices[t * 3];
+        int first = tri[1] < tri[0] ? (tri[2] < tri[1] ? 2 : 1) : (tri[2] < tri[0] ? 2 : 0);
+        for (int k = 0; k < 3; k++) set[t][k] = tri[(first + k) % 3];
+    }
+    std::sort(set.begin(), set.end());
+    return set;
+}
+
+// Builder throughput and vertex cache cost on the scene's first mesh,
+// starting again from its cache-optimized order
+static void benchBuilder(const SceneView& scene, double& trianglesPerSecond, double& acmrBefore,
+                         double& acmrAfter, bool& intact) {
+    const SceneMesh& mesh = scene.meshes[0];
+    std::vector<uint32_t> indices(scene.indices + mesh.firstIndex,
+                                  scene.indices + mesh.firstIndex + mesh.indexCount);
+    optimizeVertexCache(indices.data(), indices.size(), mesh.vertexCount, scene.vertices[mesh.baseVertex].position,
+                        sizeof(SceneVertex));
+    acmrBefore = vertexCacheAcmr(analyzeVertexCache(indices.data(), indices.size(), mesh.vertexCount));
+    std::vector<uint32_t> grouped = indices;
+    std::vector<Meshlet> meshlets;
+    auto start = std::chrono::steady_clock::now();
+    buildMeshlets(meshlets, grouped.data(), grouped.size(), mesh.vertexCount, scene.vertices[mesh.baseVertex].position,
+                  sizeof(SceneVertex));
+    optimizeMeshletVertexCache(meshlets, grouped.data(), mesh.vertexCount);
+    trianglesPerSecond = indices.size() / 3 / seconds(start);
+    acmrAfter = vertexCacheAcmr(analyzeVertexCache(grouped.data(), grouped.size(), mesh.vertexCount));
+    intact = triangleSet(indices.data(), indices.size()) == triangleSet(grouped.data(), grouped.size());
+}
+
+static bool benchScene(const char* name, Scene& scene, int copies) {
+    SceneView single = sceneView(scene);
+    MeshletReport report = checkMeshlets(single);
+    double buildRate, acmrBefore, acmrAfter;
+    bool intact;
+    benchBuilder(single, buildRate, acmrBefore, acmrAfter, intact);
+    double trianglesEach = (double)report.triangles / report.meshlets;
+    printf("%s: %zu triangles in %zu meshlets, %.1f vertices and %.1f triangles each (%.0f%% of %u)\n", name,
+           report.triangles, report.meshlets, (double)report.vertices / report.meshlets, trianglesEach,
+           100.0 * trianglesEach / MESHLET_MAX_TRIANGLES, MESHLET_MAX_TRIANGLES);
+    printf("  build %.2f Mtri/s, ACMR %.3f -> %.3f grouped into meshlets, %s, %s, %s\n", buildRate / 1e6, acmrBefore,
+           acmrAfter, report.withinLimits ? "within limits" : "OVER LIMITS",
+           report.contiguous ? "ranges contiguous" : "RANGES BROKEN",
+           intact ? "triangles intact" : "TRIANGLES CHANGED");
+
+    sceneReplicate(scene, copies);
+    SceneView view = sceneView(scene);
+    float center[3], extent = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        center[k] = (view.boundsMin[k] + view.boundsMax[k]) * 0.5f;
+        extent = std::max(extent, view.boundsMax[k] - view.boundsMin[k]);
+    }
+
+    // A single model is orbited from close enough that part of it leaves the
+    // frustum; a replicated level is walked through, cameras standing inside
+    // the grid at twice the props' height and looking outwards
+    bool walk = copies > 1;
+    float height = view.boundsMax[1] - view.boundsMin[1];
+    const int cameras = 16;
+    std::vector<VisibleMeshlet> visible;
+    MeshletCullStats stats, total;
+    double cullTime = 0.0;
+    bool conservative = true;
+    for (int c = 0; c < cameras; c++) {
+        float angle = c * 2.0f * (float)M_PI / cameras;
+        float distance = walk ? extent * 0.25f : extent * (c % 2 ? 0.6f : 1.2f);
+        float eye[3] = {center[0] + cosf(angle) * distance, center[1] + (walk ? height * 2.0f : extent * 0.3f),
+                        center[2] + sinf(angle) * distance};
+        float target[3] = {center[0], center[1], center[2]};
+        if (walk) {
+            target[0] += cosf(angle) * extent;
+            target[2] += sinf(angle) * extent;
+        }
+        float clip[16];
+        viewProjection(eye, target, 60.0f * (float)M_PI / 180.0f, 16.0f / 9.0f, extent * 0.001f, extent * 4.0f,
+                       clip);
+
+        auto start = std::chrono::steady_clock::now();
+        cullMeshlets(visible, view, clip, eye, stats);
+        cullTime += seconds(start);
+        total.meshlets += stats.meshlets;
+        total.drawsCulled += stats.drawsCulled;
+        total.frustumCulled += stats.frustumCulled;
+        total.backfaceCulled += stats.backfaceCulled;
+        total.triangles += stats.triangles;
+        total.visibleTriangles += stats.visibleTriangles;
+
+        // Brute-force check on a few cameras; every culled meshlet is tested
+        if (c >= 4) continue;
+        std::vector<bool> kept(view.meshletCount * view.drawCount, false);
+        for (const VisibleMeshlet& v : visible) kept[(size_t)v.draw * view.meshletCount + v.meshlet] = true;
+        for (size_t d = 0; d < view.drawCount && conservative; d++) {
+            const SceneMesh& mesh = view.meshes[view.draws[d].mesh];
+            for (uint32_t m = mesh.firstMeshlet; m < mesh.firstMeshlet + mesh.meshletCount; m++) {
+                if (kept[d * view.meshletCount + m]) continue;
+                if (culledVisibleTriangle(view, view.draws[d], view.meshlets[m], clip, eye)) {
+                    conservative = false;
+                    break;
+                }
+            }
+        }
+    }
+    printf("  %d copies, %zu draws: %.1f%% of meshlets frustum culled (%zu whole draws/frame), %.1f%% cone culled\n",
+           copies, view.drawCount, 100.0 * total.frustumCulled / total.meshlets, total.drawsCulled / cameras,
+           100.0 * total.backfaceCulled / total.meshlets);
+    printf("  submitted %.1f%% of %zu triangles, cull %.3f ms/frame (%.1f Mmeshlet/s), %s\n",
+           100.0 * total.visibleTriangles / total.triangles, total.triangles / cameras, cullTime / cameras * 1000.0,
+           total.meshlets / cullTime / 1e6, conservative ? "no visible triangle culled" : "CULLED A VISIBLE TRIANGLE");
+    return report.withinLimits && report.contiguous && intact && conservative;
+}
+
+int main(int argc, char** argv) {
+    std::string dir = "meshlet_work";
+    int copies = 1000;
+    int segments = 512;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "--copies") == 0 && i + 1 < argc) {
+            copies = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--segments") == 0 && i + 1 < argc) {
+            segments = atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [--dir work_dir] [--copies N] [--segments N] [file.glb ...]\n", argv[0]);
+            return -1;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    std::string spherePath = dir + "/dense_sphere.glb";
+    if (error || !writeSphereScene(spherePath, 1, segments)) {
+        fprintf(stderr, "Can't write %s\n", spherePath.c_str());
+        return 1;
+    }
+
+    bool ok = true;
+    Scene scene;
+    sceneLoadGltf(scene, spherePath.c_str());
+    ok = benchScene("dense sphere", scene, 1) && ok;
+    for (const char* path : files) {
+        if (!sceneLoadGltf(scene, path) || scene.draws.empty()) {
+            fprintf(stderr, "Can't load %s\n", path);
+            ok = false;
+            continue;
+        }
+        ok = benchScene(path, scene, copies) && ok;
+    }
+    return ok ? 0 : 1;
+}
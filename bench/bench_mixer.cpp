@@ -0,0 +1,158 @@
+// Software mixer throughput: a scalar reference loop against the SIMD mixer
+// for growing voice counts. Every voice plays for the whole run, so each
+// block mixes exactly `voices` streams. Prints a checksum of the SIMD mix so
+// runs can be compared across machines and builds.
+//
+//   bench_mixer [--wav file]   also writes the 16 voice mix to a WAV file
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "audio_mixer.h"
+
+const int SAMPLE_RATE = 44100;
+const size_t BLOCK_FRAMES = 512;
+const float SOUND_SECONDS = 4.0f;
+
+struct ScalarVoice {
+    const float* samples;
+    size_t position;
+    float gainLeft, gainRight;
+};
+
+static std::vector<float> makeSound(float freq) {
+    std::vector<float> samples((size_t)(SOUND_SECONDS * SAMPLE_RATE));
+    for (size_t i = 0; i < samples.size(); i++) {
+        float t = i / (float)SAMPLE_RATE;
+        samples[i] = 0.05f * sinf(2.0f * (float)M_PI * freq * t) * (1.0f - t / SOUND_SECONDS);
+    }
+    return samples;
+}
+
+static float voicePan(int voice, int voices) {
+    return voices > 1 ? voice * 2.0f / (voices - 1) - 1.0f : 0.0f;
+}
+
+// The reference is what the mixer would be without vector code, so keep GCC
+// from auto-vectorizing it
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((optimize("no-tree-vectorize")))
+#endif
+static double benchScalar(const std::vector<std::vector<float>>& sounds, int voices, int blocks,
+                          std::vector<float>& left, std::vector<float>& right) {
+    std::vector<ScalarVoice> active(voices);
+    for (int v = 0; v < voices; v++) {
+        float angle = (voicePan(v, voices) + 1.0f) * (float)M_PI / 4.0f;
+        active[v] = {sounds[v % sounds.size()].data(), 0, cosf(angle), sinf(angle)};
+    }
+
+    std::vector<int16_t> pcm(BLOCK_FRAMES * 2);
+    auto start = std::chrono::steady_clock::now();
+    for (int block = 0; block < blocks; block++) {
+        std::fill(left.begin(), left.end(), 0.0f);
+        std::fill(right.begin(), right.end(), 0.0f);
+        for (ScalarVoice& voice : active) {
+            for (size_t i = 0; i < BLOCK_FRAMES; i++) {
+                float s = voice.samples[voice.position + i];
+                left[i] += s * voice.gainLeft;
+                right[i] += s * voice.gainRight;
+            }
+            voice.position += BLOCK_FRAMES;
+        }
+        for (size_t i = 0; i < BLOCK_FRAMES; i++) {
+            pcm[i * 2] = (int16_t)lrintf(fminf(fmaxf(left[i], -1.0f), 1.0f) * 32767.0f);
+            pcm[i * 2 + 1] = (int16_t)lrintf(fminf(fmaxf(right[i], -1.0f), 1.0f) * 32767.0f);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+static double benchMixer(const std::vector<std::vector<float>>& sounds, int voices, int blocks,
+                         unsigned long long& checksum, WavFile* wav) {
+    Mixer mixer;
+    if (!mixerInit(mixer, SAMPLE_RATE, BLOCK_FRAMES, voices)) {
+        fprintf(stderr, "Failed to allocate the mixer\n");
+        exit(EXIT_FAILURE);
+    }
+    for (const std::vector<float>& sound : sounds) {
+        mixerAddSound(mixer, sound.data(), sound.size());
+    }
+    for (int v = 0; v < voices; v++) {
+        mixerPlay(mixer, v % (int)sounds.size(), 1.0f, voicePan(v, voices), 0);
+    }
+
+    std::vector<int16_t> pcm(BLOCK_FRAMES * 2);
+    double seconds = 0.0;
+    checksum = 1469598103934665603ULL;
+    for (int block = 0; block < blocks; block++) {
+        auto start = std::chrono::steady_clock::now();
+        mixerMix(mixer, BLOCK_FRAMES);
+        mixerToPcm16(mixer, BLOCK_FRAMES, pcm.data());
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        seconds += elapsed.count();
+
+        // FNV-1a over the PCM, outside the timed region
+        for (int16_t sample : pcm) {
+            checksum = (checksum ^ (uint16_t)sample) * 1099511628211ULL;
+        }
+        if (wav) {
+            wavWrite(*wav, pcm.data(), BLOCK_FRAMES);
+        }
+    }
+
+    mixerFree(mixer);
+    return seconds;
+}
+
+int main(int argc, char** argv) {
+    const char* wavPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--wav") == 0 && i + 1 < argc) {
+            wavPath = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--wav file]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    std::vector<std::vector<float>> sounds;
+    for (int i = 0; i < 8; i++) {
+        sounds.push_back(makeSound(110.0f * (i + 2)));
+    }
+
+    const int voiceCounts[] = {1, 16, 64, 256};
+    const int blocks = (int)(SOUND_SECONDS * SAMPLE_RATE / BLOCK_FRAMES) - 1;
+    std::vector<float> left(BLOCK_FRAMES), right(BLOCK_FRAMES);
+
+    printf("SIMD width %d, %zu frame blocks at %d Hz\n", MIXER_SIMD_WIDTH, BLOCK_FRAMES, SAMPLE_RATE);
+    printf("%7s %20s %20s %8s %12s %18s\n", "voices", "scalar voices/ms", "mixer voices/ms",
+           "speedup", "realtime x", "checksum");
+    for (int voices : voiceCounts) {
+        WavFile wav;
+        bool writeWav = wavPath && voices == 16;
+        if (writeWav && !wavOpen(wav, wavPath, SAMPLE_RATE, 2)) {
+            fprintf(stderr, "Failed to create %s\n", wavPath);
+            return -1;
+        }
+
+        double scalar = benchScalar(sounds, voices, blocks, left, right);
+        unsigned long long checksum;
+        double simd = benchMixer(sounds, voices, blocks, checksum, writeWav ? &wav : nullptr);
+        if (writeWav) {
+            wavClose(wav);
+        }
+
+        // A "voice" here is one block of one voice, i.e. BLOCK_FRAMES frames
+        double work = (double)voices * blocks;
+        double audioSeconds = blocks * BLOCK_FRAMES / (double)SAMPLE_RATE;
+        printf("%7d %20.1f %20.1f %7.2fx %12.0f %016llx\n", voices, work / (scalar * 1000.0),
+               work / (simd * 1000.0), scalar / simd, audioSeconds / simd, checksum);
+    }
+    return 0;
+}
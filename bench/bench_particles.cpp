@@ -0,0 +1,88 @@
+// Particle update throughput: the old array-of-structs vector with
+// std::remove_if compaction against the SoA pool with the SIMD kernel.
+// Both run a steady state where dead particles are respawned each frame.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "particle_pool.h"
+
+struct Particle {
+    float x, y;
+    float velX, velY;
+    float life;
+    float r, g, b;
+};
+
+const float DELTA_TIME = 1.0f / 240.0f;
+
+static float randomLife() {
+    return 0.5f + (rand() % 100) / 100.0f;
+}
+
+static double benchAos(size_t count, int frames) {
+    std::vector<Particle> particles;
+    while (particles.size() < count) {
+        particles.push_back({0.0f, 0.0f, 1.0f, -1.0f, randomLife(), 1.0f, 1.0f, 1.0f});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        for (auto& p : particles) {
+            p.x += p.velX * DELTA_TIME;
+            p.y += p.velY * DELTA_TIME;
+            p.life -= DELTA_TIME;
+        }
+        particles.erase(std::remove_if(particles.begin(), particles.end(),
+            [](const Particle& p) { return p.life <= 0.0f; }), particles.end());
+        while (particles.size() < count) {
+            particles.push_back({0.0f, 0.0f, 1.0f, -1.0f, randomLife(), 1.0f, 1.0f, 1.0f});
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+static double benchPool(size_t count, int frames) {
+    ParticlePool pool;
+    if (!particlePoolInit(pool, count)) {
+        fprintf(stderr, "Failed to allocate %zu particles\n", count);
+        exit(EXIT_FAILURE);
+    }
+    while (pool.count < count) {
+        particlePoolSpawn(pool, 0.0f, 0.0f, 1.0f, -1.0f, randomLife(), 1.0f, 1.0f, 1.0f);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        particlePoolUpdate(pool, DELTA_TIME);
+        while (pool.count < count) {
+            particlePoolSpawn(pool, 0.0f, 0.0f, 1.0f, -1.0f, randomLife(), 1.0f, 1.0f, 1.0f);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    particlePoolFree(pool);
+    return elapsed.count();
+}
+
+int main() {
+    const size_t counts[] = {10000, 100000, 1000000};
+
+    printf("SIMD width %d\n", PARTICLE_SIMD_WIDTH);
+    printf("%10s %18s %18s %8s\n", "particles", "aos particles/s", "pool particles/s", "speedup");
+    for (size_t count : counts) {
+        // Roughly the same amount of work per row
+        int frames = (int)std::max<size_t>(20, 100000000 / count / 10);
+        srand(1);
+        double aos = benchAos(count, frames);
+        srand(1);
+        double pool = benchPool(count, frames);
+        double work = (double)count * frames;
+        printf("%10zu %18.3e %18.3e %7.2fx\n", count, work / aos, work / pool, aos / pool);
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+// Vertex memory and quantization error of the compact format in
+// vertex_quantize.h: generated meshes, with a full tangent frame laid out
+// like game01.cpp's Vertex and again as glTF stores it (sign in tangent.w),
+// then every mesh of the glTF files given on the command line.
+//
+//   bench_quantize [file.glb ...]
+//
+// Errors are the largest over each mesh's vertices; "ok" means they stay
+// within what 16-bit positions, snorm16 octahedral directions and half UVs
+// can represent.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "scene_loader.h"
+#include "timing.h"
+#include "vertex_quantize.h"
+
+// position, normal, uv, tangent, bitangent: 56 bytes of floats
+struct TangentVertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+    float tangent[3];
+    float bitangent[3];
+};
+
+// UV sphere centred at `center`; the lower half has its V mirrored, so its
+// tangent frames are left-handed like mirrored halves of a real model
+static std::vector<TangentVertex> sphere(int segments, float radius, const float center[3]) {
+    std::vector<TangentVertex> vertices;
+    for (int ring = 0; ring <= segments; ring++) {
+        float v = ring / (float)segments;
+        float theta = v * (float)M_PI;
+        for (int seg = 0; seg <= segments; seg++) {
+            float u = seg / (float)segments;
+            float phi = u * 2.0f * (float)M_PI;
+            TangentVertex vertex;
+            float n[3] = {sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi)};
+            float t[3] = {-sinf(phi), 0.0f, cosf(phi)};
+            float handedness = ring * 2 > segments ? -1.0f : 1.0f;
+            for (int k = 0; k < 3; k++) {
+                vertex.position[k] = center[k] + n[k] * radius;
+                vertex.normal[k] = n[k];
+                vertex.tangent[k] = t[k];
+            }
+            vertex.bitangent[0] = (n[1] * t[2] - n[2] * t[1]) * handedness;
+            vertex.bitangent[1] = (n[2] * t[0] - n[0] * t[2]) * handedness;
+            vertex.bitangent[2] = (n[0] * t[1] - n[1] * t[0]) * handedness;
+            vertex.uv[0] = u * 4.0f;
+            vertex.uv[1] = handedness > 0.0f ? v : 1.0f - v;
+            vertices.push_back(vertex);
+        }
+    }
+    return vertices;
+}
+
+static void bounds(const float* positions, size_t stride, size_t count, float boundsMin[3], float boundsMax[3]) {
+    for (int k = 0; k < 3; k++) {
+        boundsMin[k] = INFINITY;
+        boundsMax[k] = -INFINITY;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const float* p = (const float*)((const char*)positions + i * stride);
+        for (int k = 0; k < 3; k++) {
+            boundsMin[k] = std::min(boundsMin[k], p[k]);
+            boundsMax[k] = std::max(boundsMax[k], p[k]);
+        }
+    }
+}
+
+// Half a step of the 16-bit grid plus float rounding in the decode, the
+// snorm16 octahedral bound (about 0.0074 degrees over the whole sphere) and
+// half a half-float ulp at the largest UV
+static bool withinBounds(const QuantizeError& error, float largestUv) {
+    float uvStep = largestUv > 0.0f ? ldexpf(1.0f, (int)floorf(log2f(largestUv)) - 10) : ldexpf(1.0f, -24);
+    return error.positionRelative <= 0.55f / 65535.0f && error.normalDegrees < 0.01f &&
+           error.tangentDegrees < 0.01f && error.bitangentDegrees < 0.02f && error.uv <= uvStep * 0.5f;
+}
+
+static float largestUv(const float* uvs, size_t stride, size_t count) {
+    float largest = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        const float* uv = (const float*)((const char*)uvs + i * stride);
+        largest = std::max(largest, std::max(fabsf(uv[0]), fabsf(uv[1])));
+    }
+    return largest;
+}
+
+static bool report(const char* name, size_t count, size_t sourceSize, size_t quantizedSize,
+                   const QuantizeError& error, double time, float uvRange) {
+    bool ok = withinBounds(error, uvRange);
+    printf("%-24.24s %8zu %5zu %5zu %5.2fx %10.3g %9.1e %9.5f %9.5f %9.5f %9.2g %7.1f  %s\n", name, count,
+           sourceSize, quantizedSize, (double)sourceSize / quantizedSize, error.position, error.positionRelative,
+           error.normalDegrees, error.tangentDegrees, error.bitangentDegrees, error.uv,
+           time > 0.0 ? count / time / 1e6 : 0.0, ok ? "ok" : "ERROR TOO LARGE");
+    return ok;
+}
+
+static bool benchStreams(const char* name, const VertexStreams& streams, size_t count, size_t sourceSize) {
+    float boundsMin[3], boundsMax[3];
+    bounds(streams.positions, streams.stride, count, boundsMin, boundsMax);
+
+    std::vector<QuantizedVertex> quantized(count);
+    std::vector<QuantizedTangent> quantizedTangents(count);
+    QuantizeError error;
+    double best = 1e9;
+    for (int run = 0; run < 3; run++) {
+        auto start = std::chrono::steady_clock::now();
+        error = quantizeVertices(quantized.data(), quantizedTangents.data(), streams, count, boundsMin, boundsMax);
+        best = std::min(best, seconds(start));
+    }
+    size_t quantizedSize = sizeof(QuantizedVertex) + (streams.tangents ? sizeof(QuantizedTangent) : 0);
+    return report(name, count, sourceSize, quantizedSize, error, best, largestUv(streams.uvs, streams.stride, count));
+}
+
+static bool benchTangentMesh(const char* name, const std::vector<TangentVertex>& vertices, bool tangents) {
+    VertexStreams streams;
+    streams.positions = vertices[0].position;
+    streams.normals = vertices[0].normal;
+    streams.uvs = vertices[0].uv;
+    if (tangents) {
+        streams.tangents = vertices[0].tangent;
+        streams.bitangents = vertices[0].bitangent;
+    }
+    streams.stride = sizeof(TangentVertex);
+    return benchStreams(name, streams, vertices.size(),
+                        tangents ? sizeof(TangentVertex) : offsetof(TangentVertex, tangent));
+}
+
+// The same frames the way glTF stores them, as a SceneVertex tangent with
+// the bitangent sign in w
+static bool benchSceneMesh(const char* name, const std::vector<TangentVertex>& vertices) {
+    std::vector<SceneVertex> scene(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const TangentVertex& v = vertices[i];
+        memcpy(scene[i].position, v.position, sizeof(v.position));
+        memcpy(scene[i].normal, v.normal, sizeof(v.normal));
+        memcpy(scene[i].uv, v.uv, sizeof(v.uv));
+        memcpy(scene[i].tangent, v.tangent, sizeof(v.tangent));
+        float cross[3] = {v.normal[1] * v.tangent[2] - v.normal[2] * v.tangent[1],
+                          v.normal[2] * v.tangent[0] - v.normal[0] * v.tangent[2],
+                          v.normal[0] * v.tangent[1] - v.normal[1] * v.tangent[0]};
+        float handedness = cross[0] * v.bitangent[0] + cross[1] * v.bitangent[1] + cross[2] * v.bitangent[2];
+        scene[i].tangent[3] = handedness < 0.0f ? -1.0f : 1.0f;
+    }
+    return benchStreams(name, sceneVertexStreams(scene.data()), scene.size(), sizeof(SceneVertex));
+}
+
+int main(int argc, char** argv) {
+    printf("%-24s %8s %5s %5s %6s %10s %9s %9s %9s %9s %9s %7s\n", "", "vertices", "bytes", "quant", "ratio",
+           "max pos", "relative", "normal", "tangent", "bitangent", "uv", "Mvert/s");
+
+    bool ok = true;
+    float origin[3] = {0.0f, 0.0f, 0.0f};
+    float far[3] = {1000.0f, 20.0f, -500.0f};
+    ok = benchTangentMesh("sphere r=1", sphere(256, 1.0f, origin), false) && ok;
+    ok = benchTangentMesh("sphere r=50 far away", sphere(256, 50.0f, far), false) && ok;
+    ok = benchTangentMesh("sphere r=1, tangents", sphere(256, 1.0f, origin), true) && ok;
+    ok = benchSceneMesh("sphere r=1, tangent.w", sphere(256, 1.0f, origin)) && ok;
+
+    for (int i = 1; i < argc; i++) {
+        Scene scene;
+        if (!sceneLoadGltf(scene, argv[i])) {
+            fprintf(stderr, "Can't load %s\n", argv[i]);
+            continue;
+        }
+        SceneView view = sceneView(scene);
+        QuantizedScene quantized;
+        auto start = std::chrono::steady_clock::now();
+        quantizeScene(quantized, view);
+        double time = seconds(start);
+
+        size_t quantizedSize = sizeof(QuantizedVertex) + sizeof(QuantizedTangent);
+        printf("%s: %zu meshes, %.2f MB -> %.2f MB\n", argv[i], view.meshCount,
+               view.vertexCount * sizeof(SceneVertex) / 1e6, view.vertexCount * quantizedSize / 1e6);
+        for (size_t m = 0; m < view.meshCount; m++) {
+            const SceneMesh& mesh = view.meshes[m];
+            char name[32];
+            snprintf(name, sizeof(name), "  mesh %zu", m);
+            float uvRange = largestUv(view.vertices[mesh.baseVertex].uv, sizeof(SceneVertex), mesh.vertexCount);
+            ok = report(name, mesh.vertexCount, sizeof(SceneVertex), quantizedSize, quantized.errors[m],
+                        m == 0 ? time : 0.0, uvRange) && ok;
+        }
+    }
+    return ok ? 0 : 1;
+}
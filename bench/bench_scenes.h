@@ -0,0 +1,153 @@
+#ifndef BENCH_SCENES_H
+#define BENCH_SCENES_H
+
+// Generated glTF scenes for the loader benchmarks
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static void appendBytes(std::vector<uint8_t>& bin, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    bin.insert(bin.end(), bytes, bytes + size);
+}
+
+// One accessor with its own buffer view over the bytes just appended to the
+// given buffer
+static void appendAccessor(std::string& views, std::string& accessors, int& index, int buffer, size_t offset,
+                           size_t bytes, size_t count, int componentType, const char* type,
+                           const char* bounds) {
+    char text[256];
+    snprintf(text, sizeof(text), "%s{\"buffer\":%d,\"byteOffset\":%zu,\"byteLength\":%zu}",
+             index ? "," : "", buffer, offset, bytes);
+    views += text;
+    snprintf(text, sizeof(text), "%s{\"bufferView\":%d,\"componentType\":%d,\"count\":%zu,\"type\":\"%s\"%s}",
+             index ? "," : "", index, componentType, count, type, bounds);
+    accessors += text;
+    index++;
+}
+
+static bool writeFile(const std::string& path, const void* data, size_t size) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && ok;
+}
+
+// `meshes` distinct spheres of slightly different radius on a grid, one node
+// each. A path ending in .gltf gets one external .bin per mesh, anything else
+// is written as a single .glb.
+static bool writeSphereScene(const std::string& path, int meshes, int segments) {
+    bool external = path.size() > 5 && path.compare(path.size() - 5, 5, ".gltf") == 0;
+    std::string stem = external ? path.substr(0, path.size() - 5) : path;
+    std::string name = stem.substr(stem.find_last_of('/') + 1);
+
+    std::vector<uint8_t> bin;
+    std::string views, accessors, meshList, nodes, buffers;
+    int accessor = 0;
+    int side = (int)ceilf(sqrtf((float)meshes));
+
+    for (int m = 0; m < meshes; m++) {
+        float radius = 0.5f + 0.4f * (m % 7) / 7.0f;
+        std::vector<float> positions, normals, uvs;
+        std::vector<uint32_t> indices;
+        for (int ring = 0; ring <= segments; ring++) {
+            float v = ring / (float)segments;
+            float theta = v * (float)M_PI;
+            // Exact poles and a seam whose two columns of vertices share
+            // positions, so the surface is closed where only the UVs differ
+            float sinTheta = ring == 0 || ring == segments ? 0.0f : sinf(theta);
+            float cosTheta = ring == 0 ? 1.0f : (ring == segments ? -1.0f : cosf(theta));
+            for (int seg = 0; seg <= segments; seg++) {
+                float u = seg / (float)segments;
+                float phi = (seg % segments) / (float)segments * 2.0f * (float)M_PI;
+                float n[3] = {sinTheta * cosf(phi), cosTheta, sinTheta * sinf(phi)};
+                for (int k = 0; k < 3; k++) {
+                    positions.push_back(n[k] * radius);
+                    normals.push_back(n[k]);
+                }
+                uvs.push_back(u);
+                uvs.push_back(v);
+            }
+        }
+        for (int ring = 0; ring < segments; ring++) {
+            for (int seg = 0; seg < segments; seg++) {
+                uint32_t a = ring * (segments + 1) + seg;
+                uint32_t b = a + segments + 1;
+                uint32_t tri[6] = {a, a + 1, b, a + 1, b + 1, b}; // counter-clockwise from outside
+                indices.insert(indices.end(), tri, tri + 6);
+            }
+        }
+
+        if (external) bin.clear();
+        int buffer = external ? m : 0;
+        size_t vertexCount = positions.size() / 3;
+        char bounds[128];
+        snprintf(bounds, sizeof(bounds), ",\"min\":[%g,%g,%g],\"max\":[%g,%g,%g]",
+                 -radius, -radius, -radius, radius, radius, radius);
+        int first = accessor;
+        size_t offset = bin.size();
+        appendBytes(bin, positions.data(), positions.size() * sizeof(float));
+        appendAccessor(views, accessors, accessor, buffer, offset, bin.size() - offset, vertexCount, 5126,
+                       "VEC3", bounds);
+        offset = bin.size();
+        appendBytes(bin, normals.data(), normals.size() * sizeof(float));
+        appendAccessor(views, accessors, accessor, buffer, offset, bin.size() - offset, vertexCount, 5126,
+                       "VEC3", "");
+        offset = bin.size();
+        appendBytes(bin, uvs.data(), uvs.size() * sizeof(float));
+        appendAccessor(views, accessors, accessor, buffer, offset, bin.size() - offset, vertexCount, 5126,
+                       "VEC2", "");
+        offset = bin.size();
+        appendBytes(bin, indices.data(), indices.size() * sizeof(uint32_t));
+        appendAccessor(views, accessors, accessor, buffer, offset, bin.size() - offset, indices.size(), 5125,
+                       "SCALAR", "");
+
+        char text[256];
+        if (external) {
+            std::string binName = name + "_" + std::to_string(m) + ".bin";
+            if (!writeFile(stem + "_" + std::to_string(m) + ".bin", bin.data(), bin.size())) return false;
+            snprintf(text, sizeof(text), "%s{\"byteLength\":%zu,\"uri\":\"%s\"}", m ? "," : "", bin.size(),
+                     binName.c_str());
+            buffers += text;
+        }
+        snprintf(text, sizeof(text),
+                 "%s{\"primitives\":[{\"attributes\":{\"POSITION\":%d,\"NORMAL\":%d,\"TEXCOORD_0\":%d},\"indices\":%d}]}",
+                 m ? "," : "", first, first + 1, first + 2, first + 3);
+        meshList += text;
+        snprintf(text, sizeof(text), "%s{\"mesh\":%d,\"translation\":[%d,0,%d]}", m ? "," : "", m,
+                 (m % side) * 2, (m / side) * 2);
+        nodes += text;
+    }
+
+    std::string sceneNodes;
+    for (int m = 0; m < meshes; m++) {
+        sceneNodes += (m ? "," : "") + std::to_string(m);
+    }
+    if (!external) {
+        buffers = "{\"byteLength\":" + std::to_string(bin.size()) + "}";
+    }
+    std::string json = "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[" + sceneNodes +
+                       "]}],\"nodes\":[" + nodes + "],\"meshes\":[" + meshList + "],\"accessors\":[" +
+                       accessors + "],\"bufferViews\":[" + views + "],\"buffers\":[" + buffers + "]}";
+    if (external) {
+        return writeFile(path, json.data(), json.size());
+    }
+
+    while (json.size() % 4) json += ' ';
+    while (bin.size() % 4) bin.push_back(0);
+    std::vector<uint8_t> glb;
+    uint32_t header[3] = {0x46546C67, 2, (uint32_t)(12 + 8 + json.size() + 8 + bin.size())};
+    uint32_t jsonChunk[2] = {(uint32_t)json.size(), 0x4E4F534A};
+    uint32_t binChunk[2] = {(uint32_t)bin.size(), 0x004E4942};
+    appendBytes(glb, header, sizeof(header));
+    appendBytes(glb, jsonChunk, sizeof(jsonChunk));
+    appendBytes(glb, json.data(), json.size());
+    appendBytes(glb, binChunk, sizeof(binChunk));
+    appendBytes(glb, bin.data(), bin.size());
+    return writeFile(path, glb.data(), glb.size());
+}
+
+#endif
@@ -0,0 +1,452 @@
+// A frame of game systems (system_scheduler.h): animation, physics,
+// transforms, lighting, particles, audio and an audio mix, as game01.cpp's
+// component types imply them, declared by what they read and write. The same
+// world is run serially in registration order and through the scheduler on the
+// job system. Both copies must end identical, or the run fails.
+//
+//   bench_scheduler [--entities N] [--frames N] [--threads N] [--trace path.json]
+//
+// --trace writes the scheduled frames as Chrome trace JSON; open it in
+// chrome://tracing or ui.perfetto.dev to see each thread's jobs.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "entity_world.h"
+#include "rng.h"
+#include "job_system.h"
+#include "system_scheduler.h"
+#include "timing.h"
+
+struct Transform {
+    float position[3];
+    float rotation[4];
+    float scale[3];
+};
+
+struct WorldMatrix {
+    float m[16];
+};
+
+struct RigidBody {
+    float velocity[3];
+    float mass;
+    float restitution;
+};
+
+struct Animator {
+    float time;
+    float speed;
+    float sway; // radians about Z this frame
+    uint32_t clip;
+};
+
+struct Light {
+    float color[3];
+    float intensity;
+    float range;
+    float received; // intensity at the camera
+};
+
+struct ParticleEmitter {
+    float rate; // particles a second
+    float accumulator;
+    uint32_t emitted;
+    float spread;
+};
+
+struct AudioSource {
+    float volume;
+    float gain; // after distance attenuation
+    float pan;
+    uint32_t clip;
+};
+
+enum {
+    TRANSFORM,
+    WORLD_MATRIX,
+    RIGID_BODY,
+    ANIMATOR,
+    LIGHT,
+    PARTICLE_EMITTER,
+    AUDIO_SOURCE,
+    COMPONENT_COUNT,
+};
+
+const ComponentMask HAS_TRANSFORM = 1u << TRANSFORM;
+const ComponentMask HAS_WORLD_MATRIX = 1u << WORLD_MATRIX;
+const ComponentMask HAS_RIGID_BODY = 1u << RIGID_BODY;
+const ComponentMask HAS_ANIMATOR = 1u << ANIMATOR;
+const ComponentMask HAS_LIGHT = 1u << LIGHT;
+const ComponentMask HAS_PARTICLE_EMITTER = 1u << PARTICLE_EMITTER;
+const ComponentMask HAS_AUDIO_SOURCE = 1u << AUDIO_SOURCE;
+
+const size_t COMPONENT_SIZES[COMPONENT_COUNT] = {
+    sizeof(Transform), sizeof(WorldMatrix),     sizeof(RigidBody),   sizeof(Animator),
+    sizeof(Light),     sizeof(ParticleEmitter), sizeof(AudioSource),
+};
+
+const float DELTA_TIME = 1.0f / 60.0f;
+const float CAMERA[3] = {0.0f, 2.0f, 0.0f};
+
+static float randomFloat(Rng& rng) {
+    return (rngNext(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Every entity has a transform and world matrix; 30% are rigid bodies, 30%
+// animated, 2% lights, 5% particle emitters and 5% sound sources
+static void buildWorld(EntityWorld& world, size_t entityCount, std::vector<EntityId>& entities) {
+    for (uint32_t c = 0; c < COMPONENT_COUNT; c++) {
+        entityRegisterComponent(world, COMPONENT_SIZES[c], alignof(float));
+    }
+    Rng rng;
+    rngSeed(rng, 23, 0);
+    entities.resize(entityCount);
+    for (size_t i = 0; i < entityCount; i++) {
+        ComponentMask mask = HAS_TRANSFORM | HAS_WORLD_MATRIX;
+        uint32_t roll = rngNext(rng) % 100;
+        if (roll < 30) {
+            mask |= HAS_RIGID_BODY;
+        } else if (roll < 60) {
+            mask |= HAS_ANIMATOR;
+        }
+        roll = rngNext(rng) % 100;
+        if (roll < 2) {
+            mask |= HAS_LIGHT;
+        } else if (roll < 7) {
+            mask |= HAS_PARTICLE_EMITTER;
+        } else if (roll < 12) {
+            mask |= HAS_AUDIO_SOURCE;
+        }
+        EntityId entity = entityCreate(world, mask);
+        entities[i] = entity;
+
+        Transform* transform = (Transform*)entityGet(world, entity, TRANSFORM);
+        for (int k = 0; k < 3; k++) {
+            transform->position[k] = randomFloat(rng) * 200.0f - 100.0f;
+            transform->scale[k] = 1.0f;
+        }
+        transform->position[1] = randomFloat(rng) * 10.0f;
+        float angle = randomFloat(rng) * 6.2831853f;
+        transform->rotation[1] = sinf(angle * 0.5f);
+        transform->rotation[3] = cosf(angle * 0.5f);
+        if (RigidBody* body = (RigidBody*)entityGet(world, entity, RIGID_BODY)) {
+            for (int k = 0; k < 3; k++) {
+                body->velocity[k] = randomFloat(rng) * 4.0f - 2.0f;
+            }
+            body->mass = 1.0f;
+            body->restitution = 0.6f;
+        }
+        if (Animator* animator = (Animator*)entityGet(world, entity, ANIMATOR)) {
+            animator->time = randomFloat(rng);
+            animator->speed = 0.5f + randomFloat(rng);
+            animator->clip = rngNext(rng) % 8;
+        }
+        if (Light* light = (Light*)entityGet(world, entity, LIGHT)) {
+            light->color[0] = randomFloat(rng);
+            light->color[1] = randomFloat(rng);
+            light->color[2] = randomFloat(rng);
+            light->intensity = 5.0f + randomFloat(rng) * 20.0f;
+            light->range = 10.0f + randomFloat(rng) * 40.0f;
+        }
+        if (ParticleEmitter* emitter = (ParticleEmitter*)entityGet(world, entity, PARTICLE_EMITTER)) {
+            emitter->rate = 10.0f + randomFloat(rng) * 100.0f;
+            emitter->spread = randomFloat(rng);
+        }
+        if (AudioSource* source = (AudioSource*)entityGet(world, entity, AUDIO_SOURCE)) {
+            source->volume = randomFloat(rng);
+            source->clip = rngNext(rng) % 16;
+        }
+    }
+}
+
+static void animate(const Archetype& archetype, EntityChunk& chunk) {
+    Animator* animators = entityColumn<Animator>(archetype, chunk, ANIMATOR);
+    for (uint32_t i = 0; i < chunk.count; i++) {
+        Animator& animator = animators[i];
+        animator.time += DELTA_TIME * animator.speed;
+        if (animator.time > 4.0f) animator.time -= 4.0f;
+        float phase = animator.time * 6.2831853f * 0.25f + animator.clip;
+        animator.sway = 0.2f * sinf(phase) + 0.05f * sinf(3.0f * phase);
+    }
+}
+
+static void integrate(const Archetype& archetype, EntityChunk& chunk) {
+    Transform* transforms = entityColumn<Transform>(archetype, chunk, TRANSFORM);
+    RigidBody* bodies = entityColumn<RigidBody>(archetype, chunk, RIGID_BODY);
+    for (uint32_t i = 0; i < chunk.count; i++) {
+        RigidBody& body = bodies[i];
+        float* position = transforms[i].position;
+        body.velocity[1] -= 9.8f * DELTA_TIME;
+        for (int k = 0; k < 3; k++) {
+            position[k] += body.velocity[k] * DELTA_TIME;
+        }
+        if (position[1] < 0.0f) {
+            position[1] = -position[1];
+            body.velocity[1] = -body.velocity[1] * body.restitution;
+        }
+    }
+}
+
+// World matrix from position, rotation and scale, swayed about Z when animated
+static void updateWorld(const Archetype& archetype, EntityChunk& chunk) {
+    const Transform* transforms = entityColumn<Transform>(archetype, chunk, TRANSFORM);
+    WorldMatrix* worlds = entityColumn<WorldMatrix>(archetype, chunk, WORLD_MATRIX);
+    const Animator* animators =
+        (archetype.mask & HAS_ANIMATOR) ? entityColumn<Animator>(archetype, chunk, ANIMATOR) : nullptr;
+    for (uint32_t i = 0; i < chunk.count; i++) {
+        const Transform& transform = transforms[i];
+        float x = transform.rotation[0], y = transform.rotation[1], z = transform.rotation[2];
+        float w = transform.rotation[3];
+        if (animators) {
+            float s = sinf(animators[i].sway * 0.5f), c = cosf(animators[i].sway * 0.5f);
+            float rx = x * c + y * s, ry = y * c - x * s, rz = w * s + z * c, rw = w * c - z * s;
+            x = rx;
+            y = ry;
+            z = rz;
+            w = rw;
+        }
+        float* m = worlds[i].m;
+        const float* scale = transform.scale;
+        m[0] = (1.0f - 2.0f * (y * y + z * z)) * scale[0];
+        m[1] = 2.0f * (x * y + z * w) * scale[0];
+        m[2] = 2.0f * (x * z - y * w) * scale[0];
+        m[3] = 0.0f;
+        m[4] = 2.0f * (x * y - z * w) * scale[1];
+        m[5] = (1.0f - 2.0f * (x * x + z * z)) * scale[1];
+        m[6] = 2.0f * (y * z + x * w) * scale[1];
+        m[7] = 0.0f;
+        m[8] = 2.0f * (x * z + y * w) * scale[2];
+        m[9] = 2.0f * (y * z - x * w) * scale[2];
+        m[10] = (1.0f - 2.0f * (x * x + y * y)) * scale[2];
+        m[11] = 0.0f;
+        m[12] = transform.position[0];
+        m[13] = transform.position[1];
+        m[14] = transform.position[2];
+        m[15] = 1.0f;
+    }
+}
+
+static float cameraDistance(const WorldMatrix& world) {
+    float dx = world.m[12] - CAMERA[0], dy = world.m[13] - CAMERA[1], dz = world.m[14] - CAMERA[2];
+    return sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+static void lightUp(const Archetype& archetype, EntityChunk& chunk) {
+    const WorldMatrix* worlds = entityColumn<WorldMatrix>(archetype, chunk, WORLD_MATRIX);
+    Light* lights = entityColumn<Light>(archetype, chunk, LIGHT);
+    for (uint32_t i = 0; i < chunk.count; i++) {
+        Light& light = lights[i];
+        float falloff = std::max(0.0f, 1.0f - cameraDistance(worlds[i]) / light.range);
+        light.received = light.intensity * falloff * falloff;
+    }
+}
+
+static void emitParticles(const Archetype& archetype, EntityChunk& chunk) {
+    const WorldMatrix* worlds = entityColumn<WorldMatrix>(archetype, chunk, WORLD_MATRIX);
+    ParticleEmitter* emitters = entityColumn<ParticleEmitter>(archetype, chunk, PARTICLE_EMITTER);
+    for (uint32_t i = 0; i < chunk.count; i++) {
+        // Far emitters spawn less, as a particle LOD would
+        ParticleEmitter& emitter = emitters[i];
+        float lod = 1.0f / (1.0f + cameraDistance(worlds[i]) * 0.05f);
+        emitter.accumulator += emitter.rate * lod * DELTA_TIME;
+        uint32_t count = (uint32_t)emitter.accumulator;
+        emitter.accumulator -= (float)count;
+        emitter.emitted += count;
+    }
+}
+
+static void placeSounds(const Archetype& archetype, EntityChunk& chunk) {
+    const WorldMatrix* worlds = entityColumn<WorldMatrix>(archetype, chunk, WORLD_MATRIX);
+    AudioSource* sources = entityColumn<AudioSource>(archetype, chunk, AUDIO_SOURCE);
+    for (uint32_t i = 0; i < chunk.count; i++) {
+        float distance = cameraDistance(worlds[i]);
+        sources[i].gain = sources[i].volume / (1.0f + distance * distance * 0.01f);
+        sources[i].pan = (worlds[i].m[12] - CAMERA[0]) / std::max(distance, 1.0f);
+    }
+}
+
+// What the mix sums over every sound source; it runs as one whole-world
+// job rather than per chunk
+struct FrameTotals {
+    double gain = 0.0;
+    double pan = 0.0;
+};
+
+static void addSystems(SystemScheduler& scheduler, FrameTotals& totals) {
+    System system;
+    system.name = "animation";
+    system.writes = HAS_ANIMATOR;
+    system.required = HAS_ANIMATOR;
+    system.eachChunk = animate;
+    schedulerAdd(scheduler, system);
+
+    system = System();
+    system.name = "physics";
+    system.writes = HAS_TRANSFORM | HAS_RIGID_BODY;
+    system.required = HAS_TRANSFORM | HAS_RIGID_BODY;
+    system.eachChunk = integrate;
+    schedulerAdd(scheduler, system);
+
+    system = System();
+    system.name = "transforms";
+    system.reads = HAS_TRANSFORM | HAS_ANIMATOR;
+    system.writes = HAS_WORLD_MATRIX;
+    system.required = HAS_TRANSFORM | HAS_WORLD_MATRIX;
+    system.eachChunk = updateWorld;
+    schedulerAdd(scheduler, system);
+
+    system = System();
+    system.name = "lighting";
+    system.reads = HAS_WORLD_MATRIX;
+    system.writes = HAS_LIGHT;
+    system.required = HAS_WORLD_MATRIX | HAS_LIGHT;
+    system.eachChunk = lightUp;
+    schedulerAdd(scheduler, system);
+
+    system = System();
+    system.name = "particles";
+    system.reads = HAS_WORLD_MATRIX;
+    system.writes = HAS_PARTICLE_EMITTER;
+    system.required = HAS_WORLD_MATRIX | HAS_PARTICLE_EMITTER;
+    system.eachChunk = emitParticles;
+    schedulerAdd(scheduler, system);
+
+    system = System();
+    system.name = "audio";
+    system.reads = HAS_WORLD_MATRIX;
+    system.writes = HAS_AUDIO_SOURCE;
+    system.required = HAS_WORLD_MATRIX | HAS_AUDIO_SOURCE;
+    system.eachChunk = placeSounds;
+    schedulerAdd(scheduler, system);
+
+    system = System();
+    system.name = "mix";
+    system.reads = HAS_AUDIO_SOURCE;
+    system.run = [&totals](EntityWorld& world) {
+        entityEachChunk(world, HAS_AUDIO_SOURCE, 0, [&totals](const Archetype& archetype, EntityChunk& chunk) {
+            const AudioSource* sources = entityColumn<AudioSource>(archetype, chunk, AUDIO_SOURCE);
+            for (uint32_t i = 0; i < chunk.count; i++) {
+                totals.gain += sources[i].gain;
+                totals.pan += sources[i].pan * sources[i].gain;
+            }
+        });
+    };
+    schedulerAdd(scheduler, system);
+}
+
+// Every component of every entity must match between the two worlds
+static bool compareWorlds(EntityWorld& a, EntityWorld& b, const std::vector<EntityId>& entities) {
+    for (EntityId entity : entities) {
+        ComponentMask mask = entityMask(a, entity);
+        if (entityMask(b, entity) != mask) return false;
+        for (uint32_t c = 0; c < COMPONENT_COUNT; c++) {
+            if (!(mask & (1u << c))) continue;
+            if (memcmp(entityGet(a, entity, c), entityGet(b, entity, c), COMPONENT_SIZES[c]) != 0) return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    size_t entityCount = 200000;
+    int frames = 60;
+    unsigned threads = 0;
+    const char* tracePath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--entities") == 0 && i + 1 < argc) {
+            entityCount = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--entities N] [--frames N] [--threads N] [--trace path.json]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    EntityWorld serialWorld, scheduledWorld;
+    std::vector<EntityId> entities;
+    buildWorld(serialWorld, entityCount, entities);
+    buildWorld(scheduledWorld, entityCount, entities);
+
+    JobSystem jobs;
+    jobSystemInit(jobs, threads);
+    SystemScheduler serial, scheduled;
+    FrameTotals serialTotals, scheduledTotals;
+    schedulerInit(serial, serialWorld, jobs);
+    schedulerInit(scheduled, scheduledWorld, jobs);
+    addSystems(serial, serialTotals);
+    addSystems(scheduled, scheduledTotals);
+    scheduled.tracing = tracePath != nullptr;
+
+    double serialTime = 0.0, scheduledTime = 0.0, serialBest = 1e30, scheduledBest = 1e30;
+    for (int frame = 0; frame < frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        schedulerRunSerial(serial);
+        double elapsed = seconds(start);
+        serialTime += elapsed;
+        serialBest = std::min(serialBest, elapsed);
+
+        start = std::chrono::steady_clock::now();
+        schedulerRun(scheduled);
+        elapsed = seconds(start);
+        scheduledTime += elapsed;
+        scheduledBest = std::min(scheduledBest, elapsed);
+    }
+
+    size_t chunkCount = 0;
+    for (const Archetype& archetype : scheduledWorld.archetypes) {
+        chunkCount += archetype.chunks.size();
+    }
+    printf("%zu entities, %zu archetypes, %zu chunks, %zu threads, %d frames\n", entityCount,
+           scheduledWorld.archetypes.size(), chunkCount, jobThreadCount(jobs), frames);
+    printf("  dependencies:");
+    for (size_t s = 0; s < scheduled.systems.size(); s++) {
+        for (uint32_t d = scheduled.dependentStarts[s]; d < scheduled.dependentStarts[s + 1]; d++) {
+            printf(" %s->%s", scheduled.systems[s].name, scheduled.systems[scheduled.dependents[d]].name);
+        }
+    }
+    printf("\n");
+    printf("  %-12s %10s %10s\n", "per frame", "mean ms", "best ms");
+    printf("  %-12s %10.3f %10.3f\n", "serial", serialTime / frames * 1000.0, serialBest * 1000.0);
+    printf("  %-12s %10.3f %10.3f   %.2fx\n", "scheduled", scheduledTime / frames * 1000.0, scheduledBest * 1000.0,
+           serialTime / scheduledTime);
+
+    if (tracePath) {
+        // Busy time over the threads' share of the frames' wall time
+        double busy = 0.0, wall = 0.0;
+        size_t jobCount = 0;
+        for (const TraceEvent& event : scheduled.trace) {
+            if (strcmp(event.name, "frame") == 0) {
+                wall += event.duration;
+            } else {
+                busy += event.duration;
+                jobCount++;
+            }
+        }
+        printf("  %.0f jobs a frame, threads busy %.0f%% of the frame\n", (double)jobCount / frames,
+               100.0 * busy / (wall * jobThreadCount(jobs)));
+        if (!schedulerWriteTrace(scheduled, tracePath)) {
+            fprintf(stderr, "Couldn't write %s\n", tracePath);
+            return -1;
+        }
+        printf("  trace written to %s\n", tracePath);
+    }
+    jobSystemShutdown(jobs);
+
+    bool ok = compareWorlds(serialWorld, scheduledWorld, entities) && serialTotals.gain == scheduledTotals.gain &&
+              serialTotals.pan == scheduledTotals.pan;
+    printf("  serial and scheduled worlds %s\n", ok ? "match" : "DIFFER");
+    entityWorldFree(serialWorld);
+    entityWorldFree(scheduledWorld);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+// Startup cost of a 200 sound bank: the old per-sample sin/fmod loop against
+// the vector oscillators, serial and on a thread pool, then a cold and a
+// warm start through the disk cache.
+//
+//   bench_sound_bank [--sounds N] [--threads T] [--cache dir]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "rng.h"
+#include "sound_bank.h"
+#include "thread_pool.h"
+#include "timing.h"
+
+const int SAMPLE_RATE = 44100;
+
+// The way generateSound() used to do it, one libm call per sample, but with
+// the phase in double so the error reported below is the oscillators' own
+static void referenceSound(const SoundDesc& desc, std::vector<float>& samples) {
+    samples.resize((size_t)(desc.duration * SAMPLE_RATE));
+    float sweep = 0.5f * (desc.freqEnd - desc.freq) / desc.duration;
+    uint32_t state = desc.noiseSeed ? desc.noiseSeed : 1;
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        float t = i / (float)SAMPLE_RATE;
+        double phase = (double)i / SAMPLE_RATE * (desc.freq + sweep * ((double)i / SAMPLE_RATE));
+        float x = (float)(phase - floor(phase));
+        float value = 0.0f;
+        switch (desc.wave) {
+            case WAVE_SINE: value = sinf(2.0f * (float)M_PI * x); break;
+            case WAVE_SQUARE: value = x < 0.5f ? 1.0f : -1.0f; break;
+            case WAVE_SAW: value = 2.0f * x - 1.0f; break;
+            case WAVE_TRIANGLE: value = 4.0f * fabsf(x - 0.5f) - 1.0f; break;
+            case WAVE_NOISE:
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                value = (state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+                break;
+        }
+
+        float env = desc.attack > 0.0f ? std::min(t / desc.attack, 1.0f) : 1.0f;
+        if (t > desc.attack) {
+            float decayed = desc.decay > 0.0f ? std::min((t - desc.attack) / desc.decay, 1.0f) : 1.0f;
+            env *= 1.0f - (1.0f - desc.sustain) * decayed;
+        }
+        if (desc.release > 0.0f) {
+            env *= std::max(std::min((desc.duration - t) / desc.release, 1.0f), 0.0f);
+        }
+        samples[i] = value * env * desc.amplitude;
+    }
+}
+
+// Game-like effects: short blips, sweeps and noise bursts, 50 ms to 1.5 s
+static SoundDesc randomSound(Rng& rng) {
+    SoundDesc desc;
+    desc.wave = (Waveform)rngRange(rng, 5);
+    desc.freq = 80.0f + rngFloat(rng) * 1800.0f;
+    desc.freqEnd = rngRange(rng, 2) ? desc.freq : 80.0f + rngFloat(rng) * 1800.0f;
+    desc.duration = 0.05f + rngFloat(rng) * 1.45f;
+    desc.amplitude = 0.2f + rngFloat(rng) * 0.6f;
+    desc.attack = rngFloat(rng) * 0.1f * desc.duration;
+    desc.decay = rngFloat(rng) * 0.3f * desc.duration;
+    desc.sustain = rngFloat(rng);
+    desc.release = rngFloat(rng) * 0.3f * desc.duration;
+    desc.noiseSeed = rngNext(rng) | 1;
+    return desc;
+}
+
+int main(int argc, char** argv) {
+    int soundCount = 200;
+    unsigned threads = 0;
+    const char* cacheDir = "bench_sound_cache";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sounds") == 0 && i + 1 < argc) {
+            soundCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--sounds N] [--threads T] [--cache dir]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    SoundBank bank;
+    bank.sampleRate = SAMPLE_RATE;
+    Rng rng;
+    rngSeed(rng, 1, 0);
+    double totalSeconds = 0.0;
+    for (int i = 0; i < soundCount; i++) {
+        SoundDesc desc = randomSound(rng);
+        totalSeconds += desc.duration;
+        soundBankAdd(bank, desc);
+    }
+
+    ThreadPool pool;
+    threadPoolInit(pool, threads);
+    printf("%d sounds, %.1f s of audio, %zu threads\n", soundCount, totalSeconds, pool.workers.size());
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<float>> reference(bank.descs.size());
+    for (size_t i = 0; i < bank.descs.size(); i++) {
+        referenceSound(bank.descs[i], reference[i]);
+    }
+    double referenceTime = seconds(start);
+
+    // Every timed build starts from empty sample buffers, so none of them
+    // gets away without allocating
+    bank.samples.clear();
+    soundBankBuild(bank, nullptr);
+    double serialTime = bank.stats.seconds;
+
+    // Worst difference to the libm reference. Square and saw are skipped: a
+    // last-bit difference in t moves their edges by a sample, which is a full
+    // step of error without being audible.
+    float maxError = 0.0f;
+    for (size_t i = 0; i < bank.descs.size(); i++) {
+        if (bank.descs[i].wave == WAVE_SQUARE || bank.descs[i].wave == WAVE_SAW) continue;
+        for (size_t j = 0; j < reference[i].size(); j++) {
+            maxError = std::max(maxError, fabsf(reference[i][j] - bank.samples[i][j]));
+        }
+    }
+
+    bank.samples.clear();
+    soundBankBuild(bank, &pool);
+    double parallelTime = bank.stats.seconds;
+
+    // Only our own cache files are cleared, the directory may be shared
+    bank.cacheDir = cacheDir;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(cacheDir, error)) {
+        if (entry.path().extension() == ".snd") {
+            std::filesystem::remove(entry.path(), error);
+        }
+    }
+    bank.samples.clear();
+    soundBankBuild(bank, &pool);
+    SoundBankStats cold = bank.stats;
+    bank.samples.clear();
+    soundBankBuild(bank, &pool);
+    SoundBankStats warm = bank.stats;
+
+    threadPoolShutdown(pool);
+
+    printf("%-28s %10s %10s\n", "", "ms", "speedup");
+    printf("%-28s %10.2f %10s\n", "reference (libm, serial)", referenceTime * 1000.0, "1.00x");
+    printf("%-28s %10.2f %9.2fx\n", "vector, serial", serialTime * 1000.0, referenceTime / serialTime);
+    printf("%-28s %10.2f %9.2fx\n", "vector, thread pool", parallelTime * 1000.0, referenceTime / parallelTime);
+    printf("%-28s %10.2f %9.2fx   %zu synthesized, %zu written\n", "cold cache", cold.seconds * 1000.0,
+           referenceTime / cold.seconds, cold.synthesized, cold.cacheWrites);
+    printf("%-28s %10.2f %9.2fx   %zu loaded, %zu synthesized\n", "warm cache", warm.seconds * 1000.0,
+           referenceTime / warm.seconds, warm.cacheHits, warm.synthesized);
+    printf("max sine/triangle/noise error vs reference %.2e (%.2f LSB at 16 bits)\n", maxError, maxError * 32767.0f);
+    return 0;
+}
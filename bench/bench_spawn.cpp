@@ -0,0 +1,311 @@
+// Spawning and despawning bullets at tens of thousands a second, three ways:
+// game01.cpp's bare int ids over a flat array with a component mask and a
+// free list, a sparse-set ComponentPool with generational handles
+// (component_pool.h), and the archetype world (entity_world.h). Each frame
+// moves every bullet, despawning the ones whose life runs out as it goes,
+// then spawns a new wave. A turret keeps the handle of one bullet from each wave and looks all
+// of them up every frame; with int ids a dead bullet's id picks up whatever
+// reused its slot, and with handles every lookup has to agree with when the
+// bullet actually died, or the run fails.
+//
+//   bench_spawn [--frames N] [--spawn per-frame] [--life max-frames] [--others N]
+//
+// The bullets share the world with --others long-lived entities (props,
+// characters), made first, as they would in a level.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "component_pool.h"
+#include "entity_world.h"
+#include "rng.h"
+#include "timing.h"
+
+struct Bullet {
+    float position[3];
+    float velocity[3];
+    int32_t life; // frames left
+};
+
+const float DELTA_TIME = 1.0f / 60.0f;
+const int MIN_LIFE = 30;
+
+struct SpawnConfig {
+    int frames = 600;
+    int spawnCount = 1000;
+    int maxLife = 120;
+    int others = 100000;
+};
+
+// Both the turret's handles and its ground truth: the frame its bullet dies
+struct Tracked {
+    uint32_t handle;
+    int deathFrame;
+};
+
+struct SpawnRun {
+    double update = 0.0; // moving every bullet and despawning the dead
+    double spawn = 0.0;
+    size_t spawned = 0;
+    size_t despawned = 0;
+    size_t peak = 0;
+    size_t staleLookups = 0; // dead bullets looked up
+    size_t wrongLookups = 0; // ...that found a live bullet anyway
+    double positionSum = 0.0;
+    size_t live = 0;
+};
+
+static Bullet makeBullet(Rng& rng, int maxLife) {
+    Bullet bullet;
+    for (int k = 0; k < 3; k++) {
+        bullet.position[k] = 0.0f;
+        bullet.velocity[k] = (rngNext(rng) >> 8) * (100.0f / 16777216.0f) - 50.0f;
+    }
+    bullet.life = MIN_LIFE + (int32_t)(rngNext(rng) % (uint32_t)(maxLife - MIN_LIFE + 1));
+    return bullet;
+}
+
+static void moveBullet(Bullet& bullet) {
+    for (int k = 0; k < 3; k++) {
+        bullet.position[k] += bullet.velocity[k] * DELTA_TIME;
+    }
+    bullet.life--;
+}
+
+static void finish(SpawnRun& run, const Bullet* bullets, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        run.positionSum += bullets[i].position[0] + bullets[i].position[1] + bullets[i].position[2];
+    }
+    run.live = count;
+}
+
+// game01.cpp's way: an entity is an int indexing every component array, its
+// mask says what it has, and destroyed ids go on a free list for reuse
+static void runInts(SpawnRun& run, const SpawnConfig& config) {
+    struct Entity {
+        int id;
+        unsigned int component_mask;
+    };
+    const unsigned int HAS_BULLET = 1;
+    const unsigned int HAS_TRANSFORM = 2;
+    std::vector<Entity> entities;
+    std::vector<Bullet> bullets;
+    for (int i = 0; i < config.others; i++) {
+        entities.push_back({i, HAS_TRANSFORM});
+        bullets.push_back(Bullet());
+    }
+    std::vector<int> freeIds;
+    std::vector<Tracked> tracked;
+    Rng rng;
+    rngSeed(rng, 22, 0);
+    size_t live = 0;
+    for (int frame = 0; frame < config.frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < entities.size(); i++) {
+            if (!(entities[i].component_mask & HAS_BULLET)) continue;
+            moveBullet(bullets[i]);
+            if (bullets[i].life > 0) continue;
+            entities[i].component_mask = 0;
+            freeIds.push_back((int)i);
+            live--;
+            run.despawned++;
+        }
+        run.update += seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        for (int s = 0; s < config.spawnCount; s++) {
+            int id;
+            if (!freeIds.empty()) {
+                id = freeIds.back();
+                freeIds.pop_back();
+            } else {
+                id = (int)entities.size();
+                entities.push_back({id, 0});
+                bullets.push_back(Bullet());
+            }
+            entities[id].component_mask = HAS_BULLET;
+            bullets[id] = makeBullet(rng, config.maxLife);
+            if (s == 0) tracked.push_back({(uint32_t)id, frame + bullets[id].life});
+        }
+        live += config.spawnCount;
+        run.spawned += config.spawnCount;
+        run.spawn += seconds(start);
+        run.peak = std::max(run.peak, live);
+
+        for (const Tracked& target : tracked) {
+            if (frame < target.deathFrame) continue;
+            run.staleLookups++;
+            if (entities[target.handle].component_mask & HAS_BULLET) run.wrongLookups++;
+        }
+    }
+    std::vector<Bullet> alive;
+    for (size_t i = 0; i < entities.size(); i++) {
+        if (entities[i].component_mask & HAS_BULLET) alive.push_back(bullets[i]);
+    }
+    finish(run, alive.data(), alive.size());
+}
+
+static bool runPool(SpawnRun& run, const SpawnConfig& config) {
+    // Every bullet alive at once, and the slots the handles can reach
+    size_t capacity = (size_t)config.spawnCount * config.maxLife;
+    size_t maxEntities = config.others + capacity + 2 * ENTITY_MIN_FREE_INDICES;
+    EntityHandles handles;
+    handles.generations.reserve(maxEntities);
+    for (int i = 0; i < config.others; i++) {
+        entityHandleCreate(handles);
+    }
+    ComponentPool pool;
+    if (!componentPoolInit(pool, sizeof(Bullet), capacity, maxEntities)) return false;
+    const void* storage = pool.storage;
+    const uint32_t* sparse = pool.sparse.data();
+    const uint16_t* generations = handles.generations.data();
+
+    std::vector<Tracked> tracked;
+    Rng rng;
+    rngSeed(rng, 22, 0);
+    for (int frame = 0; frame < config.frames; frame++) {
+        // Backwards, so the bullet swapped into a freed spot was already moved
+        auto start = std::chrono::steady_clock::now();
+        Bullet* bullets = componentPoolData<Bullet>(pool);
+        for (uint32_t i = pool.count; i-- > 0;) {
+            moveBullet(bullets[i]);
+            if (bullets[i].life > 0) continue;
+            EntityId entity = pool.entities[i];
+            componentPoolRemove(pool, entity);
+            entityHandleDestroy(handles, entity);
+            run.despawned++;
+        }
+        run.update += seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        for (int s = 0; s < config.spawnCount; s++) {
+            EntityId entity = entityHandleCreate(handles);
+            Bullet* bullet = (Bullet*)componentPoolAdd(pool, entity);
+            *bullet = makeBullet(rng, config.maxLife);
+            if (s == 0) tracked.push_back({entity, frame + bullet->life});
+        }
+        run.spawned += config.spawnCount;
+        run.spawn += seconds(start);
+        run.peak = std::max(run.peak, (size_t)pool.count);
+
+        for (const Tracked& target : tracked) {
+            bool dead = frame >= target.deathFrame;
+            run.staleLookups += dead;
+            if ((componentPoolGet(pool, target.handle) != nullptr) == dead) run.wrongLookups++;
+        }
+    }
+    finish(run, componentPoolData<Bullet>(pool), pool.count);
+    bool stable = pool.storage == storage && pool.sparse.data() == sparse &&
+                  handles.generations.data() == generations && pool.dropped == 0;
+    componentPoolFree(pool);
+    return stable;
+}
+
+static void runArchetypes(SpawnRun& run, const SpawnConfig& config) {
+    EntityWorld world;
+    uint32_t bulletComponent = entityRegisterComponent(world, sizeof(Bullet), alignof(Bullet));
+    uint32_t transformComponent = entityRegisterComponent(world, 16 * sizeof(float), alignof(float));
+    ComponentMask hasBullet = 1u << bulletComponent;
+    for (int i = 0; i < config.others; i++) {
+        entityCreate(world, 1u << transformComponent);
+    }
+    std::vector<Tracked> tracked;
+    std::vector<EntityId> expired;
+    Rng rng;
+    rngSeed(rng, 22, 0);
+    for (int frame = 0; frame < config.frames; frame++) {
+        // Chunks can't change while they're walked, so the dead are listed first
+        auto start = std::chrono::steady_clock::now();
+        expired.clear();
+        entityEachChunk(world, hasBullet, 0, [&](const Archetype& archetype, EntityChunk& chunk) {
+            Bullet* bullets = entityColumn<Bullet>(archetype, chunk, bulletComponent);
+            const EntityId* ids = entityChunkIds(chunk);
+            for (uint32_t i = 0; i < chunk.count; i++) {
+                moveBullet(bullets[i]);
+                if (bullets[i].life <= 0) expired.push_back(ids[i]);
+            }
+        });
+        for (EntityId entity : expired) {
+            entityDestroy(world, entity);
+        }
+        run.despawned += expired.size();
+        run.update += seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        for (int s = 0; s < config.spawnCount; s++) {
+            EntityId entity = entityCreate(world, hasBullet);
+            Bullet* bullet = (Bullet*)entityGet(world, entity, bulletComponent);
+            *bullet = makeBullet(rng, config.maxLife);
+            if (s == 0) tracked.push_back({entity, frame + bullet->life});
+        }
+        run.spawned += config.spawnCount;
+        run.spawn += seconds(start);
+        run.peak = std::max(run.peak, world.count - config.others);
+
+        for (const Tracked& target : tracked) {
+            bool dead = frame >= target.deathFrame;
+            run.staleLookups += dead;
+            if (entityAlive(world, target.handle) == dead) run.wrongLookups++;
+        }
+    }
+    std::vector<Bullet> alive;
+    entityEachChunk(world, hasBullet, 0, [&](const Archetype& archetype, EntityChunk& chunk) {
+        const Bullet* bullets = entityColumn<Bullet>(archetype, chunk, bulletComponent);
+        alive.insert(alive.end(), bullets, bullets + chunk.count);
+    });
+    finish(run, alive.data(), alive.size());
+    entityWorldFree(world);
+}
+
+int main(int argc, char** argv) {
+    SpawnConfig config;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            config.frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spawn") == 0 && i + 1 < argc) {
+            config.spawnCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--life") == 0 && i + 1 < argc) {
+            config.maxLife = std::max(atoi(argv[++i]), MIN_LIFE);
+        } else if (strcmp(argv[i], "--others") == 0 && i + 1 < argc) {
+            config.others = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--frames N] [--spawn per-frame] [--life max-frames] [--others N]\n",
+                    argv[0]);
+            return -1;
+        }
+    }
+
+    SpawnRun ints, pool, archetypes;
+    runInts(ints, config);
+    bool stable = runPool(pool, config);
+    runArchetypes(archetypes, config);
+
+    int frames = config.frames;
+    printf("%d frames, %d bullets spawned a frame (%.0f a second at 60 Hz), lives %d-%d frames, peak %zu live "
+           "among %d other entities\n",
+           frames, config.spawnCount, config.spawnCount * 60.0, MIN_LIFE, config.maxLife, pool.peak, config.others);
+    printf("  %-22s %10s %10s %10s %16s\n", "per frame", "update ms", "spawn ms", "ns/spawn", "wrong lookups");
+    const SpawnRun* runs[] = {&ints, &pool, &archetypes};
+    const char* names[] = {"int ids, flat arrays", "handles, sparse set", "handles, archetypes"};
+    for (int r = 0; r < 3; r++) {
+        const SpawnRun& run = *runs[r];
+        printf("  %-22s %10.3f %10.3f %10.1f %8zu of %zu\n", names[r], run.update / frames * 1000.0,
+               run.spawn / frames * 1000.0, run.spawn / std::max<size_t>(run.spawned, 1) * 1e9, run.wrongLookups,
+               run.staleLookups);
+    }
+    printf("  sparse set reallocated after setup: %s\n", stable ? "no" : "YES");
+
+    bool same = true;
+    for (const SpawnRun* run : {&pool, &archetypes}) {
+        same = same && run->live == ints.live && run->despawned == ints.despawned &&
+               fabs(run->positionSum - ints.positionSum) <= 1e-6 * (1.0 + fabs(ints.positionSum));
+    }
+    bool ok = same && stable && pool.wrongLookups == 0 && archetypes.wrongLookups == 0;
+    printf("  %zu live at the end in every run: %s\n", ints.live, ok ? "match" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+// World transforms of many animated rigs (transform_hierarchy.h):
+// cgltf_node_transform_world on every node, which walks each node's parent
+// chain, against one forward pass over the flattened hierarchy, over all of
+// it and over only the subtrees the animation touched. Each joint also
+// places one draw, so the frame's draw copies and BVH refit are timed too.
+// Every world matrix is compared with cgltf's, so a pass that reads a stale
+// parent fails the run.
+//
+//   bench_transforms [--rigs N] [--animated percent] [--frames N]
+//
+// Each rig has 100 joints: a spine, two arms and a head off its top, and two
+// legs off the hips, 41 deep at the fingertips.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <cgltf/cgltf.h>
+
+#include "scene_bvh.h"
+#include "scene_loader.h"
+#include "timing.h"
+#include "transform_hierarchy.h"
+
+const int RIG_JOINTS = 100;
+
+struct Rigs {
+    std::vector<cgltf_node> nodes;
+    std::vector<cgltf_node*> children;
+    std::vector<int32_t> parents;
+    int count = 0;
+};
+
+// Chains of joints, each `length` long, hanging off `parent` (a joint index
+// within the rig, -1 for the rig's root) and stepping along `step`
+struct RigChain {
+    int parent;
+    int length;
+    float step[3];
+};
+
+static void buildRigs(Rigs& rigs, int count) {
+    const RigChain chains[] = {
+        {-1, 1, {0.0f, 1.0f, 0.0f}},    // hips
+        {0, 20, {0.0f, 0.05f, 0.0f}},   // spine, joints 1-20
+        {20, 20, {0.05f, 0.0f, 0.0f}},  // left arm
+        {20, 20, {-0.05f, 0.0f, 0.0f}}, // right arm
+        {20, 9, {0.0f, 0.03f, 0.0f}},   // head
+        {0, 15, {0.03f, -0.06f, 0.0f}}, // left leg
+        {0, 15, {-0.03f, -0.06f, 0.0f}},
+    };
+    std::vector<int32_t> rigParents;
+    std::vector<const float*> steps;
+    for (const RigChain& chain : chains) {
+        for (int j = 0; j < chain.length; j++) {
+            rigParents.push_back(j ? (int32_t)rigParents.size() - 1 : chain.parent);
+            steps.push_back(chain.step);
+        }
+    }
+
+    size_t total = (size_t)count * RIG_JOINTS;
+    rigs.count = count;
+    rigs.nodes.assign(total, cgltf_node());
+    rigs.parents.resize(total);
+    int side = (int)ceilf(sqrtf((float)count));
+    for (int r = 0; r < count; r++) {
+        for (int j = 0; j < RIG_JOINTS; j++) {
+            size_t i = (size_t)r * RIG_JOINTS + j;
+            cgltf_node& node = rigs.nodes[i];
+            rigs.parents[i] = rigParents[j] < 0 ? -1 : (int32_t)(r * RIG_JOINTS + rigParents[j]);
+            node.parent = rigParents[j] < 0 ? nullptr : &rigs.nodes[rigs.parents[i]];
+            node.has_translation = 1;
+            node.has_rotation = 1;
+            node.rotation[3] = 1.0f;
+            memcpy(node.translation, steps[j], sizeof(node.translation));
+            if (j == 0) {
+                node.translation[0] = (r % side) * 2.0f;
+                node.translation[2] = (r / side) * 2.0f;
+            }
+        }
+    }
+
+    // Children lists, as cgltf keeps them
+    std::vector<size_t> childCounts(total, 0);
+    for (size_t i = 0; i < total; i++) {
+        if (rigs.parents[i] >= 0) childCounts[rigs.parents[i]]++;
+    }
+    rigs.children.resize(total);
+    size_t start = 0;
+    for (size_t i = 0; i < total; i++) {
+        rigs.nodes[i].children = rigs.children.data() + start;
+        start += childCounts[i];
+    }
+    for (size_t i = 0; i < total; i++) {
+        if (rigs.parents[i] < 0) continue;
+        cgltf_node& parent = rigs.nodes[rigs.parents[i]];
+        parent.children[parent.children_count++] = &rigs.nodes[i];
+    }
+}
+
+// Every joint of an animated rig bends a little about Z, by frame
+static void animate(Rigs& rigs, TransformHierarchy& hierarchy, int animatedRigs, int frame) {
+    for (int r = 0; r < animatedRigs; r++) {
+        for (int j = 1; j < RIG_JOINTS; j++) {
+            size_t i = (size_t)r * RIG_JOINTS + j;
+            cgltf_node& node = rigs.nodes[i];
+            float angle = 0.05f * sinf(frame * 0.1f + j * 0.3f + r);
+            node.rotation[2] = sinf(angle * 0.5f);
+            node.rotation[3] = cosf(angle * 0.5f);
+            float local[16];
+            cgltf_node_transform_local(&node, local);
+            transformSetLocal(hierarchy, (uint32_t)i, local);
+        }
+    }
+}
+
+// Largest difference from cgltf's own world matrices
+static float compareWorlds(const Rigs& rigs, const TransformHierarchy& hierarchy) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < rigs.nodes.size(); i++) {
+        float expected[16];
+        cgltf_node_transform_world(&rigs.nodes[i], expected);
+        const float* world = transformWorld(hierarchy, (uint32_t)i);
+        for (int k = 0; k < 16; k++) {
+            worst = std::max(worst, fabsf(world[k] - expected[k]) / (1.0f + fabsf(expected[k])));
+        }
+    }
+    return worst;
+}
+
+int main(int argc, char** argv) {
+    int rigCount = 1000;
+    int animatedPercent = 25;
+    int frames = 32;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rigs") == 0 && i + 1 < argc) {
+            rigCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--animated") == 0 && i + 1 < argc) {
+            animatedPercent = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--rigs N] [--animated percent] [--frames N]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    Rigs rigs;
+    buildRigs(rigs, rigCount);
+    size_t nodeCount = rigs.nodes.size();
+    std::vector<float> locals(nodeCount * 16);
+    for (size_t i = 0; i < nodeCount; i++) {
+        cgltf_node_transform_local(&rigs.nodes[i], &locals[i * 16]);
+    }
+    TransformHierarchy hierarchy;
+    auto start = std::chrono::steady_clock::now();
+    transformHierarchyBuild(hierarchy, rigs.parents.data(), locals.data(), nodeCount);
+    double buildTime = seconds(start);
+    int animatedRigs = rigCount * animatedPercent / 100;
+    size_t animatedNodes = (size_t)animatedRigs * RIG_JOINTS;
+    printf("%d rigs, %zu nodes, %d%% animated (%zu nodes): hierarchy built in %.2f ms\n", rigCount, nodeCount,
+           animatedPercent, animatedNodes, buildTime * 1000.0);
+
+    // A box per joint, drawn where the joint is
+    Scene scene;
+    SceneMesh bone = {};
+    for (int k = 0; k < 3; k++) {
+        bone.boundsMin[k] = -0.02f;
+        bone.boundsMax[k] = 0.02f;
+    }
+    scene.meshes.push_back(bone);
+    scene.draws.resize(nodeCount);
+    for (size_t i = 0; i < nodeCount; i++) {
+        scene.draws[i].mesh = 0;
+        scene.draws[i].node = (uint32_t)i;
+        memcpy(scene.draws[i].world, transformWorld(hierarchy, (uint32_t)i), sizeof(scene.draws[i].world));
+    }
+    transformBindDraws(hierarchy, scene.draws.data(), scene.draws.size());
+    SceneView view = sceneView(scene);
+    SceneBvh bvh;
+    sceneBvhBuild(bvh, view);
+
+    // Each path over the same frames of animation. cgltf recomputes every
+    // node, or just the animated rigs' when the caller tracks them.
+    std::vector<float> worlds(nodeCount * 16);
+    double cgltfAll = 0.0, cgltfAnimated = 0.0, fullPass = 0.0, marking = 0.0, dirtyPass = 0.0, drawTime = 0.0;
+    std::vector<uint32_t> moved;
+    size_t rangeCount = 0, rebuilds = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        start = std::chrono::steady_clock::now();
+        animate(rigs, hierarchy, animatedRigs, frame);
+        marking += seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nodeCount; i++) {
+            cgltf_node_transform_world(&rigs.nodes[i], &worlds[i * 16]);
+        }
+        cgltfAll += seconds(start);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < animatedNodes; i++) {
+            cgltf_node_transform_world(&rigs.nodes[i], &worlds[i * 16]);
+        }
+        cgltfAnimated += seconds(start);
+
+        start = std::chrono::steady_clock::now();
+        transformUpdate(hierarchy);
+        dirtyPass += seconds(start);
+        rangeCount += hierarchy.updated.size();
+
+        start = std::chrono::steady_clock::now();
+        transformApplyToDraws(hierarchy, scene.draws.data(), moved);
+        rebuilds += sceneBvhRefitDraws(bvh, view, moved.data(), moved.size());
+        drawTime += seconds(start);
+    }
+    float dirtyError = compareWorlds(rigs, hierarchy);
+
+    // The same pass over everything, every root marked. cgltf runs first
+    // again, untimed, so the pass finds the caches as cold as above.
+    for (int frame = 0; frame < frames; frame++) {
+        for (uint32_t n = 0; n < nodeCount; n += RIG_JOINTS) {
+            transformSetLocal(hierarchy, n, &locals[n * 16]);
+        }
+        for (size_t i = 0; i < nodeCount; i++) {
+            cgltf_node_transform_world(&rigs.nodes[i], &worlds[i * 16]);
+        }
+        start = std::chrono::steady_clock::now();
+        transformUpdate(hierarchy);
+        fullPass += seconds(start);
+    }
+    float fullError = compareWorlds(rigs, hierarchy);
+
+    printf("  %-32s %10s %12s\n", "per frame", "ms", "ns/node");
+    printf("  %-32s %10.3f %12.1f\n", "cgltf_node_transform_world, all", cgltfAll / frames * 1000.0,
+           cgltfAll / frames / nodeCount * 1e9);
+    printf("  %-32s %10.3f %12.1f\n", "cgltf_node_transform_world, anim", cgltfAnimated / frames * 1000.0,
+           cgltfAnimated / frames / std::max<size_t>(animatedNodes, 1) * 1e9);
+    printf("  %-32s %10.3f %12.1f\n", "flat pass, all", fullPass / frames * 1000.0,
+           fullPass / frames / nodeCount * 1e9);
+    printf("  %-32s %10.3f %12.1f   %.1f ranges\n", "flat pass, dirty subtrees", dirtyPass / frames * 1000.0,
+           dirtyPass / frames / std::max<size_t>(animatedNodes, 1) * 1e9, (double)rangeCount / frames);
+    printf("  %-32s %10.3f\n", "setting animated locals", marking / frames * 1000.0);
+    printf("  %-32s %10.3f   %zu draws, %zu rebuilds\n", "draw copies + BVH refit", drawTime / frames * 1000.0,
+           moved.size(), rebuilds);
+
+    const float tolerance = 1e-4f;
+    bool ok = dirtyError <= tolerance && fullError <= tolerance;
+    printf("  largest difference from cgltf: %.2e dirty, %.2e full, %s\n", dirtyError, fullError,
+           ok ? "match" : "MISMATCH");
+    return ok ? 0 : 1;
+}
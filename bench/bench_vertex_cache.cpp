@@ -0,0 +1,164 @@
+// ACMR/ATVR and vertex overfetch of the import-time reordering in
+// mesh_optimize.h on generated meshes and on the glTF files given on the
+// command line, with the optimizer's throughput and a check that every
+// triangle survives with its winding.
+//
+//   bench_vertex_cache [file.glb ...]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "mesh_optimize.h"
+#include "rng.h"
+#include "scene_loader.h"
+#include "timing.h"
+
+struct Mesh {
+    std::vector<SceneVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// size x size quads, rows emitted left to right like most exporters do
+static Mesh gridMesh(int size) {
+    Mesh mesh;
+    for (int y = 0; y <= size; y++) {
+        for (int x = 0; x <= size; x++) {
+            SceneVertex v = {};
+            v.position[0] = (float)x;
+            v.position[1] = (float)y;
+            v.normal[2] = 1.0f;
+            mesh.vertices.push_back(v);
+        }
+    }
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            uint32_t a = y * (size + 1) + x;
+            uint32_t b = a + size + 1;
+            uint32_t quad[6] = {a, a + 1, b, b, a + 1, b + 1};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+// Triangles in random order, vertices shuffled too: the worst an exporter
+// can reasonably hand us
+static Mesh shuffledMesh(Mesh mesh, uint64_t seed) {
+    Rng rng;
+    rngSeed(rng, seed, 0);
+    size_t triangles = mesh.indices.size() / 3;
+    for (size_t t = triangles - 1; t > 0; t--) {
+        size_t other = rngRange(rng, (uint32_t)(t + 1));
+        for (int k = 0; k < 3; k++) std::swap(mesh.indices[t * 3 + k], mesh.indices[other * 3 + k]);
+    }
+    std::vector<uint32_t> order(mesh.vertices.size());
+    for (size_t v = 0; v < order.size(); v++) order[v] = (uint32_t)v;
+    for (size_t v = order.size() - 1; v > 0; v--) {
+        std::swap(order[v], order[rngRange(rng, (uint32_t)(v + 1))]);
+    }
+    std::vector<SceneVertex> vertices(mesh.vertices.size());
+    for (size_t v = 0; v < order.size(); v++) vertices[order[v]] = mesh.vertices[v];
+    for (uint32_t& index : mesh.indices) index = order[index];
+    mesh.vertices.swap(vertices);
+    return mesh;
+}
+
+// Each triangle as its three positions, rotated to start at the smallest one
+// so equal triangles compare equal without changing their winding
+static std::vector<std::array<float, 9>> triangleSet(const Mesh& mesh) {
+    std::vector<std::array<float, 9>> set(mesh.indices.size() / 3);
+    for (size_t t = 0; t < set.size(); t++) {
+        const uint32_t* tri = &mesh.indices[t * 3];
+        int first = 0;
+        for (int k = 1; k < 3; k++) {
+            if (memcmp(mesh.vertices[tri[k]].position, mesh.vertices[tri[first]].position, 12) < 0) first = k;
+        }
+        for (int k = 0; k < 3; k++) {
+            memcpy(&set[t][k * 3], mesh.vertices[tri[(first + k) % 3]].position, 12);
+        }
+    }
+    std::sort(set.begin(), set.end());
+    return set;
+}
+
+// Bytes pulled into a small LRU of 64-byte lines by the vertices the FIFO
+// cache misses, over the bytes of the vertices referenced: 1 means every
+// line of vertex data was read exactly once
+static double overfetch(const Mesh& mesh) {
+    const int lineSize = 64;
+    const size_t lineCount = 64;
+    std::vector<uint32_t> loadedAt(mesh.vertices.size(), 0);
+    std::vector<uint64_t> lines; // most recently used last
+    uint32_t time = VERTEX_CACHE_SIZE + 1;
+    size_t fetched = 0;
+    for (uint32_t v : mesh.indices) {
+        if (time - loadedAt[v] <= (uint32_t)VERTEX_CACHE_SIZE) continue;
+        loadedAt[v] = time++;
+        size_t begin = v * sizeof(SceneVertex) / lineSize;
+        size_t end = ((v + 1) * sizeof(SceneVertex) - 1) / lineSize;
+        for (uint64_t line = begin; line <= end; line++) {
+            auto found = std::find(lines.begin(), lines.end(), line);
+            if (found != lines.end()) {
+                lines.erase(found);
+            } else {
+                fetched += lineSize;
+                if (lines.size() == lineCount) lines.erase(lines.begin());
+            }
+            lines.push_back(line);
+        }
+    }
+    VertexCacheStats stats = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    return (double)fetched / (stats.vertices * sizeof(SceneVertex));
+}
+
+static void benchMesh(const char* name, const Mesh& source) {
+    Mesh mesh = source;
+    VertexCacheStats before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+    auto start = std::chrono::steady_clock::now();
+    optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(),
+                        mesh.vertices[0].position, sizeof(SceneVertex));
+    double cacheTime = seconds(start);
+    start = std::chrono::steady_clock::now();
+    optimizeVertexFetch(mesh.vertices.data(), mesh.vertices.size(), sizeof(SceneVertex), mesh.indices.data(),
+                        mesh.indices.size());
+    double fetchTime = seconds(start);
+
+    VertexCacheStats after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    bool intact = triangleSet(source) == triangleSet(mesh);
+
+    double fetchBefore = overfetch(source);
+    double fetchAfter = overfetch(mesh);
+
+    printf("%-22s %9zu %7.3f %7.3f %7.3f %7.3f %9.2f %9.2f %8.1f %8.1f  %s\n", name, before.triangles,
+           vertexCacheAcmr(before), vertexCacheAcmr(after), vertexCacheAtvr(before), vertexCacheAtvr(after),
+           fetchBefore, fetchAfter, before.triangles / cacheTime / 1e6, mesh.vertices.size() / fetchTime / 1e6,
+           intact ? "ok" : "TRIANGLES CHANGED");
+}
+
+int main(int argc, char** argv) {
+    printf("FIFO cache of %d vertices\n", VERTEX_CACHE_SIZE);
+    printf("%-22s %9s %7s %7s %7s %7s %9s %9s %8s %8s\n", "", "triangles", "ACMR", "after", "ATVR", "after",
+           "overfetch", "after", "Mtri/s", "Mvert/s");
+
+    Mesh grid = gridMesh(256);
+    benchMesh("grid 256x256", grid);
+    benchMesh("grid, shuffled", shuffledMesh(grid, 1));
+    Mesh small = gridMesh(32);
+    benchMesh("grid 32x32, shuffled", shuffledMesh(small, 2));
+
+    for (int i = 1; i < argc; i++) {
+        Scene scene;
+        if (!sceneLoadGltf(scene, argv[i])) continue;
+        // The loader already optimized; its stats hold the exporter's order
+        const SceneStats& stats = scene.stats;
+        printf("%-22.22s %9zu %7.3f %7.3f %7.3f %7.3f %9s %9s %8s %8s  (as imported)\n", argv[i],
+               stats.cacheBefore.triangles, vertexCacheAcmr(stats.cacheBefore), vertexCacheAcmr(stats.cacheAfter),
+               vertexCacheAtvr(stats.cacheBefore), vertexCacheAtvr(stats.cacheAfter), "-", "-", "-", "-");
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+#ifndef UNIFORM_CACHE_H
+#define UNIFORM_CACHE_H
+
+#include <GL/glew.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+
+// Reflects a linked program's active uniforms once into a flat hash table so
+// per-frame uniform sets never pass a string to the driver:
+//
+//     UniformCache uniforms;
+//     uniformCacheBuild(uniforms, program);               // once, after link
+//     glUniformMatrix4fv(uniformLocation(uniforms, UNIFORM("uMVP")), 1, GL_FALSE, mvp);
+//
+// UNIFORM() hashes the name at compile time; the lookup is a masked index
+// into the table plus, on a collision, a few linear probes.
+
+// 32-bit FNV-1a, usable in constant expressions
+constexpr uint32_t uniformHash(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (; *name; name++) {
+        hash = (hash ^ (uint8_t)*name) * 16777619u;
+    }
+    return hash;
+}
+
+// Forces the hash to be a compile-time constant even at -O0
+#define UNIFORM(name) (std::integral_constant<uint32_t, uniformHash(name)>::value)
+
+const int UNIFORM_TABLE_SIZE = 64; // power of two, at least twice the uniforms we expect
+
+struct UniformEntry {
+    uint32_t hash;
+    GLint location; // -1 marks an empty slot
+    GLenum type;
+    GLint size;     // array length, 1 for plain uniforms
+};
+
+struct UniformCache {
+    GLuint program = 0;
+    int count = 0;
+    UniformEntry entries[UNIFORM_TABLE_SIZE];
+};
+
+// Every string-based query against GL made through this header. Snapshot it
+// around a frame to check the frame made none; that only holds if all code
+// looks uniforms up by name through uniformLocationByName.
+struct UniformStats {
+    unsigned long stringLookups = 0;
+    unsigned long hashedLookups = 0;
+    unsigned long misses = 0;
+};
+
+// One instance shared by every translation unit that includes this header
+inline UniformStats uniformStats;
+
+// The one glGetUniformLocation call site, so uniformStats sees every lookup
+static inline GLint uniformLocationByName(GLuint program, const char* name) {
+    uniformStats.stringLookups++;
+    return glGetUniformLocation(program, name);
+}
+
+static void uniformCacheBuild(UniformCache& cache, GLuint program) {
+    cache.program = program;
+    cache.count = 0;
+    for (UniformEntry& entry : cache.entries) {
+        entry.location = -1;
+    }
+
+    GLint active = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &active);
+
+    char name[256];
+    for (GLint i = 0; i < active; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, sizeof(name), &length, &size, &type, name);
+        uniformStats.stringLookups++;
+        GLint location = uniformLocationByName(program, name);
+        if (location < 0) continue; // lives in a uniform block
+
+        // Arrays are reported as "name[0]"; look them up by the bare name
+        if (length > 3 && strcmp(name + length - 3, "[0]") == 0) {
+            name[length - 3] = '\0';
+        }
+        if (cache.count * 2 >= UNIFORM_TABLE_SIZE) {
+            fprintf(stderr, "Uniform cache full, skipping %s\n", name);
+            continue;
+        }
+
+        uint32_t hash = uniformHash(name);
+        int slot = hash & (UNIFORM_TABLE_SIZE - 1);
+        while (cache.entries[slot].location >= 0 && cache.entries[slot].hash != hash) {
+            slot = (slot + 1) & (UNIFORM_TABLE_SIZE - 1);
+        }
+        // Two names with one hash would both resolve to the first location
+        if (cache.entries[slot].location >= 0) {
+            fprintf(stderr, "Uniform hash collision, skipping %s\n", name);
+            continue;
+        }
+        cache.entries[slot] = {hash, location, type, size};
+        cache.count++;
+    }
+}
+
+// -1 when the program has no such active uniform, which glUniform* ignores
+static inline GLint uniformLocation(const UniformCache& cache, uint32_t hash) {
+    uniformStats.hashedLookups++;
+    int slot = hash & (UNIFORM_TABLE_SIZE - 1);
+    while (cache.entries[slot].location >= 0) {
+        if (cache.entries[slot].hash == hash) {
+            return cache.entries[slot].location;
+        }
+        slot = (slot + 1) & (UNIFORM_TABLE_SIZE - 1);
+    }
+    uniformStats.misses++;
+    return -1;
+}
+
+#endif
@@ -0,0 +1,221 @@
+#include "audio_mixer.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+static size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+bool mixerInit(Mixer& mixer, int sampleRate, size_t blockFrames, int voices) {
+    mixerFree(mixer);
+
+    // Whole vectors only, so the kernels never need a masked tail on the output
+    blockFrames = roundUp(blockFrames ? blockFrames : MIXER_SIMD_WIDTH, MIXER_SIMD_WIDTH);
+    size_t bufferBytes = roundUp(blockFrames * sizeof(float), MIXER_ALIGN);
+
+    void* storage = aligned_alloc(MIXER_ALIGN, bufferBytes * 2);
+    if (!storage) return false;
+    memset(storage, 0, bufferBytes * 2);
+
+    mixer.sampleRate = sampleRate;
+    mixer.blockFrames = blockFrames;
+    mixer.left = (float*)storage;
+    mixer.right = (float*)((char*)storage + bufferBytes);
+    mixer.storage = storage;
+    mixer.voices.assign(voices, MixerVoice());
+    return true;
+}
+
+void mixerFree(Mixer& mixer) {
+    for (MixerSound& sound : mixer.sounds) {
+        free(sound.samples);
+    }
+    free(mixer.storage);
+    mixer = Mixer();
+}
+
+int mixerAddSound(Mixer& mixer, const float* samples, size_t frames) {
+    // Padded with silence to a whole vector so unaligned loads near the end
+    // of the sound stay inside the allocation
+    size_t bytes = roundUp(roundUp(frames, MIXER_SIMD_WIDTH) * sizeof(float), MIXER_ALIGN);
+    float* copy = (float*)aligned_alloc(MIXER_ALIGN, bytes ? bytes : MIXER_ALIGN);
+    if (!copy) return -1;
+    memset(copy, 0, bytes);
+    memcpy(copy, samples, frames * sizeof(float));
+
+    MixerSound sound;
+    sound.samples = copy;
+    sound.frames = frames;
+    mixer.sounds.push_back(sound);
+    return (int)mixer.sounds.size() - 1;
+}
+
+// A free voice if there is one, otherwise the oldest voice playing the
+// lowest priority sound at or below `priority`. Null when the request loses.
+static MixerVoice* pickVoice(Mixer& mixer, int priority) {
+    MixerVoice* victim = nullptr;
+    for (MixerVoice& voice : mixer.voices) {
+        if (!voice.active) return &voice;
+        if (voice.priority > priority) continue;
+        if (!victim || voice.priority < victim->priority ||
+            (voice.priority == victim->priority && voice.startedAt < victim->startedAt)) {
+            victim = &voice;
+        }
+    }
+    return victim;
+}
+
+MixerPlayResult mixerPlay(Mixer& mixer, int sound, float gain, float pan, int priority) {
+    MixerVoice* voice = pickVoice(mixer, priority);
+    if (!voice) return MIXER_DROPPED;
+    MixerPlayResult result = voice->active ? MIXER_STOLE : MIXER_PLAYED;
+
+    pan = fminf(fmaxf(pan, -1.0f), 1.0f);
+    float angle = (pan + 1.0f) * (float)M_PI / 4.0f;
+
+    voice->sound = sound;
+    voice->position = 0;
+    voice->gainLeft = gain * cosf(angle);
+    voice->gainRight = gain * sinf(angle);
+    voice->priority = priority;
+    voice->startedAt = mixer.playCounter++;
+    voice->active = true;
+    return result;
+}
+
+int mixerActiveVoices(const Mixer& mixer) {
+    int active = 0;
+    for (const MixerVoice& voice : mixer.voices) {
+        active += voice.active;
+    }
+    return active;
+}
+
+// left/right are aligned and start at the block, the source is read from the
+// voice's position so its loads are unaligned
+static void mixVoice(float* left, float* right, const float* src, size_t frames,
+                     float gainLeft, float gainRight) {
+    size_t i = 0;
+
+#if defined(CGLM_AVX_FP)
+    __m256 gl = _mm256_set1_ps(gainLeft);
+    __m256 gr = _mm256_set1_ps(gainRight);
+    for (; i + 8 <= frames; i += 8) {
+        __m256 s = _mm256_loadu_ps(src + i);
+        glmm_store256(left + i, _mm256_add_ps(glmm_load256(left + i), _mm256_mul_ps(s, gl)));
+        glmm_store256(right + i, _mm256_add_ps(glmm_load256(right + i), _mm256_mul_ps(s, gr)));
+    }
+#elif defined(CGLM_SSE_FP)
+    __m128 gl = _mm_set1_ps(gainLeft);
+    __m128 gr = _mm_set1_ps(gainRight);
+    for (; i + 4 <= frames; i += 4) {
+        __m128 s = _mm_loadu_ps(src + i);
+        glmm_store(left + i, _mm_add_ps(glmm_load(left + i), _mm_mul_ps(s, gl)));
+        glmm_store(right + i, _mm_add_ps(glmm_load(right + i), _mm_mul_ps(s, gr)));
+    }
+#endif
+    for (; i < frames; i++) {
+        left[i] += src[i] * gainLeft;
+        right[i] += src[i] * gainRight;
+    }
+}
+
+void mixerMix(Mixer& mixer, size_t frames) {
+    if (frames > mixer.blockFrames) frames = mixer.blockFrames;
+    memset(mixer.left, 0, mixer.blockFrames * sizeof(float));
+    memset(mixer.right, 0, mixer.blockFrames * sizeof(float));
+
+    for (MixerVoice& voice : mixer.voices) {
+        if (!voice.active) continue;
+        const MixerSound& sound = mixer.sounds[voice.sound];
+        size_t n = sound.frames - voice.position;
+        if (n > frames) n = frames;
+
+        mixVoice(mixer.left, mixer.right, sound.samples + voice.position, n,
+                 voice.gainLeft, voice.gainRight);
+        voice.position += n;
+        mixer.voiceFramesMixed += n;
+        if (voice.position == sound.frames) {
+            voice.active = false;
+        }
+    }
+    mixer.framesMixed += frames;
+}
+
+void mixerToPcm16(const Mixer& mixer, size_t frames, int16_t* interleaved) {
+    size_t i = 0;
+
+#if defined(CGLM_SSE2_FP)
+    __m128 lo = _mm_set1_ps(-1.0f);
+    __m128 hi = _mm_set1_ps(1.0f);
+    __m128 scale = _mm_set1_ps(32767.0f);
+    for (; i + 4 <= frames; i += 4) {
+        __m128 l = _mm_mul_ps(_mm_min_ps(_mm_max_ps(glmm_load(mixer.left + i), lo), hi), scale);
+        __m128 r = _mm_mul_ps(_mm_min_ps(_mm_max_ps(glmm_load(mixer.right + i), lo), hi), scale);
+        __m128i li = _mm_cvtps_epi32(l);
+        __m128i ri = _mm_cvtps_epi32(r);
+        // l0 r0 l1 r1 | l2 r2 l3 r3, packed down to 16 bits
+        __m128i pcm = _mm_packs_epi32(_mm_unpacklo_epi32(li, ri), _mm_unpackhi_epi32(li, ri));
+        _mm_storeu_si128((__m128i*)(interleaved + i * 2), pcm);
+    }
+#endif
+    for (; i < frames; i++) {
+        interleaved[i * 2] = (int16_t)lrintf(fminf(fmaxf(mixer.left[i], -1.0f), 1.0f) * 32767.0f);
+        interleaved[i * 2 + 1] = (int16_t)lrintf(fminf(fmaxf(mixer.right[i], -1.0f), 1.0f) * 32767.0f);
+    }
+}
+
+static void writeLe16(FILE* file, uint16_t value) {
+    unsigned char bytes[2] = {(unsigned char)value, (unsigned char)(value >> 8)};
+    fwrite(bytes, 1, 2, file);
+}
+
+static void writeLe32(FILE* file, uint32_t value) {
+    unsigned char bytes[4] = {(unsigned char)value, (unsigned char)(value >> 8),
+                              (unsigned char)(value >> 16), (unsigned char)(value >> 24)};
+    fwrite(bytes, 1, 4, file);
+}
+
+static void writeWavHeader(WavFile& wav) {
+    uint16_t blockAlign = (uint16_t)(wav.channels * 2);
+    fwrite("RIFF", 1, 4, wav.file);
+    writeLe32(wav.file, 36 + wav.dataBytes);
+    fwrite("WAVEfmt ", 1, 8, wav.file);
+    writeLe32(wav.file, 16);
+    writeLe16(wav.file, 1); // PCM
+    writeLe16(wav.file, (uint16_t)wav.channels);
+    writeLe32(wav.file, (uint32_t)wav.sampleRate);
+    writeLe32(wav.file, (uint32_t)wav.sampleRate * blockAlign);
+    writeLe16(wav.file, blockAlign);
+    writeLe16(wav.file, 16);
+    fwrite("data", 1, 4, wav.file);
+    writeLe32(wav.file, wav.dataBytes);
+}
+
+bool wavOpen(WavFile& wav, const char* path, int sampleRate, int channels) {
+    wav.file = fopen(path, "wb");
+    if (!wav.file) return false;
+    wav.sampleRate = sampleRate;
+    wav.channels = channels;
+    wav.dataBytes = 0;
+    writeWavHeader(wav);
+    return true;
+}
+
+// Samples are written as they are in memory, which is the little-endian
+// layout WAV wants on every platform we build for
+void wavWrite(WavFile& wav, const int16_t* samples, size_t frames) {
+    size_t count = frames * wav.channels;
+    fwrite(samples, sizeof(int16_t), count, wav.file);
+    wav.dataBytes += (uint32_t)(count * sizeof(int16_t));
+}
+
+void wavClose(WavFile& wav) {
+    if (!wav.file) return;
+    fseek(wav.file, 0, SEEK_SET);
+    writeWavHeader(wav);
+    fclose(wav.file);
+    wav = WavFile();
+}
@@ -0,0 +1,92 @@
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <cglm/common.h>
+#include <cglm/simd/intrin.h>
+
+// Same ISA selection as the particle pool: 8-wide AVX, 4-wide SSE or scalar
+#if defined(CGLM_AVX_FP)
+#  define MIXER_SIMD_WIDTH 8
+#  define MIXER_ALIGN 32
+#elif defined(CGLM_SSE_FP)
+#  define MIXER_SIMD_WIDTH 4
+#  define MIXER_ALIGN 16
+#else
+#  define MIXER_SIMD_WIDTH 1
+#  define MIXER_ALIGN 16
+#endif
+
+// Mono float samples in [-1, 1]
+struct MixerSound {
+    float* samples = nullptr;
+    size_t frames = 0;
+};
+
+struct MixerVoice {
+    int sound = -1;
+    size_t position = 0;  // next frame of the sound to mix
+    float gainLeft = 0.0f;
+    float gainRight = 0.0f;
+    int priority = 0;
+    uint64_t startedAt = 0; // play order, oldest voice is stolen first
+    bool active = false;
+};
+
+enum MixerPlayResult {
+    MIXER_PLAYED,
+    MIXER_STOLE,  // played by cutting off another voice
+    MIXER_DROPPED // every voice is busy with a higher priority sound
+};
+
+// Mixes up to `blockFrames` stereo frames at a time into planar left/right
+// float buffers. Voices only start at block boundaries. Not thread safe:
+// one thread owns the mixer.
+struct Mixer {
+    int sampleRate = 0;
+    size_t blockFrames = 0;
+    float* left = nullptr;
+    float* right = nullptr;
+    void* storage = nullptr;
+    std::vector<MixerSound> sounds;
+    std::vector<MixerVoice> voices;
+    uint64_t playCounter = 0;
+    uint64_t framesMixed = 0;
+    uint64_t voiceFramesMixed = 0; // sum over voices of the frames each contributed
+};
+
+bool mixerInit(Mixer& mixer, int sampleRate, size_t blockFrames, int voices);
+void mixerFree(Mixer& mixer);
+
+// Copies the samples in and returns the sound id, or -1 when out of memory
+int mixerAddSound(Mixer& mixer, const float* samples, size_t frames);
+
+// Starts `sound` with constant-power panning, pan -1 is hard left and 1 hard
+// right. A full mixer steals the oldest voice of the lowest priority that is
+// not above `priority`.
+MixerPlayResult mixerPlay(Mixer& mixer, int sound, float gain, float pan, int priority);
+int mixerActiveVoices(const Mixer& mixer);
+
+// Mixes the next `frames` (at most blockFrames) into mixer.left/right
+void mixerMix(Mixer& mixer, size_t frames);
+
+// Clamps the last mix and interleaves it into 16-bit stereo PCM
+void mixerToPcm16(const Mixer& mixer, size_t frames, int16_t* interleaved);
+
+// Minimal 16-bit PCM WAV writer. The header sizes are patched on close.
+struct WavFile {
+    FILE* file = nullptr;
+    int sampleRate = 0;
+    int channels = 0;
+    uint32_t dataBytes = 0;
+};
+
+bool wavOpen(WavFile& wav, const char* path, int sampleRate, int channels);
+void wavWrite(WavFile& wav, const int16_t* samples, size_t frames);
+void wavClose(WavFile& wav);
+
+#endif
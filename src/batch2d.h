@@ -0,0 +1,175 @@
+#ifndef BATCH2D_H
+#define BATCH2D_H
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Per-frame counters for driver-side work. The render loop zeroes these at
+// the start of a frame and reads them back after the flush.
+//
+// Every glBufferData allocates fresh storage, so it counts as an alloc even
+// when the size hasn't changed. Streaming buffers call it on purpose each
+// frame: the old storage is orphaned, and the driver hands over a new block
+// rather than making the upload wait for last frame's draws to finish
+// reading. The renderers built on these stats refer back here for that.
+struct FrameStats {
+    int drawCalls = 0;
+    int bufferAllocs = 0;   // glGen* and glBufferData calls
+    int bufferUploads = 0;  // calls that copy data into a buffer
+};
+
+// Attribute locations the batch shader must use
+const GLuint BATCH_ATTRIB_POSITION = 0;
+const GLuint BATCH_ATTRIB_COLOR = 1;
+
+struct BatchVertex {
+    float x, y;
+    float r, g, b, a;
+};
+
+struct BatchCommand {
+    GLenum mode;
+    GLint first;
+    GLsizei count;
+};
+
+// One long-lived VAO and a streaming VBO. Lines, quads, fans and points are
+// collected on the CPU during the frame and submitted by batchFlush(), which
+// merges consecutive submissions of the same primitive type into one draw.
+struct Batch2D {
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLsizeiptr capacity = 0; // bytes of VBO storage
+    std::vector<BatchVertex> vertices;
+    std::vector<BatchCommand> commands;
+};
+
+static void batchInit(Batch2D& batch, size_t initialVertices, FrameStats& stats) {
+    batch.capacity = initialVertices * sizeof(BatchVertex);
+    batch.vertices.reserve(initialVertices);
+
+    glGenVertexArrays(1, &batch.vao);
+    glGenBuffers(1, &batch.vbo);
+    glBindVertexArray(batch.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, batch.vbo);
+    glBufferData(GL_ARRAY_BUFFER, batch.capacity, NULL, GL_STREAM_DRAW);
+    stats.bufferAllocs += 3;
+
+    glVertexAttribPointer(BATCH_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex),
+                          (void*)offsetof(BatchVertex, x));
+    glEnableVertexAttribArray(BATCH_ATTRIB_POSITION);
+    glVertexAttribPointer(BATCH_ATTRIB_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(BatchVertex),
+                          (void*)offsetof(BatchVertex, r));
+    glEnableVertexAttribArray(BATCH_ATTRIB_COLOR);
+
+    glBindVertexArray(0);
+}
+
+static void batchDestroy(Batch2D& batch) {
+    glDeleteVertexArrays(1, &batch.vao);
+    glDeleteBuffers(1, &batch.vbo);
+    batch.vao = batch.vbo = 0;
+    batch.capacity = 0;
+}
+
+static void batchBegin(Batch2D& batch) {
+    batch.vertices.clear();
+    batch.commands.clear();
+}
+
+// Appends `count` vertices worth of `mode` primitives, extending the previous
+// command when it has the same mode. Only list modes are batched, so
+// adjacent runs can always be joined.
+static BatchVertex* batchReserve(Batch2D& batch, GLenum mode, GLsizei count) {
+    GLint first = (GLint)batch.vertices.size();
+    if (!batch.commands.empty() && batch.commands.back().mode == mode) {
+        batch.commands.back().count += count;
+    } else {
+        batch.commands.push_back({mode, first, count});
+    }
+    batch.vertices.resize(first + count);
+    return &batch.vertices[first];
+}
+
+static void batchLine(Batch2D& batch, float x0, float y0, float x1, float y1,
+                      const float* color, float alpha = 1.0f) {
+    BatchVertex* v = batchReserve(batch, GL_LINES, 2);
+    v[0] = {x0, y0, color[0], color[1], color[2], alpha};
+    v[1] = {x1, y1, color[0], color[1], color[2], alpha};
+}
+
+static void batchQuad(Batch2D& batch, float x0, float y0, float x1, float y1,
+                      const float* color, float alpha = 1.0f) {
+    BatchVertex* v = batchReserve(batch, GL_TRIANGLES, 6);
+    BatchVertex a = {x0, y0, color[0], color[1], color[2], alpha};
+    BatchVertex b = {x1, y0, color[0], color[1], color[2], alpha};
+    BatchVertex c = {x1, y1, color[0], color[1], color[2], alpha};
+    BatchVertex d = {x0, y1, color[0], color[1], color[2], alpha};
+    v[0] = a; v[1] = b; v[2] = c;
+    v[3] = a; v[4] = c; v[5] = d;
+}
+
+// Triangle fan over `count` xy pairs, expanded to a triangle list so it can
+// share a draw call with quads.
+static void batchFan(Batch2D& batch, const float* points, int count,
+                     const float* color, float alpha = 1.0f) {
+    if (count < 3) return;
+    BatchVertex* v = batchReserve(batch, GL_TRIANGLES, (count - 2) * 3);
+    for (int i = 1; i < count - 1; i++) {
+        *v++ = {points[0], points[1], color[0], color[1], color[2], alpha};
+        *v++ = {points[i * 2], points[i * 2 + 1], color[0], color[1], color[2], alpha};
+        *v++ = {points[i * 2 + 2], points[i * 2 + 3], color[0], color[1], color[2], alpha};
+    }
+}
+
+static void batchCircle(Batch2D& batch, float cx, float cy, float radius, int segments,
+                        const float* color, float alpha = 1.0f) {
+    BatchVertex* v = batchReserve(batch, GL_TRIANGLES, segments * 3);
+    float prevX = cx + radius;
+    float prevY = cy;
+    for (int i = 1; i <= segments; i++) {
+        float angle = 2.0f * M_PI * i / segments;
+        float x = cx + radius * cos(angle);
+        float y = cy + radius * sin(angle);
+        *v++ = {cx, cy, color[0], color[1], color[2], alpha};
+        *v++ = {prevX, prevY, color[0], color[1], color[2], alpha};
+        *v++ = {x, y, color[0], color[1], color[2], alpha};
+        prevX = x;
+        prevY = y;
+    }
+}
+
+static void batchPoint(Batch2D& batch, float x, float y, float r, float g, float b, float alpha) {
+    BatchVertex* v = batchReserve(batch, GL_POINTS, 1);
+    *v = {x, y, r, g, b, alpha};
+}
+
+// Uploads the frame's vertices with one buffer update and issues one draw per
+// primitive run. The caller binds the program.
+static void batchFlush(Batch2D& batch, FrameStats& stats) {
+    if (batch.vertices.empty()) return;
+
+    GLsizeiptr bytes = batch.vertices.size() * sizeof(BatchVertex);
+    glBindVertexArray(batch.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, batch.vbo);
+    if (bytes > batch.capacity) {
+        batch.capacity = std::max(bytes, batch.capacity * 2);
+    }
+    // Orphaned every flush (see FrameStats)
+    glBufferData(GL_ARRAY_BUFFER, batch.capacity, NULL, GL_STREAM_DRAW);
+    stats.bufferAllocs++;
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, batch.vertices.data());
+    stats.bufferUploads++;
+
+    for (const BatchCommand& cmd : batch.commands) {
+        glDrawArrays(cmd.mode, cmd.first, cmd.count);
+        stats.drawCalls++;
+    }
+
+    glBindVertexArray(0);
+}
+
+#endif
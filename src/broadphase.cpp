@@ -0,0 +1,305 @@
+#include "broadphase.h"
+
+#include <algorithm>
+
+static const uint64_t PAIR_EMPTY = ~0ull;
+
+// Ties put mins first, so touching boxes overlap
+static bool endpointLess(const BroadphaseEndpoint& a, const BroadphaseEndpoint& b) {
+    return a.value < b.value || (a.value == b.value && (a.body & BROADPHASE_MAX_BIT) < (b.body & BROADPHASE_MAX_BIT));
+}
+
+// With every axis sorted, endpoint order matches value order, so comparing
+// positions tests overlap on that axis
+static bool overlapsOn(const Broadphase& broadphase, uint32_t a, uint32_t b, int axis) {
+    const uint32_t* ends = &broadphase.positions[a * 6 + axis * 2];
+    const uint32_t* others = &broadphase.positions[b * 6 + axis * 2];
+    return (ends[0] < others[1]) & (others[0] < ends[1]);
+}
+
+// Where an endpoint sits, from its BroadphaseEndpoint::body
+static uint32_t& positionOf(Broadphase& broadphase, int axis, uint32_t endpoint) {
+    return broadphase.positions[(endpoint & ~BROADPHASE_MAX_BIT) * 6 + axis * 2 + (endpoint >> 31)];
+}
+
+static uint64_t pairKey(uint32_t a, uint32_t b) {
+    return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+static size_t pairHome(uint64_t key, size_t mask) {
+    return (size_t)((key * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+}
+
+// The key's slot, or the empty slot where it would go
+static size_t findPairSlot(const Broadphase& broadphase, uint64_t key) {
+    size_t mask = broadphase.pairKeys.size() - 1;
+    size_t slot = pairHome(key, mask);
+    while (broadphase.pairKeys[slot] != key && broadphase.pairKeys[slot] != PAIR_EMPTY) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Kept at most half full
+static void growPairTable(Broadphase& broadphase) {
+    size_t size = std::max<size_t>(1024, broadphase.pairKeys.size() * 2);
+    broadphase.pairKeys.assign(size, PAIR_EMPTY);
+    broadphase.pairIndices.resize(size);
+    for (size_t i = 0; i < broadphase.pairs.size(); i++) {
+        uint64_t key = pairKey(broadphase.pairs[i].a, broadphase.pairs[i].b);
+        size_t slot = findPairSlot(broadphase, key);
+        broadphase.pairKeys[slot] = key;
+        broadphase.pairIndices[slot] = (uint32_t)i;
+    }
+}
+
+static void addPair(Broadphase& broadphase, uint32_t a, uint32_t b) {
+    if ((broadphase.pairs.size() + 1) * 2 > broadphase.pairKeys.size()) growPairTable(broadphase);
+    uint64_t key = pairKey(a, b);
+    size_t slot = findPairSlot(broadphase, key);
+    if (broadphase.pairKeys[slot] == key) return;
+    broadphase.pairKeys[slot] = key;
+    broadphase.pairIndices[slot] = (uint32_t)broadphase.pairs.size();
+    broadphase.pairs.push_back({std::min(a, b), std::max(a, b)});
+    broadphase.stats.pairsAdded++;
+}
+
+static void removePair(Broadphase& broadphase, uint32_t a, uint32_t b) {
+    if (broadphase.pairs.empty()) return;
+    uint64_t key = pairKey(a, b);
+    size_t slot = findPairSlot(broadphase, key);
+    if (broadphase.pairKeys[slot] != key) return;
+    uint32_t index = broadphase.pairIndices[slot];
+
+    // Shift later entries of the probe run back over the hole, so lookups
+    // never stop early at it
+    size_t mask = broadphase.pairKeys.size() - 1;
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; broadphase.pairKeys[next] != PAIR_EMPTY; next = (next + 1) & mask) {
+        size_t home = pairHome(broadphase.pairKeys[next], mask);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            broadphase.pairKeys[hole] = broadphase.pairKeys[next];
+            broadphase.pairIndices[hole] = broadphase.pairIndices[next];
+            hole = next;
+        }
+    }
+    broadphase.pairKeys[hole] = PAIR_EMPTY;
+
+    BroadphasePair last = broadphase.pairs.back();
+    broadphase.pairs.pop_back();
+    if (index < broadphase.pairs.size()) {
+        broadphase.pairs[index] = last;
+        broadphase.pairIndices[findPairSlot(broadphase, pairKey(last.a, last.b))] = index;
+    }
+    broadphase.stats.pairsRemoved++;
+}
+
+// Insertion sort of one axis. Moving endpoint e left past p changes whether
+// their bodies overlap on this axis exactly when one is a min and the other
+// a max; the other two axes decide whether that makes or breaks a pair.
+static void sortAxis(Broadphase& broadphase, int axis) {
+    std::vector<BroadphaseEndpoint>& ends = broadphase.axes[axis];
+    int second = (axis + 1) % 3, third = (axis + 2) % 3;
+    size_t swaps = 0;
+    for (size_t i = 1; i < ends.size(); i++) {
+        BroadphaseEndpoint moving = ends[i];
+        if (!endpointLess(moving, ends[i - 1])) continue;
+        uint32_t body = moving.body & ~BROADPHASE_MAX_BIT;
+        bool isMax = (moving.body & BROADPHASE_MAX_BIT) != 0;
+        size_t j = i;
+        do {
+            BroadphaseEndpoint passed = ends[j - 1];
+            uint32_t other = passed.body & ~BROADPHASE_MAX_BIT;
+            bool otherMax = (passed.body & BROADPHASE_MAX_BIT) != 0;
+            // A min passing a max starts an overlap on this axis, a max passing
+            // a min ends one; either way only a pair that overlaps on the
+            // other two axes changes. Tested without branching: the answer
+            // is nearly always no, but which half is no is unpredictable.
+            if ((isMax != otherMax) & overlapsOn(broadphase, body, other, second) &
+                overlapsOn(broadphase, body, other, third)) {
+                if (isMax) {
+                    removePair(broadphase, body, other);
+                } else {
+                    addPair(broadphase, body, other);
+                }
+            }
+            ends[j] = passed;
+            broadphase.positions[other * 6 + axis * 2 + otherMax] = (uint32_t)j;
+            j--;
+            swaps++;
+        } while (j > 0 && endpointLess(moving, ends[j - 1]));
+        ends[j] = moving;
+        broadphase.positions[body * 6 + axis * 2 + isMax] = (uint32_t)j;
+    }
+    broadphase.stats.swaps += swaps;
+}
+
+// Drops the removed bodies' pairs, and their endpoints from each axis
+// keeping the others' order, so no pair's overlap changes
+static void removeBodies(Broadphase& broadphase) {
+    for (size_t i = broadphase.pairs.size(); i-- > 0;) {
+        BroadphasePair pair = broadphase.pairs[i];
+        if (broadphase.bodies[pair.a].removed || broadphase.bodies[pair.b].removed) {
+            removePair(broadphase, pair.a, pair.b);
+        }
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        std::vector<BroadphaseEndpoint>& ends = broadphase.axes[axis];
+        size_t write = 0;
+        for (size_t read = 0; read < ends.size(); read++) {
+            BroadphaseEndpoint end = ends[read];
+            uint32_t body = end.body & ~BROADPHASE_MAX_BIT;
+            if (broadphase.bodies[body].removed) continue;
+            if (write != read) {
+                ends[write] = end;
+                positionOf(broadphase, axis, end.body) = (uint32_t)write;
+            }
+            write++;
+        }
+        ends.resize(write);
+    }
+    for (uint32_t body : broadphase.removing) {
+        for (int axis = 0; axis < 3; axis++) {
+            broadphase.positions[body * 6 + axis * 2] = BROADPHASE_NONE;
+            broadphase.positions[body * 6 + axis * 2 + 1] = BROADPHASE_NONE;
+        }
+    }
+}
+
+// Merges the new bodies' endpoints into each axis, then sweeps the first
+// axis once for the pairs that involve a new body
+static void insertBodies(Broadphase& broadphase) {
+    for (int axis = 0; axis < 3; axis++) {
+        std::vector<BroadphaseEndpoint>& merging = broadphase.merging;
+        merging.clear();
+        for (uint32_t body : broadphase.inserting) {
+            const BroadphaseBody& entry = broadphase.bodies[body];
+            if (entry.removed) continue;
+            merging.push_back({entry.min[axis], body});
+            merging.push_back({entry.max[axis], body | BROADPHASE_MAX_BIT});
+        }
+        std::sort(merging.begin(), merging.end(), endpointLess);
+
+        // From the back, so the old endpoints move at most once
+        std::vector<BroadphaseEndpoint>& ends = broadphase.axes[axis];
+        size_t old = ends.size();
+        ends.resize(old + merging.size());
+        size_t write = ends.size();
+        size_t fromOld = old, fromNew = merging.size();
+        while (fromNew > 0) {
+            BroadphaseEndpoint next;
+            if (fromOld > 0 && endpointLess(merging[fromNew - 1], ends[fromOld - 1])) {
+                next = ends[--fromOld];
+            } else {
+                next = merging[--fromNew];
+            }
+            write--;
+            ends[write] = next;
+            positionOf(broadphase, axis, next.body) = (uint32_t)write;
+        }
+    }
+    for (uint32_t body : broadphase.inserting) {
+        if (!broadphase.bodies[body].removed) {
+            broadphase.bodies[body].fresh = true;
+            broadphase.stats.inserted++;
+        }
+    }
+
+    // Old pairs are already known, so a new body tests every open box and an
+    // old one only the open new ones
+    std::vector<uint32_t>& active = broadphase.active;
+    std::vector<uint32_t>& activeFresh = broadphase.activeFresh;
+    std::vector<uint32_t>& slots = broadphase.activeSlots;
+    active.clear();
+    activeFresh.clear();
+    slots.resize(broadphase.bodies.size() * 2);
+    for (const BroadphaseEndpoint& end : broadphase.axes[0]) {
+        uint32_t body = end.body & ~BROADPHASE_MAX_BIT;
+        bool fresh = broadphase.bodies[body].fresh;
+        if (end.body & BROADPHASE_MAX_BIT) {
+            uint32_t slot = slots[body * 2];
+            active[slot] = active.back();
+            slots[active[slot] * 2] = slot;
+            active.pop_back();
+            if (fresh) {
+                slot = slots[body * 2 + 1];
+                activeFresh[slot] = activeFresh.back();
+                slots[activeFresh[slot] * 2 + 1] = slot;
+                activeFresh.pop_back();
+            }
+            continue;
+        }
+        for (uint32_t other : fresh ? active : activeFresh) {
+            if (overlapsOn(broadphase, body, other, 1) & overlapsOn(broadphase, body, other, 2)) {
+                addPair(broadphase, body, other);
+            }
+        }
+        slots[body * 2] = (uint32_t)active.size();
+        active.push_back(body);
+        if (fresh) {
+            slots[body * 2 + 1] = (uint32_t)activeFresh.size();
+            activeFresh.push_back(body);
+        }
+    }
+    for (uint32_t body : broadphase.inserting) {
+        broadphase.bodies[body].fresh = false;
+    }
+}
+
+uint32_t broadphaseAdd(Broadphase& broadphase, const float min[3], const float max[3]) {
+    uint32_t body;
+    if (!broadphase.freeBodies.empty()) {
+        body = broadphase.freeBodies.back();
+        broadphase.freeBodies.pop_back();
+    } else {
+        body = (uint32_t)broadphase.bodies.size();
+        broadphase.bodies.emplace_back();
+        broadphase.positions.resize(broadphase.bodies.size() * 6, BROADPHASE_NONE);
+    }
+    BroadphaseBody& entry = broadphase.bodies[body];
+    for (int axis = 0; axis < 3; axis++) {
+        entry.min[axis] = min[axis];
+        entry.max[axis] = max[axis];
+    }
+    entry.removed = false;
+    entry.fresh = false;
+    broadphase.inserting.push_back(body);
+    return body;
+}
+
+void broadphaseRemove(Broadphase& broadphase, uint32_t body) {
+    BroadphaseBody& entry = broadphase.bodies[body];
+    if (entry.removed) return;
+    entry.removed = true;
+    broadphase.removing.push_back(body);
+}
+
+void broadphaseMove(Broadphase& broadphase, uint32_t body, const float min[3], const float max[3]) {
+    BroadphaseBody& entry = broadphase.bodies[body];
+    for (int axis = 0; axis < 3; axis++) {
+        entry.min[axis] = min[axis];
+        entry.max[axis] = max[axis];
+    }
+    if (broadphase.positions[body * 6] == BROADPHASE_NONE) return;
+    for (int axis = 0; axis < 3; axis++) {
+        broadphase.axes[axis][broadphase.positions[body * 6 + axis * 2]].value = min[axis];
+        broadphase.axes[axis][broadphase.positions[body * 6 + axis * 2 + 1]].value = max[axis];
+    }
+}
+
+void broadphaseUpdate(Broadphase& broadphase) {
+    broadphase.stats = BroadphaseStats();
+    if (!broadphase.removing.empty()) removeBodies(broadphase);
+    for (int axis = 0; axis < 3; axis++) {
+        sortAxis(broadphase, axis);
+    }
+    if (!broadphase.inserting.empty()) insertBodies(broadphase);
+    broadphase.inserting.clear();
+
+    // Only now, so a body added and removed before this update stays out
+    for (uint32_t body : broadphase.removing) {
+        broadphase.freeBodies.push_back(body);
+    }
+    broadphase.stats.removed = broadphase.removing.size();
+    broadphase.removing.clear();
+}
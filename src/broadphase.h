@@ -0,0 +1,86 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sweep-and-prune broadphase over the world boxes of physics bodies (the
+// Collider / Rigid_Body pairs of game01.cpp). Each axis keeps every body's
+// min and max endpoints sorted. An update re-sorts them by insertion sort,
+// which is close to linear when bodies move little between steps, and each
+// time one body's min passes another's max the pair is added or dropped,
+// so the overlapping pairs are patched in place instead of found afresh.
+//
+// Bodies added since the last update are merged in with one sort and sweep
+// rather than walked in from the end of each axis, and removed ones are
+// compacted out, their pairs dropped, before the sort.
+
+// Set in BroadphaseEndpoint::body for a max endpoint
+const uint32_t BROADPHASE_MAX_BIT = 0x80000000u;
+const uint32_t BROADPHASE_NONE = 0xffffffffu;
+
+struct BroadphaseEndpoint {
+    float value;
+    uint32_t body; // | BROADPHASE_MAX_BIT for a max
+};
+
+struct BroadphaseBody {
+    float min[3];
+    float max[3];
+    bool removed;
+    bool fresh; // merged in by the current update
+};
+
+struct BroadphasePair {
+    uint32_t a; // a < b
+    uint32_t b;
+};
+
+// Of the last broadphaseUpdate
+struct BroadphaseStats {
+    size_t swaps = 0;
+    size_t pairsAdded = 0;
+    size_t pairsRemoved = 0;
+    size_t inserted = 0;
+    size_t removed = 0;
+};
+
+struct Broadphase {
+    std::vector<BroadphaseEndpoint> axes[3];
+    // Where body b's min and max sit on each axis: [6b + 2axis] and the one
+    // after it, or BROADPHASE_NONE until the update after broadphaseAdd.
+    // Together so an overlap test reads one line per body.
+    std::vector<uint32_t> positions;
+    std::vector<BroadphaseBody> bodies; // by id, removed ones kept for reuse
+    std::vector<uint32_t> freeBodies;
+    std::vector<uint32_t> inserting; // added since the last update
+    std::vector<uint32_t> removing;  // removed since the last update
+    // Every overlapping pair, in no order; kept between updates
+    std::vector<BroadphasePair> pairs;
+    // Open-addressed table from a pair's key to its index in `pairs`
+    std::vector<uint64_t> pairKeys;
+    std::vector<uint32_t> pairIndices;
+    // Scratch for merging new bodies in
+    std::vector<BroadphaseEndpoint> merging;
+    std::vector<uint32_t> active;
+    std::vector<uint32_t> activeFresh;
+    std::vector<uint32_t> activeSlots; // per body, its index in active then in activeFresh
+    BroadphaseStats stats;
+};
+
+// Boxes must be finite with min <= max on every axis. Boxes that touch
+// overlap. Returns the body's id; ids of removed bodies are reused.
+uint32_t broadphaseAdd(Broadphase& broadphase, const float min[3], const float max[3]);
+
+// Its pairs go at the next update
+void broadphaseRemove(Broadphase& broadphase, uint32_t body);
+
+// Not for removed bodies
+void broadphaseMove(Broadphase& broadphase, uint32_t body, const float min[3], const float max[3]);
+
+// Brings `pairs` up to date with the adds, removes and moves since the last
+// update
+void broadphaseUpdate(Broadphase& broadphase);
+
+#endif
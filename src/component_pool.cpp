@@ -0,0 +1,69 @@
+#include "component_pool.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "entity_world.h"
+
+bool componentPoolInit(ComponentPool& pool, size_t componentSize, size_t capacity, size_t maxEntities) {
+    componentPoolFree(pool);
+    if (capacity == 0) capacity = 1;
+
+    size_t handleBytes = (capacity * sizeof(EntityId) + ENTITY_COLUMN_ALIGN - 1) / ENTITY_COLUMN_ALIGN *
+                         ENTITY_COLUMN_ALIGN;
+    size_t componentBytes = (capacity * componentSize + ENTITY_COLUMN_ALIGN - 1) / ENTITY_COLUMN_ALIGN *
+                            ENTITY_COLUMN_ALIGN;
+    void* storage = aligned_alloc(ENTITY_COLUMN_ALIGN, handleBytes + componentBytes);
+    if (!storage) return false;
+
+    pool.componentSize = (uint32_t)componentSize;
+    pool.capacity = (uint32_t)capacity;
+    pool.sparse.assign(maxEntities, 0);
+    pool.entities = (EntityId*)storage;
+    pool.components = (uint8_t*)storage + handleBytes;
+    pool.storage = storage;
+    return true;
+}
+
+void componentPoolFree(ComponentPool& pool) {
+    free(pool.storage);
+    pool = ComponentPool();
+}
+
+void* componentPoolAdd(ComponentPool& pool, EntityId entity) {
+    uint32_t index = entityIndex(entity);
+    if (index >= pool.sparse.size()) pool.sparse.resize((size_t)index + 1, 0);
+
+    uint32_t position = pool.sparse[index];
+    bool held = position < pool.count && entityIndex(pool.entities[position]) == index;
+    if (held && pool.entities[position] == entity) {
+        return pool.components + (size_t)position * pool.componentSize;
+    }
+    if (!held) {
+        if (pool.count == pool.capacity) {
+            pool.dropped++;
+            return nullptr;
+        }
+        position = pool.count++;
+        pool.sparse[index] = position;
+    }
+    pool.entities[position] = entity;
+    uint8_t* component = pool.components + (size_t)position * pool.componentSize;
+    memset(component, 0, pool.componentSize);
+    return component;
+}
+
+bool componentPoolRemove(ComponentPool& pool, EntityId entity) {
+    uint32_t position = componentPoolFind(pool, entity);
+    if (position == pool.count) return false;
+
+    uint32_t last = --pool.count;
+    if (position != last) {
+        EntityId moved = pool.entities[last];
+        pool.entities[position] = moved;
+        memcpy(pool.components + (size_t)position * pool.componentSize,
+               pool.components + (size_t)last * pool.componentSize, pool.componentSize);
+        pool.sparse[entityIndex(moved)] = position;
+    }
+    return true;
+}
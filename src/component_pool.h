@@ -0,0 +1,60 @@
+#ifndef COMPONENT_POOL_H
+#define COMPONENT_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "entity_handle.h"
+
+// Sparse-set storage for one component type, for components that come and
+// go too often to move their entity between archetypes (bullets, particles,
+// short-lived tags). The components are packed densely beside the handles
+// that own them; `sparse` maps an entity's slot index to its dense position.
+// Adding appends, removing swaps the last component into the hole, and
+// both are O(1). Like ParticlePool the dense arrays have a fixed capacity,
+// so nothing reallocates while entities come and go.
+struct ComponentPool {
+    uint32_t componentSize = 0;
+    uint32_t capacity = 0;
+    uint32_t count = 0;
+    size_t dropped = 0;           // adds rejected because the pool was full
+    std::vector<uint32_t> sparse; // by entity index; meaningful only where `entities` points back
+    EntityId* entities = nullptr; // dense, [0, count)
+    uint8_t* components = nullptr; // dense, [0, count), cache-line aligned
+    void* storage = nullptr;
+};
+
+// `maxEntities` sizes the sparse array up front; entities with a higher
+// index grow it on their first add
+bool componentPoolInit(ComponentPool& pool, size_t componentSize, size_t capacity, size_t maxEntities);
+void componentPoolFree(ComponentPool& pool);
+
+// The entity's component, zeroed when new. A dead handle's leftover entry
+// in the same slot is taken over. Returns nullptr (and counts a drop) when
+// the pool is full.
+void* componentPoolAdd(ComponentPool& pool, EntityId entity);
+
+// Returns false when the entity has no component here
+bool componentPoolRemove(ComponentPool& pool, EntityId entity);
+
+// Dense position of the entity's component, or `count` when it has none,
+// including when the handle is stale
+inline uint32_t componentPoolFind(const ComponentPool& pool, EntityId entity) {
+    uint32_t index = entityIndex(entity);
+    if (index >= pool.sparse.size()) return pool.count;
+    uint32_t position = pool.sparse[index];
+    return position < pool.count && pool.entities[position] == entity ? position : pool.count;
+}
+
+inline void* componentPoolGet(const ComponentPool& pool, EntityId entity) {
+    uint32_t position = componentPoolFind(pool, entity);
+    return position < pool.count ? pool.components + (size_t)position * pool.componentSize : nullptr;
+}
+
+template <typename T>
+T* componentPoolData(const ComponentPool& pool) {
+    return (T*)pool.components;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#include "entity_handle.h"
+
+EntityId entityHandleCreate(EntityHandles& handles) {
+    // Fresh slots are used while the queue is short; once they run out, the
+    // queue is taken from however short it is
+    bool fresh = handles.generations.size() < ENTITY_INDEX_MASK;
+    uint32_t index;
+    if (handles.freeCount > ENTITY_MIN_FREE_INDICES || (!fresh && handles.freeCount > 0)) {
+        index = handles.freeIndices[handles.freeHead];
+        handles.freeHead = (handles.freeHead + 1) & (handles.freeIndices.size() - 1);
+        handles.freeCount--;
+    } else if (fresh) {
+        index = (uint32_t)handles.generations.size();
+        handles.generations.push_back(0);
+    } else {
+        return ENTITY_NONE;
+    }
+    handles.count++;
+    return index | ((uint32_t)handles.generations[index] << ENTITY_INDEX_BITS);
+}
+
+bool entityHandleDestroy(EntityHandles& handles, EntityId entity) {
+    if (!entityHandleAlive(handles, entity)) return false;
+    uint32_t index = entityIndex(entity);
+    handles.generations[index] = (uint16_t)((handles.generations[index] + 1) & ENTITY_GENERATION_MASK);
+
+    if (handles.freeCount == handles.freeIndices.size()) {
+        // Unroll the full ring into one twice its size
+        size_t size = handles.freeIndices.size();
+        std::vector<uint32_t> grown(size ? size * 2 : 1024);
+        for (size_t i = 0; i < handles.freeCount; i++) {
+            grown[i] = handles.freeIndices[(handles.freeHead + i) & (size - 1)];
+        }
+        handles.freeIndices.swap(grown);
+        handles.freeHead = 0;
+    }
+    handles.freeIndices[(handles.freeHead + handles.freeCount) & (handles.freeIndices.size() - 1)] = index;
+    handles.freeCount++;
+    handles.count--;
+    return true;
+}
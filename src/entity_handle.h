@@ -0,0 +1,55 @@
+#ifndef ENTITY_HANDLE_H
+#define ENTITY_HANDLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 32-bit generational entity handles: a slot index in the low bits and the
+// slot's generation in the high ones. Destroying an entity bumps its slot's
+// generation, so handles still held to it stop matching and read as dead
+// instead of aliasing whatever reuses the slot.
+
+typedef uint32_t EntityId;
+
+const uint32_t ENTITY_INDEX_BITS = 22; // up to 4M live entities
+const uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+const uint32_t ENTITY_GENERATION_MASK = (1u << (32 - ENTITY_INDEX_BITS)) - 1;
+
+// Never issued: its index is one past the last usable slot
+const EntityId ENTITY_NONE = 0xffffffffu;
+
+// Freed slots wait in a FIFO until at least this many are free, so a slot
+// comes back only after this many other frees. Its 10-bit generation then
+// takes ENTITY_MIN_FREE_INDICES * 1024 destroys to wrap around, and a stale
+// handle can't come back to life within any realistic lifetime.
+const size_t ENTITY_MIN_FREE_INDICES = 1024;
+
+inline uint32_t entityIndex(EntityId entity) {
+    return entity & ENTITY_INDEX_MASK;
+}
+
+inline uint32_t entityGeneration(EntityId entity) {
+    return entity >> ENTITY_INDEX_BITS;
+}
+
+struct EntityHandles {
+    std::vector<uint16_t> generations; // per slot: its live handle's, or the next one's while free
+    std::vector<uint32_t> freeIndices; // ring buffer, power-of-two sized
+    size_t freeHead = 0;
+    size_t freeCount = 0;
+    size_t count = 0;                  // live handles
+};
+
+// A new handle, or ENTITY_NONE when every slot is live
+EntityId entityHandleCreate(EntityHandles& handles);
+
+// Returns false, changing nothing, when the handle is already dead
+bool entityHandleDestroy(EntityHandles& handles, EntityId entity);
+
+inline bool entityHandleAlive(const EntityHandles& handles, EntityId entity) {
+    uint32_t index = entityIndex(entity);
+    return index < handles.generations.size() && handles.generations[index] == entityGeneration(entity);
+}
+
+#endif
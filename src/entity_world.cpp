@@ -0,0 +1,179 @@
+#include "entity_world.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static size_t alignUp(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+// Bytes a chunk of `capacity` entities needs, filling in each column's offset
+static size_t layoutChunk(const EntityWorld& world, ComponentMask mask, uint32_t capacity,
+                          uint32_t offsets[ENTITY_MAX_COMPONENTS]) {
+    size_t bytes = capacity * sizeof(EntityId);
+    for (uint32_t c = 0; c < world.componentCount; c++) {
+        if (!(mask & (1u << c))) continue;
+        bytes = alignUp(bytes, ENTITY_COLUMN_ALIGN);
+        offsets[c] = (uint32_t)bytes;
+        bytes += (size_t)capacity * world.components[c].size;
+    }
+    return bytes;
+}
+
+// The archetype for `mask`, made on first use. Returns ENTITY_NONE when not
+// even one entity of it fits in a chunk.
+static uint32_t findArchetype(EntityWorld& world, ComponentMask mask) {
+    auto found = world.archetypeByMask.find(mask);
+    if (found != world.archetypeByMask.end()) return found->second;
+
+    Archetype archetype = {};
+    archetype.mask = mask;
+    size_t entityBytes = sizeof(EntityId);
+    for (uint32_t c = 0; c < world.componentCount; c++) {
+        if (mask & (1u << c)) entityBytes += world.components[c].size;
+    }
+    // Padding between columns can push the first guess over; step down until
+    // the layout fits
+    uint32_t capacity = (uint32_t)(ENTITY_CHUNK_BYTES / entityBytes);
+    while (capacity > 0 && layoutChunk(world, mask, capacity, archetype.offsets) > ENTITY_CHUNK_BYTES) {
+        capacity--;
+    }
+    if (capacity == 0) return ENTITY_NONE;
+    archetype.chunkCapacity = capacity;
+
+    uint32_t index = (uint32_t)world.archetypes.size();
+    world.archetypes.push_back(archetype);
+    world.archetypeByMask[mask] = index;
+    return index;
+}
+
+// Appends a zeroed row for `entity` to the archetype, opening a chunk when
+// the last one is full
+static bool appendRow(EntityWorld& world, uint32_t archetypeIndex, EntityId entity, EntityLocation& location) {
+    Archetype& archetype = world.archetypes[archetypeIndex];
+    if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.chunkCapacity) {
+        uint8_t* data = (uint8_t*)aligned_alloc(ENTITY_COLUMN_ALIGN, ENTITY_CHUNK_BYTES);
+        if (!data) return false;
+        archetype.chunks.push_back({data, 0});
+    }
+    EntityChunk& chunk = archetype.chunks.back();
+    uint32_t row = chunk.count++;
+    ((EntityId*)chunk.data)[row] = entity;
+    for (uint32_t c = 0; c < world.componentCount; c++) {
+        if (!(archetype.mask & (1u << c))) continue;
+        uint32_t size = world.components[c].size;
+        memset(chunk.data + archetype.offsets[c] + (size_t)row * size, 0, size);
+    }
+    archetype.count++;
+    location = {archetypeIndex, (uint32_t)archetype.chunks.size() - 1, row};
+    return true;
+}
+
+// Fills the hole at `location` with the archetype's last entity, so every
+// chunk but the last stays full, and frees the last chunk once it empties
+static void removeRow(EntityWorld& world, EntityLocation location) {
+    Archetype& archetype = world.archetypes[location.archetype];
+    EntityChunk& chunk = archetype.chunks[location.chunk];
+    EntityChunk& last = archetype.chunks.back();
+    uint32_t lastRow = last.count - 1;
+    if (&chunk != &last || location.row != lastRow) {
+        EntityId moved = ((EntityId*)last.data)[lastRow];
+        ((EntityId*)chunk.data)[location.row] = moved;
+        for (uint32_t c = 0; c < world.componentCount; c++) {
+            if (!(archetype.mask & (1u << c))) continue;
+            uint32_t size = world.components[c].size;
+            uint32_t offset = archetype.offsets[c];
+            memcpy(chunk.data + offset + (size_t)location.row * size, last.data + offset + (size_t)lastRow * size,
+                   size);
+        }
+        world.locations[entityIndex(moved)] = location;
+    }
+    archetype.count--;
+    if (--last.count == 0) {
+        free(last.data);
+        archetype.chunks.pop_back();
+    }
+}
+
+void entityWorldFree(EntityWorld& world) {
+    for (Archetype& archetype : world.archetypes) {
+        for (EntityChunk& chunk : archetype.chunks) {
+            free(chunk.data);
+        }
+    }
+    world = EntityWorld();
+}
+
+uint32_t entityRegisterComponent(EntityWorld& world, size_t size, size_t align) {
+    if (world.componentCount == ENTITY_MAX_COMPONENTS) return ENTITY_MAX_COMPONENTS;
+    if (align > ENTITY_COLUMN_ALIGN || size + sizeof(EntityId) + ENTITY_COLUMN_ALIGN > ENTITY_CHUNK_BYTES) {
+        return ENTITY_MAX_COMPONENTS;
+    }
+    uint32_t component = world.componentCount++;
+    world.components[component] = {(uint32_t)size, (uint32_t)align};
+    return component;
+}
+
+EntityId entityCreate(EntityWorld& world, ComponentMask mask) {
+    uint32_t archetype = findArchetype(world, mask);
+    if (archetype == ENTITY_NONE) return ENTITY_NONE;
+
+    EntityId entity = entityHandleCreate(world.handles);
+    if (entity == ENTITY_NONE) return ENTITY_NONE;
+    uint32_t index = entityIndex(entity);
+    if (index >= world.locations.size()) world.locations.resize((size_t)index + 1);
+    if (!appendRow(world, archetype, entity, world.locations[index])) {
+        entityHandleDestroy(world.handles, entity);
+        return ENTITY_NONE;
+    }
+    world.count++;
+    return entity;
+}
+
+void entityDestroy(EntityWorld& world, EntityId entity) {
+    if (!entityAlive(world, entity)) return;
+    removeRow(world, world.locations[entityIndex(entity)]);
+    entityHandleDestroy(world.handles, entity);
+    world.count--;
+}
+
+bool entitySetMask(EntityWorld& world, EntityId entity, ComponentMask mask) {
+    if (!entityAlive(world, entity)) return false;
+    EntityLocation from = world.locations[entityIndex(entity)];
+    if (world.archetypes[from.archetype].mask == mask) return true;
+
+    uint32_t archetypeIndex = findArchetype(world, mask);
+    if (archetypeIndex == ENTITY_NONE) return false;
+    EntityLocation to;
+    if (!appendRow(world, archetypeIndex, entity, to)) return false;
+
+    // Looked up only now, since findArchetype may have grown `archetypes`
+    const Archetype& source = world.archetypes[from.archetype];
+    const Archetype& target = world.archetypes[to.archetype];
+    const uint8_t* sourceData = source.chunks[from.chunk].data;
+    uint8_t* targetData = target.chunks[to.chunk].data;
+    ComponentMask kept = source.mask & mask;
+    for (uint32_t c = 0; c < world.componentCount; c++) {
+        if (!(kept & (1u << c))) continue;
+        uint32_t size = world.components[c].size;
+        memcpy(targetData + target.offsets[c] + (size_t)to.row * size,
+               sourceData + source.offsets[c] + (size_t)from.row * size, size);
+    }
+    removeRow(world, from);
+    world.locations[entityIndex(entity)] = to;
+    return true;
+}
+
+ComponentMask entityMask(const EntityWorld& world, EntityId entity) {
+    if (!entityAlive(world, entity)) return 0;
+    return world.archetypes[world.locations[entityIndex(entity)].archetype].mask;
+}
+
+void* entityGet(EntityWorld& world, EntityId entity, uint32_t component) {
+    if (!entityAlive(world, entity)) return nullptr;
+    const EntityLocation& location = world.locations[entityIndex(entity)];
+    const Archetype& archetype = world.archetypes[location.archetype];
+    if (!(archetype.mask & (1u << component))) return nullptr;
+    return archetype.chunks[location.chunk].data + archetype.offsets[component] +
+           (size_t)location.row * world.components[component].size;
+}
@@ -0,0 +1,112 @@
+#ifndef ENTITY_WORLD_H
+#define ENTITY_WORLD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "entity_handle.h"
+
+// Archetype entity storage. Entities with the same set of components (their
+// mask) share an archetype, packed into fixed-size chunks that hold one
+// contiguous column per component. A system that needs a few components walks
+// those columns of the archetypes that have them, with no holes between
+// entities and no per-entity mask test.
+
+const size_t ENTITY_CHUNK_BYTES = 16 * 1024;
+
+// Columns start on a cache line, so SIMD loops over them can use aligned loads
+const size_t ENTITY_COLUMN_ALIGN = 64;
+
+// One bit of a ComponentMask per registered component
+const uint32_t ENTITY_MAX_COMPONENTS = 32;
+
+typedef uint32_t ComponentMask;
+
+struct ComponentInfo {
+    uint32_t size;
+    uint32_t align;
+};
+
+struct EntityChunk {
+    uint8_t* data; // ENTITY_CHUNK_BYTES: the entities' handles, then each component's column
+    uint32_t count;
+};
+
+struct Archetype {
+    ComponentMask mask;
+    uint32_t chunkCapacity;                 // entities per chunk
+    uint32_t offsets[ENTITY_MAX_COMPONENTS]; // bytes into a chunk, for the components in `mask`
+    std::vector<EntityChunk> chunks;        // every one full but the last
+    size_t count;
+};
+
+struct EntityLocation {
+    uint32_t archetype;
+    uint32_t chunk;
+    uint32_t row;
+};
+
+struct EntityWorld {
+    ComponentInfo components[ENTITY_MAX_COMPONENTS];
+    uint32_t componentCount = 0;
+    std::vector<Archetype> archetypes;
+    std::unordered_map<ComponentMask, uint32_t> archetypeByMask;
+    EntityHandles handles;
+    std::vector<EntityLocation> locations; // by entity index
+    size_t count = 0;
+};
+
+void entityWorldFree(EntityWorld& world);
+
+// Returns the component's bit index, or ENTITY_MAX_COMPONENTS when every bit
+// is taken or the component can't be laid out in a chunk
+uint32_t entityRegisterComponent(EntityWorld& world, size_t size, size_t align);
+
+// A new entity with the components in `mask`, zeroed. Returns ENTITY_NONE
+// when a chunk or a handle couldn't be had.
+EntityId entityCreate(EntityWorld& world, ComponentMask mask);
+
+// Does nothing for a dead handle, so destroying twice is harmless
+void entityDestroy(EntityWorld& world, EntityId entity);
+
+inline bool entityAlive(const EntityWorld& world, EntityId entity) {
+    return entityHandleAlive(world.handles, entity);
+}
+
+// Moves the entity to the archetype for `mask`. Components it keeps are
+// copied, ones it gains are zeroed. Returns false when a chunk couldn't be
+// allocated or the handle is dead, leaving the entity where it was.
+bool entitySetMask(EntityWorld& world, EntityId entity, ComponentMask mask);
+
+ComponentMask entityMask(const EntityWorld& world, EntityId entity);
+
+// The entity's component, or nullptr when it doesn't have it or the handle
+// is dead. Valid until the next structural change (create, destroy, set
+// mask) in the world.
+void* entityGet(EntityWorld& world, EntityId entity, uint32_t component);
+
+template <typename T>
+T* entityColumn(const Archetype& archetype, const EntityChunk& chunk, uint32_t component) {
+    return (T*)(chunk.data + archetype.offsets[component]);
+}
+
+inline const EntityId* entityChunkIds(const EntityChunk& chunk) {
+    return (const EntityId*)chunk.data;
+}
+
+// Calls fn(archetype, chunk) for every chunk of every archetype that has all
+// of `required` and none of `excluded`, in storage order. fn must not change
+// the world's structure.
+template <typename Fn>
+void entityEachChunk(EntityWorld& world, ComponentMask required, ComponentMask excluded, Fn fn) {
+    for (Archetype& archetype : world.archetypes) {
+        if ((archetype.mask & required) != required || (archetype.mask & excluded)) continue;
+        for (EntityChunk& chunk : archetype.chunks) {
+            fn(archetype, chunk);
+        }
+    }
+}
+
+#endif
@@ -1,53 +1,25 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
-#include <AL/al.h>
-#include <AL/alc.h>
 
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <vector>
 #include <algorithm>
 #include <iostream>
 
-// Constants
-const int WIDTH = 1280;
-const int HEIGHT = 720;
-const float PADDLE_SPEED = 800.0f;
-const float INITIAL_BALL_SPEED = 400.0f;
-const float BALL_ACCELERATION = 1.05f;
-const float MAX_BALL_SPEED = 1200.0f;
+#include "batch2d.h"
+#include "particle_pool.h"
+#include "particle_renderer.h"
+#include "pong_audio.h"
+#include "pong_sim.h"
+#include "uniform_cache.h"
 
-// Game state
-struct GameState {
-    float leftPaddleY = HEIGHT / 2.0f;
-    float rightPaddleY = HEIGHT / 2.0f;
-    float ballX = WIDTH / 2.0f;
-    float ballY = HEIGHT / 2.0f;
-    float ballVelX = INITIAL_BALL_SPEED;
-    float ballVelY = 0.0f;
-    int leftScore = 0;
-    int rightScore = 0;
-    bool paused = true;
-    float timeSinceHit = 0.0f;
-};
-
-GameState gameState;
-
-// Particle system
-struct Particle {
-    float x, y;
-    float velX, velY;
-    float life;
-    float r, g, b;
-};
-
-std::vector<Particle> particles;
-
-// Audio system
-ALCdevice* alDevice = nullptr;
-ALCcontext* alContext = nullptr;
-ALuint paddleSound, wallSound, scoreSound;
+// The windowed game plays a single match
+Match match;
+GameState previousState;
+int simRate = DEFAULT_SIM_RATE;
 
 // Color theme
 struct ColorTheme {
@@ -70,32 +42,56 @@ int currentThemeIndex = 0;
 const char* vertexShaderSource = R"glsl(
     #version 330 core
     layout (location = 0) in vec2 position;
+    layout (location = 1) in vec4 color;
     uniform mat4 projection;
+    out vec4 vColor;
     void main() {
         gl_Position = projection * vec4(position, 0.0, 1.0);
+        vColor = color;
     }
 )glsl";
 
 const char* fragmentShaderSource = R"glsl(
     #version 330 core
+    in vec4 vColor;
     out vec4 FragColor;
-    uniform vec3 color;
     void main() {
-        FragColor = vec4(color, 1.0);
+        FragColor = vColor;
     }
 )glsl";
 
-const char* particleFragmentShaderSource = R"glsl(
+// Instanced particles: one quad per particle, expanded around its position
+const char* particleVertexShaderSource = R"glsl(
     #version 330 core
-    out vec4 FragColor;
-    uniform vec3 color;
-    uniform float alpha;
+    layout (location = 0) in vec2 corner;
+    layout (location = 1) in float x;
+    layout (location = 2) in float y;
+    layout (location = 3) in float r;
+    layout (location = 4) in float g;
+    layout (location = 5) in float b;
+    layout (location = 6) in float life;
+    uniform mat4 projection;
+    out vec4 vColor;
+    const float PARTICLE_SIZE = 3.0;
     void main() {
-        FragColor = vec4(color, alpha);
+        gl_Position = projection * vec4(vec2(x, y) + corner * PARTICLE_SIZE, 0.0, 1.0);
+        vColor = vec4(r, g, b, life * 2.0);
     }
 )glsl";
 
 GLuint shaderProgram, particleShaderProgram;
+UniformCache shaderUniforms, particleUniforms;
+
+// Renderer state
+Batch2D batch;
+ParticleRenderer particleRenderer;
+FrameStats frameStats;
+bool instancedParticles = true;
+
+// Benchmark options
+int stressParticles = 0;   // --stress [count]: keep this many particles alive
+int benchmarkFrames = 0;   // --frames N: exit after N frames and print timings
+bool hiddenWindow = false; // --hidden: no visible window, e.g. under llvmpipe
 
 void initOpenGL() {
     glewExperimental = GL_TRUE;
@@ -118,18 +114,21 @@ void initOpenGL() {
     glAttachShader(shaderProgram, fragmentShader);
     glLinkProgram(shaderProgram);
 
-    GLuint particleFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(particleFragmentShader, 1, &particleFragmentShaderSource, NULL);
-    glCompileShader(particleFragmentShader);
+    GLuint particleVertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(particleVertexShader, 1, &particleVertexShaderSource, NULL);
+    glCompileShader(particleVertexShader);
 
     particleShaderProgram = glCreateProgram();
-    glAttachShader(particleShaderProgram, vertexShader);
-    glAttachShader(particleShaderProgram, particleFragmentShader);
+    glAttachShader(particleShaderProgram, particleVertexShader);
+    glAttachShader(particleShaderProgram, fragmentShader);
     glLinkProgram(particleShaderProgram);
 
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
-    glDeleteShader(particleFragmentShader);
+    glDeleteShader(particleVertexShader);
+    
+    uniformCacheBuild(shaderUniforms, shaderProgram);
+    uniformCacheBuild(particleUniforms, particleShaderProgram);
 
     // Set up projection matrix
     glUseProgram(shaderProgram);
@@ -139,339 +138,162 @@ void initOpenGL() {
         0.0f, 0.0f, -1.0f, 0.0f,
         0.0f, 0.0f, 0.0f, 1.0f
     };
-    GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, ortho);
+    glUniformMatrix4fv(uniformLocation(shaderUniforms, UNIFORM("projection")), 1, GL_FALSE, ortho);
 
     glUseProgram(particleShaderProgram);
-    projLoc = glGetUniformLocation(particleShaderProgram, "projection");
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, ortho);
+    glUniformMatrix4fv(uniformLocation(particleUniforms, UNIFORM("projection")), 1, GL_FALSE, ortho);
+
+    batchInit(batch, 4096, frameStats);
+    particleRendererInit(particleRenderer, 1024, frameStats);
+    glLineWidth(2.0f);
+    glPointSize(3.0f);
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-void generateSound(ALuint& buffer, float freq, float duration, int type) {
-    const int SAMPLE_RATE = 44100;
-    int samples = static_cast<int>(duration * SAMPLE_RATE);
-    short* data = new short[samples];
-    
-    for (int i = 0; i < samples; i++) {
-        float t = i / static_cast<float>(SAMPLE_RATE);
-        float value = 0.0f;
-        
-        switch (type) {
-            case 0: // Square wave for paddle
-                value = (fmod(t * freq, 1.0f) < 0.5f) ? 0.5f : -0.5f;
-                break;
-            case 1: // Sine wave for wall
-                value = 0.5f * sin(2 * M_PI * freq * t);
-                break;
-            case 2: // Decaying sine for score
-                value = 0.7f * sin(2 * M_PI * freq * t) * (1.0f - t/duration);
-                break;
-        }
-        
-        data[i] = static_cast<short>(value * 32767);
-    }
-    
-    alGenBuffers(1, &buffer);
-    alBufferData(buffer, AL_FORMAT_MONO16, data, samples * sizeof(short), SAMPLE_RATE);
-    
-    delete[] data;
-}
-
-void initAudio() {
-    alDevice = alcOpenDevice(nullptr);
-    if (!alDevice) {
-        std::cerr << "Failed to open OpenAL device" << std::endl;
-        return;
-    }
-
-    alContext = alcCreateContext(alDevice, nullptr);
-    if (!alContext) {
-        std::cerr << "Failed to create OpenAL context" << std::endl;
-        alcCloseDevice(alDevice);
-        return;
-    }
-    alcMakeContextCurrent(alContext);
-
-    // Generate sounds programmatically
-    generateSound(paddleSound, 440.0f, 0.1f, 0);  // Short square wave
-    generateSound(wallSound, 880.0f, 0.15f, 1);   // Sine wave
-    generateSound(scoreSound, 220.0f, 1.0f, 2);   // Decaying sine
-}
-
-void cleanupAudio() {
-    alDeleteBuffers(1, &paddleSound);
-    alDeleteBuffers(1, &wallSound);
-    alDeleteBuffers(1, &scoreSound);
-
-    alcMakeContextCurrent(nullptr);
-    if (alContext) alcDestroyContext(alContext);
-    if (alDevice) alcCloseDevice(alDevice);
-}
-
-void playSound(ALuint buffer) {
-    ALuint source;
-    alGenSources(1, &source);
-    alSourcei(source, AL_BUFFER, buffer);
-    alSourcePlay(source);
-    
-    // Set up deletion after playing
-    ALint state;
-    alGetSourcei(source, AL_SOURCE_STATE, &state);
-    if (state == AL_PLAYING) {
-        // In a real game, you'd want to manage sources properly
-        alDeleteSources(1, &source);
+// Scatters particles over the whole screen until `target` are alive
+void topUpStressParticles(size_t target) {
+    while (match.particles.count < target && match.particles.count < match.particles.capacity) {
+        particlePoolSpawn(match.particles, rand() % WIDTH, rand() % HEIGHT,
+                          (rand() % 200 - 100) / 10.0f, (rand() % 200 - 100) / 10.0f,
+                          0.5f + (rand() % 100) / 100.0f,
+                          currentTheme.particle1[0], currentTheme.particle1[1], currentTheme.particle1[2]);
     }
 }
 
-void createParticles(float x, float y, int count, const float* color1, const float* color2) {
-    for (int i = 0; i < count; i++) {
-        Particle p;
-        p.x = x;
-        p.y = y;
-        p.velX = (rand() % 200 - 100) / 10.0f;
-        p.velY = (rand() % 200 - 100) / 10.0f;
-        p.life = 0.5f + (rand() % 100) / 100.0f;
-        
-        // Interpolate between two colors
-        float t = (rand() % 100) / 100.0f;
-        p.r = color1[0] * t + color2[0] * (1 - t);
-        p.g = color1[1] * t + color2[1] * (1 - t);
-        p.b = color1[2] * t + color2[2] * (1 - t);
-        
-        particles.push_back(p);
-    }
-}
-
-void updateParticles(float deltaTime) {
-    for (auto& p : particles) {
-        p.x += p.velX * deltaTime;
-        p.y += p.velY * deltaTime;
-        p.life -= deltaTime;
+// Blends the previous and current sim states for drawing. Discrete events
+// (a score resetting the ball) snap to the current state instead of
+// sweeping the ball across the field.
+GameState interpolateState(const GameState& prev, const GameState& curr, float alpha) {
+    GameState state = curr;
+    state.leftPaddleY = prev.leftPaddleY + (curr.leftPaddleY - prev.leftPaddleY) * alpha;
+    state.rightPaddleY = prev.rightPaddleY + (curr.rightPaddleY - prev.rightPaddleY) * alpha;
+    if (prev.leftScore == curr.leftScore && prev.rightScore == curr.rightScore) {
+        state.ballX = prev.ballX + (curr.ballX - prev.ballX) * alpha;
+        state.ballY = prev.ballY + (curr.ballY - prev.ballY) * alpha;
+        state.timeSinceHit = prev.timeSinceHit + (curr.timeSinceHit - prev.timeSinceHit) * alpha;
     }
-    
-    particles.erase(std::remove_if(particles.begin(), particles.end(), 
-        [](const Particle& p) { return p.life <= 0.0f; }), particles.end());
-}
-
-void resetBall(bool serveToRight) {
-    gameState.ballX = WIDTH / 2.0f;
-    gameState.ballY = HEIGHT / 2.0f;
-    gameState.ballVelX = serveToRight ? INITIAL_BALL_SPEED : -INITIAL_BALL_SPEED;
-    gameState.ballVelY = (rand() % 200 - 100) / 100.0f * INITIAL_BALL_SPEED * 0.5f;
-    gameState.paused = true;
-    gameState.timeSinceHit = 0.0f;
+    return state;
 }
 
-void updateGame(float deltaTime) {
-    if (gameState.paused) {
-        if (glfwGetTime() > 1.0f) { // Wait 1 second before serving
-            gameState.paused = false;
-        }
-        return;
-    }
-    
-    gameState.timeSinceHit += deltaTime;
-    
-    // Update ball position
-    gameState.ballX += gameState.ballVelX * deltaTime;
-    gameState.ballY += gameState.ballVelY * deltaTime;
-    
-    // Ball collision with top and bottom
-    if (gameState.ballY <= 0 || gameState.ballY >= HEIGHT) {
-        gameState.ballVelY = -gameState.ballVelY;
-        gameState.ballY = gameState.ballY <= 0 ? 0 : HEIGHT;
-        playSound(wallSound);
-        createParticles(gameState.ballX, gameState.ballY, 20, currentTheme.particle1, currentTheme.particle2);
-    }
-    
-    // Ball collision with paddles
-    bool hit = false;
-    
-    // Left paddle
-    if (gameState.ballX <= 30 && gameState.ballX >= 20 && 
-        gameState.ballY >= gameState.leftPaddleY - 60 && gameState.ballY <= gameState.leftPaddleY + 60) {
-        float hitPos = (gameState.ballY - gameState.leftPaddleY) / 60.0f;
-        gameState.ballVelX = fabs(gameState.ballVelX) * BALL_ACCELERATION;
-        gameState.ballVelY = hitPos * PADDLE_SPEED * 0.8f;
-        gameState.ballX = 30;
-        hit = true;
-    }
-    
-    // Right paddle
-    if (gameState.ballX >= WIDTH - 30 && gameState.ballX <= WIDTH - 20 && 
-        gameState.ballY >= gameState.rightPaddleY - 60 && gameState.ballY <= gameState.rightPaddleY + 60) {
-        float hitPos = (gameState.ballY - gameState.rightPaddleY) / 60.0f;
-        gameState.ballVelX = -fabs(gameState.ballVelX) * BALL_ACCELERATION;
-        gameState.ballVelY = hitPos * PADDLE_SPEED * 0.8f;
-        gameState.ballX = WIDTH - 30;
-        hit = true;
-    }
-    
-    if (hit) {
-        playSound(paddleSound);
-        createParticles(gameState.ballX, gameState.ballY, 30, currentTheme.particle1, currentTheme.particle2);
-        gameState.timeSinceHit = 0.0f;
-        
-        // Limit ball speed
-        float speed = sqrt(gameState.ballVelX * gameState.ballVelX + gameState.ballVelY * gameState.ballVelY);
-        if (speed > MAX_BALL_SPEED) {
-            gameState.ballVelX = gameState.ballVelX / speed * MAX_BALL_SPEED;
-            gameState.ballVelY = gameState.ballVelY / speed * MAX_BALL_SPEED;
-        }
-    }
-    
-    // Ball out of bounds
-    if (gameState.ballX < 0) {
-        gameState.rightScore++;
-        playSound(scoreSound);
-        createParticles(WIDTH / 4, HEIGHT / 2, 100, currentTheme.particle1, currentTheme.particle2);
-        resetBall(true);
-    } else if (gameState.ballX > WIDTH) {
-        gameState.leftScore++;
-        playSound(scoreSound);
-        createParticles(3 * WIDTH / 4, HEIGHT / 2, 100, currentTheme.particle1, currentTheme.particle2);
-        resetBall(false);
-    }
-}
-
-void render() {
+void render(const GameState& state) {
     glClearColor(currentTheme.bg[0], currentTheme.bg[1], currentTheme.bg[2], 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
     
-    // Draw center line
-    glUseProgram(shaderProgram);
-    GLfloat lineVertices[] = {
-        WIDTH / 2.0f, 0.0f,
-        WIDTH / 2.0f, HEIGHT
-    };
-    GLuint vao, vbo;
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(lineVertices), lineVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-    glEnableVertexAttribArray(0);
+    batchBegin(batch);
     
+    // Draw center line
     float lineColor[] = {0.3f, 0.3f, 0.4f};
-    glUniform3fv(glGetUniformLocation(shaderProgram, "color"), 1, lineColor);
-    glLineWidth(2.0f);
-    glDrawArrays(GL_LINES, 0, 2);
-    
-    glDeleteVertexArrays(1, &vao);
-    glDeleteBuffers(1, &vbo);
+    batchLine(batch, WIDTH / 2.0f, 0.0f, WIDTH / 2.0f, HEIGHT, lineColor);
     
     // Draw paddles
-    GLfloat leftPaddleVertices[] = {
-        20.0f, gameState.leftPaddleY - 60.0f,
-        30.0f, gameState.leftPaddleY - 60.0f,
-        30.0f, gameState.leftPaddleY + 60.0f,
-        20.0f, gameState.leftPaddleY + 60.0f
-    };
-    
-    GLfloat rightPaddleVertices[] = {
-        WIDTH - 30.0f, gameState.rightPaddleY - 60.0f,
-        WIDTH - 20.0f, gameState.rightPaddleY - 60.0f,
-        WIDTH - 20.0f, gameState.rightPaddleY + 60.0f,
-        WIDTH - 30.0f, gameState.rightPaddleY + 60.0f
-    };
-    
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(leftPaddleVertices), leftPaddleVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    glUniform3fv(glGetUniformLocation(shaderProgram, "color"), 1, currentTheme.paddle);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-    
-    glBufferData(GL_ARRAY_BUFFER, sizeof(rightPaddleVertices), rightPaddleVertices, GL_STATIC_DRAW);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-    
-    glDeleteVertexArrays(1, &vao);
-    glDeleteBuffers(1, &vbo);
+    batchQuad(batch, 20.0f, state.leftPaddleY - 60.0f,
+              30.0f, state.leftPaddleY + 60.0f, currentTheme.paddle);
+    batchQuad(batch, WIDTH - 30.0f, state.rightPaddleY - 60.0f,
+              WIDTH - 20.0f, state.rightPaddleY + 60.0f, currentTheme.paddle);
     
     // Draw ball
     const int SEGMENTS = 32;
-    GLfloat ballVertices[SEGMENTS * 2 + 4];
-    float radius = 10.0f + 5.0f * sin(gameState.timeSinceHit * 10.0f);
+    float radius = 10.0f + 5.0f * sin(state.timeSinceHit * 10.0f);
+    batchCircle(batch, state.ballX, state.ballY, radius, SEGMENTS, currentTheme.ball);
     
-    ballVertices[0] = gameState.ballX;
-    ballVertices[1] = gameState.ballY;
-    for (int i = 0; i <= SEGMENTS; i++) {
-        float angle = 2.0f * M_PI * i / SEGMENTS;
-        ballVertices[2 + i * 2] = gameState.ballX + radius * cos(angle);
-        ballVertices[3 + i * 2] = gameState.ballY + radius * sin(angle);
+    // Draw particles
+    if (!instancedParticles) {
+        for (size_t i = 0; i < match.particles.count; i++) {
+            batchPoint(batch, match.particles.x[i], match.particles.y[i],
+                       match.particles.r[i], match.particles.g[i], match.particles.b[i], match.particles.life[i] * 2.0f);
+        }
     }
     
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(ballVertices), ballVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    glUniform3fv(glGetUniformLocation(shaderProgram, "color"), 1, currentTheme.ball);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, SEGMENTS + 2);
-    
-    glDeleteVertexArrays(1, &vao);
-    glDeleteBuffers(1, &vbo);
+    glUseProgram(shaderProgram);
+    batchFlush(batch, frameStats);
     
-    // Draw particles
-    if (!particles.empty()) {
+    if (instancedParticles) {
         glUseProgram(particleShaderProgram);
-        
-        GLfloat particleVertices[particles.size() * 2];
-        for (size_t i = 0; i < particles.size(); i++) {
-            particleVertices[i * 2] = particles[i].x;
-            particleVertices[i * 2 + 1] = particles[i].y;
-        }
-        
-        glGenVertexArrays(1, &vao);
-        glGenBuffers(1, &vbo);
-        glBindVertexArray(vao);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(particleVertices), particleVertices, GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-        glEnableVertexAttribArray(0);
-        
-        glPointSize(3.0f);
-        for (size_t i = 0; i < particles.size(); i++) {
-            float alpha = particles[i].life * 2.0f;
-            glUniform3f(glGetUniformLocation(particleShaderProgram, "color"), 
-                       particles[i].r, particles[i].g, particles[i].b);
-            glUniform1f(glGetUniformLocation(particleShaderProgram, "alpha"), alpha);
-            glDrawArrays(GL_POINTS, i, 1);
-        }
-        
-        glDeleteVertexArrays(1, &vao);
-        glDeleteBuffers(1, &vbo);
+        particleRendererDraw(particleRenderer, match.particles, frameStats);
     }
 }
 
+// Shows the driver-side cost of the last second of frames in the title bar
+void updateStatsTitle(GLFWwindow* window, double currentTime) {
+    static double lastUpdate = 0.0;
+    static int frames = 0;
+    static FrameStats total;
+    
+    frames++;
+    total.drawCalls += frameStats.drawCalls;
+    total.bufferAllocs += frameStats.bufferAllocs;
+    total.bufferUploads += frameStats.bufferUploads;
+    
+    if (currentTime - lastUpdate < 1.0) return;
+    
+    AudioStats audio = audioStats();
+    char title[192];
+    snprintf(title, sizeof(title), "Ultra Pong | %d fps | draws/frame %.1f | buffer allocs/frame %.2f | uploads/frame %.1f"
+             " | voices %d/%d | dropped sounds %llu",
+             frames, total.drawCalls / (float)frames, total.bufferAllocs / (float)frames,
+             total.bufferUploads / (float)frames, audio.activeVoices, audio.totalVoices,
+             (unsigned long long)(audio.droppedQueue + audio.droppedVoices));
+    glfwSetWindowTitle(window, title);
+    
+    lastUpdate = currentTime;
+    frames = 0;
+    total = FrameStats();
+}
+
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, GL_TRUE);
     }
     if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
-        if (gameState.paused && gameState.timeSinceHit > 0.5f) {
-            gameState.paused = false;
+        if (match.state.paused && match.state.timeSinceHit > 0.5f) {
+            match.state.paused = false;
         }
     }
+    if (key == GLFW_KEY_I && action == GLFW_PRESS) {
+        instancedParticles = !instancedParticles;
+    }
     if (key == GLFW_KEY_T && action == GLFW_PRESS) {
         currentThemeIndex = (currentThemeIndex + 1) % themes.size();
         currentTheme = themes[currentThemeIndex];
     }
 }
 
-int main() {
-    srand(time(NULL));
+int main(int argc, char** argv) {
+    unsigned seed = time(NULL);
+    AudioOutput audioOutput = AUDIO_OUTPUT_DEVICE;
+    const char* wavPath = nullptr;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stress") == 0) {
+            stressParticles = 1000000;
+            if (i + 1 < argc && argv[i + 1][0] != '-') stressParticles = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--hz") == 0 && i + 1 < argc) {
+            simRate = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            benchmarkFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--hidden") == 0) {
+            hiddenWindow = true;
+        } else if (strcmp(argv[i], "--no-instancing") == 0) {
+            instancedParticles = false;
+        } else if (strcmp(argv[i], "--audio") == 0 && i + 1 < argc && strcmp(argv[i + 1], "device") == 0) {
+            audioOutput = AUDIO_OUTPUT_DEVICE;
+            i++;
+        } else if (strcmp(argv[i], "--audio") == 0 && i + 1 < argc && strcmp(argv[i + 1], "null") == 0) {
+            audioOutput = AUDIO_OUTPUT_NULL;
+            i++;
+        } else if (strcmp(argv[i], "--wav") == 0 && i + 1 < argc) {
+            audioOutput = AUDIO_OUTPUT_WAV;
+            wavPath = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--hz rate] [--seed N] [--stress [count]] [--frames N] [--hidden] [--no-instancing] "
+                    "[--audio device|null] [--wav file]\n", argv[0]);
+            return -1;
+        }
+    }
     
     if (!glfwInit()) {
         fprintf(stderr, "Failed to initialize GLFW\n");
@@ -482,6 +304,9 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    if (hiddenWindow) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
     
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Ultra Pong", NULL, NULL);
     if (!window) {
@@ -492,47 +317,106 @@ int main() {
     
     glfwMakeContextCurrent(window);
     glfwSetKeyCallback(window, keyCallback);
+    if (benchmarkFrames > 0) {
+        glfwSwapInterval(0);
+    }
     
     initOpenGL();
-    initAudio();
+    if (!audioInit(audioOutput, wavPath)) {
+        fprintf(stderr, "Failed to start audio, continuing without sound\n");
+    }
+    
+    srand(seed);
+    if (!matchInit(match, seed, 0, std::max((size_t)stressParticles, MAX_PARTICLES))) {
+        fprintf(stderr, "Failed to allocate particle pool\n");
+        audioShutdown();
+        glfwTerminate();
+        return -1;
+    }
     
     currentTheme = themes[currentThemeIndex];
-    resetBall(true);
+    resetBall(match, true);
+    
+    const float simStep = 1.0f / simRate;
+    double accumulator = 0.0;
+    previousState = match.state;
     
     double lastTime = glfwGetTime();
+    double benchmarkStart = lastTime;
+    unsigned long stringLookupsBeforeLoop = uniformStats.stringLookups;
+    int frameCount = 0;
+    double particlesDrawn = 0.0;
     
     while (!glfwWindowShouldClose(window)) {
         double currentTime = glfwGetTime();
-        float deltaTime = currentTime - lastTime;
+        accumulator += currentTime - lastTime;
         lastTime = currentTime;
         
         // Handle input
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-            gameState.leftPaddleY -= PADDLE_SPEED * deltaTime;
-        }
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-            gameState.leftPaddleY += PADDLE_SPEED * deltaTime;
+        PaddleInput input;
+        input.leftUp = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+        input.leftDown = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+        input.rightUp = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+        input.rightDown = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+        
+        int steps = 0;
+        while (accumulator >= simStep && steps < MAX_STEPS_PER_FRAME) {
+            previousState = match.state;
+            updatePaddles(match.state, input, simStep);
+            unsigned events = updateGame(match, simStep, currentTheme.particle1, currentTheme.particle2);
+            // Hits are panned to where the ball is
+            float pan = match.state.ballX / WIDTH * 2.0f - 1.0f;
+            if (events & SIM_EVENT_WALL_HIT) audioPlay(SOUND_WALL, pan);
+            if (events & SIM_EVENT_PADDLE_HIT) audioPlay(SOUND_PADDLE, pan);
+            if (events & SIM_EVENT_SCORED) audioPlay(SOUND_SCORE);
+            updateParticles(match, simStep);
+            accumulator -= simStep;
+            steps++;
         }
-        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
-            gameState.rightPaddleY -= PADDLE_SPEED * deltaTime;
+        // Too far behind (debugger, window drag): drop the backlog rather
+        // than trying to simulate all of it next frame
+        if (steps == MAX_STEPS_PER_FRAME && accumulator >= simStep) {
+            accumulator = 0.0;
         }
-        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
-            gameState.rightPaddleY += PADDLE_SPEED * deltaTime;
+        if (stressParticles > 0) {
+            topUpStressParticles(stressParticles);
         }
         
-        // Keep paddles in bounds
-        gameState.leftPaddleY = std::max(60.0f, std::min((float)HEIGHT - 60.0f, gameState.leftPaddleY));
-        gameState.rightPaddleY = std::max(60.0f, std::min((float)HEIGHT - 60.0f, gameState.rightPaddleY));
-        
-        updateGame(deltaTime);
-        updateParticles(deltaTime);
-        render();
+        frameStats = FrameStats();
+        render(interpolateState(previousState, match.state, (float)(accumulator / simStep)));
+        updateStatsTitle(window, currentTime);
         
         glfwSwapBuffers(window);
         glfwPollEvents();
+        
+        particlesDrawn += match.particles.count;
+        if (benchmarkFrames > 0 && ++frameCount >= benchmarkFrames) {
+            glFinish();
+            double elapsed = glfwGetTime() - benchmarkStart;
+            printf("%s particles: %d frames in %.3f s, %.3f ms/frame, %.0f particles/s, %d draws/frame\n",
+                   instancedParticles ? "instanced" : "batched", frameCount, elapsed,
+                   elapsed * 1000.0 / frameCount, particlesDrawn / elapsed, frameStats.drawCalls);
+            printf("uniform name lookups during the run: %lu\n",
+                   uniformStats.stringLookups - stringLookupsBeforeLoop);
+            break;
+        }
     }
     
-    cleanupAudio();
+    batchDestroy(batch);
+    particleRendererDestroy(particleRenderer);
+    matchFree(match);
+    glDeleteProgram(shaderProgram);
+    glDeleteProgram(particleShaderProgram);
+    audioShutdown();
     glfwTerminate();
+    
+    AudioStats audio = audioStats();
+    printf("audio: %llu requests, %llu played (%llu stole a voice), %llu dropped on full queue, "
+           "%llu dropped with no voice, peak %d/%d voices, %llu frames mixed to %s\n",
+           (unsigned long long)audio.requests, (unsigned long long)audio.played,
+           (unsigned long long)audio.stolen, (unsigned long long)audio.droppedQueue,
+           (unsigned long long)audio.droppedVoices, audio.peakVoices, audio.totalVoices,
+           (unsigned long long)audio.framesMixed,
+           audio.output == AUDIO_OUTPUT_DEVICE ? "device" : audio.output == AUDIO_OUTPUT_WAV ? "wav" : "null");
     return 0;
 }
@@ -0,0 +1,327 @@
+#ifndef INDIRECT_RENDERER_H
+#define INDIRECT_RENDERER_H
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "batch2d.h"
+#include "meshlet_cull.h"
+#include "scene_loader.h"
+#include "vertex_quantize.h"
+
+// Attribute locations and the SSBO binding the scene shaders must use
+const GLuint SCENE_ATTRIB_POSITION = 0;
+const GLuint SCENE_ATTRIB_NORMAL = 1;
+const GLuint SCENE_ATTRIB_UV = 2;
+const GLuint SCENE_ATTRIB_TANGENT = 3; // quantized scenes only
+const GLuint SCENE_TRANSFORM_BINDING = 0;
+const GLuint SCENE_DECODE_BINDING = 1; // quantized scenes: QuantizeDecode per draw
+
+// Layout fixed by GL for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Draws a whole scene with one glMultiDrawElementsIndirect. Each draw's world
+// matrix sits in an SSBO at the draw's index, which every command carries as
+// its baseInstance and the vertex shader reads as
+// transforms[gl_BaseInstanceARB]; that way a command per culled meshlet finds
+// its draw's matrix as well. Needs GL 4.3 and ARB_shader_draw_parameters; the
+// shared vertex/index buffers also work for one draw call per primitive.
+// Quantized scenes (vertex_quantize.h) also get each draw's position decode
+// in a second SSBO, read as decode[gl_BaseInstanceARB * 2] and [... + 1].
+struct IndirectRenderer {
+    GLuint vao = 0;
+    GLuint vertexBuffer = 0;
+    GLuint tangentBuffer = 0; // quantized scenes: QuantizedTangent per vertex
+    GLuint indexBuffer = 0;
+    GLuint commandBuffer = 0;
+    GLuint frameCommandBuffer = 0; // culled or lod-picked commands, rewritten every frame
+    GLuint transformBuffer = 0;
+    GLuint decodeBuffer = 0;
+    GLsizei drawCount = 0;
+};
+
+static bool indirectRendererSupported() {
+    return GLEW_VERSION_4_3 && GLEW_ARB_shader_draw_parameters;
+}
+
+// Uploads the scene's geometry into the shared buffers straight from the
+// view's arrays, so a mapped cache file goes to the driver without a copy
+static void indirectRendererInit(IndirectRenderer& renderer, const SceneView& scene, FrameStats& stats) {
+    glGenVertexArrays(1, &renderer.vao);
+    glGenBuffers(1, &renderer.vertexBuffer);
+    glGenBuffers(1, &renderer.indexBuffer);
+    glGenBuffers(1, &renderer.commandBuffer);
+    glGenBuffers(1, &renderer.frameCommandBuffer);
+    glGenBuffers(1, &renderer.transformBuffer);
+    glBindVertexArray(renderer.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, scene.vertexCount * sizeof(SceneVertex), scene.vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(SCENE_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(SceneVertex),
+                          (void*)offsetof(SceneVertex, position));
+    glEnableVertexAttribArray(SCENE_ATTRIB_POSITION);
+    glVertexAttribPointer(SCENE_ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(SceneVertex),
+                          (void*)offsetof(SceneVertex, normal));
+    glEnableVertexAttribArray(SCENE_ATTRIB_NORMAL);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, scene.indexCount * sizeof(uint32_t), scene.indices, GL_STATIC_DRAW);
+    stats.bufferAllocs += 8; // 6 names, 2 stores
+    stats.bufferUploads += 2;
+
+    glBindVertexArray(0);
+}
+
+// Same buffers with the quantized vertices in place of the scene's, their
+// tangents in a buffer of their own. The index buffer and mesh ranges are
+// the scene's, unchanged.
+static void indirectRendererInitQuantized(IndirectRenderer& renderer, const SceneView& scene,
+                                          const QuantizedScene& quantized, FrameStats& stats) {
+    glGenVertexArrays(1, &renderer.vao);
+    glGenBuffers(1, &renderer.vertexBuffer);
+    glGenBuffers(1, &renderer.indexBuffer);
+    glGenBuffers(1, &renderer.commandBuffer);
+    glGenBuffers(1, &renderer.frameCommandBuffer);
+    glGenBuffers(1, &renderer.transformBuffer);
+    glGenBuffers(1, &renderer.decodeBuffer);
+    glGenBuffers(1, &renderer.tangentBuffer);
+    glBindVertexArray(renderer.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, quantized.vertices.size() * sizeof(QuantizedVertex), quantized.vertices.data(),
+                 GL_STATIC_DRAW);
+    glVertexAttribPointer(SCENE_ATTRIB_POSITION, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(QuantizedVertex),
+                          (void*)offsetof(QuantizedVertex, position));
+    glEnableVertexAttribArray(SCENE_ATTRIB_POSITION);
+    glVertexAttribPointer(SCENE_ATTRIB_NORMAL, 2, GL_SHORT, GL_TRUE, sizeof(QuantizedVertex),
+                          (void*)offsetof(QuantizedVertex, normal));
+    glEnableVertexAttribArray(SCENE_ATTRIB_NORMAL);
+    glVertexAttribPointer(SCENE_ATTRIB_UV, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(QuantizedVertex),
+                          (void*)offsetof(QuantizedVertex, uv));
+    glEnableVertexAttribArray(SCENE_ATTRIB_UV);
+
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.tangentBuffer);
+    glBufferData(GL_ARRAY_BUFFER, quantized.tangents.size() * sizeof(QuantizedTangent), quantized.tangents.data(),
+                 GL_STATIC_DRAW);
+    glVertexAttribPointer(SCENE_ATTRIB_TANGENT, 2, GL_SHORT, GL_TRUE, sizeof(QuantizedTangent),
+                          (void*)offsetof(QuantizedTangent, tangent));
+    glEnableVertexAttribArray(SCENE_ATTRIB_TANGENT);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, scene.indexCount * sizeof(uint32_t), scene.indices, GL_STATIC_DRAW);
+    stats.bufferAllocs += 11; // 8 names, 3 stores
+    stats.bufferUploads += 3;
+
+    glBindVertexArray(0);
+}
+
+// Builds one command per draw and uploads the draws' world matrices in the
+// same order, plus their meshes' decode constants when `quantized` is given.
+// Call again whenever the draw list or a transform changes.
+static void indirectRendererSetDraws(IndirectRenderer& renderer, const SceneView& scene, FrameStats& stats,
+                                     const QuantizedScene* quantized = nullptr) {
+    std::vector<DrawElementsIndirectCommand> commands(scene.drawCount);
+    std::vector<float> transforms(scene.drawCount * 16);
+    for (size_t i = 0; i < scene.drawCount; i++) {
+        const SceneDraw& draw = scene.draws[i];
+        const SceneMesh& mesh = scene.meshes[draw.mesh];
+        commands[i].count = mesh.indexCount;
+        commands[i].instanceCount = 1;
+        commands[i].firstIndex = mesh.firstIndex;
+        commands[i].baseVertex = (GLint)mesh.baseVertex;
+        commands[i].baseInstance = (GLuint)i;
+        memcpy(&transforms[i * 16], draw.world, sizeof(draw.world));
+    }
+    renderer.drawCount = (GLsizei)commands.size();
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand),
+                 commands.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer.transformBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, transforms.size() * sizeof(float), transforms.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    stats.bufferAllocs += 2;
+    stats.bufferUploads += 2;
+
+    if (quantized) {
+        std::vector<QuantizeDecode> decode(scene.drawCount);
+        for (size_t i = 0; i < scene.drawCount; i++) {
+            decode[i] = quantized->decode[scene.draws[i].mesh];
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, renderer.decodeBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, decode.size() * sizeof(QuantizeDecode), decode.data(),
+                     GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        stats.bufferAllocs++;
+        stats.bufferUploads++;
+    }
+}
+
+static void indirectRendererDestroy(IndirectRenderer& renderer) {
+    glDeleteVertexArrays(1, &renderer.vao);
+    glDeleteBuffers(1, &renderer.vertexBuffer);
+    glDeleteBuffers(1, &renderer.tangentBuffer);
+    glDeleteBuffers(1, &renderer.indexBuffer);
+    glDeleteBuffers(1, &renderer.commandBuffer);
+    glDeleteBuffers(1, &renderer.frameCommandBuffer);
+    glDeleteBuffers(1, &renderer.transformBuffer);
+    glDeleteBuffers(1, &renderer.decodeBuffer);
+    renderer = IndirectRenderer();
+}
+
+// The whole draw list in one call. The caller binds the program.
+static void indirectRendererDraw(IndirectRenderer& renderer, FrameStats& stats) {
+    if (renderer.drawCount == 0) return;
+
+    glBindVertexArray(renderer.vao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SCENE_TRANSFORM_BINDING, renderer.transformBuffer);
+    if (renderer.decodeBuffer) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SCENE_DECODE_BINDING, renderer.decodeBuffer);
+    }
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, renderer.drawCount, 0);
+    stats.drawCalls++;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// One command per meshlet that survived cullMeshlets, all in one
+// glMultiDrawElementsIndirect. Needs indirectRendererSetDraws for the
+// transforms; the caller binds the program.
+static void indirectRendererDrawMeshlets(IndirectRenderer& renderer, const SceneView& scene,
+                                         const std::vector<VisibleMeshlet>& visible, FrameStats& stats) {
+    if (visible.empty()) return;
+
+    std::vector<DrawElementsIndirectCommand> commands(visible.size());
+    for (size_t i = 0; i < visible.size(); i++) {
+        const Meshlet& meshlet = scene.meshlets[visible[i].meshlet];
+        const SceneMesh& mesh = scene.meshes[scene.draws[visible[i].draw].mesh];
+        commands[i].count = meshlet.triangleCount * 3;
+        commands[i].instanceCount = 1;
+        commands[i].firstIndex = meshlet.firstIndex;
+        commands[i].baseVertex = (GLint)mesh.baseVertex;
+        commands[i].baseInstance = visible[i].draw;
+    }
+
+    glBindVertexArray(renderer.vao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.frameCommandBuffer);
+    // New storage every frame, like every per-frame command upload here
+    // (see FrameStats)
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand),
+                 commands.data(), GL_STREAM_DRAW);
+    stats.bufferAllocs++;
+    stats.bufferUploads++;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SCENE_TRANSFORM_BINDING, renderer.transformBuffer);
+    if (renderer.decodeBuffer) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SCENE_DECODE_BINDING, renderer.decodeBuffer);
+    }
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, (GLsizei)commands.size(), 0);
+    stats.drawCalls++;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// One command per draw at the level selectLods picked for it, all in one
+// glMultiDrawElementsIndirect. Needs indirectRendererSetDraws for the
+// transforms; the caller binds the program.
+static void indirectRendererDrawLods(IndirectRenderer& renderer, const SceneView& scene,
+                                     const std::vector<uint8_t>& levels, FrameStats& stats) {
+    if (scene.drawCount == 0) return;
+
+    std::vector<DrawElementsIndirectCommand> commands(scene.drawCount);
+    for (size_t i = 0; i < scene.drawCount; i++) {
+        const SceneMesh& mesh = scene.meshes[scene.draws[i].mesh];
+        const SceneLod& lod = mesh.lods[levels[i]];
+        commands[i].count = lod.indexCount;
+        commands[i].instanceCount = 1;
+        commands[i].firstIndex = lod.firstIndex;
+        commands[i].baseVertex = (GLint)mesh.baseVertex;
+        commands[i].baseInstance = (GLuint)i;
+    }
+
+    glBindVertexArray(renderer.vao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.frameCommandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand),
+                 commands.data(), GL_STREAM_DRAW);
+    stats.bufferAllocs++;
+    stats.bufferUploads++;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SCENE_TRANSFORM_BINDING, renderer.transformBuffer);
+    if (renderer.decodeBuffer) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SCENE_DECODE_BINDING, renderer.decodeBuffer);
+    }
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, (GLsizei)commands.size(), 0);
+    stats.drawCalls++;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// One command per draw that survived sceneBvhCull, at the level selectLods
+// picked for it when `levels` is given, all in one
+// glMultiDrawElementsIndirect. Needs indirectRendererSetDraws for the
+// transforms; the caller binds the program.
+static void indirectRendererDrawVisible(IndirectRenderer& renderer, const SceneView& scene,
+                                        const std::vector<uint32_t>& visible, FrameStats& stats,
+                                        const uint8_t* levels = nullptr) {
+    if (visible.empty()) return;
+
+    std::vector<DrawElementsIndirectCommand> commands(visible.size());
+    for (size_t i = 0; i < visible.size(); i++) {
+        const SceneMesh& mesh = scene.meshes[scene.draws[visible[i]].mesh];
+        const SceneLod& lod = mesh.lods[levels ? levels[visible[i]] : 0];
+        commands[i].count = lod.indexCount;
+        commands[i].instanceCount = 1;
+        commands[i].firstIndex = lod.firstIndex;
+        commands[i].baseVertex = (GLint)mesh.baseVertex;
+        commands[i].baseInstance = visible[i];
+    }
+
+    glBindVertexArray(renderer.vao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.frameCommandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand),
+                 commands.data(), GL_STREAM_DRAW);
+    stats.bufferAllocs++;
+    stats.bufferUploads++;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SCENE_TRANSFORM_BINDING, renderer.transformBuffer);
+    if (renderer.decodeBuffer) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SCENE_DECODE_BINDING, renderer.decodeBuffer);
+    }
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, (GLsizei)commands.size(), 0);
+    stats.drawCalls++;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// Reference path over the same buffers: one glDrawElementsBaseVertex and one
+// model matrix upload per draw. Quantized scenes also set the mesh's decode
+// constants as a vec4[2] uniform.
+static void indirectRendererDrawEach(IndirectRenderer& renderer, const SceneView& scene, GLint modelLocation,
+                                     FrameStats& stats, const QuantizedScene* quantized = nullptr,
+                                     GLint decodeLocation = -1) {
+    glBindVertexArray(renderer.vao);
+    for (size_t i = 0; i < scene.drawCount; i++) {
+        const SceneDraw& draw = scene.draws[i];
+        const SceneMesh& mesh = scene.meshes[draw.mesh];
+        glUniformMatrix4fv(modelLocation, 1, GL_FALSE, draw.world);
+        if (quantized) {
+            glUniform4fv(decodeLocation, 2, quantized->decode[draw.mesh].offset);
+        }
+        glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT,
+                                 (void*)(mesh.firstIndex * sizeof(uint32_t)), (GLint)mesh.baseVertex);
+        stats.drawCalls++;
+    }
+    glBindVertexArray(0);
+}
+
+#endif
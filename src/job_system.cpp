@@ -0,0 +1,301 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+#include "rng.h"
+
+// The calling thread's place in a job system
+struct JobThread {
+    JobSystem* system = nullptr;
+    uint32_t index = 0;
+    Rng rng; // picks the first victim to steal from
+};
+
+static thread_local JobThread currentThread;
+
+// Chase-Lev deque operations, with the memory orders of Lê et al.,
+// "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+// Only the owner pushes and pops; any thread steals.
+
+static void writeSlot(JobSlot& slot, const Job& job) {
+    slot.function.store(job.function, std::memory_order_relaxed);
+    slot.data.store(job.data, std::memory_order_relaxed);
+    slot.begin.store(job.begin, std::memory_order_relaxed);
+    slot.end.store(job.end, std::memory_order_relaxed);
+    slot.counter.store(job.counter, std::memory_order_relaxed);
+}
+
+static void readSlot(const JobSlot& slot, Job& job) {
+    job.function = slot.function.load(std::memory_order_relaxed);
+    job.data = slot.data.load(std::memory_order_relaxed);
+    job.begin = slot.begin.load(std::memory_order_relaxed);
+    job.end = slot.end.load(std::memory_order_relaxed);
+    job.counter = slot.counter.load(std::memory_order_relaxed);
+}
+
+static bool dequePush(JobDeque& deque, const Job& job) {
+    int64_t bottom = deque.bottom.load(std::memory_order_relaxed);
+    int64_t top = deque.top.load(std::memory_order_acquire);
+    if (bottom - top >= (int64_t)JOB_DEQUE_CAPACITY) return false;
+    writeSlot(deque.slots[bottom & (JOB_DEQUE_CAPACITY - 1)], job);
+    deque.bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+static bool dequePop(JobDeque& deque, Job& job) {
+    int64_t bottom = deque.bottom.load(std::memory_order_relaxed) - 1;
+    deque.bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = deque.top.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        deque.bottom.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+    }
+    readSlot(deque.slots[bottom & (JOB_DEQUE_CAPACITY - 1)], job);
+    if (top == bottom) {
+        // The last job: race the thieves for it
+        bool won = deque.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                     std::memory_order_relaxed);
+        deque.bottom.store(bottom + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+static bool dequeSteal(JobDeque& deque, Job& job) {
+    int64_t top = deque.top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = deque.bottom.load(std::memory_order_acquire);
+    if (top >= bottom) return false;
+    readSlot(deque.slots[top & (JOB_DEQUE_CAPACITY - 1)], job);
+    return deque.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+// This thread's own jobs first, newest first; then the oldest job of each
+// other thread in turn, starting from a random one
+static bool findJob(JobSystem& system, Job& job) {
+    uint32_t self = currentThread.index;
+    if (dequePop(*system.deques[self], job)) return true;
+    uint32_t count = (uint32_t)system.deques.size();
+    uint32_t first = count > 1 ? rngNext(currentThread.rng) % count : 0;
+    for (uint32_t k = 0; k < count; k++) {
+        uint32_t victim = (first + k) % count;
+        if (victim == self) continue;
+        if (dequeSteal(*system.deques[victim], job)) {
+            system.stats.stolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void runJob(JobSystem& system, const Job& job);
+
+static void pushJob(JobSystem& system, const Job& job) {
+    if (!dequePush(*system.deques[currentThread.index], job)) {
+        system.stats.inlined.fetch_add(1, std::memory_order_relaxed);
+        runJob(system, job);
+        return;
+    }
+    // Pairs with the fence in workerMain between announcing sleep and
+    // looking for work one last time: either it sees this job or this sees it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (system.sleepers.load(std::memory_order_relaxed) > 0) {
+        {
+            std::lock_guard<std::mutex> lock(system.sleepMutex);
+            system.wakeEpoch++;
+        }
+        system.wake.notify_one();
+    }
+}
+
+// Set in JobCounter::pending while it holds continuations, so the counter
+// reads as busy until the job that finishes last has handed them out
+static const uint32_t JOB_CONTINUATIONS = 1u << 31;
+
+static void countJob(JobCounter* counter) {
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The decrement is the last touch of the counter unless continuations wait,
+// so a waiter that sees zero may free it at once
+static void finishJob(JobSystem& system, JobCounter& counter) {
+    uint32_t pending = counter.pending.fetch_sub(1, std::memory_order_acq_rel);
+    if (pending != (JOB_CONTINUATIONS | 1)) return;
+    std::vector<Job> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex);
+        ready.swap(counter.continuations);
+    }
+    for (const Job& job : ready) {
+        pushJob(system, job);
+    }
+    counter.pending.fetch_and(~JOB_CONTINUATIONS, std::memory_order_release);
+}
+
+static void runJob(JobSystem& system, const Job& job) {
+    job.function(job.data, job.begin, job.end);
+    system.stats.executed.fetch_add(1, std::memory_order_relaxed);
+    if (job.counter) finishJob(system, *job.counter);
+}
+
+// Binds the calling thread to one core, so its deque and the data its jobs
+// touch stay in that core's caches
+static void pinThread(unsigned core) {
+#if defined(__linux__)
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(core % std::max(1u, std::thread::hardware_concurrency()), &cores);
+    pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores);
+#else
+    (void)core;
+#endif
+}
+
+static void workerMain(JobSystem* system, uint32_t index, bool pin) {
+    currentThread.system = system;
+    currentThread.index = index;
+    rngSeed(currentThread.rng, index, index);
+    if (pin) pinThread(index);
+
+    int spins = 0;
+    for (;;) {
+        Job job;
+        if (findJob(*system, job)) {
+            runJob(*system, job);
+            spins = 0;
+            continue;
+        }
+        if (++spins < JOB_IDLE_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Announce the sleep, look once more, then sleep until a push
+        std::unique_lock<std::mutex> lock(system->sleepMutex);
+        if (system->stopping) return;
+        uint64_t epoch = system->wakeEpoch;
+        system->sleepers.fetch_add(1, std::memory_order_relaxed);
+        lock.unlock();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool found = findJob(*system, job);
+        lock.lock();
+        if (!found) {
+            system->wake.wait(lock, [system, epoch] { return system->stopping || system->wakeEpoch != epoch; });
+        }
+        system->sleepers.fetch_sub(1, std::memory_order_relaxed);
+        lock.unlock();
+        if (found) runJob(*system, job);
+        spins = 0;
+    }
+}
+
+void jobSystemInit(JobSystem& system, unsigned threads, bool pin) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    system.stopping = false;
+    system.wakeEpoch = 0;
+    for (unsigned i = 0; i < threads; i++) {
+        system.deques.push_back(new JobDeque());
+    }
+    currentThread.system = &system;
+    currentThread.index = 0;
+    rngSeed(currentThread.rng, 0, 0);
+    if (pin) pinThread(0);
+    for (unsigned i = 1; i < threads; i++) {
+        system.workers.emplace_back(workerMain, &system, i, pin);
+    }
+}
+
+void jobSystemShutdown(JobSystem& system) {
+    {
+        std::lock_guard<std::mutex> lock(system.sleepMutex);
+        system.stopping = true;
+        system.wakeEpoch++;
+    }
+    system.wake.notify_all();
+    for (std::thread& worker : system.workers) {
+        worker.join();
+    }
+    system.workers.clear();
+    for (JobDeque* deque : system.deques) {
+        delete deque;
+    }
+    system.deques.clear();
+    if (currentThread.system == &system) currentThread = JobThread();
+}
+
+void jobSubmit(JobSystem& system, const Job& job, JobCounter* counter) {
+    Job counted = job;
+    counted.counter = counter;
+    countJob(counter);
+    pushJob(system, counted);
+}
+
+void jobSubmitAfter(JobSystem& system, JobCounter& dependency, const Job& job, JobCounter* counter) {
+    Job counted = job;
+    counted.counter = counter;
+    countJob(counter);
+    {
+        // Marking the counter only while jobs are pending means the job that
+        // finishes last sees the mark and takes the list
+        std::lock_guard<std::mutex> lock(dependency.mutex);
+        uint32_t pending = dependency.pending.load(std::memory_order_acquire);
+        while ((pending & ~JOB_CONTINUATIONS) != 0) {
+            if (dependency.pending.compare_exchange_weak(pending, pending | JOB_CONTINUATIONS,
+                                                         std::memory_order_acq_rel, std::memory_order_acquire)) {
+                dependency.continuations.push_back(counted);
+                return;
+            }
+        }
+    }
+    pushJob(system, counted);
+}
+
+void jobWait(JobSystem& system, JobCounter& counter) {
+    while (counter.pending.load(std::memory_order_acquire) != 0) {
+        Job job;
+        if (findJob(system, job)) {
+            runJob(system, job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+struct ParallelFor {
+    JobSystem* system;
+    const std::function<void(size_t, size_t)>* body;
+    size_t grain;
+    JobCounter counter;
+};
+
+// Pushes the far half until what's left fits the grain, then runs that
+static void parallelForRange(void* data, size_t begin, size_t end) {
+    ParallelFor& work = *(ParallelFor*)data;
+    while (end - begin > work.grain) {
+        size_t middle = begin + (end - begin) / 2;
+        jobSubmit(*work.system, {parallelForRange, data, middle, end, nullptr}, &work.counter);
+        end = middle;
+    }
+    (*work.body)(begin, end);
+}
+
+void jobParallelFor(JobSystem& system, size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) return;
+    if (grain == 0) {
+        grain = std::max<size_t>(1, count / (jobThreadCount(system) * JOB_RANGES_PER_THREAD));
+    }
+    ParallelFor work;
+    work.system = &system;
+    work.body = &body;
+    work.grain = grain;
+    parallelForRange(&work, 0, count);
+    jobWait(system, work.counter);
+}
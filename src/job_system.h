@@ -0,0 +1,117 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing job system. Every thread, the one that set the system up
+// included, owns a Chase-Lev deque: it pushes and pops jobs at the bottom
+// while idle threads steal from the top, so work spreads without a shared
+// queue or lock. Jobs are plain function pointers over a range, and a
+// JobCounter tracks a batch of them; waiting on one runs other jobs meanwhile
+// instead of blocking, and jobSubmitAfter starts a job once a counter drains.
+//
+// Jobs may be submitted from the thread that called jobSystemInit and from
+// inside jobs. The ThreadPool (thread_pool.h) remains for code that submits
+// from anywhere.
+
+// Jobs each deque holds. A push to a full deque runs the job right away.
+const size_t JOB_DEQUE_CAPACITY = 4096;
+
+// jobParallelFor's automatic grain aims for this many ranges per thread, so
+// a thread that finishes early still finds ranges to steal
+const size_t JOB_RANGES_PER_THREAD = 8;
+
+// Failed attempts to find work before an idle worker sleeps
+const int JOB_IDLE_SPINS = 256;
+
+typedef void (*JobFunction)(void* data, size_t begin, size_t end);
+
+struct JobCounter;
+
+struct Job {
+    JobFunction function;
+    void* data;
+    size_t begin;
+    size_t end;
+    JobCounter* counter; // decremented when the job has run, may be null
+};
+
+struct JobCounter {
+    // Jobs not yet finished; the top bit is also set while continuations wait
+    std::atomic<uint32_t> pending{0};
+    // Jobs held back by jobSubmitAfter until the last pending job finishes
+    std::mutex mutex;
+    std::vector<Job> continuations;
+};
+
+// A job slot's fields are atomics so a thief can read a slot the owner is
+// refilling; the thief's claim on `top` decides whether what it read counts
+struct JobSlot {
+    std::atomic<JobFunction> function;
+    std::atomic<void*> data;
+    std::atomic<size_t> begin;
+    std::atomic<size_t> end;
+    std::atomic<JobCounter*> counter;
+};
+
+struct JobDeque {
+    alignas(64) std::atomic<int64_t> top{0};    // next to steal
+    alignas(64) std::atomic<int64_t> bottom{0}; // next to push, owned by one thread
+    JobSlot slots[JOB_DEQUE_CAPACITY];
+};
+
+struct JobStats {
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> stolen{0};
+    std::atomic<uint64_t> inlined{0}; // pushed to a full deque and run at once
+};
+
+struct JobSystem {
+    std::vector<std::thread> workers;
+    std::vector<JobDeque*> deques; // [0] is the thread that called jobSystemInit
+    std::atomic<uint32_t> sleepers{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    uint64_t wakeEpoch = 0;        // bumped under sleepMutex to wake sleepers
+    bool stopping = false;
+    JobStats stats;
+};
+
+// threads counts the calling thread: threads == 0 uses one per hardware
+// thread, threads == 1 runs every job on the caller while it waits. With
+// pin, thread i is bound to core i (Linux only; ignored elsewhere).
+void jobSystemInit(JobSystem& system, unsigned threads = 0, bool pin = false);
+void jobSystemShutdown(JobSystem& system);
+
+inline size_t jobThreadCount(const JobSystem& system) {
+    return system.deques.size();
+}
+
+// Queues the job on the calling thread's deque, counting it in `counter`
+void jobSubmit(JobSystem& system, const Job& job, JobCounter* counter);
+
+// Holds the job until `dependency` has no jobs pending, then queues it.
+// `dependency` must not gain jobs again until its continuations are out, and
+// must be waited on itself before it's freed: handing them out is the last
+// thing its final job does.
+void jobSubmitAfter(JobSystem& system, JobCounter& dependency, const Job& job, JobCounter* counter);
+
+// Runs queued jobs, this thread's first, until `counter` has none pending.
+// Can be called from inside a job.
+void jobWait(JobSystem& system, JobCounter& counter);
+
+// Splits [0, count) into ranges of at most `grain` items and runs
+// body(begin, end) for each across the threads, returning when all are
+// done. grain == 0 picks one from the thread count (JOB_RANGES_PER_THREAD).
+// Ranges are split in halves, the far half pushed, so thieves take big
+// pieces. Can be called from inside a job.
+void jobParallelFor(JobSystem& system, size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+#endif
@@ -5,6 +5,8 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include "../../include/uniform_cache.h"
+
 #define DEG2RAD(angle) ((angle) * M_PI / 180.0f)
 
 // Basic 4x4 matrix (row-major) helper
@@ -128,6 +130,10 @@ int main() {
     glDeleteShader(vShader);
     glDeleteShader(fShader);
 
+    UniformCache uniforms;
+    uniformCacheBuild(uniforms, shaderProgram);
+    GLint mvpLoc = uniformLocation(uniforms, UNIFORM("uMVP"));
+
     // Buffers
     GLuint VAO, VBO, EBO;
     glGenVertexArrays(1, &VAO);
@@ -170,7 +176,7 @@ int main() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         glUseProgram(shaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "uMVP"), 1, GL_FALSE, mvp);
+        glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, mvp);
 
         glBindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
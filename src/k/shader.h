@@ -6,8 +6,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../../include/uniform_cache.h"
+
+// Setters take UNIFORM("name") and look it up in `uniforms`, built at link
+// time, so they never pass a string to the driver
 typedef struct {
     GLuint id;
+    UniformCache uniforms;
 } Shader;
 
 static char* load_file(const char* path) {
@@ -53,7 +58,7 @@ static void check_shader_errors(GLuint shader, const char* type) {
 }
 
 static Shader shader_create(const char* vertex_path, const char* fragment_path) {
-    Shader shader = {0};
+    Shader shader = {};
 
     char* vertex_code = load_file(vertex_path);
     char* fragment_code = load_file(fragment_path);
@@ -78,6 +83,7 @@ static Shader shader_create(const char* vertex_path, const char* fragment_path)
     glAttachShader(shader.id, fragment);
     glLinkProgram(shader.id);
     check_shader_errors(shader.id, "PROGRAM");
+    uniformCacheBuild(shader.uniforms, shader.id);
 
     glDeleteShader(vertex);
     glDeleteShader(fragment);
@@ -92,16 +98,16 @@ static void shader_use(const Shader* shader) {
     glUseProgram(shader->id);
 }
 
-static void shader_set_bool(const Shader* shader, const char* name, int value) {
-    glUniform1i(glGetUniformLocation(shader->id, name), value);
+static void shader_set_bool(const Shader* shader, uint32_t name, int value) {
+    glUniform1i(uniformLocation(shader->uniforms, name), value);
 }
 
-static void shader_set_int(const Shader* shader, const char* name, int value) {
-    glUniform1i(glGetUniformLocation(shader->id, name), value);
+static void shader_set_int(const Shader* shader, uint32_t name, int value) {
+    glUniform1i(uniformLocation(shader->uniforms, name), value);
 }
 
-static void shader_set_float(const Shader* shader, const char* name, float value) {
-    glUniform1f(glGetUniformLocation(shader->id, name), value);
+static void shader_set_float(const Shader* shader, uint32_t name, float value) {
+    glUniform1f(uniformLocation(shader->uniforms, name), value);
 }
 
 #endif
@@ -0,0 +1,51 @@
+#include "lod_select.h"
+
+#include <algorithm>
+
+void selectLods(std::vector<uint8_t>& levels, const SceneView& scene, const float camera[3], float pixelsPerUnit,
+                float maxPixels, LodSelectStats& stats) {
+    levels.resize(scene.drawCount);
+    stats = LodSelectStats();
+    stats.draws = scene.drawCount;
+
+    for (size_t d = 0; d < scene.drawCount; d++) {
+        const SceneDraw& draw = scene.draws[d];
+        const SceneMesh& mesh = scene.meshes[draw.mesh];
+        const float* m = draw.world;
+
+        // Bounding sphere in world space; the largest axis scale bounds how
+        // much the matrix can stretch an error
+        float center[3];
+        float radiusSquared = 0.0f;
+        for (int k = 0; k < 3; k++) {
+            center[k] = (mesh.boundsMin[k] + mesh.boundsMax[k]) * 0.5f;
+            float half = (mesh.boundsMax[k] - mesh.boundsMin[k]) * 0.5f;
+            radiusSquared += half * half;
+        }
+        float scale = 0.0f;
+        for (int col = 0; col < 3; col++) {
+            scale = std::max(scale, sqrtf(m[col * 4] * m[col * 4] + m[col * 4 + 1] * m[col * 4 + 1] +
+                                          m[col * 4 + 2] * m[col * 4 + 2]));
+        }
+        float toCamera[3];
+        for (int row = 0; row < 3; row++) {
+            float world = m[row] * center[0] + m[4 + row] * center[1] + m[8 + row] * center[2] + m[12 + row];
+            toCamera[row] = camera[row] - world;
+        }
+        float distance = sqrtf(toCamera[0] * toCamera[0] + toCamera[1] * toCamera[1] + toCamera[2] * toCamera[2]) -
+                         sqrtf(radiusSquared) * scale;
+
+        // error * scale / distance * pixelsPerUnit <= maxPixels, without the division
+        uint32_t level = 0;
+        if (distance > 0.0f) {
+            while (level + 1 < mesh.lodCount &&
+                   mesh.lods[level + 1].error * scale * pixelsPerUnit <= maxPixels * distance) {
+                level++;
+            }
+        }
+        levels[d] = (uint8_t)level;
+        stats.drawsAtLevel[level]++;
+        stats.triangles += mesh.indexCount / 3;
+        stats.selectedTriangles += mesh.lods[level].indexCount / 3;
+    }
+}
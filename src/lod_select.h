@@ -0,0 +1,34 @@
+#ifndef LOD_SELECT_H
+#define LOD_SELECT_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scene_loader.h"
+
+// Per-frame choice of each draw's level of detail (SceneMesh::lods) by how
+// many pixels its simplification error would cover on screen.
+
+struct LodSelectStats {
+    size_t draws = 0;
+    size_t drawsAtLevel[SCENE_MAX_LODS] = {};
+    size_t triangles = 0;         // every draw at full detail
+    size_t selectedTriangles = 0;
+};
+
+// Pixels one unit covers at distance one, for a perspective projection with
+// a vertical field of view of `fovY` radians
+inline float lodPixelsPerUnit(float fovY, float viewportHeight) {
+    return viewportHeight / (2.0f * tanf(fovY * 0.5f));
+}
+
+// Replaces `levels` with one level per draw: the coarsest whose error, scaled
+// by the draw's world matrix and seen from the nearest point of the mesh's
+// bounding sphere, covers at most `maxPixels`. A camera inside the sphere
+// gets full detail. `camera` is in the scene's world space.
+void selectLods(std::vector<uint8_t>& levels, const SceneView& scene, const float camera[3], float pixelsPerUnit,
+                float maxPixels, LodSelectStats& stats);
+
+#endif
@@ -4,6 +4,8 @@
 #include<stdio.h>
 #include<math.h>
 
+#include "uniform_cache.h"
+
 
 const char* vertexShaderSource = 
     "#version 330 core\n"
@@ -85,6 +87,9 @@ int main()
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
+    UniformCache uniforms;
+    uniformCacheBuild(uniforms, shaderProgram);
+
     // Cursor geometry (circle)
     float radius = 15.0f;
     int segments = 32;
@@ -128,9 +133,9 @@ while(!glfwWindowShouldClose(window))
 
         // Draw cursor
         glUseProgram(shaderProgram);
-        glUniform2f(glGetUniformLocation(shaderProgram, "uCursorPos"), cursorPos[0], cursorPos[1]);
-        glUniform2f(glGetUniformLocation(shaderProgram, "uScreenSize"), (float)width, (float)height);
-        glUniform3f(glGetUniformLocation(shaderProgram, "uColor"), 1.0f, 0.0f, 0.0f); // Red
+        glUniform2f(uniformLocation(uniforms, UNIFORM("uCursorPos")), cursorPos[0], cursorPos[1]);
+        glUniform2f(uniformLocation(uniforms, UNIFORM("uScreenSize")), (float)width, (float)height);
+        glUniform3f(uniformLocation(uniforms, UNIFORM("uColor")), 1.0f, 0.0f, 0.0f); // Red
         
         glBindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLE_FAN, 0, segments + 1); // +1 for center point
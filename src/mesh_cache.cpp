@@ -0,0 +1,256 @@
+#include "mesh_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "scene_import.h"
+#include "timing.h"
+
+const size_t SECTION_ALIGN = 64;
+
+static uint64_t alignUp(uint64_t offset) {
+    return (offset + SECTION_ALIGN - 1) & ~(uint64_t)(SECTION_ALIGN - 1);
+}
+
+// Read-only private mapping of a whole file, null when empty or unreadable
+static void* mapFile(const char* path, size_t& size) {
+    size = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    void* mapping = nullptr;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+        } else {
+            size = (size_t)info.st_size;
+        }
+    }
+    close(fd);
+    return mapping;
+}
+
+static void unmap(MeshCache& cache) {
+    if (cache.mapping) {
+        munmap(cache.mapping, cache.size);
+    }
+    cache.mapping = nullptr;
+    cache.size = 0;
+    cache.view = SceneView();
+}
+
+std::string meshCachePath(const char* sourcePath) {
+    return std::string(sourcePath) + ".cache";
+}
+
+bool meshCacheSourceInfo(const char* sourcePath, MeshCacheSource& source, bool hash) {
+    struct stat info;
+    if (stat(sourcePath, &info) != 0) return false;
+    source.size = (uint64_t)info.st_size;
+    source.time = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+    source.hashed = false;
+    if (!hash) return true;
+
+    size_t size = 0;
+    const uint8_t* bytes = (const uint8_t*)mapFile(sourcePath, size);
+    if (!bytes && source.size > 0) return false;
+    uint64_t value = 1469598103934665603ULL;
+    for (size_t i = 0; i < size; i++) {
+        value = (value ^ bytes[i]) * 1099511628211ULL;
+    }
+    if (bytes) {
+        munmap((void*)bytes, size);
+    }
+    source.hash = value;
+    source.hashed = true;
+    return true;
+}
+
+static bool writeSection(FILE* file, uint64_t offset, const void* data, size_t bytes) {
+    static const char padding[SECTION_ALIGN] = {};
+    long position = ftell(file);
+    if (position < 0 || (uint64_t)position > offset) return false;
+    size_t pad = (size_t)(offset - (uint64_t)position);
+    return fwrite(padding, 1, pad, file) == pad && (bytes == 0 || fwrite(data, 1, bytes, file) == bytes);
+}
+
+bool meshCacheWrite(const Scene& scene, const char* cachePath, const MeshCacheSource& source) {
+    MeshCacheHeader header = {};
+    memcpy(header.magic, "MSHC", 4);
+    header.version = MESH_CACHE_VERSION;
+    header.sourceHash = source.hash;
+    header.sourceSize = source.size;
+    header.sourceTime = source.time;
+    header.vertexStride = sizeof(SceneVertex);
+    header.meshStride = sizeof(SceneMesh);
+    header.drawStride = sizeof(SceneDraw);
+    header.meshletStride = sizeof(Meshlet);
+    header.vertexCount = scene.vertices.size();
+    header.indexCount = scene.indices.size();
+    header.meshletCount = scene.meshlets.size();
+    header.meshCount = scene.meshes.size();
+    header.drawCount = scene.draws.size();
+    header.vertexOffset = alignUp(sizeof(header));
+    header.indexOffset = alignUp(header.vertexOffset + header.vertexCount * sizeof(SceneVertex));
+    header.meshletOffset = alignUp(header.indexOffset + header.indexCount * sizeof(uint32_t));
+    header.meshOffset = alignUp(header.meshletOffset + header.meshletCount * sizeof(Meshlet));
+    header.drawOffset = alignUp(header.meshOffset + header.meshCount * sizeof(SceneMesh));
+    memcpy(header.boundsMin, scene.boundsMin, sizeof(header.boundsMin));
+    memcpy(header.boundsMax, scene.boundsMax, sizeof(header.boundsMax));
+    header.nodes = scene.stats.nodes;
+    header.primitives = scene.stats.primitives;
+    header.skippedPrimitives = scene.stats.skippedPrimitives;
+    header.generatedNormals = scene.stats.generatedNormals;
+    header.cacheTriangles = scene.stats.cacheAfter.triangles;
+    header.cacheVertices = scene.stats.cacheAfter.vertices;
+    header.cacheMissesBefore = scene.stats.cacheBefore.misses;
+    header.cacheMissesAfter = scene.stats.cacheAfter.misses;
+
+    std::string tmpPath = std::string(cachePath) + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              writeSection(file, header.vertexOffset, scene.vertices.data(),
+                           scene.vertices.size() * sizeof(SceneVertex)) &&
+              writeSection(file, header.indexOffset, scene.indices.data(),
+                           scene.indices.size() * sizeof(uint32_t)) &&
+              writeSection(file, header.meshletOffset, scene.meshlets.data(),
+                           scene.meshlets.size() * sizeof(Meshlet)) &&
+              writeSection(file, header.meshOffset, scene.meshes.data(),
+                           scene.meshes.size() * sizeof(SceneMesh)) &&
+              writeSection(file, header.drawOffset, scene.draws.data(),
+                           scene.draws.size() * sizeof(SceneDraw));
+    ok = fclose(file) == 0 && ok;
+    if (!ok || std::rename(tmpPath.c_str(), cachePath) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+static bool sectionFits(uint64_t offset, uint64_t count, uint64_t stride, size_t size) {
+    return offset % SECTION_ALIGN == 0 && offset <= size && count <= (size - offset) / stride;
+}
+
+bool meshCacheOpen(MeshCache& cache, const char* cachePath) {
+    unmap(cache);
+    size_t size = 0;
+    void* mapping = mapFile(cachePath, size);
+    if (!mapping) return false;
+
+    const MeshCacheHeader* header = (const MeshCacheHeader*)mapping;
+    bool valid = size >= sizeof(MeshCacheHeader) &&
+                 memcmp(header->magic, "MSHC", 4) == 0 &&
+                 header->version == MESH_CACHE_VERSION &&
+                 header->vertexStride == sizeof(SceneVertex) &&
+                 header->meshStride == sizeof(SceneMesh) &&
+                 header->drawStride == sizeof(SceneDraw) &&
+                 header->meshletStride == sizeof(Meshlet) &&
+                 sectionFits(header->vertexOffset, header->vertexCount, sizeof(SceneVertex), size) &&
+                 sectionFits(header->indexOffset, header->indexCount, sizeof(uint32_t), size) &&
+                 sectionFits(header->meshletOffset, header->meshletCount, sizeof(Meshlet), size) &&
+                 sectionFits(header->meshOffset, header->meshCount, sizeof(SceneMesh), size) &&
+                 sectionFits(header->drawOffset, header->drawCount, sizeof(SceneDraw), size);
+    if (!valid) {
+        munmap(mapping, size);
+        return false;
+    }
+
+    const char* base = (const char*)mapping;
+    cache.mapping = mapping;
+    cache.size = size;
+    cache.view.vertices = (const SceneVertex*)(base + header->vertexOffset);
+    cache.view.indices = (const uint32_t*)(base + header->indexOffset);
+    cache.view.meshlets = (const Meshlet*)(base + header->meshletOffset);
+    cache.view.meshes = (const SceneMesh*)(base + header->meshOffset);
+    cache.view.draws = (const SceneDraw*)(base + header->drawOffset);
+    cache.view.vertexCount = header->vertexCount;
+    cache.view.indexCount = header->indexCount;
+    cache.view.meshletCount = header->meshletCount;
+    cache.view.meshCount = header->meshCount;
+    cache.view.drawCount = header->drawCount;
+    memcpy(cache.view.boundsMin, header->boundsMin, sizeof(cache.view.boundsMin));
+    memcpy(cache.view.boundsMax, header->boundsMax, sizeof(cache.view.boundsMax));
+    cache.sceneStats.nodes = header->nodes;
+    cache.sceneStats.primitives = header->primitives;
+    cache.sceneStats.skippedPrimitives = header->skippedPrimitives;
+    cache.sceneStats.generatedNormals = header->generatedNormals;
+    cache.sceneStats.cacheBefore.triangles = cache.sceneStats.cacheAfter.triangles = header->cacheTriangles;
+    cache.sceneStats.cacheBefore.vertices = cache.sceneStats.cacheAfter.vertices = header->cacheVertices;
+    cache.sceneStats.cacheBefore.misses = header->cacheMissesBefore;
+    cache.sceneStats.cacheAfter.misses = header->cacheMissesAfter;
+    return true;
+}
+
+bool meshCacheLoad(MeshCache& cache, const char* sourcePath, ThreadPool* pool) {
+    meshCacheClose(cache);
+    auto start = std::chrono::steady_clock::now();
+    MeshCacheStats& stats = cache.stats;
+
+    MeshCacheSource source;
+    if (!meshCacheSourceInfo(sourcePath, source, false)) {
+        fprintf(stderr, "Can't stat %s\n", sourcePath);
+        return false;
+    }
+    std::string cachePath = meshCachePath(sourcePath);
+
+    auto phase = std::chrono::steady_clock::now();
+    if (meshCacheOpen(cache, cachePath.c_str())) {
+        stats.mapSeconds = seconds(phase);
+        const MeshCacheHeader* header = (const MeshCacheHeader*)cache.mapping;
+        bool match = header->sourceSize == source.size && header->sourceTime == source.time;
+        // Same size but touched (a checkout, a copy): only the contents can tell
+        if (!match && header->sourceSize == source.size) {
+            phase = std::chrono::steady_clock::now();
+            match = meshCacheSourceInfo(sourcePath, source, true) && header->sourceHash == source.hash;
+            stats.hashSeconds = seconds(phase);
+            stats.hashed = true;
+        }
+        if (match) {
+            stats.hit = true;
+            stats.seconds = seconds(start);
+            return true;
+        }
+        unmap(cache);
+    }
+
+    phase = std::chrono::steady_clock::now();
+    Scene scene;
+    bool loaded = pool ? sceneLoadGltfParallel(scene, sourcePath, *pool) : sceneLoadGltf(scene, sourcePath);
+    if (!loaded) return false;
+    stats.importSeconds = seconds(phase);
+
+    if (!source.hashed) {
+        phase = std::chrono::steady_clock::now();
+        meshCacheSourceInfo(sourcePath, source, true);
+        stats.hashSeconds = seconds(phase);
+        stats.hashed = true;
+    }
+
+    phase = std::chrono::steady_clock::now();
+    bool written = source.hashed && meshCacheWrite(scene, cachePath.c_str(), source);
+    stats.writeSeconds = seconds(phase);
+    phase = std::chrono::steady_clock::now();
+    if (!written || !meshCacheOpen(cache, cachePath.c_str())) {
+        fprintf(stderr, "Can't write %s, using the imported scene\n", cachePath.c_str());
+        cache.scene = std::move(scene);
+        cache.view = sceneView(cache.scene);
+        cache.sceneStats = cache.scene.stats;
+    }
+    stats.mapSeconds = seconds(phase);
+    stats.seconds = seconds(start);
+    return true;
+}
+
+void meshCacheClose(MeshCache& cache) {
+    unmap(cache);
+    cache = MeshCache();
+}
@@ -0,0 +1,99 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "scene_loader.h"
+
+struct ThreadPool;
+
+// Bumped whenever the file layout or the import changes, so stale caches miss
+const uint32_t MESH_CACHE_VERSION = 6;
+
+// A cooked scene is this header followed by the vertex, index, meshlet, mesh
+// and draw arrays exactly as SceneView expects them, each 64-byte aligned. Offsets are
+// in bytes from the start of the file.
+struct MeshCacheHeader {
+    char magic[4];          // "MSHC"
+    uint32_t version;
+    uint64_t sourceHash;    // FNV-1a over every byte of the source file
+    uint64_t sourceSize;
+    int64_t sourceTime;     // modification time, lets an untouched source skip the hash
+    uint32_t vertexStride;  // sizeof of each element, guards against layout changes
+    uint32_t meshStride;
+    uint32_t drawStride;
+    uint32_t meshletStride;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t meshletCount;
+    uint64_t meshCount;
+    uint64_t drawCount;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t meshletOffset;
+    uint64_t meshOffset;
+    uint64_t drawOffset;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint64_t nodes;
+    uint64_t primitives;
+    uint64_t skippedPrimitives;
+    uint64_t generatedNormals;
+    uint64_t cacheTriangles;     // SceneStats::cacheBefore/After
+    uint64_t cacheVertices;
+    uint64_t cacheMissesBefore;
+    uint64_t cacheMissesAfter;
+};
+
+// Identity of the source file the cache was cooked from
+struct MeshCacheSource {
+    uint64_t hash = 0;
+    uint64_t size = 0;
+    int64_t time = 0;
+    bool hashed = false;
+};
+
+struct MeshCacheStats {
+    bool hit = false;
+    bool hashed = false;       // the source had to be hashed to validate the cache
+    double hashSeconds = 0.0;
+    double importSeconds = 0.0; // glTF parse and import, misses only
+    double writeSeconds = 0.0;
+    double mapSeconds = 0.0;
+    double seconds = 0.0;      // the whole meshCacheLoad
+};
+
+// A scene read through the cache. `view` points into the read-only mapping,
+// or into `scene` when the cache couldn't be written next to the source.
+struct MeshCache {
+    void* mapping = nullptr;
+    size_t size = 0;
+    Scene scene;
+    SceneView view;
+    SceneStats sceneStats;
+    MeshCacheStats stats;
+};
+
+// "<source>.cache", next to the asset
+std::string meshCachePath(const char* sourcePath);
+
+// Size and modification time, plus the content hash when `hash` is set
+bool meshCacheSourceInfo(const char* sourcePath, MeshCacheSource& source, bool hash);
+
+// Written under a temporary name and renamed into place
+bool meshCacheWrite(const Scene& scene, const char* cachePath, const MeshCacheSource& source);
+
+// Maps the cache and points cache.view into it. Fails on a missing, truncated
+// or foreign file; does not check the source.
+bool meshCacheOpen(MeshCache& cache, const char* cachePath);
+
+// Opens the cooked cache when it matches the source, otherwise imports the
+// glTF file (on the pool when given one) and cooks the cache for next time.
+// Returns false only when the source itself can't be loaded.
+bool meshCacheLoad(MeshCache& cache, const char* sourcePath, ThreadPool* pool = nullptr);
+
+void meshCacheClose(MeshCache& cache);
+
+#endif
@@ -0,0 +1,226 @@
+#include "mesh_optimize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    VertexCacheStats stats;
+    stats.triangles = indexCount / 3;
+
+    // A vertex is cached while fewer than VERTEX_CACHE_SIZE misses happened
+    // since it was loaded; hits don't refresh it
+    std::vector<uint32_t> loadedAt(vertexCount, 0);
+    std::vector<bool> seen(vertexCount, false);
+    uint32_t time = VERTEX_CACHE_SIZE + 1;
+    for (size_t i = 0; i < indexCount; i++) {
+        uint32_t v = indices[i];
+        if (time - loadedAt[v] > (uint32_t)VERTEX_CACHE_SIZE) {
+            loadedAt[v] = time++;
+            stats.misses++;
+        }
+        if (!seen[v]) {
+            seen[v] = true;
+            stats.vertices++;
+        }
+    }
+    return stats;
+}
+
+void buildAdjacency(TriangleAdjacency& adjacency, const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    adjacency.offsets.assign(vertexCount + 1, 0);
+    for (size_t i = 0; i < indexCount; i++) {
+        adjacency.offsets[indices[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        adjacency.offsets[v + 1] += adjacency.offsets[v];
+    }
+    std::vector<uint32_t> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    adjacency.triangles.resize(indexCount);
+    for (size_t i = 0; i < indexCount; i++) {
+        adjacency.triangles[cursor[indices[i]]++] = (uint32_t)(i / 3);
+    }
+}
+
+// Orders clusters of triangles so the ones facing away from the mesh centre
+// are drawn first; they are the likeliest to occlude the rest
+static void sortClusters(uint32_t* indices, size_t indexCount, const std::vector<size_t>& clusterStarts,
+                         const float* positions, size_t stride) {
+    size_t clusterCount = clusterStarts.size();
+    if (clusterCount < 2) return;
+
+    auto position = [positions, stride](uint32_t v) {
+        return (const float*)((const char*)positions + v * stride);
+    };
+
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < indexCount; i++) {
+        const float* p = position(indices[i]);
+        for (int k = 0; k < 3; k++) meshCentroid[k] += p[k];
+    }
+    for (int k = 0; k < 3; k++) meshCentroid[k] /= (float)indexCount;
+
+    std::vector<float> potential(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        size_t begin = clusterStarts[c];
+        size_t end = c + 1 < clusterCount ? clusterStarts[c + 1] : indexCount / 3;
+        float centroid[3] = {0.0f, 0.0f, 0.0f};
+        float normal[3] = {0.0f, 0.0f, 0.0f};
+        float area = 0.0f;
+        for (size_t t = begin; t < end; t++) {
+            const float* a = position(indices[t * 3]);
+            const float* b = position(indices[t * 3 + 1]);
+            const float* d = position(indices[t * 3 + 2]);
+            float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            float e2[3] = {d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+            // Twice the area-weighted normal
+            float n[3] = {e1[1] * e2[2] - e1[2] * e2[1],
+                          e1[2] * e2[0] - e1[0] * e2[2],
+                          e1[0] * e2[1] - e1[1] * e2[0]};
+            float weight = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; k++) {
+                centroid[k] += (a[k] + b[k] + d[k]) * (weight / 3.0f);
+                normal[k] += n[k];
+            }
+            area += weight;
+        }
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area <= 0.0f || length <= 0.0f) {
+            potential[c] = 0.0f;
+            continue;
+        }
+        float dot = 0.0f;
+        for (int k = 0; k < 3; k++) {
+            dot += (centroid[k] / area - meshCentroid[k]) * (normal[k] / length);
+        }
+        potential[c] = dot;
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) order[c] = (uint32_t)c;
+    std::stable_sort(order.begin(), order.end(),
+                     [&potential](uint32_t a, uint32_t b) { return potential[a] > potential[b]; });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(indexCount);
+    for (uint32_t c : order) {
+        size_t begin = clusterStarts[c] * 3;
+        size_t end = c + 1 < clusterCount ? clusterStarts[c + 1] * 3 : indexCount;
+        sorted.insert(sorted.end(), indices + begin, indices + end);
+    }
+    memcpy(indices, sorted.data(), indexCount * sizeof(uint32_t));
+}
+
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, const float* positions,
+                         size_t stride) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2 || vertexCount == 0) return;
+
+    TriangleAdjacency adjacency;
+    buildAdjacency(adjacency, indices, indexCount, vertexCount);
+
+    // live[v]: triangles of v not emitted yet; loadedAt[v]: cache timestamp
+    std::vector<uint32_t> live(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    std::vector<uint32_t> loadedAt(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+    std::vector<size_t> clusterStarts;
+
+    const uint32_t cacheSize = VERTEX_CACHE_SIZE;
+    uint32_t time = cacheSize + 1;
+    size_t scan = 0;
+    int64_t fan = 0;
+    bool jumped = true;
+
+    while (fan >= 0) {
+        if (jumped) {
+            clusterStarts.push_back(output.size() / 3);
+            jumped = false;
+        }
+
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t a = adjacency.offsets[fan]; a < adjacency.offsets[fan + 1]; a++) {
+            uint32_t t = adjacency.triangles[a];
+            if (emitted[t]) continue;
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[t * 3 + k];
+                output.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - loadedAt[v] > cacheSize) {
+                    loadedAt[v] = time++;
+                }
+            }
+            emitted[t] = true;
+        }
+
+        // Next fan: the candidate that will still be cached after emitting
+        // its remaining triangles and has been in the cache longest
+        int64_t next = -1;
+        int64_t best = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) continue;
+            int64_t priority = 0;
+            if (time - loadedAt[v] + 2 * live[v] <= cacheSize) {
+                priority = time - loadedAt[v];
+            }
+            if (priority > best) {
+                best = priority;
+                next = v;
+            }
+        }
+
+        if (next < 0) {
+            // Dead end: back to a recently used vertex, else the next live one
+            jumped = true;
+            while (!deadEnds.empty() && next < 0) {
+                uint32_t v = deadEnds.back();
+                deadEnds.pop_back();
+                if (live[v] > 0) next = v;
+            }
+            while (next < 0 && scan < vertexCount) {
+                if (live[scan] > 0) next = (int64_t)scan;
+                scan++;
+            }
+        }
+        fan = next;
+    }
+
+    memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+    if (positions) {
+        sortClusters(indices, indexCount, clusterStarts, positions, stride);
+    }
+}
+
+void optimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices,
+                         size_t indexCount) {
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        if (remap[indices[i]] == UINT32_MAX) {
+            remap[indices[i]] = next++;
+        }
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (remap[v] == UINT32_MAX) {
+            remap[v] = next++;
+        }
+    }
+
+    std::vector<char> original((const char*)vertices, (const char*)vertices + vertexCount * vertexSize);
+    for (size_t v = 0; v < vertexCount; v++) {
+        memcpy((char*)vertices + remap[v] * vertexSize, &original[v * vertexSize], vertexSize);
+    }
+    for (size_t i = 0; i < indexCount; i++) {
+        indices[i] = remap[indices[i]];
+    }
+}
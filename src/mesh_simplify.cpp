@@ -0,0 +1,478 @@
+#include "mesh_simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "mesh_optimize.h"
+
+// How much more a plane standing on an open border or attribute seam counts
+// than a face's plane
+const double SIMPLIFY_EDGE_WEIGHT = 10.0;
+
+// Each pass collapses at most the cheapest third of its candidate edges, so
+// the order stays close to a global cheapest-first one
+const size_t SIMPLIFY_PASS_FRACTION = 3;
+
+// A symmetric 4x4 quadric (A, b, c) summing weighted squared plane
+// distances, and the total weight so the cost reads as a distance. Planes
+// aren't weighted by area: that lets a thin part's few small faces be
+// outvoted by its long sides, and the part collapses at no cost.
+struct Quadric {
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double weight;
+};
+
+enum VertexKind {
+    VERTEX_INTERIOR,
+    VERTEX_BORDER, // on exactly two open edges, may slide along them
+    VERTEX_SEAM,   // on exactly two attribute seams, may slide along them
+    VERTEX_LOCKED  // corners, junctions and non-manifold spots never move
+};
+
+// An edge between two points and the triangles on it
+struct SimplifyEdge {
+    uint32_t points[2];    // smaller first
+    uint32_t sides;        // triangles on the edge
+    uint32_t triangles[2]; // the first two of them
+    bool seam;             // two sides whose triangles use different vertices at its ends
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double error;
+};
+
+static const float* vertexPosition(const float* positions, size_t stride, uint32_t v) {
+    return (const float*)((const char*)positions + v * stride);
+}
+
+static void quadricAddPlane(Quadric& q, const double n[3], double d, double weight) {
+    q.a00 += weight * n[0] * n[0];
+    q.a01 += weight * n[0] * n[1];
+    q.a02 += weight * n[0] * n[2];
+    q.a11 += weight * n[1] * n[1];
+    q.a12 += weight * n[1] * n[2];
+    q.a22 += weight * n[2] * n[2];
+    q.b0 += weight * n[0] * d;
+    q.b1 += weight * n[1] * d;
+    q.b2 += weight * n[2] * d;
+    q.c += weight * d * d;
+    q.weight += weight;
+}
+
+static void quadricAdd(Quadric& q, const Quadric& r) {
+    q.a00 += r.a00;
+    q.a01 += r.a01;
+    q.a02 += r.a02;
+    q.a11 += r.a11;
+    q.a12 += r.a12;
+    q.a22 += r.a22;
+    q.b0 += r.b0;
+    q.b1 += r.b1;
+    q.b2 += r.b2;
+    q.c += r.c;
+    q.weight += r.weight;
+}
+
+// Root mean squared distance from p to the quadric's planes
+static double quadricError(const Quadric& q, const float p[3]) {
+    double x = p[0], y = p[1], z = p[2];
+    double e = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+               2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+    return q.weight > 0.0 ? sqrt(std::max(e, 0.0) / q.weight) : 0.0;
+}
+
+static void cross(const double a[3], const double b[3], double out[3]) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// Distance from p to the triangle abc, by the Voronoi region of abc that
+// holds p (Ericson, "Real-Time Collision Detection", 5.1.5)
+static float pointTriangleDistance(const float* p, const float* a, const float* b, const float* c) {
+    float ab[3], ac[3], ap[3], bp[3], cp[3], closest[3];
+    for (int k = 0; k < 3; k++) {
+        ab[k] = b[k] - a[k];
+        ac[k] = c[k] - a[k];
+        ap[k] = p[k] - a[k];
+        bp[k] = p[k] - b[k];
+        cp[k] = p[k] - c[k];
+    }
+    auto dot = [](const float* x, const float* y) { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; };
+    float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    float va = d3 * d6 - d5 * d4, vb = d5 * d2 - d1 * d6, vc = d1 * d4 - d3 * d2;
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        memcpy(closest, a, sizeof(closest));
+    } else if (d3 >= 0.0f && d4 <= d3) {
+        memcpy(closest, b, sizeof(closest));
+    } else if (d6 >= 0.0f && d5 <= d6) {
+        memcpy(closest, c, sizeof(closest));
+    } else if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        float v = d1 / (d1 - d3);
+        for (int k = 0; k < 3; k++) closest[k] = a[k] + v * ab[k];
+    } else if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        float w = d2 / (d2 - d6);
+        for (int k = 0; k < 3; k++) closest[k] = a[k] + w * ac[k];
+    } else if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        for (int k = 0; k < 3; k++) closest[k] = b[k] + w * (c[k] - b[k]);
+    } else {
+        float denom = 1.0f / (va + vb + vc);
+        float v = vb * denom, w = vc * denom;
+        for (int k = 0; k < 3; k++) closest[k] = a[k] + ab[k] * v + ac[k] * w;
+    }
+    float d[3] = {p[0] - closest[0], p[1] - closest[1], p[2] - closest[2]};
+    return sqrtf(dot(d, d));
+}
+
+static float distance(const float* a, const float* b) {
+    float d[3] = {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+    return sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+}
+
+// Every edge once, found through the triangles around its smaller point.
+// `visitedBy` holds vertexCount entries.
+static void collectEdges(std::vector<SimplifyEdge>& edges, const TriangleAdjacency& adjacency,
+                         const uint32_t* points, const uint32_t* indices, std::vector<uint32_t>& visitedBy) {
+    edges.clear();
+    std::fill(visitedBy.begin(), visitedBy.end(), UINT32_MAX);
+    auto wedgeAt = [&](uint32_t triangle, uint32_t p) {
+        const uint32_t* tri = &points[triangle * 3];
+        return indices[triangle * 3 + (tri[0] == p ? 0 : (tri[1] == p ? 1 : 2))];
+    };
+    uint32_t vertexCount = (uint32_t)visitedBy.size();
+    for (uint32_t a = 0; a < vertexCount; a++) {
+        const uint32_t* fan = &adjacency.triangles[adjacency.offsets[a]];
+        size_t fanSize = adjacency.offsets[a + 1] - adjacency.offsets[a];
+        for (size_t f = 0; f < fanSize; f++) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t b = points[fan[f] * 3 + k];
+                if (b <= a || visitedBy[b] == a) continue;
+                visitedBy[b] = a;
+                SimplifyEdge edge = {{a, b}, 0, {0, 0}, false};
+                for (size_t g = f; g < fanSize; g++) {
+                    const uint32_t* tri = &points[fan[g] * 3];
+                    if (tri[0] != b && tri[1] != b && tri[2] != b) continue;
+                    if (edge.sides < 2) edge.triangles[edge.sides] = fan[g];
+                    edge.sides++;
+                }
+                edge.seam = edge.sides == 2 && (wedgeAt(edge.triangles[0], a) != wedgeAt(edge.triangles[1], a) ||
+                                                wedgeAt(edge.triangles[0], b) != wedgeAt(edge.triangles[1], b));
+                edges.push_back(edge);
+            }
+        }
+    }
+}
+
+// Drops triangles with two corners on the same point
+static size_t removeDegenerate(uint32_t* indices, size_t indexCount, const std::vector<uint32_t>& point) {
+    size_t kept = 0;
+    for (size_t i = 0; i < indexCount; i += 3) {
+        uint32_t a = point[indices[i]], b = point[indices[i + 1]], c = point[indices[i + 2]];
+        if (a == b || b == c || c == a) continue;
+        memmove(&indices[kept], &indices[i], 3 * sizeof(uint32_t));
+        kept += 3;
+    }
+    return kept;
+}
+
+size_t simplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions,
+                    size_t vertexCount, size_t stride, size_t targetIndexCount, float* resultError, bool keepSeams) {
+    std::vector<uint32_t> result(indices, indices + indexCount / 3 * 3);
+
+    // Vertices sharing a position are wedges of one point, named after the
+    // lowest of them; `nextWedge` links each point's wedges in a ring
+    std::vector<uint32_t> point(vertexCount);
+    std::vector<uint32_t> nextWedge(vertexCount);
+    {
+        std::vector<uint32_t> order(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++) order[v] = v;
+        std::sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) {
+            const float* p = vertexPosition(positions, stride, x);
+            const float* q = vertexPosition(positions, stride, y);
+            for (int k = 0; k < 3; k++) {
+                if (p[k] != q[k]) return p[k] < q[k];
+            }
+            return x < y;
+        });
+        for (size_t i = 0; i < vertexCount;) {
+            size_t end = i + 1;
+            const float* p = vertexPosition(positions, stride, order[i]);
+            while (end < vertexCount) {
+                const float* q = vertexPosition(positions, stride, order[end]);
+                if (p[0] != q[0] || p[1] != q[1] || p[2] != q[2]) break;
+                end++;
+            }
+            for (size_t j = i; j < end; j++) {
+                point[order[j]] = order[i];
+                nextWedge[order[j]] = order[j + 1 < end ? j + 1 : i];
+            }
+            i = end;
+        }
+    }
+    size_t count = removeDegenerate(result.data(), result.size(), point);
+    result.resize(count);
+
+    std::vector<uint32_t> points(count); // point of each index
+    std::vector<uint32_t> visitedBy(vertexCount);
+    std::vector<SimplifyEdge> edges;
+    TriangleAdjacency adjacency;
+    auto collect = [&]() {
+        for (size_t i = 0; i < count; i++) points[i] = point[result[i]];
+        buildAdjacency(adjacency, points.data(), count, vertexCount);
+        collectEdges(edges, adjacency, points.data(), result.data(), visitedBy);
+    };
+    collect();
+
+    // Face planes, plus planes standing on borders and seams
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+    auto position = [&](uint32_t v) { return vertexPosition(positions, stride, v); };
+    auto faceNormal = [&](uint32_t t, double n[3]) {
+        const float* a = position(point[result[t * 3]]);
+        const float* b = position(point[result[t * 3 + 1]]);
+        const float* c = position(point[result[t * 3 + 2]]);
+        double e1[3] = {(double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2]};
+        double e2[3] = {(double)c[0] - a[0], (double)c[1] - a[1], (double)c[2] - a[2]};
+        cross(e1, e2, n);
+    };
+    for (size_t t = 0; t < count / 3; t++) {
+        double n[3];
+        faceNormal((uint32_t)t, n);
+        double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length == 0.0) continue;
+        for (int k = 0; k < 3; k++) n[k] /= length;
+        const float* a = position(point[result[t * 3]]);
+        double d = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]);
+        for (int k = 0; k < 3; k++) quadricAddPlane(quadrics[point[result[t * 3 + k]]], n, d, 1.0);
+    }
+
+    std::vector<uint32_t> borderEdges(vertexCount, 0);
+    std::vector<uint32_t> seamEdges(vertexCount, 0);
+    std::vector<bool> nonManifold(vertexCount, false);
+    for (const SimplifyEdge& edge : edges) {
+        uint32_t a = edge.points[0], b = edge.points[1];
+        if (edge.sides > 2) {
+            nonManifold[a] = nonManifold[b] = true;
+        } else if (edge.sides == 1 || edge.seam) {
+            (edge.sides == 1 ? borderEdges : seamEdges)[a]++;
+            (edge.sides == 1 ? borderEdges : seamEdges)[b]++;
+            const float* pa = position(a);
+            const float* pb = position(b);
+            double e[3] = {(double)pb[0] - pa[0], (double)pb[1] - pa[1], (double)pb[2] - pa[2]};
+            for (uint32_t side = 0; side < edge.sides; side++) {
+                double n[3], m[3];
+                faceNormal(edge.triangles[side], n);
+                cross(e, n, m);
+                double length = sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+                if (length == 0.0) continue;
+                for (int k = 0; k < 3; k++) m[k] /= length;
+                double d = -(m[0] * pa[0] + m[1] * pa[1] + m[2] * pa[2]);
+                quadricAddPlane(quadrics[a], m, d, SIMPLIFY_EDGE_WEIGHT);
+                quadricAddPlane(quadrics[b], m, d, SIMPLIFY_EDGE_WEIGHT);
+            }
+        }
+    }
+    std::vector<uint8_t> kind(vertexCount, VERTEX_INTERIOR);
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (nonManifold[v] || (borderEdges[v] && seamEdges[v])) {
+            kind[v] = VERTEX_LOCKED;
+        } else if (borderEdges[v]) {
+            kind[v] = borderEdges[v] == 2 ? VERTEX_BORDER : VERTEX_LOCKED;
+        } else if (seamEdges[v] && keepSeams) {
+            kind[v] = seamEdges[v] == 2 ? VERTEX_SEAM : VERTEX_LOCKED;
+        }
+    }
+
+    std::vector<uint32_t> remap(vertexCount);
+    // Rings of the input points each remaining point has absorbed, itself included
+    std::vector<uint32_t> nextMerged(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) remap[v] = nextMerged[v] = v;
+    float maxError = 0.0f;
+    std::vector<Collapse> collapses;
+    std::vector<std::pair<uint32_t, uint32_t>> moves; // wedge -> wedge of one collapse
+    std::vector<uint32_t> touched(vertexCount, 0);
+    std::vector<uint32_t> mark(vertexCount, 0);
+    std::vector<uint32_t> seen(vertexCount, 0);
+    uint32_t stamp = 0;
+
+    for (uint32_t pass = 1; count > targetIndexCount; pass++) {
+        if (pass > 1) collect();
+
+        // The cheaper allowed direction of every manifold edge
+        collapses.clear();
+        for (const SimplifyEdge& edge : edges) {
+            bool border = edge.sides == 1;
+            Collapse best = {0, 0, INFINITY};
+            for (int k = 0; k < 2 && edge.sides <= 2; k++) {
+                uint32_t u = edge.points[k], t = edge.points[1 - k];
+                bool allowed = kind[u] == VERTEX_INTERIOR ||
+                               (kind[u] == VERTEX_BORDER && border &&
+                                (kind[t] == VERTEX_BORDER || kind[t] == VERTEX_LOCKED)) ||
+                               (kind[u] == VERTEX_SEAM && edge.seam &&
+                                (kind[t] == VERTEX_SEAM || kind[t] == VERTEX_LOCKED));
+                if (!allowed) continue;
+                Quadric merged = quadrics[u];
+                quadricAdd(merged, quadrics[t]);
+                double error = quadricError(merged, position(t));
+                if (error < best.error) best = {u, t, error};
+            }
+            if (best.error < INFINITY) collapses.push_back(best);
+        }
+        if (collapses.empty()) break;
+        auto cheaper = [](const Collapse& x, const Collapse& y) {
+            if (x.error != y.error) return x.error < y.error;
+            return x.from < y.from;
+        };
+        size_t passSize = (collapses.size() + SIMPLIFY_PASS_FRACTION - 1) / SIMPLIFY_PASS_FRACTION;
+        std::nth_element(collapses.begin(), collapses.begin() + (passSize - 1), collapses.end(), cheaper);
+        collapses.resize(passSize);
+        std::sort(collapses.begin(), collapses.end(), cheaper);
+
+        // Collapses whose neighbourhoods don't overlap, so each sees the mesh
+        // as it was at the start of the pass
+        size_t triangles = count / 3;
+        bool collapsed = false;
+        for (const Collapse& collapse : collapses) {
+            if (triangles <= targetIndexCount / 3) break;
+            uint32_t u = collapse.from, t = collapse.to;
+            if (touched[u] == pass || touched[t] == pass) continue;
+            const uint32_t* fanU = &adjacency.triangles[adjacency.offsets[u]];
+            size_t fanUSize = adjacency.offsets[u + 1] - adjacency.offsets[u];
+
+            // Link condition: u and t share no neighbours but the corners
+            // opposite their edge, otherwise the collapse pinches the surface
+            stamp++;
+            for (uint32_t a = adjacency.offsets[t]; a < adjacency.offsets[t + 1]; a++) {
+                for (int k = 0; k < 3; k++) mark[points[adjacency.triangles[a] * 3 + k]] = stamp;
+            }
+            size_t edgeTriangles = 0, shared = 0;
+            bool valid = true;
+            for (size_t f = 0; f < fanUSize && valid; f++) {
+                const uint32_t* tri = &points[fanU[f] * 3];
+                if (tri[0] == t || tri[1] == t || tri[2] == t) {
+                    edgeTriangles++;
+                } else {
+                    // Moving u onto t must not turn the triangle over
+                    int k = tri[0] == u ? 0 : (tri[1] == u ? 1 : 2);
+                    const float* pu = position(u);
+                    const float* pt = position(t);
+                    const float* pb = position(tri[(k + 1) % 3]);
+                    const float* pc = position(tri[(k + 2) % 3]);
+                    double b0[3] = {(double)pb[0] - pu[0], (double)pb[1] - pu[1], (double)pb[2] - pu[2]};
+                    double c0[3] = {(double)pc[0] - pu[0], (double)pc[1] - pu[1], (double)pc[2] - pu[2]};
+                    double b1[3] = {(double)pb[0] - pt[0], (double)pb[1] - pt[1], (double)pb[2] - pt[2]};
+                    double c1[3] = {(double)pc[0] - pt[0], (double)pc[1] - pt[1], (double)pc[2] - pt[2]};
+                    double before[3], after[3];
+                    cross(b0, c0, before);
+                    cross(b1, c1, after);
+                    valid = before[0] * after[0] + before[1] * after[1] + before[2] * after[2] > 0.0;
+                }
+                for (int k = 0; k < 3; k++) {
+                    uint32_t p = tri[k];
+                    if (p != u && p != t && mark[p] == stamp && seen[p] != stamp) {
+                        seen[p] = stamp;
+                        shared++;
+                    }
+                }
+            }
+            if (!valid || edgeTriangles == 0 || shared != edgeTriangles) continue;
+
+            // Each wedge of u follows its side of the edge to the wedge of t
+            // there; a wedge with no triangle on the edge would tear a seam.
+            // Without keepSeams such a wedge joins the wedge of t whose
+            // triangle faces the most like its own.
+            moves.clear();
+            uint32_t w = u;
+            do {
+                uint32_t target = UINT32_MAX;
+                bool used = false;
+                double facing[3] = {0.0, 0.0, 0.0};
+                for (size_t f = 0; f < fanUSize && valid; f++) {
+                    const uint32_t* tri = &result[fanU[f] * 3];
+                    const uint32_t* triPoints = &points[fanU[f] * 3];
+                    if (tri[0] != w && tri[1] != w && tri[2] != w) continue;
+                    used = true;
+                    double n[3];
+                    faceNormal(fanU[f], n);
+                    for (int k = 0; k < 3; k++) facing[k] += n[k];
+                    for (int k = 0; k < 3; k++) {
+                        if (triPoints[k] != t || target == tri[k]) continue;
+                        valid = target == UINT32_MAX || !keepSeams;
+                        if (target == UINT32_MAX) target = tri[k];
+                    }
+                }
+                if (used && target == UINT32_MAX && !keepSeams) {
+                    double bestDot = -INFINITY;
+                    for (uint32_t a = adjacency.offsets[t]; a < adjacency.offsets[t + 1]; a++) {
+                        uint32_t tri = adjacency.triangles[a];
+                        double n[3];
+                        faceNormal(tri, n);
+                        double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                        double dot = (n[0] * facing[0] + n[1] * facing[1] + n[2] * facing[2]) / std::max(length, 1e-30);
+                        if (dot <= bestDot) continue;
+                        bestDot = dot;
+                        for (int k = 0; k < 3; k++) {
+                            if (points[tri * 3 + k] == t) target = result[tri * 3 + k];
+                        }
+                    }
+                }
+                if (used && target == UINT32_MAX) valid = false;
+                if (used && valid) moves.push_back({w, target});
+                w = nextWedge[w];
+            } while (w != u && valid);
+            if (!valid) continue;
+
+            for (const auto& move : moves) remap[move.first] = move.second;
+            quadricAdd(quadrics[t], quadrics[u]);
+            // The error is measured rather than read off the quadrics, which
+            // average over many planes: how far every point u has absorbed
+            // ends up from the triangles around t once u moves onto it
+            float error = 0.0f;
+            uint32_t merged = u;
+            do {
+                const float* p = position(merged);
+                float nearest = INFINITY;
+                for (size_t f = 0; f < fanUSize; f++) {
+                    const uint32_t* tri = &points[fanU[f] * 3];
+                    if (tri[0] == t || tri[1] == t || tri[2] == t) continue;
+                    const float* corners[3];
+                    for (int k = 0; k < 3; k++) corners[k] = position(tri[k] == u ? t : tri[k]);
+                    nearest = std::min(nearest, pointTriangleDistance(p, corners[0], corners[1], corners[2]));
+                }
+                for (uint32_t a = adjacency.offsets[t]; a < adjacency.offsets[t + 1]; a++) {
+                    const uint32_t* tri = &points[adjacency.triangles[a] * 3];
+                    if (tri[0] == u || tri[1] == u || tri[2] == u) continue;
+                    nearest = std::min(nearest, pointTriangleDistance(p, position(tri[0]), position(tri[1]),
+                                                                      position(tri[2])));
+                }
+                if (nearest == INFINITY) nearest = distance(p, position(t));
+                error = std::max(error, nearest);
+                merged = nextMerged[merged];
+            } while (merged != u);
+            maxError = std::max(maxError, error);
+            std::swap(nextMerged[u], nextMerged[t]);
+            triangles -= edgeTriangles;
+            for (size_t f = 0; f < fanUSize; f++) {
+                for (int k = 0; k < 3; k++) touched[points[fanU[f] * 3 + k]] = pass;
+            }
+            collapsed = true;
+        }
+        if (!collapsed) break;
+
+        for (size_t i = 0; i < count; i++) result[i] = remap[result[i]];
+        count = removeDegenerate(result.data(), count, point);
+        result.resize(count);
+    }
+
+    if (resultError) *resultError = maxError;
+    memcpy(destination, result.data(), count * sizeof(uint32_t));
+    return count;
+}
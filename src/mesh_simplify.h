@@ -0,0 +1,31 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Edge-collapse simplification driven by quadric error metrics (Garland and
+// Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997),
+// used at import to build each mesh's coarser levels of detail.
+
+// Writes a coarser version of the triangle list to `destination` (room for
+// indexCount indices) and returns its index count, stopping once it holds no
+// more than targetIndexCount indices or nothing more can collapse. Every
+// collapse moves a vertex onto a neighbour, so the result indexes the same
+// vertices and the vertex buffer is shared between levels.
+//
+// Vertices at the same position but with different normals or UVs are
+// treated as one surface point whose copies must move together, so UV
+// seams and hard edges stay closed; open borders only collapse along
+// themselves. With `keepSeams` the seams only collapse along themselves
+// too, which keeps attributes intact but can't touch a flat-shaded mesh
+// whose every vertex is a corner; without it collapses cross seams and the
+// geometry alone decides, for distant levels. `resultError` receives the
+// largest distance, in mesh units, from a vertex that moved to the result's
+// triangles around where it went: the vertices themselves are measured, not
+// the surface between them.
+size_t simplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions,
+                    size_t vertexCount, size_t stride, size_t targetIndexCount, float* resultError,
+                    bool keepSeams = true);
+
+#endif
@@ -0,0 +1,197 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "mesh_optimize.h"
+
+// Below this the normals spread past ~84 degrees and the cone can't cull
+const float MESHLET_CONE_MIN_DOT = 0.1f;
+
+static const float* vertexPosition(const float* positions, size_t stride, uint32_t v) {
+    return (const float*)((const char*)positions + v * stride);
+}
+
+// Sphere around the meshlet's box, and the cone around its triangle normals
+static void meshletBounds(Meshlet& meshlet, const uint32_t* indices, const std::vector<uint32_t>& vertices,
+                          const float* positions, size_t stride) {
+    float boxMin[3] = {INFINITY, INFINITY, INFINITY};
+    float boxMax[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (uint32_t v : vertices) {
+        const float* p = vertexPosition(positions, stride, v);
+        for (int k = 0; k < 3; k++) {
+            boxMin[k] = std::min(boxMin[k], p[k]);
+            boxMax[k] = std::max(boxMax[k], p[k]);
+        }
+    }
+    for (int k = 0; k < 3; k++) meshlet.center[k] = (boxMin[k] + boxMax[k]) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (uint32_t v : vertices) {
+        const float* p = vertexPosition(positions, stride, v);
+        float d[3] = {p[0] - meshlet.center[0], p[1] - meshlet.center[1], p[2] - meshlet.center[2]};
+        radiusSquared = std::max(radiusSquared, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    }
+    meshlet.radius = sqrtf(radiusSquared);
+
+    std::vector<float> normals;
+    normals.reserve(meshlet.triangleCount * 3);
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+        const uint32_t* tri = &indices[meshlet.firstIndex + t * 3];
+        const float* a = vertexPosition(positions, stride, tri[0]);
+        const float* b = vertexPosition(positions, stride, tri[1]);
+        const float* c = vertexPosition(positions, stride, tri[2]);
+        float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0f) continue; // degenerate, faces nowhere
+        for (int k = 0; k < 3; k++) {
+            normals.push_back(n[k] / length);
+            axis[k] += n[k] / length;
+        }
+    }
+
+    float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    float minDot = 1.0f;
+    if (length > 0.0f) {
+        for (int k = 0; k < 3; k++) axis[k] /= length;
+        for (size_t i = 0; i < normals.size(); i += 3) {
+            minDot = std::min(minDot, normals[i] * axis[0] + normals[i + 1] * axis[1] + normals[i + 2] * axis[2]);
+        }
+    }
+    if (length <= 0.0f || minDot <= MESHLET_CONE_MIN_DOT) {
+        memset(meshlet.coneAxis, 0, sizeof(meshlet.coneAxis));
+        meshlet.coneCutoff = 1.0f;
+        return;
+    }
+    memcpy(meshlet.coneAxis, axis, sizeof(axis));
+    meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+}
+
+void buildMeshlets(std::vector<Meshlet>& meshlets, uint32_t* indices, size_t indexCount, size_t vertexCount,
+                   const float* positions, size_t stride) {
+    meshlets.clear();
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) return;
+
+    TriangleAdjacency adjacency;
+    buildAdjacency(adjacency, indices, indexCount, vertexCount);
+
+    const uint8_t notInMeshlet = 0xff;
+    std::vector<uint8_t> local(vertexCount, notInMeshlet);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> candidateOf(triangleCount, UINT32_MAX); // meshlet that listed it
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> vertices; // of the open meshlet
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+
+    Meshlet meshlet = {};
+    size_t scan = 0;
+    int64_t seed = -1; // the neighbour that didn't fit in the last full meshlet
+
+    auto finish = [&]() {
+        if (meshlet.triangleCount == 0) return;
+        meshlet.vertexCount = (uint32_t)vertices.size();
+        meshletBounds(meshlet, output.data(), vertices, positions, stride);
+        meshlets.push_back(meshlet);
+        for (uint32_t v : vertices) local[v] = notInMeshlet;
+        vertices.clear();
+        candidates.clear();
+        meshlet = Meshlet();
+        meshlet.firstIndex = (uint32_t)output.size();
+    };
+
+    auto newVertices = [&](uint32_t t) {
+        uint32_t count = 0;
+        for (int k = 0; k < 3; k++) count += local[indices[t * 3 + k]] == notInMeshlet;
+        return count;
+    };
+
+    for (size_t placed = 0; placed < triangleCount;) {
+        // The neighbour adding the fewest vertices, first found on ties
+        int64_t best = -1;
+        uint32_t bestNew = 4;
+        size_t kept = 0;
+        for (uint32_t t : candidates) {
+            if (emitted[t]) continue;
+            candidates[kept++] = t;
+            uint32_t added = newVertices(t);
+            if (added < bestNew) {
+                bestNew = added;
+                best = t;
+            }
+        }
+        candidates.resize(kept);
+
+        if (best < 0 && seed >= 0 && !emitted[seed]) {
+            // A new meshlet carries on next to where the last one filled up
+            best = seed;
+            bestNew = newVertices((uint32_t)seed);
+        } else if (best < 0) {
+            // Nothing connected left: close a reasonably full meshlet rather
+            // than let it sprawl across the mesh, then take the next triangle
+            // in the original order
+            if (meshlet.triangleCount >= MESHLET_MAX_TRIANGLES / 4) finish();
+            while (emitted[scan]) scan++;
+            best = (int64_t)scan;
+            bestNew = newVertices((uint32_t)scan);
+        }
+        seed = -1;
+
+        if (vertices.size() + bestNew > MESHLET_MAX_VERTICES || meshlet.triangleCount == MESHLET_MAX_TRIANGLES) {
+            finish();
+            seed = best;
+            continue;
+        }
+
+        uint32_t t = (uint32_t)best;
+        emitted[t] = true;
+        placed++;
+        meshlet.triangleCount++;
+        uint32_t meshletIndex = (uint32_t)meshlets.size();
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = indices[t * 3 + k];
+            output.push_back(v);
+            if (local[v] != notInMeshlet) continue;
+            local[v] = (uint8_t)vertices.size();
+            vertices.push_back(v);
+            for (uint32_t a = adjacency.offsets[v]; a < adjacency.offsets[v + 1]; a++) {
+                uint32_t neighbour = adjacency.triangles[a];
+                if (emitted[neighbour] || candidateOf[neighbour] == meshletIndex) continue;
+                candidateOf[neighbour] = meshletIndex;
+                candidates.push_back(neighbour);
+            }
+        }
+    }
+    finish();
+
+    memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+void optimizeMeshletVertexCache(const std::vector<Meshlet>& meshlets, uint32_t* indices, size_t vertexCount) {
+    // Each range is renumbered to its own few vertices first, so the cache
+    // pass sizes its tables by the meshlet rather than by the whole mesh
+    std::vector<uint32_t> localOf(vertexCount, UINT32_MAX);
+    std::vector<uint32_t> globalOf;
+    std::vector<uint32_t> localIndices;
+    for (const Meshlet& meshlet : meshlets) {
+        uint32_t* range = indices + meshlet.firstIndex;
+        size_t count = (size_t)meshlet.triangleCount * 3;
+        globalOf.clear();
+        localIndices.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            uint32_t v = range[i];
+            if (localOf[v] == UINT32_MAX) {
+                localOf[v] = (uint32_t)globalOf.size();
+                globalOf.push_back(v);
+            }
+            localIndices[i] = localOf[v];
+        }
+        optimizeVertexCache(localIndices.data(), count, globalOf.size());
+        for (size_t i = 0; i < count; i++) range[i] = globalOf[localIndices[i]];
+        for (uint32_t v : globalOf) localOf[v] = UINT32_MAX;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Small clusters of a mesh's triangles with the bounds needed to cull them
+// as a unit (see meshlet_cull.h). Limits match what mesh shader hardware
+// likes, so the same clusters can move to the GPU later.
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet {
+    uint32_t firstIndex;    // a contiguous range of the index buffer
+    uint32_t triangleCount;
+    uint32_t vertexCount;   // distinct vertices referenced
+    uint32_t reserved;
+    float center[3];        // bounding sphere, mesh space
+    float radius;
+    // Normal cone: every triangle of the meshlet faces away from a camera at
+    // c when dot(center - c, coneAxis) >= coneCutoff * |center - c| + radius.
+    // coneCutoff is 1 when the normals spread too far for the test to work.
+    float coneAxis[3];
+    float coneCutoff;
+};
+
+// Splits a mesh into meshlets of at most MESHLET_MAX_VERTICES vertices and
+// MESHLET_MAX_TRIANGLES triangles, reordering its triangles in place so each
+// meshlet is one contiguous index range; firstIndex is relative to
+// `indices`. Each meshlet grows across shared edges, preferring the
+// triangle that adds the fewest new vertices, starting from the current
+// triangle order, so run it after optimizeVertexCache. Winding is kept.
+void buildMeshlets(std::vector<Meshlet>& meshlets, uint32_t* indices, size_t indexCount, size_t vertexCount,
+                   const float* positions, size_t stride);
+
+// Grouping undoes most of optimizeVertexCache's order, so this runs it again
+// over each meshlet's range on its own, for the cache only: overdraw order
+// inside one small cluster buys little. Triangles only move within their
+// meshlet, so ranges, bounds and cones stay valid.
+void optimizeMeshletVertexCache(const std::vector<Meshlet>& meshlets, uint32_t* indices, size_t vertexCount);
+
+#endif
@@ -0,0 +1,115 @@
+#include "meshlet_cull.h"
+
+#include <cmath>
+
+// out = a * b, column-major
+static void multiply(const float* a, const float* b, float* out) {
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) sum += a[k * 4 + row] * b[col * 4 + k];
+            out[col * 4 + row] = sum;
+        }
+    }
+}
+
+// A point through the inverse of an affine column-major matrix. False when
+// the matrix is singular or mirrors: a mirrored draw's triangles flip
+// winding, so its cones would cull the wrong side.
+static bool inverseTransformPoint(const float* m, const float p[3], float out[3]) {
+    float a = m[0], b = m[4], c = m[8];
+    float d = m[1], e = m[5], f = m[9];
+    float g = m[2], h = m[6], i = m[10];
+    float det = a * (e * i - f * h) - b * (d * i - f * g) + c * (d * h - e * g);
+    if (det <= 0.0f) return false;
+    float q[3] = {p[0] - m[12], p[1] - m[13], p[2] - m[14]};
+    out[0] = ((e * i - f * h) * q[0] + (c * h - b * i) * q[1] + (b * f - c * e) * q[2]) / det;
+    out[1] = ((f * g - d * i) * q[0] + (a * i - c * g) * q[1] + (c * d - a * f) * q[2]) / det;
+    out[2] = ((d * h - e * g) * q[0] + (b * g - a * h) * q[1] + (a * e - b * d) * q[2]) / det;
+    return true;
+}
+
+void frustumPlanes(const float clip[16], float planes[6][4]) {
+    for (int k = 0; k < 4; k++) {
+        float w = clip[k * 4 + 3];
+        planes[0][k] = w + clip[k * 4 + 0]; // left
+        planes[1][k] = w - clip[k * 4 + 0]; // right
+        planes[2][k] = w + clip[k * 4 + 1]; // bottom
+        planes[3][k] = w - clip[k * 4 + 1]; // top
+        planes[4][k] = w + clip[k * 4 + 2]; // near
+        planes[5][k] = w - clip[k * 4 + 2]; // far
+    }
+}
+
+// Outside when the sphere lies entirely behind one plane; `lengths` are the
+// planes' normal lengths, so they need no normalizing
+static bool sphereOutside(const float planes[6][4], const float lengths[6], const float center[3], float radius) {
+    for (int p = 0; p < 6; p++) {
+        float distance =
+            planes[p][0] * center[0] + planes[p][1] * center[1] + planes[p][2] * center[2] + planes[p][3];
+        if (distance < -radius * lengths[p]) return true;
+    }
+    return false;
+}
+
+void cullMeshlets(std::vector<VisibleMeshlet>& visible, const SceneView& scene, const float viewProjection[16],
+                  const float camera[3], MeshletCullStats& stats) {
+    visible.clear();
+    stats = MeshletCullStats();
+    stats.draws = scene.drawCount;
+
+    for (size_t d = 0; d < scene.drawCount; d++) {
+        const SceneDraw& draw = scene.draws[d];
+        const SceneMesh& mesh = scene.meshes[draw.mesh];
+        stats.meshlets += mesh.meshletCount;
+        stats.triangles += mesh.indexCount / 3;
+
+        // Frustum and camera in mesh space
+        float clip[16];
+        float planes[6][4];
+        float lengths[6];
+        float eye[3] = {};
+        multiply(viewProjection, draw.world, clip);
+        frustumPlanes(clip, planes);
+        for (int p = 0; p < 6; p++) {
+            lengths[p] =
+                sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        }
+        bool coneTest = inverseTransformPoint(draw.world, camera, eye);
+
+        float meshCenter[3];
+        float meshRadius = 0.0f;
+        for (int k = 0; k < 3; k++) {
+            meshCenter[k] = (mesh.boundsMin[k] + mesh.boundsMax[k]) * 0.5f;
+            float half = (mesh.boundsMax[k] - mesh.boundsMin[k]) * 0.5f;
+            meshRadius += half * half;
+        }
+        if (sphereOutside(planes, lengths, meshCenter, sqrtf(meshRadius))) {
+            stats.drawsCulled++;
+            stats.frustumCulled += mesh.meshletCount;
+            continue;
+        }
+
+        for (uint32_t m = mesh.firstMeshlet; m < mesh.firstMeshlet + mesh.meshletCount; m++) {
+            const Meshlet& meshlet = scene.meshlets[m];
+            if (sphereOutside(planes, lengths, meshlet.center, meshlet.radius)) {
+                stats.frustumCulled++;
+                continue;
+            }
+            if (coneTest && meshlet.coneCutoff < 1.0f) {
+                float toMeshlet[3] = {meshlet.center[0] - eye[0], meshlet.center[1] - eye[1],
+                                      meshlet.center[2] - eye[2]};
+                float distance = sqrtf(toMeshlet[0] * toMeshlet[0] + toMeshlet[1] * toMeshlet[1] +
+                                       toMeshlet[2] * toMeshlet[2]);
+                float along = toMeshlet[0] * meshlet.coneAxis[0] + toMeshlet[1] * meshlet.coneAxis[1] +
+                              toMeshlet[2] * meshlet.coneAxis[2];
+                if (along >= meshlet.coneCutoff * distance + meshlet.radius) {
+                    stats.backfaceCulled++;
+                    continue;
+                }
+            }
+            visible.push_back({m, (uint32_t)d});
+            stats.visibleTriangles += meshlet.triangleCount;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef MESHLET_CULL_H
+#define MESHLET_CULL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scene_loader.h"
+
+// Per-frame CPU culling of a scene's meshlets (see meshlet.h) against the
+// view frustum and their normal cones. The survivors become one indirect
+// command each (indirectRendererDrawMeshlets).
+
+// One meshlet of one draw that survived culling
+struct VisibleMeshlet {
+    uint32_t meshlet; // into SceneView::meshlets
+    uint32_t draw;    // into SceneView::draws
+};
+
+struct MeshletCullStats {
+    size_t draws = 0;
+    size_t drawsCulled = 0;     // whole mesh outside the frustum
+    size_t meshlets = 0;        // tested, including those of culled draws
+    size_t frustumCulled = 0;
+    size_t backfaceCulled = 0;
+    size_t triangles = 0;       // in every draw
+    size_t visibleTriangles = 0;
+};
+
+// The six planes (a, b, c, d) of a column-major clip matrix, inside where
+// a*x + b*y + c*z + d >= 0. Not normalized. Gribb and Hartmann, "Fast
+// Extraction of Viewing Frustum Planes from the World-View-Projection
+// Matrix", 2001.
+void frustumPlanes(const float clip[16], float planes[6][4]);
+
+// Replaces `visible` with the meshlets of every draw that may be seen from
+// `camera` through `viewProjection`, both in the scene's world space. Each
+// draw is tested in its own mesh space, so any affine world matrix works.
+void cullMeshlets(std::vector<VisibleMeshlet>& visible, const SceneView& scene, const float viewProjection[16],
+                  const float camera[3], MeshletCullStats& stats);
+
+#endif
@@ -0,0 +1,141 @@
+#include "particle_pool.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static const int POOL_ARRAYS = 8;
+
+bool particlePoolInit(ParticlePool& pool, size_t capacity) {
+    particlePoolFree(pool);
+
+    // Round up so the SIMD kernel can always run whole vectors past `count`
+    capacity = (capacity + PARTICLE_SIMD_WIDTH - 1) / PARTICLE_SIMD_WIDTH * PARTICLE_SIMD_WIDTH;
+    if (capacity == 0) capacity = PARTICLE_SIMD_WIDTH;
+
+    size_t arrayBytes = capacity * sizeof(float);
+    arrayBytes = (arrayBytes + PARTICLE_ALIGN - 1) / PARTICLE_ALIGN * PARTICLE_ALIGN;
+
+    void* storage = aligned_alloc(PARTICLE_ALIGN, arrayBytes * POOL_ARRAYS);
+    if (!storage) return false;
+    memset(storage, 0, arrayBytes * POOL_ARRAYS);
+
+    float* arrays[POOL_ARRAYS];
+    for (int i = 0; i < POOL_ARRAYS; i++) {
+        arrays[i] = (float*)((char*)storage + arrayBytes * i);
+    }
+
+    pool.capacity = capacity;
+    pool.count = 0;
+    pool.dropped = 0;
+    pool.x = arrays[0];
+    pool.y = arrays[1];
+    pool.velX = arrays[2];
+    pool.velY = arrays[3];
+    pool.life = arrays[4];
+    pool.r = arrays[5];
+    pool.g = arrays[6];
+    pool.b = arrays[7];
+    pool.storage = storage;
+    return true;
+}
+
+void particlePoolFree(ParticlePool& pool) {
+    free(pool.storage);
+    pool = ParticlePool();
+}
+
+bool particlePoolSpawn(ParticlePool& pool, float x, float y, float velX, float velY,
+                       float life, float r, float g, float b) {
+    if (pool.count == pool.capacity) {
+        pool.dropped++;
+        return false;
+    }
+    size_t i = pool.count++;
+    pool.x[i] = x;
+    pool.y[i] = y;
+    pool.velX[i] = velX;
+    pool.velY[i] = velY;
+    pool.life[i] = life;
+    pool.r[i] = r;
+    pool.g[i] = g;
+    pool.b[i] = b;
+    return true;
+}
+
+void particlePoolRemove(ParticlePool& pool, size_t index) {
+    size_t last = --pool.count;
+    pool.x[index] = pool.x[last];
+    pool.y[index] = pool.y[last];
+    pool.velX[index] = pool.velX[last];
+    pool.velY[index] = pool.velY[last];
+    pool.life[index] = pool.life[last];
+    pool.r[index] = pool.r[last];
+    pool.g[index] = pool.g[last];
+    pool.b[index] = pool.b[last];
+}
+
+void particlePoolClear(ParticlePool& pool) {
+    pool.count = 0;
+}
+
+static void integrate(ParticlePool& pool, float deltaTime) {
+    size_t n = pool.count;
+    size_t i = 0;
+
+#if defined(CGLM_AVX_FP)
+    __m256 dt = _mm256_set1_ps(deltaTime);
+    for (; i < n; i += 8) {
+        glmm_store256(pool.x + i, _mm256_add_ps(glmm_load256(pool.x + i),
+                                                _mm256_mul_ps(glmm_load256(pool.velX + i), dt)));
+        glmm_store256(pool.y + i, _mm256_add_ps(glmm_load256(pool.y + i),
+                                                _mm256_mul_ps(glmm_load256(pool.velY + i), dt)));
+        glmm_store256(pool.life + i, _mm256_sub_ps(glmm_load256(pool.life + i), dt));
+    }
+#elif defined(CGLM_SSE_FP)
+    __m128 dt = _mm_set1_ps(deltaTime);
+    for (; i < n; i += 4) {
+        glmm_store(pool.x + i, _mm_add_ps(glmm_load(pool.x + i),
+                                          _mm_mul_ps(glmm_load(pool.velX + i), dt)));
+        glmm_store(pool.y + i, _mm_add_ps(glmm_load(pool.y + i),
+                                          _mm_mul_ps(glmm_load(pool.velY + i), dt)));
+        glmm_store(pool.life + i, _mm_sub_ps(glmm_load(pool.life + i), dt));
+    }
+#else
+    for (; i < n; i++) {
+        pool.x[i] += pool.velX[i] * deltaTime;
+        pool.y[i] += pool.velY[i] * deltaTime;
+        pool.life[i] -= deltaTime;
+    }
+#endif
+}
+
+// True when none of the PARTICLE_SIMD_WIDTH particles starting at `i` died.
+// `i` is not necessarily a multiple of the vector width, so loads are unaligned.
+static inline bool allAlive(const float* life, size_t i) {
+#if defined(CGLM_AVX_FP)
+    __m256 dead = _mm256_cmp_ps(_mm256_loadu_ps(life + i), _mm256_setzero_ps(), _CMP_LE_OQ);
+    return _mm256_movemask_ps(dead) == 0;
+#elif defined(CGLM_SSE_FP)
+    __m128 dead = _mm_cmple_ps(_mm_loadu_ps(life + i), _mm_setzero_ps());
+    return _mm_movemask_ps(dead) == 0;
+#else
+    return life[i] > 0.0f;
+#endif
+}
+
+void particlePoolUpdate(ParticlePool& pool, float deltaTime) {
+    integrate(pool, deltaTime);
+
+    // Skip whole vectors of live particles, then swap-and-pop the dead ones.
+    // A particle swapped in from the end was already integrated this frame.
+    size_t i = 0;
+    while (i < pool.count) {
+        if (i + PARTICLE_SIMD_WIDTH <= pool.count && allAlive(pool.life, i)) {
+            i += PARTICLE_SIMD_WIDTH;
+        } else if (pool.life[i] <= 0.0f) {
+            particlePoolRemove(pool, i);
+        } else {
+            i++;
+        }
+    }
+}
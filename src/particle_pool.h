@@ -0,0 +1,52 @@
+#ifndef PARTICLE_POOL_H
+#define PARTICLE_POOL_H
+
+#include <cstddef>
+
+#include <cglm/common.h>
+#include <cglm/simd/intrin.h>
+
+// SIMD width and array alignment follow cglm: AVX builds use 8-wide lanes
+// and 32-byte alignment (CGLM_ALIGN_MAT), SSE builds 4-wide and 16-byte.
+#if defined(CGLM_AVX_FP)
+#  define PARTICLE_SIMD_WIDTH 8
+#  define PARTICLE_ALIGN 32
+#elif defined(CGLM_SSE_FP)
+#  define PARTICLE_SIMD_WIDTH 4
+#  define PARTICLE_ALIGN 16
+#else
+#  define PARTICLE_SIMD_WIDTH 1
+#  define PARTICLE_ALIGN 16
+#endif
+
+// Fixed-capacity structure-of-arrays particle storage. Live particles are
+// always packed in [0, count); dead ones are removed by swapping the last
+// live particle into their slot, so removal is O(1) and order is not kept.
+struct ParticlePool {
+    size_t capacity = 0; // rounded up to a multiple of PARTICLE_SIMD_WIDTH
+    size_t count = 0;
+    size_t dropped = 0;  // spawns rejected because the pool was full
+    float* x = nullptr;
+    float* y = nullptr;
+    float* velX = nullptr;
+    float* velY = nullptr;
+    float* life = nullptr;
+    float* r = nullptr;
+    float* g = nullptr;
+    float* b = nullptr;
+    void* storage = nullptr;
+};
+
+bool particlePoolInit(ParticlePool& pool, size_t capacity);
+void particlePoolFree(ParticlePool& pool);
+
+// Returns false (and counts a drop) when the pool is full
+bool particlePoolSpawn(ParticlePool& pool, float x, float y, float velX, float velY,
+                       float life, float r, float g, float b);
+void particlePoolRemove(ParticlePool& pool, size_t index);
+void particlePoolClear(ParticlePool& pool);
+
+// Integrates every live particle and removes the ones whose life ran out
+void particlePoolUpdate(ParticlePool& pool, float deltaTime);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef PARTICLE_RENDERER_H
+#define PARTICLE_RENDERER_H
+
+#include <GL/glew.h>
+#include <algorithm>
+
+#include "batch2d.h"
+#include "particle_pool.h"
+
+// Attribute locations the particle shader must use. Corner is per-vertex,
+// the rest advance once per instance.
+const GLuint PARTICLE_ATTRIB_CORNER = 0;
+const GLuint PARTICLE_ATTRIB_X = 1;
+const GLuint PARTICLE_ATTRIB_Y = 2;
+const GLuint PARTICLE_ATTRIB_R = 3;
+const GLuint PARTICLE_ATTRIB_G = 4;
+const GLuint PARTICLE_ATTRIB_B = 5;
+const GLuint PARTICLE_ATTRIB_LIFE = 6;
+
+const int PARTICLE_INSTANCE_STREAMS = 6;
+
+// Draws every live particle as an instanced quad in a single call. The
+// instance buffer mirrors the pool's structure-of-arrays layout: one region
+// of `capacity` floats per stream, each feeding a scalar attribute.
+struct ParticleRenderer {
+    GLuint vao = 0;
+    GLuint quadVbo = 0;
+    GLuint instanceVbo = 0;
+    size_t capacity = 0; // particles per stream
+};
+
+static void particleRendererBindStreams(ParticleRenderer& renderer) {
+    const GLuint attribs[PARTICLE_INSTANCE_STREAMS] = {
+        PARTICLE_ATTRIB_X, PARTICLE_ATTRIB_Y, PARTICLE_ATTRIB_R,
+        PARTICLE_ATTRIB_G, PARTICLE_ATTRIB_B, PARTICLE_ATTRIB_LIFE
+    };
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.instanceVbo);
+    glBufferData(GL_ARRAY_BUFFER, renderer.capacity * sizeof(float) * PARTICLE_INSTANCE_STREAMS,
+                 NULL, GL_STREAM_DRAW);
+    for (int i = 0; i < PARTICLE_INSTANCE_STREAMS; i++) {
+        glVertexAttribPointer(attribs[i], 1, GL_FLOAT, GL_FALSE, 0,
+                              (void*)(renderer.capacity * sizeof(float) * i));
+        glEnableVertexAttribArray(attribs[i]);
+        glVertexAttribDivisor(attribs[i], 1);
+    }
+}
+
+static void particleRendererInit(ParticleRenderer& renderer, size_t initialParticles,
+                                 FrameStats& stats) {
+    const float corners[] = {
+        -0.5f, -0.5f,
+         0.5f, -0.5f,
+        -0.5f,  0.5f,
+         0.5f,  0.5f
+    };
+
+    renderer.capacity = initialParticles;
+
+    glGenVertexArrays(1, &renderer.vao);
+    glGenBuffers(1, &renderer.quadVbo);
+    glGenBuffers(1, &renderer.instanceVbo);
+    glBindVertexArray(renderer.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.quadVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(PARTICLE_ATTRIB_CORNER, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glEnableVertexAttribArray(PARTICLE_ATTRIB_CORNER);
+
+    particleRendererBindStreams(renderer);
+    stats.bufferAllocs += 5;
+    stats.bufferUploads++;
+
+    glBindVertexArray(0);
+}
+
+static void particleRendererDestroy(ParticleRenderer& renderer) {
+    glDeleteVertexArrays(1, &renderer.vao);
+    glDeleteBuffers(1, &renderer.quadVbo);
+    glDeleteBuffers(1, &renderer.instanceVbo);
+    renderer = ParticleRenderer();
+}
+
+// Uploads the live prefix of each pool array and draws them with one
+// instanced call. The caller binds the program.
+static void particleRendererDraw(ParticleRenderer& renderer, const ParticlePool& pool,
+                                 FrameStats& stats) {
+    if (pool.count == 0) return;
+
+    glBindVertexArray(renderer.vao);
+    // Orphaned every frame (see FrameStats), regrown when the pool outgrows it
+    if (pool.count > renderer.capacity) {
+        renderer.capacity = std::max(pool.count, renderer.capacity * 2);
+        particleRendererBindStreams(renderer);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, renderer.instanceVbo);
+        glBufferData(GL_ARRAY_BUFFER, renderer.capacity * sizeof(float) * PARTICLE_INSTANCE_STREAMS,
+                     NULL, GL_STREAM_DRAW);
+    }
+    stats.bufferAllocs++;
+
+    const float* streams[PARTICLE_INSTANCE_STREAMS] = {
+        pool.x, pool.y, pool.r, pool.g, pool.b, pool.life
+    };
+    GLsizeiptr streamBytes = pool.count * sizeof(float);
+    for (int i = 0; i < PARTICLE_INSTANCE_STREAMS; i++) {
+        glBufferSubData(GL_ARRAY_BUFFER, renderer.capacity * sizeof(float) * i, streamBytes, streams[i]);
+        stats.bufferUploads++;
+    }
+
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)pool.count);
+    stats.drawCalls++;
+
+    glBindVertexArray(0);
+}
+
+#endif
@@ -2,6 +2,8 @@
 #include <GLFW/glfw3.h>
 #include <cmath>
 
+#include "../include/uniform_cache.h"
+
 
 // Window dimensions
 const unsigned int SCR_WIDTH = 800;
@@ -81,7 +83,7 @@ int main() {
 
     // Projection matrix (2D orthographic)
     float projection[8][8] = (-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
-    GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
+    GLuint projLoc = uniformLocationByName(shaderProgram, "projection");
     glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projection[0][0]);
 */
     // Game loop
@@ -151,13 +153,13 @@ void updateGame(float deltaTime) {
 // Rendering
 void renderObject(GameObject obj, GLuint shader, float r, float g, float b) {
     glUseProgram(shader);
-    glUniform3f(glGetUniformLocation(shader, "color"), r, g, b);
+    glUniform3f(uniformLocationByName(shader, "color"), r, g, b);
     
     float model[16] = (1.0f);
     model = glm::translate(model, glm::vec3(obj.x, obj.y, 0.0f));
     model = glm::scale(model, glm::vec3(obj.width, obj.height, 1.0f));
     
-    GLint modelLoc = glGetUniformLocation(shader, "model");
+    GLint modelLoc = uniformLocationByName(shader, "model");
     glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &model[0][0]);
     
     glBindVertexArray(VAO);
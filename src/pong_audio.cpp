@@ -0,0 +1,311 @@
+#include "pong_audio.h"
+
+#include <AL/al.h>
+#include <AL/alc.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "audio_mixer.h"
+#include "sound_bank.h"
+#include "spsc_queue.h"
+#include "thread_pool.h"
+
+const int SAMPLE_RATE = 44100;
+const int MAX_VOICES = 16;
+const size_t COMMAND_QUEUE_SIZE = 256;
+// Next to the executable, so the cache doesn't depend on where the game is
+// launched from
+const char* SOUND_CACHE_DIR = "sound_cache";
+
+// The device output keeps STREAM_BUFFERS blocks queued on one source, so
+// sounds start at most about STREAM_BUFFERS * BLOCK_FRAMES / SAMPLE_RATE
+// (~46 ms) after they are requested
+const size_t BLOCK_FRAMES = 512;
+const int STREAM_BUFFERS = 4;
+
+// Higher priority sounds may steal a voice from lower or equal ones
+const int SOUND_PRIORITY[SOUND_COUNT] = {
+    1, // SOUND_PADDLE
+    0, // SOUND_WALL
+    2  // SOUND_SCORE
+};
+
+struct AudioCommand {
+    SoundId sound;
+    float pan;
+};
+
+static ALCdevice* alDevice = nullptr;
+static ALCcontext* alContext = nullptr;
+static ALuint streamSource = 0;
+static ALuint streamBuffers[STREAM_BUFFERS];
+static WavFile wavFile;
+static AudioOutput audioOutput = AUDIO_OUTPUT_NULL;
+
+// Owned by the audio thread once it is running
+static Mixer mixer;
+static int soundIds[SOUND_COUNT];
+static int16_t pcmBlock[BLOCK_FRAMES * 2];
+
+static SpscQueue<AudioCommand, COMMAND_QUEUE_SIZE> commandQueue;
+static std::thread audioThread;
+static std::atomic<bool> audioRunning{false};
+
+static std::atomic<uint64_t> statRequests{0};
+static std::atomic<uint64_t> statPlayed{0};
+static std::atomic<uint64_t> statStolen{0};
+static std::atomic<uint64_t> statDroppedQueue{0};
+static std::atomic<uint64_t> statDroppedVoices{0};
+static std::atomic<uint64_t> statFramesMixed{0};
+static std::atomic<int> statActiveVoices{0};
+static std::atomic<int> statPeakVoices{0};
+
+// Bank entries are added in SoundId order
+static SoundDesc paddleSoundDesc() {
+    SoundDesc desc;
+    desc.wave = WAVE_SQUARE;
+    desc.freq = desc.freqEnd = 440.0f;
+    desc.duration = 0.1f;
+    desc.amplitude = 0.5f;
+    return desc;
+}
+
+static SoundDesc wallSoundDesc() {
+    SoundDesc desc;
+    desc.wave = WAVE_SINE;
+    desc.freq = desc.freqEnd = 880.0f;
+    desc.duration = 0.15f;
+    desc.amplitude = 0.5f;
+    return desc;
+}
+
+// Decays linearly to silence over the whole second
+static SoundDesc scoreSoundDesc() {
+    SoundDesc desc;
+    desc.wave = WAVE_SINE;
+    desc.freq = desc.freqEnd = 220.0f;
+    desc.duration = 1.0f;
+    desc.amplitude = 0.7f;
+    desc.decay = 1.0f;
+    desc.sustain = 0.0f;
+    return desc;
+}
+
+static bool openDevice() {
+    alDevice = alcOpenDevice(nullptr);
+    if (!alDevice) {
+        std::cerr << "Failed to open OpenAL device, mixing to the null output" << std::endl;
+        return false;
+    }
+
+    alContext = alcCreateContext(alDevice, nullptr);
+    if (!alContext) {
+        std::cerr << "Failed to create OpenAL context, mixing to the null output" << std::endl;
+        alcCloseDevice(alDevice);
+        alDevice = nullptr;
+        return false;
+    }
+    alcMakeContextCurrent(alContext);
+
+    alGenSources(1, &streamSource);
+    alGenBuffers(STREAM_BUFFERS, streamBuffers);
+    return true;
+}
+
+static void closeDevice() {
+    alSourceStop(streamSource);
+    alSourcei(streamSource, AL_BUFFER, 0);
+    alDeleteSources(1, &streamSource);
+    alDeleteBuffers(STREAM_BUFFERS, streamBuffers);
+
+    alcMakeContextCurrent(nullptr);
+    alcDestroyContext(alContext);
+    alcCloseDevice(alDevice);
+    alContext = nullptr;
+    alDevice = nullptr;
+}
+
+static void startQueuedSounds() {
+    AudioCommand command;
+    while (spscPop(commandQueue, command)) {
+        switch (mixerPlay(mixer, soundIds[command.sound], 1.0f, command.pan, SOUND_PRIORITY[command.sound])) {
+            case MIXER_STOLE:
+                statStolen.fetch_add(1, std::memory_order_relaxed);
+                // fall through
+            case MIXER_PLAYED:
+                statPlayed.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case MIXER_DROPPED:
+                statDroppedVoices.fetch_add(1, std::memory_order_relaxed);
+                break;
+        }
+    }
+}
+
+// Mixes the next block into pcmBlock and publishes the usage counters
+static void mixBlock() {
+    startQueuedSounds();
+    int active = mixerActiveVoices(mixer);
+    mixerMix(mixer, BLOCK_FRAMES);
+    mixerToPcm16(mixer, BLOCK_FRAMES, pcmBlock);
+
+    statFramesMixed.store(mixer.framesMixed, std::memory_order_relaxed);
+    statActiveVoices.store(active, std::memory_order_relaxed);
+    if (active > statPeakVoices.load(std::memory_order_relaxed)) {
+        statPeakVoices.store(active, std::memory_order_relaxed);
+    }
+}
+
+static void deviceLoop() {
+    for (ALuint buffer : streamBuffers) {
+        mixBlock();
+        alBufferData(buffer, AL_FORMAT_STEREO16, pcmBlock, sizeof(pcmBlock), SAMPLE_RATE);
+    }
+    alSourceQueueBuffers(streamSource, STREAM_BUFFERS, streamBuffers);
+    alSourcePlay(streamSource);
+
+    while (audioRunning.load(std::memory_order_acquire)) {
+        ALint processed = 0;
+        alGetSourcei(streamSource, AL_BUFFERS_PROCESSED, &processed);
+        if (processed == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        while (processed-- > 0) {
+            ALuint buffer;
+            alSourceUnqueueBuffers(streamSource, 1, &buffer);
+            mixBlock();
+            alBufferData(buffer, AL_FORMAT_STEREO16, pcmBlock, sizeof(pcmBlock), SAMPLE_RATE);
+            alSourceQueueBuffers(streamSource, 1, &buffer);
+        }
+
+        // The source stops if we fell behind and it ran dry
+        ALint state;
+        alGetSourcei(streamSource, AL_SOURCE_STATE, &state);
+        if (state != AL_PLAYING) {
+            alSourcePlay(streamSource);
+        }
+    }
+}
+
+// Without a device nothing drains the mix, so blocks are paced by the clock
+static void clockLoop() {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t blocks = 0;
+
+    while (audioRunning.load(std::memory_order_acquire)) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        uint64_t due = (uint64_t)(elapsed.count() * SAMPLE_RATE / BLOCK_FRAMES);
+        if (blocks >= due) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        for (; blocks < due; blocks++) {
+            mixBlock();
+            if (audioOutput == AUDIO_OUTPUT_WAV) {
+                wavWrite(wavFile, pcmBlock, BLOCK_FRAMES);
+            }
+        }
+    }
+}
+
+// Falls back to the working directory where the executable's path can't be
+// read (anywhere without /proc)
+static std::string soundCachePath() {
+    std::error_code error;
+    std::filesystem::path exe = std::filesystem::read_symlink("/proc/self/exe", error);
+    if (error || !exe.has_parent_path()) return SOUND_CACHE_DIR;
+    return (exe.parent_path() / SOUND_CACHE_DIR).string();
+}
+
+static void audioThreadLoop() {
+    if (audioOutput == AUDIO_OUTPUT_DEVICE) {
+        deviceLoop();
+    } else {
+        clockLoop();
+    }
+}
+
+bool audioInit(AudioOutput output, const char* wavPath) {
+    if (!mixerInit(mixer, SAMPLE_RATE, BLOCK_FRAMES, MAX_VOICES)) {
+        std::cerr << "Failed to allocate the audio mixer" << std::endl;
+        return false;
+    }
+
+    SoundBank bank;
+    bank.sampleRate = SAMPLE_RATE;
+    bank.cacheDir = soundCachePath();
+    soundBankAdd(bank, paddleSoundDesc());
+    soundBankAdd(bank, wallSoundDesc());
+    soundBankAdd(bank, scoreSoundDesc());
+    // One thread per sound; only cache misses have any work to spread
+    ThreadPool pool;
+    threadPoolInit(pool, SOUND_COUNT);
+    soundBankBuild(bank, &pool);
+    threadPoolShutdown(pool);
+
+    for (int i = 0; i < SOUND_COUNT; i++) {
+        soundIds[i] = mixerAddSound(mixer, bank.samples[i].data(), bank.samples[i].size());
+        if (soundIds[i] < 0) {
+            std::cerr << "Failed to allocate sound buffers" << std::endl;
+            mixerFree(mixer);
+            return false;
+        }
+    }
+
+    if (output == AUDIO_OUTPUT_DEVICE && !openDevice()) {
+        output = AUDIO_OUTPUT_NULL;
+    }
+    if (output == AUDIO_OUTPUT_WAV && !wavOpen(wavFile, wavPath, SAMPLE_RATE, 2)) {
+        std::cerr << "Failed to create " << wavPath << std::endl;
+        mixerFree(mixer);
+        return false;
+    }
+    audioOutput = output;
+
+    audioRunning.store(true, std::memory_order_release);
+    audioThread = std::thread(audioThreadLoop);
+    return true;
+}
+
+void audioShutdown() {
+    if (!audioRunning.load(std::memory_order_relaxed)) return;
+
+    audioRunning.store(false, std::memory_order_release);
+    audioThread.join();
+
+    if (audioOutput == AUDIO_OUTPUT_DEVICE) {
+        closeDevice();
+    } else if (audioOutput == AUDIO_OUTPUT_WAV) {
+        wavClose(wavFile);
+    }
+    mixerFree(mixer);
+}
+
+void audioPlay(SoundId sound, float pan) {
+    statRequests.fetch_add(1, std::memory_order_relaxed);
+    if (!audioRunning.load(std::memory_order_relaxed)) return;
+    if (!spscPush(commandQueue, AudioCommand{sound, pan})) {
+        statDroppedQueue.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+AudioStats audioStats() {
+    AudioStats stats;
+    stats.requests = statRequests.load(std::memory_order_relaxed);
+    stats.played = statPlayed.load(std::memory_order_relaxed);
+    stats.stolen = statStolen.load(std::memory_order_relaxed);
+    stats.droppedQueue = statDroppedQueue.load(std::memory_order_relaxed);
+    stats.droppedVoices = statDroppedVoices.load(std::memory_order_relaxed);
+    stats.framesMixed = statFramesMixed.load(std::memory_order_relaxed);
+    stats.output = audioOutput;
+    stats.activeVoices = statActiveVoices.load(std::memory_order_relaxed);
+    stats.peakVoices = statPeakVoices.load(std::memory_order_relaxed);
+    stats.totalVoices = MAX_VOICES;
+    return stats;
+}
@@ -0,0 +1,47 @@
+#ifndef PONG_AUDIO_H
+#define PONG_AUDIO_H
+
+#include <cstdint>
+
+enum AudioOutput {
+    AUDIO_OUTPUT_DEVICE, // stream the mix to OpenAL
+    AUDIO_OUTPUT_WAV,    // write the mix to a WAV file in real time
+    AUDIO_OUTPUT_NULL    // mix and discard, for machines without a sound device
+};
+
+enum SoundId {
+    SOUND_PADDLE,
+    SOUND_WALL,
+    SOUND_SCORE,
+    SOUND_COUNT
+};
+
+// Counters published by the audio thread. Safe to read from any thread.
+struct AudioStats {
+    uint64_t requests;      // audioPlay() calls
+    uint64_t played;        // requests that got a voice
+    uint64_t stolen;        // of those, how many cut off a lower-priority voice
+    uint64_t droppedQueue;  // lost because the command queue was full
+    uint64_t droppedVoices; // lost because every voice was busy with equal or higher priority
+    uint64_t framesMixed;
+    AudioOutput output;
+    int activeVoices;
+    int peakVoices;
+    int totalVoices;
+};
+
+// Synthesizes the sounds and starts the audio thread, which mixes every voice
+// itself and hands finished blocks to the output. AUDIO_OUTPUT_DEVICE falls
+// back to the null output when there is no OpenAL device. Returns false only
+// when the WAV file can't be created or memory runs out.
+bool audioInit(AudioOutput output = AUDIO_OUTPUT_DEVICE, const char* wavPath = nullptr);
+void audioShutdown();
+
+// Queues a sound for the audio thread. Never blocks and never calls into
+// OpenAL, so it is safe on the simulation thread. Pan goes from -1 (left)
+// to 1 (right).
+void audioPlay(SoundId sound, float pan = 0.0f);
+
+AudioStats audioStats();
+
+#endif
@@ -0,0 +1,243 @@
+// Runs Ultra Pong matches with no window, GL context or audio device, as
+// fast as the CPU allows, spread over a thread pool. Reports simulation
+// throughput and aggregated per-match stats.
+//
+//   pong_headless [--matches N] [--seed S] [--input ai|script] [--points P] [--hz rate]
+//                 [--threads T]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "pong_sim.h"
+#include "thread_pool.h"
+
+enum InputSource {
+    INPUT_AI,
+    INPUT_SCRIPT
+};
+
+// Per-paddle aiming error, re-rolled after every hit so the AI sometimes
+// misses. Paddles are 120 px tall, so an error past 60 px loses the point.
+struct AiState {
+    float leftAim = 0.0f;
+    float rightAim = 0.0f;
+};
+
+static void rerollAim(AiState& ai, Rng& rng) {
+    ai.leftAim = rngRange(rng, 141) - 70;
+    ai.rightAim = rngRange(rng, 141) - 70;
+}
+
+// Each paddle chases the ball while it is heading its way, otherwise it
+// drifts back to the middle
+static PaddleInput aiInput(const GameState& state, const AiState& ai) {
+    const float DEAD_ZONE = 4.0f;
+    float leftTarget = state.ballVelX < 0 ? state.ballY + ai.leftAim : HEIGHT / 2.0f;
+    float rightTarget = state.ballVelX > 0 ? state.ballY + ai.rightAim : HEIGHT / 2.0f;
+
+    PaddleInput input;
+    input.leftUp = state.leftPaddleY > leftTarget + DEAD_ZONE;
+    input.leftDown = state.leftPaddleY < leftTarget - DEAD_ZONE;
+    input.rightUp = state.rightPaddleY > rightTarget + DEAD_ZONE;
+    input.rightDown = state.rightPaddleY < rightTarget - DEAD_ZONE;
+    return input;
+}
+
+// Fixed sweep pattern: each paddle moves up and down with its own period
+static PaddleInput scriptInput(long tick, int simRate) {
+    double t = (double)tick / simRate;
+    PaddleInput input;
+    input.leftUp = fmod(t, 1.4) < 0.7;
+    input.leftDown = !input.leftUp;
+    input.rightUp = fmod(t, 1.1) < 0.55;
+    input.rightDown = !input.rightUp;
+    return input;
+}
+
+struct MatchConfig {
+    unsigned seed;
+    InputSource source;
+    int points;
+    int simRate;
+};
+
+struct MatchResult {
+    long ticks = 0;
+    int leftScore = 0;
+    int rightScore = 0;
+    bool abandoned = false;
+    int rallies = 0;      // points played
+    long rallyHits = 0;   // paddle hits over all rallies
+    int longestRally = 0;
+    float maxBallSpeed = 0.0f;
+};
+
+// Plays one full match. Its random stream is derived from the run seed and
+// the match index only, so results don't depend on thread scheduling.
+static MatchResult playMatch(const MatchConfig& config, int index) {
+    const float particleColor1[3] = {0.9f, 0.5f, 0.1f};
+    const float particleColor2[3] = {0.9f, 0.9f, 0.1f};
+    const float simStep = 1.0f / config.simRate;
+    const long maxTicks = 3600L * config.simRate; // give up on a match after an hour of game time
+
+    MatchResult result;
+    Match match;
+    if (!matchInit(match, config.seed, index)) {
+        result.abandoned = true;
+        return result;
+    }
+    resetBall(match, index % 2 == 0);
+    AiState ai;
+    rerollAim(ai, match.rng);
+
+    const GameState& state = match.state;
+    int rally = 0;
+    while (state.leftScore < config.points && state.rightScore < config.points && result.ticks < maxTicks) {
+        PaddleInput input = config.source == INPUT_AI ? aiInput(state, ai)
+                                                      : scriptInput(result.ticks, config.simRate);
+        updatePaddles(match.state, input, simStep);
+        unsigned events = updateGame(match, simStep, particleColor1, particleColor2);
+        updateParticles(match, simStep);
+        result.ticks++;
+
+        float speed = sqrtf(state.ballVelX * state.ballVelX + state.ballVelY * state.ballVelY);
+        result.maxBallSpeed = std::max(result.maxBallSpeed, speed);
+        if (events & SIM_EVENT_PADDLE_HIT) {
+            rally++;
+        }
+        if (events & SIM_EVENT_SCORED) {
+            result.rallies++;
+            result.rallyHits += rally;
+            result.longestRally = std::max(result.longestRally, rally);
+            rally = 0;
+        }
+        if (events & (SIM_EVENT_PADDLE_HIT | SIM_EVENT_SCORED)) {
+            rerollAim(ai, match.rng);
+        }
+    }
+
+    result.leftScore = state.leftScore;
+    result.rightScore = state.rightScore;
+    result.abandoned = result.ticks == maxTicks;
+    matchFree(match);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int matches = 100;
+    unsigned seed = 1;
+    InputSource source = INPUT_AI;
+    int points = 11;
+    int simRate = DEFAULT_SIM_RATE;
+    unsigned threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+            matches = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "ai") == 0) {
+                source = INPUT_AI;
+            } else if (strcmp(argv[i], "script") == 0) {
+                source = INPUT_SCRIPT;
+            } else {
+                fprintf(stderr, "Unknown input source: %s\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--points") == 0 && i + 1 < argc) {
+            points = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--hz") == 0 && i + 1 < argc) {
+            simRate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--matches N] [--seed S] [--input ai|script] [--points P] [--hz rate] "
+                    "[--threads T]\n", argv[0]);
+            return -1;
+        }
+    }
+    if (matches < 1 || points < 1 || simRate < 1) {
+        fprintf(stderr, "--matches, --points and --hz must be positive\n");
+        return -1;
+    }
+
+    MatchConfig config = {seed, source, points, simRate};
+    std::vector<MatchResult> results(matches);
+
+    ThreadPool pool;
+    threadPoolInit(pool, threads);
+
+    auto start = std::chrono::steady_clock::now();
+    threadPoolParallelFor(pool, matches, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            results[i] = playMatch(config, (int)i);
+        }
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    size_t workers = pool.workers.size();
+    threadPoolShutdown(pool);
+
+    // Aggregate in match order so the summary is the same for any thread count
+    long totalTicks = 0;
+    int leftWins = 0;
+    int rightWins = 0;
+    int abandoned = 0;
+    long winnerPoints = 0;
+    long loserPoints = 0;
+    long rallies = 0;
+    long rallyHits = 0;
+    int longestRally = 0;
+    double maxSpeedSum = 0.0;
+    float maxSpeed = 0.0f;
+    unsigned long long checksum = 1469598103934665603ULL;
+
+    for (const MatchResult& result : results) {
+        totalTicks += result.ticks;
+        if (result.abandoned) {
+            abandoned++;
+        } else if (result.leftScore > result.rightScore) {
+            leftWins++;
+        } else {
+            rightWins++;
+        }
+        winnerPoints += std::max(result.leftScore, result.rightScore);
+        loserPoints += std::min(result.leftScore, result.rightScore);
+        rallies += result.rallies;
+        rallyHits += result.rallyHits;
+        longestRally = std::max(longestRally, result.longestRally);
+        maxSpeedSum += result.maxBallSpeed;
+        maxSpeed = std::max(maxSpeed, result.maxBallSpeed);
+
+        // FNV-1a over the match outcome, to spot non-determinism between runs
+        unsigned long long outcome[3] = {(unsigned long long)result.ticks,
+                                         (unsigned long long)result.leftScore,
+                                         (unsigned long long)result.rightScore};
+        for (unsigned long long value : outcome) {
+            checksum = (checksum ^ value) * 1099511628211ULL;
+        }
+    }
+
+    const float simStep = 1.0f / simRate;
+    printf("%d matches (%s input, seed %u, first to %d, %d Hz) on %zu threads\n", matches,
+           source == INPUT_AI ? "ai" : "script", seed, points, simRate, workers);
+    printf("left wins %d, right wins %d, abandoned %d\n", leftWins, rightWins, abandoned);
+    printf("score: winner %.2f, loser %.2f on average\n",
+           winnerPoints / (double)matches, loserPoints / (double)matches);
+    printf("rallies: %ld, %.2f paddle hits on average, longest %d\n",
+           rallies, rallies ? rallyHits / (double)rallies : 0.0, longestRally);
+    printf("max ball speed: %.1f px/s on average per match, %.1f px/s overall\n",
+           maxSpeedSum / matches, maxSpeed);
+    printf("%ld ticks (%.1f h game time) in %.3f s\n", totalTicks, totalTicks * simStep / 3600.0,
+           elapsed.count());
+    printf("%.0f ticks/s, %.1f matches/s\n", totalTicks / elapsed.count(), matches / elapsed.count());
+    printf("checksum %016llx\n", checksum);
+    return 0;
+}
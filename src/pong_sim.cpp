@@ -0,0 +1,134 @@
+#include "pong_sim.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+bool matchInit(Match& match, uint64_t seed, uint64_t stream, size_t maxParticles) {
+    match.state = GameState();
+    rngSeed(match.rng, seed, stream);
+    return particlePoolInit(match.particles, maxParticles);
+}
+
+void matchFree(Match& match) {
+    particlePoolFree(match.particles);
+}
+
+void createParticles(Match& match, float x, float y, int count, const float* color1, const float* color2) {
+    for (int i = 0; i < count; i++) {
+        float velX = (rngRange(match.rng, 200) - 100) / 10.0f;
+        float velY = (rngRange(match.rng, 200) - 100) / 10.0f;
+        float life = 0.5f + (rngRange(match.rng, 100)) / 100.0f;
+        
+        // Interpolate between two colors
+        float t = (rngRange(match.rng, 100)) / 100.0f;
+        particlePoolSpawn(match.particles, x, y, velX, velY, life,
+                          color1[0] * t + color2[0] * (1 - t),
+                          color1[1] * t + color2[1] * (1 - t),
+                          color1[2] * t + color2[2] * (1 - t));
+    }
+}
+
+void updateParticles(Match& match, float deltaTime) {
+    particlePoolUpdate(match.particles, deltaTime);
+}
+
+void resetBall(Match& match, bool serveToRight) {
+    GameState& state = match.state;
+    state.ballX = WIDTH / 2.0f;
+    state.ballY = HEIGHT / 2.0f;
+    state.ballVelX = serveToRight ? INITIAL_BALL_SPEED : -INITIAL_BALL_SPEED;
+    state.ballVelY = (rngRange(match.rng, 200) - 100) / 100.0f * INITIAL_BALL_SPEED * 0.5f;
+    state.paused = true;
+    state.timeSinceHit = 0.0f;
+}
+
+void updatePaddles(GameState& state, const PaddleInput& input, float deltaTime) {
+    if (input.leftUp) state.leftPaddleY -= PADDLE_SPEED * deltaTime;
+    if (input.leftDown) state.leftPaddleY += PADDLE_SPEED * deltaTime;
+    if (input.rightUp) state.rightPaddleY -= PADDLE_SPEED * deltaTime;
+    if (input.rightDown) state.rightPaddleY += PADDLE_SPEED * deltaTime;
+    
+    // Keep paddles in bounds
+    state.leftPaddleY = std::max(60.0f, std::min((float)HEIGHT - 60.0f, state.leftPaddleY));
+    state.rightPaddleY = std::max(60.0f, std::min((float)HEIGHT - 60.0f, state.rightPaddleY));
+}
+
+unsigned updateGame(Match& match, float deltaTime, const float* particleColor1, const float* particleColor2) {
+    GameState& state = match.state;
+    unsigned events = 0;
+    
+    state.time += deltaTime;
+    
+    if (state.paused) {
+        if (state.time > 1.0) { // Wait 1 second before serving
+            state.paused = false;
+        }
+        return events;
+    }
+    
+    state.timeSinceHit += deltaTime;
+    
+    // Update ball position
+    state.ballX += state.ballVelX * deltaTime;
+    state.ballY += state.ballVelY * deltaTime;
+    
+    // Ball collision with top and bottom
+    if (state.ballY <= 0 || state.ballY >= HEIGHT) {
+        state.ballVelY = -state.ballVelY;
+        state.ballY = state.ballY <= 0 ? 0 : HEIGHT;
+        events |= SIM_EVENT_WALL_HIT;
+        createParticles(match, state.ballX, state.ballY, 20, particleColor1, particleColor2);
+    }
+    
+    // Ball collision with paddles
+    bool hit = false;
+    
+    // Left paddle
+    if (state.ballX <= 30 && state.ballX >= 20 && 
+        state.ballY >= state.leftPaddleY - 60 && state.ballY <= state.leftPaddleY + 60) {
+        float hitPos = (state.ballY - state.leftPaddleY) / 60.0f;
+        state.ballVelX = fabs(state.ballVelX) * BALL_ACCELERATION;
+        state.ballVelY = hitPos * PADDLE_SPEED * 0.8f;
+        state.ballX = 30;
+        hit = true;
+    }
+    
+    // Right paddle
+    if (state.ballX >= WIDTH - 30 && state.ballX <= WIDTH - 20 && 
+        state.ballY >= state.rightPaddleY - 60 && state.ballY <= state.rightPaddleY + 60) {
+        float hitPos = (state.ballY - state.rightPaddleY) / 60.0f;
+        state.ballVelX = -fabs(state.ballVelX) * BALL_ACCELERATION;
+        state.ballVelY = hitPos * PADDLE_SPEED * 0.8f;
+        state.ballX = WIDTH - 30;
+        hit = true;
+    }
+    
+    if (hit) {
+        events |= SIM_EVENT_PADDLE_HIT;
+        createParticles(match, state.ballX, state.ballY, 30, particleColor1, particleColor2);
+        state.timeSinceHit = 0.0f;
+        
+        // Limit ball speed
+        float speed = sqrt(state.ballVelX * state.ballVelX + state.ballVelY * state.ballVelY);
+        if (speed > MAX_BALL_SPEED) {
+            state.ballVelX = state.ballVelX / speed * MAX_BALL_SPEED;
+            state.ballVelY = state.ballVelY / speed * MAX_BALL_SPEED;
+        }
+    }
+    
+    // Ball out of bounds
+    if (state.ballX < 0) {
+        state.rightScore++;
+        events |= SIM_EVENT_RIGHT_SCORED;
+        createParticles(match, WIDTH / 4, HEIGHT / 2, 100, particleColor1, particleColor2);
+        resetBall(match, true);
+    } else if (state.ballX > WIDTH) {
+        state.leftScore++;
+        events |= SIM_EVENT_LEFT_SCORED;
+        createParticles(match, 3 * WIDTH / 4, HEIGHT / 2, 100, particleColor1, particleColor2);
+        resetBall(match, false);
+    }
+    
+    return events;
+}
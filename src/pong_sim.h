@@ -0,0 +1,79 @@
+#ifndef PONG_SIM_H
+#define PONG_SIM_H
+
+#include <cstddef>
+
+#include "particle_pool.h"
+#include "rng.h"
+
+// Ultra Pong game logic. Nothing in here touches GL, GLFW or OpenAL, so it
+// runs the same inside the windowed game and in headless tools.
+
+// Constants
+const int WIDTH = 1280;
+const int HEIGHT = 720;
+const float PADDLE_SPEED = 800.0f;
+const float INITIAL_BALL_SPEED = 400.0f;
+const float BALL_ACCELERATION = 1.05f;
+const float MAX_BALL_SPEED = 1200.0f;
+
+// Fixed-step simulation. Physics always advances by 1 / simRate seconds;
+// rendering interpolates between the last two simulated states.
+const int DEFAULT_SIM_RATE = 240;
+const int MAX_STEPS_PER_FRAME = 8; // catch-up cap, avoids the spiral of death
+
+// Game state
+struct GameState {
+    float leftPaddleY = HEIGHT / 2.0f;
+    float rightPaddleY = HEIGHT / 2.0f;
+    float ballX = WIDTH / 2.0f;
+    float ballY = HEIGHT / 2.0f;
+    float ballVelX = INITIAL_BALL_SPEED;
+    float ballVelY = 0.0f;
+    int leftScore = 0;
+    int rightScore = 0;
+    bool paused = true;
+    float timeSinceHit = 0.0f;
+    double time = 0.0; // simulated seconds since start
+};
+
+// Paddle controls sampled once per frame and applied on every sim step
+struct PaddleInput {
+    bool leftUp = false;
+    bool leftDown = false;
+    bool rightUp = false;
+    bool rightDown = false;
+};
+
+// What happened during a call to updateGame(), for sound and stats
+enum SimEvent {
+    SIM_EVENT_WALL_HIT = 1 << 0,
+    SIM_EVENT_PADDLE_HIT = 1 << 1,
+    SIM_EVENT_LEFT_SCORED = 1 << 2,
+    SIM_EVENT_RIGHT_SCORED = 1 << 3,
+    SIM_EVENT_SCORED = SIM_EVENT_LEFT_SCORED | SIM_EVENT_RIGHT_SCORED
+};
+
+// Particle system
+const size_t MAX_PARTICLES = 4096;
+
+// One independent game: its state, its particles and its own random
+// stream. Matches share nothing, so any number can run side by side.
+struct Match {
+    GameState state;
+    ParticlePool particles;
+    Rng rng;
+};
+
+bool matchInit(Match& match, uint64_t seed, uint64_t stream, size_t maxParticles = MAX_PARTICLES);
+void matchFree(Match& match);
+
+void createParticles(Match& match, float x, float y, int count, const float* color1, const float* color2);
+void updateParticles(Match& match, float deltaTime);
+void resetBall(Match& match, bool serveToRight);
+void updatePaddles(GameState& state, const PaddleInput& input, float deltaTime);
+
+// Advances the ball one step and returns a mask of SimEvent bits
+unsigned updateGame(Match& match, float deltaTime, const float* particleColor1, const float* particleColor2);
+
+#endif
@@ -1,31 +1,146 @@
-#define CGLTF_IMPLEMENTATION
-#include <cgltf/cgltf.h>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <vector>
+
+#include "indirect_renderer.h"
+#include "lod_select.h"
+#include "mesh_cache.h"
+#include "scene_bvh.h"
+#include "scene_import.h"
+#include "scene_loader.h"
+#include "thread_pool.h"
+#include "uniform_cache.h"
+#include "vertex_quantize.h"
 
 // Shader sources
+// One draw call per primitive, the node's world matrix set as a uniform
 const char* vertex_shader_source = R"glsl(
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+uniform mat4 model;
+uniform mat4 scene;
+uniform mat4 view;
+uniform mat4 projection;
+out vec3 normal;
+void main() {
+    mat4 world = scene * model;
+    normal = mat3(transpose(inverse(world))) * aNormal;
+    gl_Position = projection * view * world * vec4(aPos, 1.0);
+}
+)glsl";
+
+// One glMultiDrawElementsIndirect for the whole scene, world matrices fetched
+// from the transform SSBO by the draw index each command carries as its
+// base instance
+const char* indirect_vertex_shader_source = R"glsl(
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (std430, binding = 0) readonly buffer Transforms {
+    mat4 transforms[];
+};
+uniform mat4 scene;
+uniform mat4 view;
+uniform mat4 projection;
+out vec3 normal;
+void main() {
+    mat4 world = scene * transforms[gl_BaseInstanceARB];
+    normal = mat3(transpose(inverse(world))) * aNormal;
+    gl_Position = projection * view * world * vec4(aPos, 1.0);
+}
+)glsl";
+
+// --quantize: 16-byte vertices plus a 4-byte tangent (see vertex_quantize.h).
+// Positions come back from the mesh's bounds, normals and tangents from
+// their octahedral pairs, and the bitangent from the two and the sign in
+// aPos.w. The tangent frame is there for normal-mapping fragment shaders;
+// the default one only lights by the normal.
+const char* quantized_vertex_shader_source = R"glsl(
+#version 330 core
+layout (location = 0) in vec4 aPos;     // unorm16 within the mesh bounds, w the bitangent sign
+layout (location = 1) in vec2 aNormal;  // snorm16 octahedral
+layout (location = 3) in vec2 aTangent; // snorm16 octahedral
+uniform vec4 decode[2];                 // mesh bounds offset, scale
 uniform mat4 model;
+uniform mat4 scene;
 uniform mat4 view;
 uniform mat4 projection;
+out vec3 normal;
+out vec3 tangent;
+out vec3 bitangent;
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    mat4 world = scene * model;
+    vec3 position = decode[0].xyz + aPos.xyz * decode[1].xyz;
+    vec3 n = oct_decode(aNormal);
+    vec3 t = oct_decode(aTangent);
+    normal = mat3(transpose(inverse(world))) * n;
+    tangent = mat3(world) * t;
+    bitangent = mat3(world) * (cross(n, t) * (aPos.w * 2.0 - 1.0));
+    gl_Position = projection * view * world * vec4(position, 1.0);
+}
+)glsl";
+
+const char* quantized_indirect_vertex_shader_source = R"glsl(
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+layout (location = 0) in vec4 aPos;
+layout (location = 1) in vec2 aNormal;
+layout (location = 3) in vec2 aTangent;
+layout (std430, binding = 0) readonly buffer Transforms {
+    mat4 transforms[];
+};
+layout (std430, binding = 1) readonly buffer Decode {
+    vec4 decode[]; // per draw: mesh bounds offset, scale
+};
+uniform mat4 scene;
+uniform mat4 view;
+uniform mat4 projection;
+out vec3 normal;
+out vec3 tangent;
+out vec3 bitangent;
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+void main() {
+    mat4 world = scene * transforms[gl_BaseInstanceARB];
+    vec3 position = decode[gl_BaseInstanceARB * 2].xyz + aPos.xyz * decode[gl_BaseInstanceARB * 2 + 1].xyz;
+    vec3 n = oct_decode(aNormal);
+    vec3 t = oct_decode(aTangent);
+    normal = mat3(transpose(inverse(world))) * n;
+    tangent = mat3(world) * t;
+    bitangent = mat3(world) * (cross(n, t) * (aPos.w * 2.0 - 1.0));
+    gl_Position = projection * view * world * vec4(position, 1.0);
 }
 )glsl";
 
 const char* fragment_shader_source = R"glsl(
 #version 330 core
+in vec3 normal;
 out vec4 FragColor;
 void main() {
-    FragColor = vec4(0.8, 0.8, 0.8, 1.0); // Default gray color
+    // Default gray with a headlight-ish key light so primitives are told apart
+    float light = 0.3 + 0.7 * max(dot(normalize(normal), normalize(vec3(0.3, 0.5, 1.0))), 0.0);
+    FragColor = vec4(vec3(0.8) * light, 1.0);
 }
 )glsl";
 
@@ -45,8 +160,8 @@ GLuint compile_shader(GLenum type, const char* source) {
     return shader;
 }
 
-GLuint create_shader_program() {
-    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
+GLuint create_shader_program(const char* vertex_source) {
+    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
     GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
     
     GLuint program = glCreateProgram();
@@ -69,32 +184,139 @@ GLuint create_shader_program() {
     return program;
 }
 
-cgltf_data* load_gltf(const char* filename) {
-    cgltf_options options = {};
-    cgltf_data* data = NULL;
-    
-    if (cgltf_parse_file(&options, filename, &data) != cgltf_result_success) {
-        printf("Failed to parse GLTF file\n");
-        return NULL;
+// A loaded file, uploaded into its own buffers and placed next to the
+// previous one along X
+struct Model {
+    SceneView view;
+    QuantizedScene quantized; // decode constants only once uploaded
+    bool is_quantized;
+    IndirectRenderer renderer;
+    SceneBvh bvh; // over the draws in scene space, for indirect drawing
+    glm::vec3 offset;
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max; // after the offset
+};
+
+// Largest quantization error of each mesh, worst first, and the memory saved
+void print_quantize_stats(const QuantizedScene& quantized) {
+    size_t mesh_count = quantized.errors.size();
+    size_t vertex_count = quantized.vertices.size();
+    printf("  quantized %zu vertices: %.2f MB -> %.2f MB\n", vertex_count, vertex_count * sizeof(SceneVertex) / 1e6,
+           vertex_count * (sizeof(QuantizedVertex) + sizeof(QuantizedTangent)) / 1e6);
+    std::vector<size_t> order(mesh_count);
+    for (size_t m = 0; m < mesh_count; m++) {
+        order[m] = m;
     }
-    
-    if (cgltf_load_buffers(&options, data, filename) != cgltf_result_success) {
-        printf("Failed to load GLTF buffers\n");
-        cgltf_free(data);
-        return NULL;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return quantized.errors[a].positionRelative > quantized.errors[b].positionRelative;
+    });
+    const size_t shown = 8;
+    for (size_t i = 0; i < mesh_count && i < shown; i++) {
+        const QuantizeError& error = quantized.errors[order[i]];
+        printf("  mesh %zu: position %g (%.1e of its size), normal %.4f deg, tangent %.4f deg, bitangent %.4f deg, "
+               "uv %g\n", order[i], error.position, error.positionRelative, error.normalDegrees, error.tangentDegrees,
+               error.bitangentDegrees, error.uv);
     }
-    
-    if (cgltf_validate(data) != cgltf_result_success) {
-        printf("GLTF validation warnings\n");
-        // Continue anyway as validation might report non-critical issues
+    if (mesh_count > shown) {
+        printf("  ... %zu more meshes\n", mesh_count - shown);
+    }
+}
+
+void add_model(std::vector<Model>& models, const SceneView& view, bool indirect, bool quantize,
+               FrameStats& stats) {
+    Model model;
+    model.view = view;
+    model.is_quantized = quantize;
+    if (quantize) {
+        quantizeScene(model.quantized, view);
+        print_quantize_stats(model.quantized);
+        indirectRendererInitQuantized(model.renderer, view, model.quantized, stats);
+        std::vector<QuantizedVertex>().swap(model.quantized.vertices);
+        std::vector<QuantizedTangent>().swap(model.quantized.tangents);
+    } else {
+        indirectRendererInit(model.renderer, view, stats);
+    }
+    if (indirect) {
+        indirectRendererSetDraws(model.renderer, view, stats, quantize ? &model.quantized : nullptr);
+        sceneBvhBuild(model.bvh, view);
     }
     
-    return data;
+    glm::vec3 bounds_min = glm::make_vec3(view.boundsMin);
+    glm::vec3 bounds_max = glm::make_vec3(view.boundsMax);
+    float x = 0.0f;
+    if (!models.empty()) {
+        const Model& last = models.back();
+        x = last.bounds_max.x + (last.bounds_max.x - last.bounds_min.x) * 0.1f - bounds_min.x;
+    }
+    model.offset = glm::vec3(x, 0.0f, 0.0f);
+    model.bounds_min = bounds_min + model.offset;
+    model.bounds_max = bounds_max + model.offset;
+    models.push_back(model);
+}
+
+// Post-transform cache efficiency of the exporter's order against the
+// reordering done at import
+void print_cache_stats(const SceneStats& stats) {
+    printf("  ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (%zu triangles, FIFO cache of %d)\n",
+           vertexCacheAcmr(stats.cacheBefore), vertexCacheAcmr(stats.cacheAfter),
+           vertexCacheAtvr(stats.cacheBefore), vertexCacheAtvr(stats.cacheAfter),
+           stats.cacheAfter.triangles, VERTEX_CACHE_SIZE);
 }
 
 double lastX = 0, lastY = 0;
 float rotX = 0, rotY = 0;
 bool firstMouse = true;
+bool indirect_supported = false; // set once the context exists
+bool use_indirect = true;
+bool cull_meshlets = false;
+MeshletCullStats cull_stats; // summed over the models of the last frame
+bool select_lods = false;
+LodSelectStats lod_stats; // summed over the models of the last frame
+bool cull_draws = true;
+BvhCullStats draw_cull_stats; // summed over the models of the last frame
+
+void key_pressed(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (key == GLFW_KEY_I && action == GLFW_PRESS) {
+        if (!indirect_supported) {
+            printf("indirect drawing unavailable on this context\n");
+            return;
+        }
+        use_indirect = !use_indirect;
+        printf("%s\n", use_indirect ? "glMultiDrawElementsIndirect" : "one draw call per primitive");
+    }
+    if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+        cull_meshlets = !cull_meshlets;
+        select_lods = false;
+        printf("meshlet culling %s (indirect drawing only)\n", cull_meshlets ? "on" : "off");
+        if (!cull_meshlets && cull_stats.meshlets) {
+            printf("  last frame: %zu of %zu meshlets frustum culled, %zu backface culled, "
+                   "%zu of %zu triangles drawn\n", cull_stats.frustumCulled, cull_stats.meshlets,
+                   cull_stats.backfaceCulled, cull_stats.visibleTriangles, cull_stats.triangles);
+        }
+    }
+    if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+        select_lods = !select_lods;
+        cull_meshlets = false;
+        printf("level of detail selection %s (indirect drawing only)\n", select_lods ? "on" : "off");
+        if (!select_lods && lod_stats.draws) {
+            printf("  last frame: %zu draws,", lod_stats.draws);
+            for (uint32_t level = 0; level < SCENE_MAX_LODS; level++) {
+                printf(" %zu at lod %u%s", lod_stats.drawsAtLevel[level], level,
+                       level + 1 < SCENE_MAX_LODS ? "," : "");
+            }
+            printf(", %zu of %zu triangles drawn\n", lod_stats.selectedTriangles, lod_stats.triangles);
+        }
+    }
+    if (key == GLFW_KEY_F && action == GLFW_PRESS) {
+        cull_draws = !cull_draws;
+        printf("draw frustum culling %s (indirect drawing, not with meshlet culling)\n", cull_draws ? "on" : "off");
+        if (!cull_draws && draw_cull_stats.draws) {
+            printf("  last frame: %zu of %zu draws visible, %zu tree nodes visited, %zu leaves tested\n",
+                   draw_cull_stats.visible, draw_cull_stats.draws, draw_cull_stats.nodesVisited,
+                   draw_cull_stats.leavesTested);
+        }
+    }
+}
 
 void cursor_pos(GLFWwindow* window, double x, double y) {
     if (firstMouse) {
@@ -109,20 +331,25 @@ void cursor_pos(GLFWwindow* window, double x, double y) {
     lastY = y;
 }
 
-int main() {
+int main(int argc, char** argv) {
     // Initialize GLFW
     if (!glfwInit()) {
         printf("Failed to initialize GLFW\n");
         return -1;
     }
     
-    // Configure GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    // Configure GLFW: 4.3 for indirect drawing, 3.3 still runs the per-draw path
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     
     // Create window
     GLFWwindow* window = glfwCreateWindow(1200, 800, "GLTF Viewer", NULL, NULL);
+    if (!window) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(1200, 800, "GLTF Viewer", NULL, NULL);
+    }
     if (!window) {
         printf("Failed to create GLFW window\n");
         glfwTerminate();
@@ -140,116 +367,232 @@ int main() {
     
     // Set up callbacks
     glfwSetCursorPosCallback(window, cursor_pos);
+    glfwSetKeyCallback(window, key_pressed);
     
     // Configure OpenGL
     glEnable(GL_DEPTH_TEST);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     
-    // Create shader program
-    GLuint shader_program = create_shader_program();
-    glUseProgram(shader_program);
-    
-    // Load GLTF model
-    cgltf_data* gltf = load_gltf("../assets/bench_01.glb");
-    if (!gltf || gltf->meshes_count == 0) {
-        printf("Failed to load GLTF file or no meshes found\n");
-        glfwTerminate();
-        return 1;
-    }
-    
-    // Get the first mesh and primitive
-    cgltf_mesh* mesh = &gltf->meshes[0];
-    cgltf_primitive* prim = &mesh->primitives[0];
-    
-    // Extract position data
-    float* positions = NULL;
-    unsigned short* indices = NULL;
-    int num_positions = 0;
-    int num_indices = 0;
-    
-    for (cgltf_size i = 0; i < prim->attributes_count; ++i) {
-        cgltf_attribute* attr = &prim->attributes[i];
-        if (attr->type == cgltf_attribute_type_position) {
-            cgltf_accessor* acc = attr->data;
-            positions = (float*)((uint8_t*)acc->buffer_view->buffer->data + 
-                               acc->buffer_view->offset + 
-                               acc->offset);
-            num_positions = acc->count;
+    // --quantize uploads 20-byte vertices instead of the 48-byte float ones
+    bool quantize = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quantize") == 0) {
+            quantize = true;
+        } else {
+            paths.push_back(argv[i]);
         }
     }
-    
-    if (prim->indices) {
-        cgltf_accessor* acc = prim->indices;
-        indices = (unsigned short*)((uint8_t*)acc->buffer_view->buffer->data + 
-                                   acc->buffer_view->offset + 
-                                   acc->offset);
-        num_indices = acc->count;
+    if (paths.empty()) {
+        paths.push_back("../assets/bench_01.glb");
     }
     
-    // Create VAO, VBO, and EBO
-    GLuint VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    
-    glBindVertexArray(VAO);
+    // Create shader programs
+    GLuint shader_program = create_shader_program(quantize ? quantized_vertex_shader_source : vertex_shader_source);
+    indirect_supported = indirectRendererSupported();
+    GLuint indirect_program = indirect_supported
+        ? create_shader_program(quantize ? quantized_indirect_vertex_shader_source : indirect_vertex_shader_source)
+        : 0;
+    use_indirect = indirect_supported;
+    if (!indirect_supported) {
+        printf("GL 4.3 with ARB_shader_draw_parameters not available, drawing one primitive at a time\n");
+    }
     
-    // Position attribute
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, num_positions * 3 * sizeof(float), positions, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // Imports run on a thread pool: one file is read through the cooked cache
+    // (imported on the pool when stale), several go through an import batch
+    // and are uploaded one by one as the ready-queue hands them over
+    ThreadPool pool;
+    threadPoolInit(pool);
     
-    // Indices
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_indices * sizeof(unsigned short), indices, GL_STATIC_DRAW);
+    std::vector<Model> models;
+    FrameStats stats;
+    MeshCache cache;
+    SceneBatch batch;
+    if (paths.size() == 1) {
+        if (!meshCacheLoad(cache, paths[0].c_str(), &pool) || cache.view.drawCount == 0) {
+            printf("Failed to load GLTF file or no drawable meshes found\n");
+            threadPoolShutdown(pool);
+            glfwTerminate();
+            return 1;
+        }
+        printf("%s: %zu nodes, %zu primitives (%zu skipped)\n", paths[0].c_str(), cache.sceneStats.nodes,
+               cache.sceneStats.primitives, cache.sceneStats.skippedPrimitives);
+        print_cache_stats(cache.sceneStats);
+        printf("%s in %.2f ms\n", cache.stats.hit ? "Mapped cooked cache" : "Imported and cooked",
+               cache.stats.seconds * 1000.0);
+        add_model(models, cache.view, indirect_supported, quantize, stats);
+    } else {
+        sceneBatchStart(batch, pool, paths);
+    }
     
     // Get uniform locations
-    GLint model_loc = glGetUniformLocation(shader_program, "model");
-    GLint view_loc = glGetUniformLocation(shader_program, "view");
-    GLint proj_loc = glGetUniformLocation(shader_program, "projection");
+    GLint model_loc = uniformLocationByName(shader_program, "model");
+    GLint decode_loc = uniformLocationByName(shader_program, "decode");
+    GLint scene_loc[2] = {uniformLocationByName(shader_program, "scene"), -1};
+    GLint view_loc[2] = {uniformLocationByName(shader_program, "view"), -1};
+    GLint proj_loc[2] = {uniformLocationByName(shader_program, "projection"), -1};
+    if (indirect_supported) {
+        scene_loc[1] = uniformLocationByName(indirect_program, "scene");
+        view_loc[1] = uniformLocationByName(indirect_program, "view");
+        proj_loc[1] = uniformLocationByName(indirect_program, "projection");
+    }
     
-    // Projection matrix
-    glm::mat4 projection = glm::perspective(
-        glm::radians(40.0f), 
-        (float)1200 / (float)800, 
-        0.1f, 
-        100.0f
-    );
-    glUniformMatrix4fv(proj_loc, 1, GL_FALSE, glm::value_ptr(projection));
+    glm::vec3 center(0.0f);
+    float distance = 1.0f;
+    size_t framed_models = 0;
+    glm::mat4 projection(1.0f);
+    std::vector<VisibleMeshlet> visible;
+    std::vector<uint8_t> levels;
+    std::vector<uint32_t> visible_draws;
+    const float lod_pixels_per_unit = lodPixelsPerUnit(glm::radians(40.0f), 800.0f);
     
     // Main render loop
     while (!glfwWindowShouldClose(window)) {
+        // Upload whatever the import batch finished since the last frame
+        size_t ready;
+        while (sceneBatchPop(batch, ready, false)) {
+            const SceneImport& import = *batch.imports[ready];
+            if (!import.ok || import.scene.draws.empty()) {
+                printf("%s: failed to load or no drawable meshes\n", import.path.c_str());
+                continue;
+            }
+            printf("%s: %zu primitives ready after %.2f ms\n", import.path.c_str(),
+                   import.scene.stats.primitives, import.seconds * 1000.0);
+            print_cache_stats(import.scene.stats);
+            add_model(models, sceneView(import.scene), indirect_supported, quantize, stats);
+        }
+        
+        // Frame everything loaded so far: center it and back the camera off
+        // to fit its bounding sphere
+        if (framed_models != models.size()) {
+            framed_models = models.size();
+            glm::vec3 bounds_min = models[0].bounds_min;
+            glm::vec3 bounds_max = models[0].bounds_max;
+            for (const Model& model : models) {
+                bounds_min = glm::min(bounds_min, model.bounds_min);
+                bounds_max = glm::max(bounds_max, model.bounds_max);
+            }
+            center = (bounds_min + bounds_max) * 0.5f;
+            float radius = glm::max(glm::length(bounds_max - bounds_min) * 0.5f, 0.001f);
+            distance = radius / sinf(glm::radians(20.0f));
+            
+            // Projection matrix
+            projection = glm::perspective(
+                glm::radians(40.0f), 
+                (float)1200 / (float)800, 
+                distance * 0.01f, 
+                distance + radius * 2.0f
+            );
+            glUseProgram(shader_program);
+            glUniformMatrix4fv(proj_loc[0], 1, GL_FALSE, glm::value_ptr(projection));
+            if (indirect_supported) {
+                glUseProgram(indirect_program);
+                glUniformMatrix4fv(proj_loc[1], 1, GL_FALSE, glm::value_ptr(projection));
+            }
+        }
+        
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        int mode = use_indirect ? 1 : 0;
+        // Culling meshlets by their normal cones drops back faces, so have GL
+        // drop the remaining ones too and the picture doesn't change
+        bool culling = mode && cull_meshlets;
+        if (culling) {
+            glEnable(GL_CULL_FACE);
+        } else {
+            glDisable(GL_CULL_FACE);
+        }
+        glUseProgram(mode ? indirect_program : shader_program);
         
         // View matrix (camera)
         glm::mat4 view = glm::lookAt(
-            glm::vec3(0.0f, 0.0f, 3.0f),
+            glm::vec3(0.0f, 0.0f, distance),
             glm::vec3(0.0f, 0.0f, 0.0f),
             glm::vec3(0.0f, 1.0f, 0.0f)
         );
-        glUniformMatrix4fv(view_loc, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(view_loc[mode], 1, GL_FALSE, glm::value_ptr(view));
         
-        // Model matrix (object transformation)
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::rotate(model, glm::radians(rotX), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::rotate(model, glm::radians(rotY), glm::vec3(0.0f, 1.0f, 0.0f));
-        glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(model));
+        // Scene rotation, applied on top of each node's world transform
+        glm::mat4 rotation = glm::mat4(1.0f);
+        rotation = glm::rotate(rotation, glm::radians(rotX), glm::vec3(1.0f, 0.0f, 0.0f));
+        rotation = glm::rotate(rotation, glm::radians(rotY), glm::vec3(0.0f, 1.0f, 0.0f));
+        rotation = glm::translate(rotation, -center);
         
-        // Draw the mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, 0);
+        // Draw every node's primitives out of each model's shared buffers
+        bool lods = mode && select_lods;
+        if (culling) {
+            cull_stats = MeshletCullStats();
+        }
+        if (lods) {
+            lod_stats = LodSelectStats();
+        }
+        if (mode && cull_draws) {
+            draw_cull_stats = BvhCullStats();
+        }
+        for (Model& model : models) {
+            glm::mat4 placed = glm::translate(rotation, model.offset);
+            glUniformMatrix4fv(scene_loc[mode], 1, GL_FALSE, glm::value_ptr(placed));
+            if (culling) {
+                // Frustum and camera in the model's scene space
+                glm::mat4 view_projection = projection * view * placed;
+                glm::vec3 eye = glm::vec3(glm::inverse(placed) * glm::vec4(0.0f, 0.0f, distance, 1.0f));
+                MeshletCullStats model_stats;
+                cullMeshlets(visible, model.view, glm::value_ptr(view_projection), glm::value_ptr(eye), model_stats);
+                indirectRendererDrawMeshlets(model.renderer, model.view, visible, stats);
+                cull_stats.meshlets += model_stats.meshlets;
+                cull_stats.frustumCulled += model_stats.frustumCulled;
+                cull_stats.backfaceCulled += model_stats.backfaceCulled;
+                cull_stats.triangles += model_stats.triangles;
+                cull_stats.visibleTriangles += model_stats.visibleTriangles;
+            } else if (mode) {
+                if (lods) {
+                    // Errors under a pixel at the 800-pixel-high viewport
+                    glm::vec3 eye = glm::vec3(glm::inverse(placed) * glm::vec4(0.0f, 0.0f, distance, 1.0f));
+                    LodSelectStats model_stats;
+                    selectLods(levels, model.view, glm::value_ptr(eye), lod_pixels_per_unit, 1.0f, model_stats);
+                    lod_stats.draws += model_stats.draws;
+                    for (uint32_t level = 0; level < SCENE_MAX_LODS; level++) {
+                        lod_stats.drawsAtLevel[level] += model_stats.drawsAtLevel[level];
+                    }
+                    lod_stats.triangles += model_stats.triangles;
+                    lod_stats.selectedTriangles += model_stats.selectedTriangles;
+                }
+                if (cull_draws) {
+                    // Draws whose world box may be in view, frustum in the model's scene space
+                    glm::mat4 view_projection = projection * view * placed;
+                    BvhCullStats model_stats;
+                    sceneBvhCull(model.bvh, glm::value_ptr(view_projection), visible_draws, model_stats);
+                    indirectRendererDrawVisible(model.renderer, model.view, visible_draws, stats,
+                                                lods ? levels.data() : nullptr);
+                    draw_cull_stats.draws += model_stats.draws;
+                    draw_cull_stats.nodesVisited += model_stats.nodesVisited;
+                    draw_cull_stats.leavesTested += model_stats.leavesTested;
+                    draw_cull_stats.visible += model_stats.visible;
+                } else if (lods) {
+                    indirectRendererDrawLods(model.renderer, model.view, levels, stats);
+                } else {
+                    indirectRendererDraw(model.renderer, stats);
+                }
+            } else {
+                indirectRendererDrawEach(model.renderer, model.view, model_loc, stats,
+                                         model.is_quantized ? &model.quantized : nullptr, decode_loc);
+            }
+        }
         
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
     
-    // Cleanup
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    // Cleanup: imports still in flight reference the batch, let them finish
+    threadPoolWait(pool);
+    threadPoolShutdown(pool);
+    for (Model& model : models) {
+        indirectRendererDestroy(model.renderer);
+    }
+    meshCacheClose(cache);
     glDeleteProgram(shader_program);
-    cgltf_free(gltf);
+    if (indirect_supported) {
+        glDeleteProgram(indirect_program);
+    }
     glfwTerminate();
     
     return 0;
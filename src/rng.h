@@ -0,0 +1,40 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// PCG32 (pcg-random.org). Small, fast and splittable: every (seed, stream)
+// pair is an independent sequence, so parallel work can each own one
+// instead of sharing the global rand() state.
+struct Rng {
+    uint64_t state = 0x853c49e6748fea9bULL;
+    uint64_t inc = 0xda3e39cb94b95bdbULL;
+};
+
+static inline uint32_t rngNext(Rng& rng) {
+    uint64_t old = rng.state;
+    rng.state = old * 6364136223846793005ULL + rng.inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+static inline void rngSeed(Rng& rng, uint64_t seed, uint64_t stream) {
+    rng.state = 0;
+    rng.inc = (stream << 1u) | 1u;
+    rngNext(rng);
+    rng.state += seed;
+    rngNext(rng);
+}
+
+// Uniform integer in [0, n), drop-in for `rand() % n`
+static inline int rngRange(Rng& rng, int n) {
+    return (int)(rngNext(rng) % (uint32_t)n);
+}
+
+// Uniform float in [0, 1)
+static inline float rngFloat(Rng& rng) {
+    return (rngNext(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+#endif
@@ -0,0 +1,406 @@
+#include "scene_bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+#include <cglm/box.h>
+#include <cglm/frustum.h>
+
+// Bins per axis when looking for the cheapest split (Wald, "On fast
+// Construction of SAH-based Bounding Volume Hierarchies", 2007)
+const int BVH_BINS = 16;
+
+void sceneDrawBounds(const SceneView& scene, size_t draw, float boundsMin[3], float boundsMax[3]) {
+    const SceneDraw& d = scene.draws[draw];
+    const SceneMesh& mesh = scene.meshes[d.mesh];
+    mat4 world;
+    memcpy(world, d.world, sizeof(world));
+    vec3 box[2] = {{mesh.boundsMin[0], mesh.boundsMin[1], mesh.boundsMin[2]},
+                   {mesh.boundsMax[0], mesh.boundsMax[1], mesh.boundsMax[2]}};
+    vec3 out[2];
+    glm_aabb_transform(box, world, out);
+    memcpy(boundsMin, out[0], sizeof(vec3));
+    memcpy(boundsMax, out[1], sizeof(vec3));
+}
+
+static float surfaceArea(const float* boundsMin, const float* boundsMax) {
+    float x = std::max(boundsMax[0] - boundsMin[0], 0.0f);
+    float y = std::max(boundsMax[1] - boundsMin[1], 0.0f);
+    float z = std::max(boundsMax[2] - boundsMin[2], 0.0f);
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+// Draw boxes during a build, six floats each laid out like cglm's vec3[2]
+struct BvhBuilder {
+    SceneBvh& bvh;
+    std::vector<float> boxes;
+    std::vector<float> centroids;
+    uint32_t leafCount = 0;
+};
+
+static vec3* drawBox(BvhBuilder& builder, uint32_t draw) {
+    return (vec3*)&builder.boxes[draw * 6];
+}
+
+static void setBounds(BvhNode& node, vec3 box[2]) {
+    memcpy(node.boundsMin, box[0], sizeof(vec3));
+    memcpy(node.boundsMax, box[1], sizeof(vec3));
+}
+
+// Copies a leaf's draw boxes into its block, unused lanes zeroed
+static void writeLeaf(BvhBuilder& builder, uint32_t index) {
+    const BvhNode& node = builder.bvh.nodes[index];
+    float* block = &builder.bvh.leafBoxes[node.child * 6 * BVH_LEAF_SIZE];
+    memset(block, 0, 6 * BVH_LEAF_SIZE * sizeof(float));
+    for (uint32_t lane = 0; lane < node.itemCount; lane++) {
+        uint32_t item = builder.bvh.items[node.firstItem + lane];
+        builder.bvh.slots[item] = {index, lane};
+        const float* box = builder.boxes.data() + item * 6;
+        for (int row = 0; row < 6; row++) {
+            block[row * BVH_LEAF_SIZE + lane] = box[row];
+        }
+    }
+}
+
+// Median split along the longest centroid axis
+static uint32_t splitMedian(BvhBuilder& builder, uint32_t first, uint32_t count, int axis) {
+    uint32_t* items = builder.bvh.items.data() + first;
+    const float* centroids = builder.centroids.data();
+    std::nth_element(items, items + count / 2, items + count, [&](uint32_t a, uint32_t b) {
+        return centroids[a * 3 + axis] < centroids[b * 3 + axis];
+    });
+    return count / 2;
+}
+
+// Splits [first, first + count) at the binned split with the lowest
+// surface area cost and returns the size of the left part
+static uint32_t splitSah(BvhBuilder& builder, uint32_t first, uint32_t count, const float* centroidMin,
+                         const float* centroidMax) {
+    uint32_t* items = builder.bvh.items.data() + first;
+    const float* centroids = builder.centroids.data();
+
+    float bestCost = FLT_MAX;
+    int bestAxis = -1;
+    int bestBin = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f) continue;
+        float scale = BVH_BINS / extent;
+
+        vec3 bins[BVH_BINS][2];
+        uint32_t binCounts[BVH_BINS] = {};
+        for (int b = 0; b < BVH_BINS; b++) glm_aabb_invalidate(bins[b]);
+        for (uint32_t i = 0; i < count; i++) {
+            int b = std::min((int)((centroids[items[i] * 3 + axis] - centroidMin[axis]) * scale), BVH_BINS - 1);
+            binCounts[b]++;
+            glm_aabb_merge(bins[b], drawBox(builder, items[i]), bins[b]);
+        }
+
+        // Right-hand areas swept from the end, then left-hand ones from the start
+        float rightArea[BVH_BINS];
+        uint32_t rightCount[BVH_BINS];
+        vec3 sweep[2];
+        glm_aabb_invalidate(sweep);
+        uint32_t sum = 0;
+        for (int b = BVH_BINS - 1; b > 0; b--) {
+            glm_aabb_merge(sweep, bins[b], sweep);
+            sum += binCounts[b];
+            rightArea[b] = sum ? surfaceArea(sweep[0], sweep[1]) : 0.0f;
+            rightCount[b] = sum;
+        }
+        glm_aabb_invalidate(sweep);
+        sum = 0;
+        for (int b = 1; b < BVH_BINS; b++) {
+            glm_aabb_merge(sweep, bins[b - 1], sweep);
+            sum += binCounts[b - 1];
+            if (sum == 0 || rightCount[b] == 0) continue;
+            float cost = surfaceArea(sweep[0], sweep[1]) * sum + rightArea[b] * rightCount[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+    if (bestAxis < 0) return count / 2; // every centroid in one spot, any split will do
+
+    float scale = BVH_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+    uint32_t* middle = std::partition(items, items + count, [&](uint32_t item) {
+        int b = std::min((int)((centroids[item * 3 + bestAxis] - centroidMin[bestAxis]) * scale), BVH_BINS - 1);
+        return b < bestBin;
+    });
+    return (uint32_t)(middle - items);
+}
+
+static void buildNode(BvhBuilder& builder, uint32_t index, uint32_t first, uint32_t count, uint32_t depth) {
+    SceneBvh& bvh = builder.bvh;
+    vec3 box[2];
+    vec3 centroidBox[2];
+    glm_aabb_invalidate(box);
+    glm_aabb_invalidate(centroidBox);
+    for (uint32_t i = first; i < first + count; i++) {
+        uint32_t item = bvh.items[i];
+        glm_aabb_merge(box, drawBox(builder, item), box);
+        const float* centroid = &builder.centroids[item * 3];
+        vec3 point[2] = {{centroid[0], centroid[1], centroid[2]}, {centroid[0], centroid[1], centroid[2]}};
+        glm_aabb_merge(centroidBox, point, centroidBox);
+    }
+
+    BvhNode& node = bvh.nodes[index];
+    setBounds(node, box);
+    node.firstItem = first;
+    node.itemCount = count;
+    if (count <= BVH_LEAF_SIZE) {
+        node.leaf = 1;
+        node.child = builder.leafCount++;
+        bvh.leafBoxes.resize(builder.leafCount * 6 * BVH_LEAF_SIZE);
+        writeLeaf(builder, index);
+        return;
+    }
+
+    // Splitting at the median from here on would just fit under
+    // BVH_MAX_DEPTH, so stop following the heuristic
+    uint32_t medianDepth = 0;
+    for (uint32_t n = count; n > BVH_LEAF_SIZE; n = (n + 1) / 2) medianDepth++;
+    uint32_t leftCount;
+    if (depth + medianDepth + 1 >= BVH_MAX_DEPTH) {
+        int axis = 0;
+        for (int k = 1; k < 3; k++) {
+            float extent = centroidBox[1][k] - centroidBox[0][k];
+            if (extent > centroidBox[1][axis] - centroidBox[0][axis]) axis = k;
+        }
+        leftCount = splitMedian(builder, first, count, axis);
+    } else {
+        leftCount = splitSah(builder, first, count, centroidBox[0], centroidBox[1]);
+    }
+
+    uint32_t left = (uint32_t)bvh.nodes.size();
+    bvh.nodes.resize(left + 2);
+    bvh.parents.resize(left + 2, index);
+    bvh.nodes[index].leaf = 0;
+    bvh.nodes[index].child = left;
+    buildNode(builder, left, first, leftCount, depth + 1);
+    buildNode(builder, left + 1, first + leftCount, count - leftCount, depth + 1);
+}
+
+void sceneBvhBuild(SceneBvh& bvh, const SceneView& scene) {
+    bvh.nodes.clear();
+    bvh.parents.clear();
+    bvh.items.resize(scene.drawCount);
+    bvh.slots.resize(scene.drawCount);
+    bvh.leafBoxes.clear();
+    bvh.builds++;
+    if (scene.drawCount == 0) {
+        bvh.builtCost = 0.0f;
+        return;
+    }
+
+    BvhBuilder builder = {bvh, {}, {}, 0};
+    builder.boxes.resize(scene.drawCount * 6);
+    builder.centroids.resize(scene.drawCount * 3);
+    for (size_t d = 0; d < scene.drawCount; d++) {
+        float* box = &builder.boxes[d * 6];
+        sceneDrawBounds(scene, d, box, box + 3);
+        for (int k = 0; k < 3; k++) {
+            builder.centroids[d * 3 + k] = (box[k] + box[3 + k]) * 0.5f;
+        }
+        bvh.items[d] = (uint32_t)d;
+    }
+
+    bvh.nodes.reserve(scene.drawCount / BVH_LEAF_SIZE * 4 + 1);
+    bvh.nodes.resize(1);
+    bvh.parents.resize(1, 0);
+    buildNode(builder, 0, 0, (uint32_t)scene.drawCount, 0);
+    bvh.builtCost = sceneBvhCost(bvh);
+}
+
+// Writes one draw's current box into its leaf's block
+static void refitDraw(SceneBvh& bvh, const SceneView& scene, uint32_t draw) {
+    const BvhSlot& slot = bvh.slots[draw];
+    float* block = &bvh.leafBoxes[bvh.nodes[slot.leaf].child * 6 * BVH_LEAF_SIZE];
+    float box[6];
+    sceneDrawBounds(scene, draw, box, box + 3);
+    for (int row = 0; row < 6; row++) {
+        block[row * BVH_LEAF_SIZE + slot.lane] = box[row];
+    }
+}
+
+// A node's bounds from its leaf block or its two children
+static void refitNode(SceneBvh& bvh, BvhNode& node) {
+    vec3 box[2];
+    glm_aabb_invalidate(box);
+    if (node.leaf) {
+        const float* block = &bvh.leafBoxes[node.child * 6 * BVH_LEAF_SIZE];
+        for (uint32_t lane = 0; lane < node.itemCount; lane++) {
+            vec3 drawBox[2];
+            for (int row = 0; row < 6; row++) {
+                drawBox[row / 3][row % 3] = block[row * BVH_LEAF_SIZE + lane];
+            }
+            glm_aabb_merge(box, drawBox, box);
+        }
+    } else {
+        for (uint32_t c = node.child; c < node.child + 2; c++) {
+            const BvhNode& child = bvh.nodes[c];
+            vec3 childBox[2] = {{child.boundsMin[0], child.boundsMin[1], child.boundsMin[2]},
+                                {child.boundsMax[0], child.boundsMax[1], child.boundsMax[2]}};
+            glm_aabb_merge(box, childBox, box);
+        }
+    }
+    setBounds(node, box);
+}
+
+static bool rebuildIfWorse(SceneBvh& bvh, const SceneView& scene) {
+    if (sceneBvhCost(bvh) <= bvh.builtCost * BVH_REBUILD_RATIO) return false;
+    sceneBvhBuild(bvh, scene);
+    return true;
+}
+
+bool sceneBvhRefit(SceneBvh& bvh, const SceneView& scene) {
+    // Draws in their own order, so their matrices are read front to back
+    for (size_t d = 0; d < scene.drawCount; d++) {
+        refitDraw(bvh, scene, (uint32_t)d);
+    }
+    // Children always follow their parent, so walking backwards refits
+    // both of them before the node above
+    for (size_t i = bvh.nodes.size(); i-- > 0;) {
+        refitNode(bvh, bvh.nodes[i]);
+    }
+    return rebuildIfWorse(bvh, scene);
+}
+
+bool sceneBvhRefitDraws(SceneBvh& bvh, const SceneView& scene, const uint32_t* draws, size_t count) {
+    bvh.dirty.assign(bvh.nodes.size(), 0);
+    for (size_t i = 0; i < count; i++) {
+        refitDraw(bvh, scene, draws[i]);
+        // Mark the path up, stopping where another draw already did
+        for (uint32_t n = bvh.slots[draws[i]].leaf; !bvh.dirty[n]; n = bvh.parents[n]) {
+            bvh.dirty[n] = 1;
+            if (n == 0) break;
+        }
+    }
+    for (size_t i = bvh.nodes.size(); i-- > 0;) {
+        if (bvh.dirty[i]) refitNode(bvh, bvh.nodes[i]);
+    }
+    return rebuildIfWorse(bvh, scene);
+}
+
+float sceneBvhCost(const SceneBvh& bvh) {
+    if (bvh.nodes.empty()) return 0.0f;
+    float rootArea = surfaceArea(bvh.nodes[0].boundsMin, bvh.nodes[0].boundsMax);
+    if (rootArea <= 0.0f) return 1.0f;
+    // One plane test per node either way, a leaf's being a vector of boxes
+    float area = 0.0f;
+    for (const BvhNode& node : bvh.nodes) {
+        area += surfaceArea(node.boundsMin, node.boundsMax);
+    }
+    return area / rootArea;
+}
+
+// Bit per lane of a leaf whose box isn't behind any of the planes in
+// `planeMask`; the same test as glm_aabb_frustum, on a whole leaf at once
+static uint32_t leafVisible(const float* block, uint32_t count, vec4 planes[6], uint32_t planeMask) {
+    uint32_t lanes = (1u << count) - 1;
+#if defined(CGLM_AVX_FP)
+    __m256 outside = _mm256_setzero_ps();
+    for (int p = 0; p < 6; p++) {
+        if (!(planeMask & (1u << p))) continue;
+        const float* plane = planes[p];
+        // Per axis, the box's corner furthest along the plane's normal
+        __m256 x = _mm256_loadu_ps(block + (plane[0] > 0.0f ? 3 : 0) * BVH_LEAF_SIZE);
+        __m256 y = _mm256_loadu_ps(block + (plane[1] > 0.0f ? 4 : 1) * BVH_LEAF_SIZE);
+        __m256 z = _mm256_loadu_ps(block + (plane[2] > 0.0f ? 5 : 2) * BVH_LEAF_SIZE);
+        __m256 dp = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[0]), x),
+                                                _mm256_mul_ps(_mm256_set1_ps(plane[1]), y)),
+                                  _mm256_mul_ps(_mm256_set1_ps(plane[2]), z));
+        outside = _mm256_or_ps(outside, _mm256_cmp_ps(dp, _mm256_set1_ps(-plane[3]), _CMP_LT_OQ));
+    }
+    return ~(uint32_t)_mm256_movemask_ps(outside) & lanes;
+#elif defined(CGLM_SSE_FP)
+    __m128 outside = _mm_setzero_ps();
+    for (int p = 0; p < 6; p++) {
+        if (!(planeMask & (1u << p))) continue;
+        const float* plane = planes[p];
+        __m128 x = _mm_loadu_ps(block + (plane[0] > 0.0f ? 3 : 0) * BVH_LEAF_SIZE);
+        __m128 y = _mm_loadu_ps(block + (plane[1] > 0.0f ? 4 : 1) * BVH_LEAF_SIZE);
+        __m128 z = _mm_loadu_ps(block + (plane[2] > 0.0f ? 5 : 2) * BVH_LEAF_SIZE);
+        __m128 dp = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), x), _mm_mul_ps(_mm_set1_ps(plane[1]), y)),
+                               _mm_mul_ps(_mm_set1_ps(plane[2]), z));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(dp, _mm_set1_ps(-plane[3])));
+    }
+    return ~(uint32_t)_mm_movemask_ps(outside) & lanes;
+#else
+    (void)planeMask;
+    uint32_t visible = 0;
+    for (uint32_t lane = 0; lane < count; lane++) {
+        vec3 box[2];
+        for (int row = 0; row < 6; row++) {
+            box[row / 3][row % 3] = block[row * BVH_LEAF_SIZE + lane];
+        }
+        if (glm_aabb_frustum(box, planes)) visible |= 1u << lane;
+    }
+    return visible & lanes;
+#endif
+}
+
+void sceneBvhCull(const SceneBvh& bvh, const float viewProjection[16], std::vector<uint32_t>& visible,
+                  BvhCullStats& stats) {
+    visible.clear();
+    stats = BvhCullStats();
+    stats.draws = bvh.items.size();
+    if (bvh.nodes.empty()) return;
+
+    mat4 clip;
+    memcpy(clip, viewProjection, sizeof(clip));
+    vec4 planes[6];
+    glm_frustum_planes(clip, planes);
+
+    // Each entry carries the planes its node's parent still straddled; a
+    // node entirely inside one of them passes it to no descendant
+    struct Entry {
+        uint32_t node;
+        uint32_t planeMask;
+    };
+    Entry stack[BVH_MAX_DEPTH + 1];
+    uint32_t size = 0;
+    stack[size++] = {0, 0x3f};
+    while (size) {
+        Entry entry = stack[--size];
+        const BvhNode& node = bvh.nodes[entry.node];
+        stats.nodesVisited++;
+
+        bool outside = false;
+        uint32_t planeMask = entry.planeMask;
+        for (int p = 0; p < 6 && !outside; p++) {
+            if (!(planeMask & (1u << p))) continue;
+            const float* plane = planes[p];
+            float furthest = plane[0] * (plane[0] > 0.0f ? node.boundsMax[0] : node.boundsMin[0]) +
+                             plane[1] * (plane[1] > 0.0f ? node.boundsMax[1] : node.boundsMin[1]) +
+                             plane[2] * (plane[2] > 0.0f ? node.boundsMax[2] : node.boundsMin[2]);
+            float nearest = plane[0] * (plane[0] > 0.0f ? node.boundsMin[0] : node.boundsMax[0]) +
+                            plane[1] * (plane[1] > 0.0f ? node.boundsMin[1] : node.boundsMax[1]) +
+                            plane[2] * (plane[2] > 0.0f ? node.boundsMin[2] : node.boundsMax[2]);
+            outside = furthest < -plane[3];
+            if (nearest >= -plane[3]) planeMask &= ~(1u << p);
+        }
+        if (outside) continue;
+
+        const uint32_t* items = bvh.items.data() + node.firstItem;
+        if (planeMask == 0) {
+            stats.nodesAccepted++;
+            visible.insert(visible.end(), items, items + node.itemCount);
+        } else if (node.leaf) {
+            stats.leavesTested++;
+            stats.boxesTested += node.itemCount;
+            uint32_t lanes = leafVisible(&bvh.leafBoxes[node.child * 6 * BVH_LEAF_SIZE], node.itemCount, planes,
+                                         planeMask);
+            for (; lanes; lanes &= lanes - 1) {
+                visible.push_back(items[__builtin_ctz(lanes)]);
+            }
+        } else {
+            stack[size++] = {node.child + 1, planeMask};
+            stack[size++] = {node.child, planeMask};
+        }
+    }
+    stats.visible = visible.size();
+}
@@ -0,0 +1,95 @@
+#ifndef SCENE_BVH_H
+#define SCENE_BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <cglm/common.h>
+#include <cglm/simd/intrin.h>
+
+#include "scene_loader.h"
+
+// Bounding volume hierarchy over a scene's draws for per-frame frustum
+// culling. Each draw's mesh bounds go through its world matrix into a world
+// AABB; the tree is built top-down with the surface area heuristic and
+// refitted in place when the matrices move.
+
+// A leaf holds one SIMD vector of draws and is tested against the frustum in
+// one go: 8 boxes per test in AVX builds, 4 in SSE builds (see particle_pool.h).
+#if defined(CGLM_AVX_FP)
+#  define BVH_LEAF_SIZE 8
+#else
+#  define BVH_LEAF_SIZE 4
+#endif
+
+// Deep enough for any tree sceneBvhBuild makes; it falls back to median
+// splits before the traversal stack could overflow
+const uint32_t BVH_MAX_DEPTH = 64;
+
+// A refit that makes the tree this much more expensive to traverse than
+// when it was built rebuilds it instead
+const float BVH_REBUILD_RATIO = 1.5f;
+
+struct BvhNode {
+    float boundsMin[3];
+    uint32_t firstItem; // into SceneBvh::items; a subtree's draws are contiguous
+    float boundsMax[3];
+    uint32_t itemCount;
+    uint32_t child; // interior: left child, the right one follows it; leaf: its block in leafBoxes
+    uint32_t leaf;
+};
+
+// Where a draw's box sits: its leaf node and lane within the leaf's block
+struct BvhSlot {
+    uint32_t leaf;
+    uint32_t lane;
+};
+
+struct SceneBvh {
+    std::vector<BvhNode> nodes; // nodes[0] is the root, children after parents
+    std::vector<uint32_t> parents; // per node, the root's is itself
+    std::vector<uint32_t> items; // draw indices, in leaf order
+    std::vector<BvhSlot> slots;  // per draw
+    std::vector<uint8_t> dirty;  // per node, scratch for sceneBvhRefitDraws
+    // Per leaf, its draws' world boxes as six rows of BVH_LEAF_SIZE floats:
+    // min x, min y, min z, max x, max y, max z
+    std::vector<float> leafBoxes;
+    float builtCost = 0.0f; // sceneBvhCost right after the last build
+    size_t builds = 0;
+};
+
+struct BvhCullStats {
+    size_t draws = 0;
+    size_t nodesVisited = 0;
+    size_t nodesAccepted = 0; // entirely inside, their draws taken untested
+    size_t leavesTested = 0;
+    size_t boxesTested = 0;
+    size_t visible = 0;
+};
+
+// World AABB of one draw: its mesh's bounds through its world matrix
+void sceneDrawBounds(const SceneView& scene, size_t draw, float boundsMin[3], float boundsMax[3]);
+
+void sceneBvhBuild(SceneBvh& bvh, const SceneView& scene);
+
+// Recomputes every draw's box and the nodes above it, keeping the tree's
+// shape. Returns true when the refitted tree's cost passed
+// BVH_REBUILD_RATIO and it was rebuilt instead. The draw count must not change.
+bool sceneBvhRefit(SceneBvh& bvh, const SceneView& scene);
+
+// The same for only the listed draws and the nodes above them, for when a
+// few of many draws moved
+bool sceneBvhRefitDraws(SceneBvh& bvh, const SceneView& scene, const uint32_t* draws, size_t count);
+
+// Expected traversal cost under the surface area heuristic, relative to
+// testing the root alone
+float sceneBvhCost(const SceneBvh& bvh);
+
+// Replaces `visible` with the draws whose world box isn't entirely outside
+// one of the frustum planes of `viewProjection` (column-major, scene world
+// space), in tree order. Same result as glm_aabb_frustum on every draw.
+void sceneBvhCull(const SceneBvh& bvh, const float viewProjection[16], std::vector<uint32_t>& visible,
+                  BvhCullStats& stats);
+
+#endif
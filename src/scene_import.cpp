@@ -0,0 +1,210 @@
+#include "scene_import.h"
+
+#include <cgltf/cgltf.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "thread_pool.h"
+#include "timing.h"
+
+const size_t UNPACK_GRAIN = 16384; // vertices per unpack job
+
+// Everything one file needs while its jobs are in flight
+struct SceneImportFile {
+    SceneBatch* batch = nullptr;
+    ThreadPool* pool = nullptr;
+    size_t index = 0;
+    cgltf_options options = {};
+    cgltf_data* data = nullptr;
+    SceneImportPlan plan;
+    std::atomic<size_t> remaining{0}; // jobs of the current stage still running
+    std::atomic<bool> failed{false};
+};
+
+SceneBatch::SceneBatch() = default;
+SceneBatch::~SceneBatch() = default;
+
+static void finish(SceneImportFile& file, bool ok) {
+    if (file.data) {
+        cgltf_free(file.data);
+        file.data = nullptr;
+    }
+    file.plan = SceneImportPlan();
+
+    SceneBatch& batch = *file.batch;
+    SceneImport& import = *batch.imports[file.index];
+    import.ok = ok;
+    import.seconds = seconds(batch.start);
+    // Notified under the lock: once the import is popped the batch may be
+    // destroyed, so nothing of it can be touched after unlocking
+    std::lock_guard<std::mutex> lock(batch.mutex);
+    batch.readyQueue.push_back(file.index);
+    batch.ready.notify_one();
+}
+
+static void assemble(SceneImportFile& file) {
+    sceneAssemble(file.batch->imports[file.index]->scene, file.plan);
+    finish(file, true);
+}
+
+// GLB chunks and data: URIs, then the node walk, then one job per primitive
+static void unpack(SceneImportFile& file) {
+    const char* path = file.batch->imports[file.index]->path.c_str();
+    if (cgltf_load_buffers(&file.options, file.data, path) != cgltf_result_success) {
+        fprintf(stderr, "Failed to load buffers of %s\n", path);
+        finish(file, false);
+        return;
+    }
+    if (cgltf_validate(file.data) != cgltf_result_success) {
+        // Often non-critical, carry on and let the importer skip what it can't use
+        fprintf(stderr, "%s: glTF validation warnings\n", path);
+    }
+
+    scenePlanImport(file.plan, file.data);
+    size_t count = file.plan.primitives.size();
+    if (count == 0) {
+        assemble(file);
+        return;
+    }
+
+    // Runs of consecutive primitives of about UNPACK_GRAIN vertices each, so
+    // scenes of many tiny primitives don't drown in job overhead
+    std::vector<size_t> starts;
+    size_t vertices = UNPACK_GRAIN;
+    for (size_t i = 0; i < count; i++) {
+        if (vertices >= UNPACK_GRAIN) {
+            starts.push_back(i);
+            vertices = 0;
+        }
+        const cgltf_primitive* prim = file.plan.primitives[i];
+        vertices += prim->attributes_count ? prim->attributes[0].data->count : 1;
+    }
+    starts.push_back(count);
+
+    file.remaining = starts.size() - 1;
+    for (size_t job = 0; job + 1 < starts.size(); job++) {
+        SceneImportFile* state = &file;
+        size_t begin = starts[job];
+        size_t end = starts[job + 1];
+        threadPoolSubmit(*file.pool, [state, begin, end] {
+            for (size_t i = begin; i < end; i++) {
+                sceneUnpackPrimitive(*state->plan.primitives[i], state->plan.unpacked[i]);
+            }
+            if (--state->remaining == 0) {
+                assemble(*state);
+            }
+        });
+    }
+}
+
+// Reads an external .bin next to the glTF file into memory cgltf will free
+static bool readBuffer(cgltf_buffer& buffer, const std::string& gltfPath) {
+    std::string uri = buffer.uri;
+    uri.resize(cgltf_decode_uri(&uri[0]));
+    size_t slash = gltfPath.find_last_of("/\\");
+    std::string path = slash == std::string::npos ? uri : gltfPath.substr(0, slash + 1) + uri;
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    void* data = malloc(buffer.size ? buffer.size : 1);
+    bool ok = data && fread(data, 1, buffer.size, file) == buffer.size;
+    fclose(file);
+    if (!ok) {
+        free(data);
+        return false;
+    }
+    buffer.data = data;
+    buffer.data_free_method = cgltf_data_free_method_memory_free;
+    return true;
+}
+
+static void parse(SceneImportFile& file) {
+    const std::string& path = file.batch->imports[file.index]->path;
+    if (cgltf_parse_file(&file.options, path.c_str(), &file.data) != cgltf_result_success) {
+        fprintf(stderr, "Failed to parse %s\n", path.c_str());
+        finish(file, false);
+        return;
+    }
+
+    // External file buffers are read concurrently; GLB chunks and data: URIs
+    // are left to cgltf_load_buffers
+    std::vector<size_t> external;
+    for (cgltf_size i = 0; i < file.data->buffers_count; i++) {
+        const char* uri = file.data->buffers[i].uri;
+        if (uri && strncmp(uri, "data:", 5) != 0 && !strstr(uri, "://")) {
+            external.push_back(i);
+        }
+    }
+    if (external.empty()) {
+        unpack(file);
+        return;
+    }
+    file.remaining = external.size();
+    for (size_t buffer : external) {
+        SceneImportFile* state = &file;
+        threadPoolSubmit(*file.pool, [state, buffer, path] {
+            if (!readBuffer(state->data->buffers[buffer], path)) {
+                fprintf(stderr, "Failed to read buffer %zu of %s\n", buffer, path.c_str());
+                state->failed = true;
+            }
+            if (--state->remaining == 0) {
+                if (state->failed) {
+                    finish(*state, false);
+                } else {
+                    unpack(*state);
+                }
+            }
+        });
+    }
+}
+
+void sceneBatchStart(SceneBatch& batch, ThreadPool& pool, const std::vector<std::string>& paths) {
+    batch.start = std::chrono::steady_clock::now();
+    batch.delivered = 0;
+    batch.readyQueue.clear();
+    batch.imports.clear();
+    batch.files.clear();
+    for (size_t i = 0; i < paths.size(); i++) {
+        batch.imports.emplace_back(new SceneImport());
+        batch.imports[i]->path = paths[i];
+        batch.files.emplace_back(new SceneImportFile());
+        SceneImportFile& file = *batch.files[i];
+        file.batch = &batch;
+        file.pool = &pool;
+        file.index = i;
+    }
+    for (size_t i = 0; i < paths.size(); i++) {
+        SceneImportFile* file = batch.files[i].get();
+        threadPoolSubmit(pool, [file] { parse(*file); });
+    }
+}
+
+bool sceneBatchPop(SceneBatch& batch, size_t& index, bool wait) {
+    if (sceneBatchDone(batch)) return false;
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    if (wait) {
+        batch.ready.wait(lock, [&batch] { return !batch.readyQueue.empty(); });
+    } else if (batch.readyQueue.empty()) {
+        return false;
+    }
+    index = batch.readyQueue.front();
+    batch.readyQueue.pop_front();
+    batch.delivered++;
+    return true;
+}
+
+bool sceneBatchDone(const SceneBatch& batch) {
+    return batch.delivered == batch.imports.size();
+}
+
+bool sceneLoadGltfParallel(Scene& scene, const char* path, ThreadPool& pool) {
+    SceneBatch batch;
+    sceneBatchStart(batch, pool, {path});
+    size_t index;
+    sceneBatchPop(batch, index, true);
+    scene = std::move(batch.imports[index]->scene);
+    return batch.imports[index]->ok;
+}
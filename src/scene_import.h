@@ -0,0 +1,65 @@
+#ifndef SCENE_IMPORT_H
+#define SCENE_IMPORT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "scene_loader.h"
+
+struct ThreadPool;
+
+// One file of a batch. Filled in by the pool; read it once it has come out
+// of sceneBatchPop.
+struct SceneImport {
+    std::string path;
+    Scene scene;
+    bool ok = false;
+    double seconds = 0.0;   // from the batch start until the scene was ready
+};
+
+struct SceneImportFile;
+
+// Imports many glTF files at once on a thread pool. Every file runs as a
+// chain of jobs: parse, read its external buffers concurrently, then unpack
+// its primitives concurrently and assemble the Scene. Finished scenes are
+// handed to the GL thread through a ready-queue, in completion order, so
+// uploads start while other files are still importing.
+//
+//     SceneBatch batch;
+//     sceneBatchStart(batch, pool, paths);
+//     size_t index;
+//     while (sceneBatchPop(batch, index, true)) upload(batch.imports[index]->scene);
+struct SceneBatch {
+    std::vector<std::unique_ptr<SceneImport>> imports;
+    std::vector<std::unique_ptr<SceneImportFile>> files; // in-flight state
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<size_t> readyQueue;
+    size_t delivered = 0;
+    std::chrono::steady_clock::time_point start;
+
+    // Out of line, SceneImportFile is only complete in scene_import.cpp
+    SceneBatch();
+    ~SceneBatch();
+};
+
+// The batch must stay alive, and the pool running, until every import has
+// been popped
+void sceneBatchStart(SceneBatch& batch, ThreadPool& pool, const std::vector<std::string>& paths);
+
+// Next finished import, failed ones included. Without `wait` it returns false
+// when nothing is ready yet; it always returns false once all were delivered.
+bool sceneBatchPop(SceneBatch& batch, size_t& index, bool wait);
+
+bool sceneBatchDone(const SceneBatch& batch);
+
+// One file through the same pipeline, blocking until it is imported
+bool sceneLoadGltfParallel(Scene& scene, const char* path, ThreadPool& pool);
+
+#endif
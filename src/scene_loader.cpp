@@ -0,0 +1,449 @@
+#define CGLTF_IMPLEMENTATION
+#include "scene_loader.h"
+
+#include <cgltf/cgltf.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#include "mesh_simplify.h"
+
+// out = a * b, column-major
+static void multiplyMatrix(const float* a, const float* b, float* out) {
+    float result[16];
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                sum += a[k * 4 + row] * b[col * 4 + k];
+            }
+            result[col * 4 + row] = sum;
+        }
+    }
+    memcpy(out, result, sizeof(result));
+}
+
+static void transformPoint(const float* m, const float* p, float* out) {
+    for (int row = 0; row < 3; row++) {
+        out[row] = m[row] * p[0] + m[4 + row] * p[1] + m[8 + row] * p[2] + m[12 + row];
+    }
+}
+
+static const cgltf_accessor* findAttribute(const cgltf_primitive& prim, cgltf_attribute_type type) {
+    for (cgltf_size i = 0; i < prim.attributes_count; i++) {
+        if (prim.attributes[i].type == type && prim.attributes[i].index == 0) {
+            return prim.attributes[i].data;
+        }
+    }
+    return NULL;
+}
+
+// Unpacks any component type (normalized integers included) into `components`
+// floats per vertex, written into the interleaved vertices at `offset` floats
+static void unpackAttribute(const cgltf_accessor* accessor, int components, SceneVertex* vertices,
+                            size_t offset) {
+    size_t count = accessor->count;
+    size_t available = cgltf_num_components(accessor->type);
+    std::vector<float> values(count * available);
+    cgltf_accessor_unpack_floats(accessor, values.data(), values.size());
+
+    int copied = (int)available < components ? (int)available : components;
+    for (size_t i = 0; i < count; i++) {
+        float* out = (float*)&vertices[i] + offset;
+        memcpy(out, &values[i * available], copied * sizeof(float));
+    }
+}
+
+// Triangle lists, rebuilding strips and fans into them
+static void toTriangleList(cgltf_primitive_type type, std::vector<uint32_t>& indices) {
+    if (type == cgltf_primitive_type_triangles || indices.size() < 3) return;
+
+    std::vector<uint32_t> list;
+    list.reserve((indices.size() - 2) * 3);
+    for (size_t i = 2; i < indices.size(); i++) {
+        if (type == cgltf_primitive_type_triangle_strip) {
+            // Every other triangle is wound the other way round
+            bool odd = i % 2 == 1;
+            list.push_back(indices[i - 2]);
+            list.push_back(indices[odd ? i : i - 1]);
+            list.push_back(indices[odd ? i - 1 : i]);
+        } else {
+            list.push_back(indices[0]);
+            list.push_back(indices[i - 1]);
+            list.push_back(indices[i]);
+        }
+    }
+    indices.swap(list);
+}
+
+// Area-weighted smooth normals for primitives that don't ship their own
+static void generateNormals(SceneVertex* vertices, size_t vertexCount, const uint32_t* indices,
+                            size_t indexCount) {
+    for (size_t i = 0; i < vertexCount; i++) {
+        memset(vertices[i].normal, 0, sizeof(vertices[i].normal));
+    }
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        const float* a = vertices[indices[i]].position;
+        const float* b = vertices[indices[i + 1]].position;
+        const float* c = vertices[indices[i + 2]].position;
+        float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1],
+                      e1[2] * e2[0] - e1[0] * e2[2],
+                      e1[0] * e2[1] - e1[1] * e2[0]};
+        for (int k = 0; k < 3; k++) {
+            float* normal = vertices[indices[i + k]].normal;
+            normal[0] += n[0];
+            normal[1] += n[1];
+            normal[2] += n[2];
+        }
+    }
+    for (size_t i = 0; i < vertexCount; i++) {
+        float* n = vertices[i].normal;
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length > 0.0f) {
+            n[0] /= length;
+            n[1] /= length;
+            n[2] /= length;
+        }
+    }
+}
+
+// Errors add up along the chain, so each level's error estimates its
+// distance from the full mesh
+void sceneBuildLods(SceneMesh& mesh, std::vector<uint32_t>& indices, size_t vertexCount, const float* positions,
+                    size_t stride) {
+    uint32_t fullCount = (uint32_t)indices.size();
+    mesh.lods[0] = {0, fullCount, 0.0f};
+    mesh.lodCount = 1;
+    std::vector<uint32_t> lod(fullCount);
+    while (mesh.lodCount < SCENE_MAX_LODS) {
+        const SceneLod& previous = mesh.lods[mesh.lodCount - 1];
+        size_t target = (size_t)(fullCount / 3 * SCENE_LOD_RATIOS[mesh.lodCount]) * 3;
+        float error = 0.0f;
+        size_t enough = previous.indexCount - previous.indexCount / 8;
+        size_t count = simplifyMesh(lod.data(), &indices[previous.firstIndex], previous.indexCount, positions,
+                                    vertexCount, stride, target, &error);
+        if (count > enough) {
+            count = simplifyMesh(lod.data(), &indices[previous.firstIndex], previous.indexCount, positions,
+                                 vertexCount, stride, target, &error, false);
+        }
+        if (count == 0 || count > enough) break;
+        optimizeVertexCache(lod.data(), count, vertexCount, positions, stride);
+        mesh.lods[mesh.lodCount++] = {(uint32_t)indices.size(), (uint32_t)count, previous.error + error};
+        indices.insert(indices.end(), lod.begin(), lod.begin() + count);
+    }
+}
+
+// Unpacks one primitive into its own arrays. Touches nothing but the
+// primitive's accessors, so primitives can be unpacked concurrently.
+bool sceneUnpackPrimitive(const cgltf_primitive& prim, ScenePrimitive& out) {
+    out = ScenePrimitive();
+    if (prim.type != cgltf_primitive_type_triangles &&
+        prim.type != cgltf_primitive_type_triangle_strip &&
+        prim.type != cgltf_primitive_type_triangle_fan) {
+        return false;
+    }
+    const cgltf_accessor* positions = findAttribute(prim, cgltf_attribute_type_position);
+    if (!positions || positions->count == 0) return false;
+    // KHR_draco_mesh_compression leaves the accessors without data; we have no decoder
+    if (!positions->buffer_view && !positions->is_sparse) return false;
+    if (prim.indices && !prim.indices->buffer_view && !prim.indices->is_sparse) return false;
+
+    size_t vertexCount = positions->count;
+    std::vector<uint32_t>& indices = out.indices;
+    if (prim.indices) {
+        indices.resize(prim.indices->count);
+        if (cgltf_accessor_unpack_indices(prim.indices, indices.data(), sizeof(uint32_t),
+                                          indices.size()) != indices.size()) {
+            // Sparse index accessors aren't handled by the bulk unpacker
+            for (size_t i = 0; i < indices.size(); i++) {
+                indices[i] = (uint32_t)cgltf_accessor_read_index(prim.indices, i);
+            }
+        }
+        for (uint32_t index : indices) {
+            if (index >= vertexCount) return false;
+        }
+    } else {
+        indices.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++) {
+            indices[i] = (uint32_t)i;
+        }
+    }
+    toTriangleList(prim.type, indices);
+    indices.resize(indices.size() / 3 * 3);
+    if (indices.empty()) return false;
+
+    out.vertices.resize(vertexCount, SceneVertex());
+    SceneVertex* vertices = out.vertices.data();
+
+    unpackAttribute(positions, 3, vertices, offsetof(SceneVertex, position) / sizeof(float));
+    const cgltf_accessor* normals = findAttribute(prim, cgltf_attribute_type_normal);
+    if (normals && normals->count == vertexCount) {
+        unpackAttribute(normals, 3, vertices, offsetof(SceneVertex, normal) / sizeof(float));
+    } else {
+        generateNormals(vertices, vertexCount, indices.data(), indices.size());
+        out.generatedNormals = true;
+    }
+    const cgltf_accessor* uvs = findAttribute(prim, cgltf_attribute_type_texcoord);
+    if (uvs && uvs->count == vertexCount) {
+        unpackAttribute(uvs, 2, vertices, offsetof(SceneVertex, uv) / sizeof(float));
+    }
+    const cgltf_accessor* tangents = findAttribute(prim, cgltf_attribute_type_tangent);
+    if (tangents && tangents->count == vertexCount) {
+        unpackAttribute(tangents, 4, vertices, offsetof(SceneVertex, tangent) / sizeof(float));
+    }
+
+    // Triangles reordered for the post-transform cache and overdraw, grouped
+    // into meshlets along that order and reordered again within each, then
+    // the coarser levels appended, then vertices renumbered in the order the
+    // full mesh fetches them
+    SceneMesh& mesh = out.mesh;
+    uint32_t indexCount = (uint32_t)indices.size();
+    out.cacheBefore = analyzeVertexCache(indices.data(), indexCount, vertexCount);
+    optimizeVertexCache(indices.data(), indexCount, vertexCount, vertices[0].position, sizeof(SceneVertex));
+    buildMeshlets(out.meshlets, indices.data(), indexCount, vertexCount, vertices[0].position,
+                  sizeof(SceneVertex));
+    optimizeMeshletVertexCache(out.meshlets, indices.data(), vertexCount);
+    sceneBuildLods(mesh, indices, vertexCount, vertices[0].position, sizeof(SceneVertex));
+    optimizeVertexFetch(vertices, vertexCount, sizeof(SceneVertex), indices.data(), indices.size());
+    out.cacheAfter = analyzeVertexCache(indices.data(), indexCount, vertexCount);
+
+    mesh.indexCount = indexCount;
+    mesh.vertexCount = (uint32_t)vertexCount;
+    mesh.meshletCount = (uint32_t)out.meshlets.size();
+    for (int k = 0; k < 3; k++) {
+        mesh.boundsMin[k] = FLT_MAX;
+        mesh.boundsMax[k] = -FLT_MAX;
+    }
+    for (size_t i = 0; i < vertexCount; i++) {
+        for (int k = 0; k < 3; k++) {
+            mesh.boundsMin[k] = fminf(mesh.boundsMin[k], vertices[i].position[k]);
+            mesh.boundsMax[k] = fmaxf(mesh.boundsMax[k], vertices[i].position[k]);
+        }
+    }
+    out.ok = true;
+    return true;
+}
+
+struct PlanState {
+    SceneImportPlan& plan;
+    const cgltf_data* data;
+    // glTF mesh -> the plan slot of its first primitive, filled on first use
+    std::unordered_map<const cgltf_mesh*, uint32_t> planned;
+};
+
+static void planNode(PlanState& state, const cgltf_node* node, const float* parentWorld) {
+    SceneImportPlan& plan = state.plan;
+    float local[16];
+    float world[16];
+    cgltf_node_transform_local(node, local);
+    multiplyMatrix(parentWorld, local, world);
+    plan.nodes++;
+
+    if (node->mesh) {
+        auto found = state.planned.find(node->mesh);
+        if (found == state.planned.end()) {
+            found = state.planned.emplace(node->mesh, (uint32_t)plan.primitives.size()).first;
+            for (cgltf_size i = 0; i < node->mesh->primitives_count; i++) {
+                plan.primitives.push_back(&node->mesh->primitives[i]);
+            }
+        }
+
+        for (cgltf_size i = 0; i < node->mesh->primitives_count; i++) {
+            SceneDraw draw;
+            draw.mesh = found->second + (uint32_t)i;
+            draw.node = (uint32_t)(node - state.data->nodes);
+            memcpy(draw.world, world, sizeof(world));
+            plan.draws.push_back(draw);
+        }
+    }
+
+    for (cgltf_size i = 0; i < node->children_count; i++) {
+        planNode(state, node->children[i], world);
+    }
+}
+
+void scenePlanImport(SceneImportPlan& plan, const cgltf_data* data) {
+    plan = SceneImportPlan();
+    const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    PlanState state = {plan, data, {}};
+
+    const cgltf_scene* gltfScene = data->scene ? data->scene : (data->scenes_count ? &data->scenes[0] : NULL);
+    if (gltfScene) {
+        for (cgltf_size i = 0; i < gltfScene->nodes_count; i++) {
+            planNode(state, gltfScene->nodes[i], identity);
+        }
+    } else {
+        for (cgltf_size i = 0; i < data->nodes_count; i++) {
+            if (!data->nodes[i].parent) {
+                planNode(state, &data->nodes[i], identity);
+            }
+        }
+    }
+    plan.unpacked.resize(plan.primitives.size());
+}
+
+static void growBounds(Scene& scene, const SceneMesh& mesh, const float* world) {
+    for (int corner = 0; corner < 8; corner++) {
+        float p[3] = {corner & 1 ? mesh.boundsMax[0] : mesh.boundsMin[0],
+                      corner & 2 ? mesh.boundsMax[1] : mesh.boundsMin[1],
+                      corner & 4 ? mesh.boundsMax[2] : mesh.boundsMin[2]};
+        float w[3];
+        transformPoint(world, p, w);
+        for (int k = 0; k < 3; k++) {
+            scene.boundsMin[k] = fminf(scene.boundsMin[k], w[k]);
+            scene.boundsMax[k] = fmaxf(scene.boundsMax[k], w[k]);
+        }
+    }
+}
+
+static void addCacheStats(VertexCacheStats& total, const VertexCacheStats& stats) {
+    total.triangles += stats.triangles;
+    total.misses += stats.misses;
+    total.vertices += stats.vertices;
+}
+
+void sceneAssemble(Scene& scene, SceneImportPlan& plan) {
+    scene = Scene();
+    scene.stats.nodes = plan.nodes;
+    for (int k = 0; k < 3; k++) {
+        scene.boundsMin[k] = FLT_MAX;
+        scene.boundsMax[k] = -FLT_MAX;
+    }
+
+    // Plan slot -> SceneMesh index, UINT32_MAX for primitives that were skipped
+    std::vector<uint32_t> meshIndex(plan.unpacked.size(), UINT32_MAX);
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    size_t meshletCount = 0;
+    for (size_t i = 0; i < plan.unpacked.size(); i++) {
+        const ScenePrimitive& prim = plan.unpacked[i];
+        if (!prim.ok) {
+            scene.stats.skippedPrimitives++;
+            continue;
+        }
+        meshIndex[i] = (uint32_t)scene.meshes.size();
+        SceneMesh mesh = prim.mesh;
+        mesh.firstIndex = (uint32_t)indexCount;
+        mesh.baseVertex = (uint32_t)vertexCount;
+        mesh.firstMeshlet = (uint32_t)meshletCount;
+        for (uint32_t level = 0; level < mesh.lodCount; level++) {
+            mesh.lods[level].firstIndex += mesh.firstIndex;
+        }
+        scene.meshes.push_back(mesh);
+        vertexCount += prim.vertices.size();
+        indexCount += prim.indices.size();
+        meshletCount += prim.meshlets.size();
+        scene.stats.primitives++;
+        scene.stats.generatedNormals += prim.generatedNormals;
+        addCacheStats(scene.stats.cacheBefore, prim.cacheBefore);
+        addCacheStats(scene.stats.cacheAfter, prim.cacheAfter);
+    }
+
+    scene.vertices.resize(vertexCount);
+    scene.indices.resize(indexCount);
+    scene.meshlets.resize(meshletCount);
+    for (size_t i = 0; i < plan.unpacked.size(); i++) {
+        ScenePrimitive& prim = plan.unpacked[i];
+        if (meshIndex[i] == UINT32_MAX) continue;
+        const SceneMesh& mesh = scene.meshes[meshIndex[i]];
+        memcpy(&scene.vertices[mesh.baseVertex], prim.vertices.data(), prim.vertices.size() * sizeof(SceneVertex));
+        memcpy(&scene.indices[mesh.firstIndex], prim.indices.data(), prim.indices.size() * sizeof(uint32_t));
+        for (size_t m = 0; m < prim.meshlets.size(); m++) {
+            Meshlet& meshlet = scene.meshlets[mesh.firstMeshlet + m];
+            meshlet = prim.meshlets[m];
+            meshlet.firstIndex += mesh.firstIndex;
+        }
+        prim = ScenePrimitive();
+    }
+
+    for (const SceneDraw& planned : plan.draws) {
+        if (meshIndex[planned.mesh] == UINT32_MAX) continue;
+        SceneDraw draw = planned;
+        draw.mesh = meshIndex[planned.mesh];
+        scene.draws.push_back(draw);
+        growBounds(scene, scene.meshes[draw.mesh], draw.world);
+    }
+
+    if (scene.draws.empty()) {
+        for (int k = 0; k < 3; k++) {
+            scene.boundsMin[k] = scene.boundsMax[k] = 0.0f;
+        }
+    }
+}
+
+bool sceneImport(Scene& scene, const cgltf_data* data) {
+    SceneImportPlan plan;
+    scenePlanImport(plan, data);
+    for (size_t i = 0; i < plan.primitives.size(); i++) {
+        sceneUnpackPrimitive(*plan.primitives[i], plan.unpacked[i]);
+    }
+    sceneAssemble(scene, plan);
+    return true;
+}
+
+SceneView sceneView(const Scene& scene) {
+    SceneView view;
+    view.vertices = scene.vertices.data();
+    view.indices = scene.indices.data();
+    view.meshlets = scene.meshlets.data();
+    view.meshes = scene.meshes.data();
+    view.draws = scene.draws.data();
+    view.vertexCount = scene.vertices.size();
+    view.indexCount = scene.indices.size();
+    view.meshletCount = scene.meshlets.size();
+    view.meshCount = scene.meshes.size();
+    view.drawCount = scene.draws.size();
+    memcpy(view.boundsMin, scene.boundsMin, sizeof(view.boundsMin));
+    memcpy(view.boundsMax, scene.boundsMax, sizeof(view.boundsMax));
+    return view;
+}
+
+void sceneReplicate(Scene& scene, int copies) {
+    if (copies <= 1 || scene.draws.empty()) return;
+
+    std::vector<SceneDraw> original = scene.draws;
+    float cellX = (scene.boundsMax[0] - scene.boundsMin[0]) * 1.25f;
+    float cellZ = (scene.boundsMax[2] - scene.boundsMin[2]) * 1.25f;
+    int side = (int)ceilf(sqrtf((float)copies));
+
+    scene.draws.reserve(original.size() * copies);
+    for (int copy = 1; copy < copies; copy++) {
+        float offset[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+        offset[12] = (copy % side) * cellX;
+        offset[14] = (copy / side) * cellZ;
+        for (const SceneDraw& draw : original) {
+            SceneDraw placed = draw;
+            multiplyMatrix(offset, draw.world, placed.world);
+            scene.draws.push_back(placed);
+            growBounds(scene, scene.meshes[placed.mesh], placed.world);
+        }
+    }
+}
+
+bool sceneLoadGltf(Scene& scene, const char* path) {
+    cgltf_options options = {};
+    cgltf_data* data = NULL;
+
+    if (cgltf_parse_file(&options, path, &data) != cgltf_result_success) {
+        fprintf(stderr, "Failed to parse %s\n", path);
+        return false;
+    }
+    if (cgltf_load_buffers(&options, data, path) != cgltf_result_success) {
+        fprintf(stderr, "Failed to load buffers of %s\n", path);
+        cgltf_free(data);
+        return false;
+    }
+    if (cgltf_validate(data) != cgltf_result_success) {
+        // Often non-critical, carry on and let the importer skip what it can't use
+        fprintf(stderr, "%s: glTF validation warnings\n", path);
+    }
+
+    bool ok = sceneImport(scene, data);
+    cgltf_free(data);
+    return ok;
+}
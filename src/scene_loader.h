@@ -0,0 +1,148 @@
+#ifndef SCENE_LOADER_H
+#define SCENE_LOADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh_optimize.h"
+#include "meshlet.h"
+
+struct cgltf_data;
+struct cgltf_primitive;
+
+struct SceneVertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+    float tangent[4]; // glTF's: w is the bitangent sign. Zero when the file has none.
+};
+
+// Levels of detail per mesh, the full mesh included. Each coarser level
+// aims at SCENE_LOD_RATIOS of the full mesh's triangles; a mesh that stops
+// simplifying gets fewer levels.
+const uint32_t SCENE_MAX_LODS = 4;
+const float SCENE_LOD_RATIOS[SCENE_MAX_LODS] = {1.0f, 0.5f, 0.25f, 0.125f};
+
+// One level: an index range over the mesh's vertices, and how far (in mesh
+// units) it may stray from the full mesh
+struct SceneLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+};
+
+// Geometry of one glTF primitive inside the shared buffers. Indices are
+// relative to baseVertex, so a range can be drawn with
+// glDrawElementsBaseVertex straight out of the shared index buffer. Its
+// triangles are stored meshlet by meshlet, so each of its meshlets is a
+// sub-range of the same indices. The coarser levels follow in the index
+// buffer and reuse the same vertices; lods[0] is firstIndex/indexCount.
+struct SceneMesh {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t baseVertex;
+    uint32_t vertexCount;
+    uint32_t firstMeshlet;
+    uint32_t meshletCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint32_t lodCount;
+    SceneLod lods[SCENE_MAX_LODS];
+};
+
+// One mesh placed by one node. Meshes shared by several nodes are stored
+// once and drawn once per node.
+struct SceneDraw {
+    uint32_t mesh;
+    uint32_t node;
+    float world[16]; // column-major, like glUniformMatrix4fv expects
+};
+
+struct SceneStats {
+    size_t nodes = 0;
+    size_t primitives = 0;        // imported
+    size_t skippedPrimitives = 0; // points, lines, Draco-compressed or missing positions
+    size_t generatedNormals = 0;  // primitives that came without normals
+    VertexCacheStats cacheBefore; // all primitives, in the exporter's order
+    VertexCacheStats cacheAfter;  // after the import-time reordering
+};
+
+// A whole glTF scene flattened into one vertex buffer, one index buffer and
+// a draw list in node order.
+struct Scene {
+    std::vector<SceneVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Meshlet> meshlets; // firstIndex into `indices`
+    std::vector<SceneMesh> meshes;
+    std::vector<SceneDraw> draws;
+    float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+    float boundsMax[3] = {0.0f, 0.0f, 0.0f}; // world space, over all draws
+    SceneStats stats;
+};
+
+// Read-only view of a scene's arrays, wherever they live: a Scene's vectors
+// or a mapped cache file (see mesh_cache.h)
+struct SceneView {
+    const SceneVertex* vertices = nullptr;
+    const uint32_t* indices = nullptr;
+    const Meshlet* meshlets = nullptr;
+    const SceneMesh* meshes = nullptr;
+    const SceneDraw* draws = nullptr;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    size_t meshletCount = 0;
+    size_t meshCount = 0;
+    size_t drawCount = 0;
+    float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+    float boundsMax[3] = {0.0f, 0.0f, 0.0f};
+};
+
+SceneView sceneView(const Scene& scene);
+
+// Parses the file, loads its buffers and imports the default scene (or every
+// root node when the file has no scenes). Returns false when the file can't
+// be read; primitives that can't be drawn as triangles are skipped.
+bool sceneLoadGltf(Scene& scene, const char* path);
+bool sceneImport(Scene& scene, const cgltf_data* data);
+
+// sceneImport in three steps, for callers that spread the unpacking over
+// threads (see scene_import.h): plan walks the node tree, each planned
+// primitive is unpacked on its own, and assemble concatenates them in plan
+// order. The result is the same as sceneImport's.
+struct ScenePrimitive {
+    std::vector<SceneVertex> vertices;
+    std::vector<uint32_t> indices; // every level of detail, lod firstIndex relative to it until assembled
+    std::vector<Meshlet> meshlets; // firstIndex relative to `indices` until assembled
+    SceneMesh mesh = {};       // firstIndex, baseVertex and firstMeshlet are set by sceneAssemble
+    VertexCacheStats cacheBefore;
+    VertexCacheStats cacheAfter;
+    bool generatedNormals = false;
+    bool ok = false;
+};
+
+struct SceneImportPlan {
+    std::vector<const cgltf_primitive*> primitives; // every primitive of every used mesh, once
+    std::vector<ScenePrimitive> unpacked;           // one slot per primitive
+    std::vector<SceneDraw> draws;                   // `mesh` indexes `primitives` until assembled
+    size_t nodes = 0;
+};
+
+void scenePlanImport(SceneImportPlan& plan, const cgltf_data* data);
+bool sceneUnpackPrimitive(const cgltf_primitive& prim, ScenePrimitive& out);
+void sceneAssemble(Scene& scene, SceneImportPlan& plan);
+
+// The unpacking step that fills mesh.lods: appends the coarser levels to
+// `indices`, which hold the full mesh, each simplified from the one before
+// (mesh_simplify.h) and cache-optimized on its own. A level that barely
+// shrinks with seams kept is retried across them (flat-shaded props are all
+// seams); one that still barely shrinks ends the chain.
+void sceneBuildLods(SceneMesh& mesh, std::vector<uint32_t>& indices, size_t vertexCount, const float* positions,
+                    size_t stride);
+
+// Repeats the current draw list `copies` times in total on a square grid in
+// the XZ plane, one scene-sized cell per copy. Geometry stays shared; only
+// draws are added. Used to build large benchmark scenes out of small files.
+void sceneReplicate(Scene& scene, int copies);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef SOUND_BANK_H
+#define SOUND_BANK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ThreadPool;
+
+// Bumped whenever synthesis changes output, so stale cache files miss
+const uint32_t SOUND_BANK_VERSION = 2;
+
+enum Waveform {
+    WAVE_SINE,
+    WAVE_SQUARE,
+    WAVE_SAW,
+    WAVE_TRIANGLE,
+    WAVE_NOISE
+};
+
+// One oscillator with a linear pitch sweep, shaped by a linear ADSR envelope.
+// Times are in seconds; a zero attack, decay or release skips that stage.
+struct SoundDesc {
+    Waveform wave = WAVE_SINE;
+    float freq = 440.0f;
+    float freqEnd = 440.0f; // pitch at the end of the sound
+    float duration = 0.1f;
+    float amplitude = 0.5f;
+    float attack = 0.0f;
+    float decay = 0.0f;
+    float sustain = 1.0f;   // level held after the decay, 0..1
+    float release = 0.0f;
+    uint32_t noiseSeed = 1;
+};
+
+struct SoundBankStats {
+    size_t synthesized = 0;
+    size_t cacheHits = 0;
+    size_t cacheWrites = 0;
+    double seconds = 0.0;   // wall time of the last soundBankBuild
+};
+
+// Describes sounds up front, then renders them all in one go. Rendered
+// sounds are mono float samples in [-1, 1].
+struct SoundBank {
+    int sampleRate = 44100;
+    std::string cacheDir;   // empty disables the disk cache
+    std::vector<SoundDesc> descs;
+    std::vector<std::vector<float>> samples;
+    SoundBankStats stats;
+};
+
+// Returns the sound's index in the bank
+int soundBankAdd(SoundBank& bank, const SoundDesc& desc);
+
+// Renders every sound, loading it from the cache when a file with a matching
+// parameter hash exists and writing the cache otherwise. A null pool renders
+// on the calling thread.
+void soundBankBuild(SoundBank& bank, ThreadPool* pool);
+
+// Stable across runs and platforms, covers the sample rate and SOUND_BANK_VERSION
+uint64_t soundDescHash(const SoundDesc& desc, int sampleRate);
+
+// Renders one sound with the vector oscillators
+void synthesizeSound(const SoundDesc& desc, int sampleRate, std::vector<float>& samples);
+
+#endif
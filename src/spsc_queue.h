@@ -0,0 +1,42 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Neither side ever blocks: push fails when full, pop when empty.
+// Head and tail live on separate cache lines so the two threads don't
+// false-share.
+template <typename T, size_t Capacity>
+struct SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+    alignas(64) std::atomic<size_t> head{0}; // next slot to read, owned by the consumer
+    alignas(64) std::atomic<size_t> tail{0}; // next slot to write, owned by the producer
+    alignas(64) T items[Capacity];
+};
+
+template <typename T, size_t Capacity>
+bool spscPush(SpscQueue<T, Capacity>& queue, const T& item) {
+    size_t tail = queue.tail.load(std::memory_order_relaxed);
+    if (tail - queue.head.load(std::memory_order_acquire) == Capacity) {
+        return false;
+    }
+    queue.items[tail & (Capacity - 1)] = item;
+    queue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t Capacity>
+bool spscPop(SpscQueue<T, Capacity>& queue, T& item) {
+    size_t head = queue.head.load(std::memory_order_relaxed);
+    if (head == queue.tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    item = queue.items[head & (Capacity - 1)];
+    queue.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+#endif
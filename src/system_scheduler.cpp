@@ -0,0 +1,214 @@
+#include "system_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+struct ChunkRef {
+    const Archetype* archetype;
+    EntityChunk* chunk;
+};
+
+struct FrameRun;
+
+// Data of the system's jobs
+struct SystemRun {
+    FrameRun* frame;
+    uint32_t index;
+    std::atomic<uint32_t> waitingOn{0}; // conflicting systems still to finish
+    std::atomic<uint32_t> jobsLeft{0};
+    std::vector<ChunkRef> chunks;
+};
+
+// One schedulerRun, alive on the calling thread's stack until `jobs` drains
+struct FrameRun {
+    SystemScheduler* scheduler;
+    std::vector<SystemRun> systems;
+    JobCounter jobs;
+};
+
+static bool conflicts(const System& a, const System& b) {
+    return (a.writes & (b.reads | b.writes)) || (b.writes & a.reads);
+}
+
+// Caller holds traceMutex
+static uint32_t traceThread(SystemScheduler& scheduler) {
+    std::thread::id id = std::this_thread::get_id();
+    for (size_t i = 0; i < scheduler.traceThreads.size(); i++) {
+        if (scheduler.traceThreads[i] == id) return (uint32_t)i;
+    }
+    scheduler.traceThreads.push_back(id);
+    return (uint32_t)scheduler.traceThreads.size() - 1;
+}
+
+static void recordEvent(SystemScheduler& scheduler, const char* name, uint32_t chunks,
+                        std::chrono::steady_clock::time_point start) {
+    if (!scheduler.tracing) return;
+    auto end = std::chrono::steady_clock::now();
+    double startUs = std::chrono::duration<double, std::micro>(start - scheduler.epoch).count();
+    double durationUs = std::chrono::duration<double, std::micro>(end - start).count();
+    std::lock_guard<std::mutex> lock(scheduler.traceMutex);
+    scheduler.trace.push_back({name, traceThread(scheduler), scheduler.frame, chunks, startUs, durationUs});
+}
+
+static void startSystem(FrameRun& frame, uint32_t s);
+
+// Starts the systems waiting on `s`. Called from the system's last job, whose
+// own count in frame.jobs keeps the frame alive until their jobs are queued.
+static void finishSystem(FrameRun& frame, uint32_t s) {
+    const SystemScheduler& scheduler = *frame.scheduler;
+    for (uint32_t i = scheduler.dependentStarts[s]; i < scheduler.dependentStarts[s + 1]; i++) {
+        uint32_t dependent = scheduler.dependents[i];
+        if (frame.systems[dependent].waitingOn.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            startSystem(frame, dependent);
+        }
+    }
+}
+
+static void runSystemJob(void* data, size_t, size_t) {
+    SystemRun& run = *(SystemRun*)data;
+    SystemScheduler& scheduler = *run.frame->scheduler;
+    const System& system = scheduler.systems[run.index];
+    auto start = std::chrono::steady_clock::now();
+    system.run(*scheduler.world);
+    recordEvent(scheduler, system.name, 0, start);
+    finishSystem(*run.frame, run.index);
+}
+
+static void runChunkJob(void* data, size_t begin, size_t end) {
+    SystemRun& run = *(SystemRun*)data;
+    SystemScheduler& scheduler = *run.frame->scheduler;
+    const System& system = scheduler.systems[run.index];
+    auto start = std::chrono::steady_clock::now();
+    for (size_t c = begin; c < end; c++) {
+        system.eachChunk(*run.chunks[c].archetype, *run.chunks[c].chunk);
+    }
+    recordEvent(scheduler, system.name, (uint32_t)(end - begin), start);
+    if (run.jobsLeft.fetch_sub(1, std::memory_order_acq_rel) == 1) finishSystem(*run.frame, run.index);
+}
+
+static void startSystem(FrameRun& frame, uint32_t s) {
+    SystemScheduler& scheduler = *frame.scheduler;
+    const System& system = scheduler.systems[s];
+    SystemRun& run = frame.systems[s];
+    if (!system.eachChunk) {
+        jobSubmit(*scheduler.jobs, {runSystemJob, &run, 0, 0, nullptr}, &frame.jobs);
+        return;
+    }
+
+    // The chunks are listed when the system starts; the structure doesn't
+    // change during the frame, so the list stays valid until it finishes
+    run.chunks.clear();
+    entityEachChunk(*scheduler.world, system.required, system.excluded,
+                    [&run](const Archetype& archetype, EntityChunk& chunk) {
+                        run.chunks.push_back({&archetype, &chunk});
+                    });
+    size_t jobs = (run.chunks.size() + SCHEDULER_CHUNKS_PER_JOB - 1) / SCHEDULER_CHUNKS_PER_JOB;
+    if (jobs == 0) {
+        finishSystem(frame, s);
+        return;
+    }
+    run.jobsLeft.store((uint32_t)jobs, std::memory_order_relaxed);
+    for (size_t begin = 0; begin < run.chunks.size(); begin += SCHEDULER_CHUNKS_PER_JOB) {
+        size_t end = std::min(run.chunks.size(), begin + SCHEDULER_CHUNKS_PER_JOB);
+        jobSubmit(*scheduler.jobs, {runChunkJob, &run, begin, end, nullptr}, &frame.jobs);
+    }
+}
+
+// Each enabled system depends on every earlier enabled one it conflicts
+// with. Edges implied by others are kept; they cost a decrement each.
+static void buildGraph(SystemScheduler& scheduler) {
+    size_t count = scheduler.systems.size();
+    scheduler.dependentStarts.assign(count + 1, 0);
+    scheduler.dependents.clear();
+    scheduler.dependencyCounts.assign(count, 0);
+    for (size_t a = 0; a < count; a++) {
+        scheduler.dependentStarts[a] = (uint32_t)scheduler.dependents.size();
+        const System& system = scheduler.systems[a];
+        if (!system.enabled) continue;
+        for (size_t b = a + 1; b < count; b++) {
+            const System& later = scheduler.systems[b];
+            if (!later.enabled || !conflicts(system, later)) continue;
+            scheduler.dependents.push_back((uint32_t)b);
+            scheduler.dependencyCounts[b]++;
+        }
+    }
+    scheduler.dependentStarts[count] = (uint32_t)scheduler.dependents.size();
+}
+
+void schedulerInit(SystemScheduler& scheduler, EntityWorld& world, JobSystem& jobs) {
+    scheduler.world = &world;
+    scheduler.jobs = &jobs;
+    scheduler.systems.clear();
+    scheduler.frame = 0;
+    scheduler.trace.clear();
+    scheduler.traceThreads.assign(1, std::this_thread::get_id());
+    scheduler.epoch = std::chrono::steady_clock::now();
+}
+
+uint32_t schedulerAdd(SystemScheduler& scheduler, const System& system) {
+    scheduler.systems.push_back(system);
+    return (uint32_t)scheduler.systems.size() - 1;
+}
+
+void schedulerRun(SystemScheduler& scheduler) {
+    auto start = std::chrono::steady_clock::now();
+    buildGraph(scheduler);
+
+    size_t count = scheduler.systems.size();
+    FrameRun frame;
+    frame.scheduler = &scheduler;
+    frame.systems = std::vector<SystemRun>(count);
+    for (size_t s = 0; s < count; s++) {
+        frame.systems[s].frame = &frame;
+        frame.systems[s].index = (uint32_t)s;
+        frame.systems[s].waitingOn.store(scheduler.dependencyCounts[s], std::memory_order_relaxed);
+    }
+    for (size_t s = 0; s < count; s++) {
+        if (scheduler.systems[s].enabled && scheduler.dependencyCounts[s] == 0) startSystem(frame, (uint32_t)s);
+    }
+    // Runs jobs here too rather than blocking
+    jobWait(*scheduler.jobs, frame.jobs);
+    recordEvent(scheduler, "frame", 0, start);
+    scheduler.frame++;
+}
+
+void schedulerRunSerial(SystemScheduler& scheduler) {
+    auto frameStart = std::chrono::steady_clock::now();
+    for (const System& system : scheduler.systems) {
+        if (!system.enabled) continue;
+        auto start = std::chrono::steady_clock::now();
+        uint32_t chunks = 0;
+        if (system.eachChunk) {
+            entityEachChunk(*scheduler.world, system.required, system.excluded,
+                            [&](const Archetype& archetype, EntityChunk& chunk) {
+                                system.eachChunk(archetype, chunk);
+                                chunks++;
+                            });
+        } else {
+            system.run(*scheduler.world);
+        }
+        recordEvent(scheduler, system.name, chunks, start);
+    }
+    recordEvent(scheduler, "frame", 0, frameStart);
+    scheduler.frame++;
+}
+
+bool schedulerWriteTrace(const SystemScheduler& scheduler, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t t = 0; t < scheduler.traceThreads.size(); t++) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%zu,\"args\":{\"name\":\"%s %zu\"}}",
+                t ? ",\n" : "", t, t == 0 ? "main" : "worker", t);
+    }
+    // System names go out as they are; they're identifiers, not user text
+    for (const TraceEvent& event : scheduler.trace) {
+        fprintf(file,
+                ",\n{\"name\":\"%s\",\"cat\":\"system\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"frame\":%u,\"chunks\":%u}}",
+                event.name, event.thread, event.start, event.duration, event.frame, event.chunks);
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
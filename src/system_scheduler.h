@@ -0,0 +1,90 @@
+#ifndef SYSTEM_SCHEDULER_H
+#define SYSTEM_SCHEDULER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "entity_world.h"
+#include "job_system.h"
+
+// Runs an EntityWorld's systems for a frame on a JobSystem. Each system
+// declares the components it reads and writes. Two systems conflict when
+// either writes a component the other touches, and a system waits for every
+// conflicting system registered before it, so a frame computes the same as
+// running the systems one after another in registration order. Systems that
+// iterate a query are split into jobs of a few chunks each.
+//
+// Systems must not change the world's structure (create, destroy, set
+// mask) while a frame runs; queue those and apply them after schedulerRun.
+
+// Chunks per job of a query system: 64 KB of components, enough to keep a
+// job's overhead small against its work
+const size_t SCHEDULER_CHUNKS_PER_JOB = 4;
+
+struct System {
+    const char* name = "";
+    ComponentMask reads = 0;
+    ComponentMask writes = 0;
+    // Either called once per frame...
+    std::function<void(EntityWorld&)> run;
+    // ...or once per chunk matching required/excluded, chunks spread across
+    // the job threads
+    std::function<void(const Archetype&, EntityChunk&)> eachChunk;
+    ComponentMask required = 0;
+    ComponentMask excluded = 0;
+    bool enabled = true;
+};
+
+// One job of one system, or a whole frame, for the Chrome trace
+struct TraceEvent {
+    const char* name;
+    uint32_t thread; // 0 is the thread that called schedulerRun
+    uint32_t frame;
+    uint32_t chunks;
+    double start; // microseconds since the scheduler was set up
+    double duration;
+};
+
+struct SystemScheduler {
+    EntityWorld* world = nullptr;
+    JobSystem* jobs = nullptr;
+    std::vector<System> systems;
+    // Rebuilt every frame from the enabled systems: system s must finish
+    // before dependents[dependentStarts[s]] up to dependents[dependentStarts[s + 1]]
+    std::vector<uint32_t> dependentStarts;
+    std::vector<uint32_t> dependents;
+    std::vector<uint32_t> dependencyCounts;
+    uint32_t frame = 0;
+
+    bool tracing = false;
+    std::vector<TraceEvent> trace;
+    std::vector<std::thread::id> traceThreads; // index is TraceEvent::thread
+    std::mutex traceMutex;
+    std::chrono::steady_clock::time_point epoch;
+};
+
+void schedulerInit(SystemScheduler& scheduler, EntityWorld& world, JobSystem& jobs);
+
+// Returns the system's index. Systems that conflict run in the order they
+// were added.
+uint32_t schedulerAdd(SystemScheduler& scheduler, const System& system);
+
+// Runs one frame of every enabled system and returns when all are done,
+// running jobs on the calling thread meanwhile. Call it from the thread that
+// set up the JobSystem.
+void schedulerRun(SystemScheduler& scheduler);
+
+// The same frame on the calling thread alone, in registration order
+void schedulerRunSerial(SystemScheduler& scheduler);
+
+// Writes the traced events as Chrome trace JSON (chrome://tracing, Perfetto):
+// one row per thread, one slice per job. Returns false when the file
+// couldn't be written.
+bool schedulerWriteTrace(const SystemScheduler& scheduler, const char* path);
+
+#endif
@@ -0,0 +1,83 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+static void workerLoop(ThreadPool* pool) {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->jobReady.wait(lock, [pool] { return pool->stopping || !pool->jobs.empty(); });
+            if (pool->jobs.empty()) return; // stopping and drained
+            job = std::move(pool->jobs.front());
+            pool->jobs.pop_front();
+        }
+
+        job();
+
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (--pool->pending == 0) {
+            pool->idle.notify_all();
+        }
+    }
+}
+
+void threadPoolInit(ThreadPool& pool, unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    pool.stopping = false;
+    for (unsigned i = 0; i < threads; i++) {
+        pool.workers.emplace_back(workerLoop, &pool);
+    }
+}
+
+void threadPoolShutdown(ThreadPool& pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.stopping = true;
+    }
+    pool.jobReady.notify_all();
+    for (std::thread& worker : pool.workers) {
+        worker.join();
+    }
+    pool.workers.clear();
+}
+
+void threadPoolSubmit(ThreadPool& pool, std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.jobs.push_back(std::move(job));
+        pool.pending++;
+    }
+    pool.jobReady.notify_one();
+}
+
+void threadPoolWait(ThreadPool& pool) {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.idle.wait(lock, [&pool] { return pool.pending == 0; });
+}
+
+void threadPoolParallelFor(ThreadPool& pool, size_t count, size_t grain,
+                           const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) return;
+    grain = std::max<size_t>(1, grain);
+
+    // Completion is tracked per call so unrelated jobs on the pool don't
+    // hold this one up
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining = (count + grain - 1) / grain;
+
+    for (size_t begin = 0; begin < count; begin += grain) {
+        size_t end = std::min(count, begin + grain);
+        threadPoolSubmit(pool, [&, begin, end] {
+            body(begin, end);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0) done.notify_one();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&remaining] { return remaining == 0; });
+}
@@ -0,0 +1,37 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling jobs from one shared FIFO queue.
+struct ThreadPool {
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable idle;
+    size_t pending = 0; // queued + running
+    bool stopping = false;
+};
+
+// threads == 0 uses one worker per hardware thread
+void threadPoolInit(ThreadPool& pool, unsigned threads = 0);
+void threadPoolShutdown(ThreadPool& pool);
+void threadPoolSubmit(ThreadPool& pool, std::function<void()> job);
+
+// Blocks until every submitted job has finished
+void threadPoolWait(ThreadPool& pool);
+
+// Splits [0, count) into chunks of at most `grain` items, runs
+// body(begin, end) for each on the pool and returns when all are done.
+// Must not be called from inside a pool job.
+void threadPoolParallelFor(ThreadPool& pool, size_t count, size_t grain,
+                           const std::function<void(size_t, size_t)>& body);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <chrono>
+
+// Wall time since `start`, for the build stats and the benchmarks
+inline double seconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+#endif
@@ -0,0 +1,173 @@
+#include "transform_hierarchy.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <cgltf/cgltf.h>
+#include <cglm/mat4.h>
+
+void transformHierarchyBuild(TransformHierarchy& hierarchy, const int32_t* parents, const float* locals,
+                             size_t count) {
+    hierarchy = TransformHierarchy();
+
+    // Children of each node by the caller's index, then a depth-first walk
+    // from every root lays the nodes out with each subtree contiguous
+    std::vector<uint32_t> childStarts(count + 1, 0);
+    for (size_t i = 0; i < count; i++) {
+        if (parents[i] >= 0) childStarts[parents[i] + 1]++;
+    }
+    for (size_t i = 0; i < count; i++) {
+        childStarts[i + 1] += childStarts[i];
+    }
+    std::vector<uint32_t> children(childStarts[count]);
+    std::vector<uint32_t> filled(childStarts.begin(), childStarts.end() - 1);
+    for (size_t i = 0; i < count; i++) {
+        if (parents[i] >= 0) children[filled[parents[i]]++] = (uint32_t)i;
+    }
+
+    hierarchy.parents.resize(count);
+    hierarchy.subtreeEnds.resize(count);
+    hierarchy.slots.resize(count);
+    hierarchy.nodes.reserve(count);
+    hierarchy.locals.resize(count);
+    hierarchy.worlds.resize(count);
+    hierarchy.dirty.assign(count, 0);
+
+    std::vector<uint32_t> stack;
+    for (size_t root = 0; root < count; root++) {
+        if (parents[root] >= 0) continue;
+        stack.push_back((uint32_t)root);
+        while (!stack.empty()) {
+            uint32_t node = stack.back();
+            stack.pop_back();
+            uint32_t slot = (uint32_t)hierarchy.nodes.size();
+            hierarchy.slots[node] = slot;
+            hierarchy.nodes.push_back(node);
+            hierarchy.parents[slot] = parents[node] >= 0 ? (int32_t)hierarchy.slots[parents[node]] : -1;
+            memcpy(hierarchy.locals[slot].m, locals + node * 16, sizeof(mat4));
+            // Reversed, so the first child is stored first
+            for (uint32_t c = childStarts[node + 1]; c-- > childStarts[node];) {
+                stack.push_back(children[c]);
+            }
+        }
+    }
+
+    // Every subtree ends where the next node that isn't below it starts;
+    // walking backwards, a node's end is the furthest of its children's
+    for (size_t n = hierarchy.nodes.size(); n-- > 0;) {
+        hierarchy.subtreeEnds[n] = std::max(hierarchy.subtreeEnds[n], (uint32_t)n + 1);
+        int32_t parent = hierarchy.parents[n];
+        if (parent >= 0) {
+            hierarchy.subtreeEnds[parent] = std::max(hierarchy.subtreeEnds[parent], hierarchy.subtreeEnds[n]);
+        }
+    }
+
+    for (uint32_t n = 0; n < (uint32_t)hierarchy.nodes.size(); n++) {
+        if (hierarchy.parents[n] >= 0) continue;
+        hierarchy.dirty[n] = 1;
+        hierarchy.dirtyRoots.push_back(n);
+    }
+    transformUpdate(hierarchy);
+}
+
+void transformHierarchyFromGltf(TransformHierarchy& hierarchy, const cgltf_data* data) {
+    std::vector<int32_t> parents(data->nodes_count);
+    std::vector<float> locals(data->nodes_count * 16);
+    for (cgltf_size i = 0; i < data->nodes_count; i++) {
+        const cgltf_node& node = data->nodes[i];
+        parents[i] = node.parent ? (int32_t)(node.parent - data->nodes) : -1;
+        cgltf_node_transform_local(&node, &locals[i * 16]);
+    }
+    transformHierarchyBuild(hierarchy, parents.data(), locals.data(), data->nodes_count);
+}
+
+void transformSetLocal(TransformHierarchy& hierarchy, uint32_t node, const float local[16]) {
+    uint32_t slot = hierarchy.slots[node];
+    memcpy(hierarchy.locals[slot].m, local, sizeof(mat4));
+    if (!hierarchy.dirty[slot]) {
+        hierarchy.dirty[slot] = 1;
+        hierarchy.dirtyRoots.push_back(slot);
+    }
+}
+
+// Appends the subtree under `root` to the updated ranges unless the last
+// one already holds it, and merges it with the last one when they touch.
+// Subtrees are nested or disjoint, so visiting dirty nodes in stored order
+// only ever has to look at the last range.
+static void addRange(TransformHierarchy& hierarchy, uint32_t root) {
+    TransformRange* last = hierarchy.updated.empty() ? nullptr : &hierarchy.updated.back();
+    if (last && root < last->end) return;
+    if (last && root == last->end) {
+        last->end = hierarchy.subtreeEnds[root];
+    } else {
+        hierarchy.updated.push_back({root, hierarchy.subtreeEnds[root]});
+    }
+}
+
+void transformUpdate(TransformHierarchy& hierarchy) {
+    std::vector<uint32_t>& roots = hierarchy.dirtyRoots;
+    hierarchy.updated.clear();
+    if (roots.size() * TRANSFORM_SCAN_RATIO < hierarchy.nodes.size()) {
+        std::sort(roots.begin(), roots.end());
+        for (uint32_t root : roots) {
+            hierarchy.dirty[root] = 0;
+            addRange(hierarchy, root);
+        }
+    } else {
+        // Sorting this many would cost more than reading every flag
+        uint8_t* dirty = hierarchy.dirty.data();
+        uint8_t* flagsEnd = dirty + hierarchy.nodes.size();
+        for (uint8_t* flag = dirty; (flag = (uint8_t*)memchr(flag, 1, flagsEnd - flag));) {
+            uint32_t n = (uint32_t)(flag - dirty);
+            addRange(hierarchy, n);
+            uint32_t end = hierarchy.updated.back().end;
+            memset(flag, 0, end - n);
+            flag = dirty + end;
+        }
+    }
+    roots.clear();
+
+    // Parents come first, so each one is already current when its children
+    // read it; those outside the range weren't dirty
+    TransformMatrix* worlds = hierarchy.worlds.data();
+    TransformMatrix* locals = hierarchy.locals.data();
+    const int32_t* parents = hierarchy.parents.data();
+    for (const TransformRange& range : hierarchy.updated) {
+        for (uint32_t n = range.first; n < range.end; n++) {
+            if (parents[n] < 0) {
+                glm_mat4_copy(locals[n].m, worlds[n].m);
+            } else {
+                glm_mat4_mul(worlds[parents[n]].m, locals[n].m, worlds[n].m);
+            }
+        }
+    }
+}
+
+void transformBindDraws(TransformHierarchy& hierarchy, const SceneDraw* draws, size_t drawCount) {
+    size_t count = hierarchy.nodes.size();
+    hierarchy.drawStarts.assign(count + 1, 0);
+    for (size_t d = 0; d < drawCount; d++) {
+        hierarchy.drawStarts[hierarchy.slots[draws[d].node] + 1]++;
+    }
+    for (size_t n = 0; n < count; n++) {
+        hierarchy.drawStarts[n + 1] += hierarchy.drawStarts[n];
+    }
+    hierarchy.drawIndices.resize(drawCount);
+    std::vector<uint32_t> filled(hierarchy.drawStarts.begin(), hierarchy.drawStarts.end() - 1);
+    for (size_t d = 0; d < drawCount; d++) {
+        hierarchy.drawIndices[filled[hierarchy.slots[draws[d].node]]++] = (uint32_t)d;
+    }
+}
+
+void transformApplyToDraws(const TransformHierarchy& hierarchy, SceneDraw* draws, std::vector<uint32_t>& moved) {
+    moved.clear();
+    for (const TransformRange& range : hierarchy.updated) {
+        for (uint32_t n = range.first; n < range.end; n++) {
+            for (uint32_t i = hierarchy.drawStarts[n]; i < hierarchy.drawStarts[n + 1]; i++) {
+                uint32_t d = hierarchy.drawIndices[i];
+                memcpy(draws[d].world, hierarchy.worlds[n].m, sizeof(draws[d].world));
+                moved.push_back(d);
+            }
+        }
+    }
+}
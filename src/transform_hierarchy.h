@@ -0,0 +1,80 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <cglm/types.h>
+
+#include "scene_loader.h"
+
+// Node transforms kept flat, parents before children, so world matrices are
+// brought up to date in one forward pass instead of walking each node's
+// parent chain (cgltf_node_transform_world is O(depth) per node). Changing a
+// local matrix marks the node's subtree dirty, and transformUpdate only
+// recomputes the dirty subtrees, each a contiguous range of the arrays.
+
+// transformUpdate sorts the dirty nodes while there are fewer than one in
+// this many, and reads every node's flag past that
+const size_t TRANSFORM_SCAN_RATIO = 64;
+
+// Aligned the way cglm's SIMD matrix multiply loads it
+struct TransformMatrix {
+    mat4 m;
+};
+
+// Nodes [first, end) of the stored order
+struct TransformRange {
+    uint32_t first;
+    uint32_t end;
+};
+
+// Callers name nodes by their own index (a glTF node's, say); the arrays
+// below are in the stored, depth-first order
+struct TransformHierarchy {
+    std::vector<int32_t> parents;       // stored index, -1 for a root
+    std::vector<uint32_t> subtreeEnds;  // node n's subtree is [n, subtreeEnds[n])
+    std::vector<uint32_t> slots;        // caller's index -> stored index
+    std::vector<uint32_t> nodes;        // stored index -> caller's index
+    std::vector<TransformMatrix> locals;
+    std::vector<TransformMatrix> worlds;
+    std::vector<uint8_t> dirty;         // local changed since the last update
+    std::vector<uint32_t> dirtyRoots;   // stored indices, in the order they were marked
+    std::vector<TransformRange> updated; // what the last transformUpdate recomputed
+    // Draws placed by stored node n (transformBindDraws):
+    // drawIndices[drawStarts[n]] up to drawIndices[drawStarts[n + 1]]
+    std::vector<uint32_t> drawStarts;
+    std::vector<uint32_t> drawIndices;
+};
+
+// `parents` and `locals` (16 floats each, column-major) are indexed by the
+// caller's node index, -1 marking a root. Computes every world matrix, so
+// `updated` covers every node afterwards.
+void transformHierarchyBuild(TransformHierarchy& hierarchy, const int32_t* parents, const float* locals,
+                             size_t count);
+
+// Every node of the file, named by its index in data->nodes
+void transformHierarchyFromGltf(TransformHierarchy& hierarchy, const cgltf_data* data);
+
+void transformSetLocal(TransformHierarchy& hierarchy, uint32_t node, const float local[16]);
+
+// Recomputes the world matrices of every subtree marked since the last call
+// and records them in `updated`, in order, nested subtrees folded into the
+// one around them
+void transformUpdate(TransformHierarchy& hierarchy);
+
+inline const float* transformWorld(const TransformHierarchy& hierarchy, uint32_t node) {
+    return hierarchy.worlds[hierarchy.slots[node]].m[0];
+}
+
+// Remembers which draws each node places, by SceneDraw::node. Each draw's
+// world matrix is its node's alone, so draws placed by sceneReplicate don't
+// belong here.
+void transformBindDraws(TransformHierarchy& hierarchy, const SceneDraw* draws, size_t drawCount);
+
+// Copies the last update's world matrices into the bound draws and lists
+// them in `moved`, ready for sceneBvhRefitDraws and a transform upload
+void transformApplyToDraws(const TransformHierarchy& hierarchy, SceneDraw* draws, std::vector<uint32_t>& moved);
+
+#endif
@@ -0,0 +1,209 @@
+#include "vertex_quantize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7fffffff;
+
+    if (magnitude >= 0x7f800000) {
+        return (uint16_t)(sign | (magnitude > 0x7f800000 ? 0x7e00 : 0x7c00)); // NaN stays NaN
+    }
+    if (magnitude >= 0x477ff000) {
+        return (uint16_t)(sign | 0x7c00); // rounds past 65504
+    }
+    if (magnitude < 0x38800000) {
+        // Subnormal half: the value in units of 2^-24, rounded by the FPU
+        float absolute;
+        memcpy(&absolute, &magnitude, sizeof(absolute));
+        return (uint16_t)(sign | (uint32_t)lrintf(absolute * 16777216.0f));
+    }
+    uint32_t half = (magnitude - 0x38000000) >> 13; // rebias 127 -> 15
+    uint32_t rest = magnitude & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+    return (uint16_t)(sign | half);
+}
+
+float halfToFloat(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+    if (exponent == 0) {
+        float value = ldexpf((float)mantissa, -24);
+        return sign ? -value : value;
+    }
+    uint32_t bits = exponent == 31 ? sign | 0x7f800000 | (mantissa << 13)
+                                   : sign | ((exponent + 112) << 23) | (mantissa << 13);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Same arithmetic as the shader's decode, snorm16 read as max(c / 32767, -1)
+static void octDecodeFloat(float x, float y, float v[3]) {
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    float t = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    float length = sqrtf(x * x + y * y + z * z);
+    v[0] = x / length;
+    v[1] = y / length;
+    v[2] = z / length;
+}
+
+void octDecode(const int16_t in[2], float v[3]) {
+    octDecodeFloat(std::max(in[0] / 32767.0f, -1.0f), std::max(in[1] / 32767.0f, -1.0f), v);
+}
+
+void octEncode(const float v[3], int16_t out[2]) {
+    float l1 = fabsf(v[0]) + fabsf(v[1]) + fabsf(v[2]);
+    if (l1 <= 0.0f) {
+        out[0] = out[1] = 0;
+        return;
+    }
+    float x = v[0] / l1;
+    float y = v[1] / l1;
+    if (v[2] < 0.0f) {
+        float folded = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded;
+    }
+
+    float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    float bestDot = -2.0f;
+    for (int k = 0; k < 4; k++) {
+        float cx = (k & 1) ? ceilf(x * 32767.0f) : floorf(x * 32767.0f);
+        float cy = (k & 2) ? ceilf(y * 32767.0f) : floorf(y * 32767.0f);
+        int16_t code[2] = {(int16_t)std::clamp(cx, -32767.0f, 32767.0f),
+                           (int16_t)std::clamp(cy, -32767.0f, 32767.0f)};
+        float decoded[3];
+        octDecode(code, decoded);
+        float dot = (decoded[0] * v[0] + decoded[1] * v[1] + decoded[2] * v[2]) / length;
+        if (dot > bestDot) {
+            bestDot = dot;
+            out[0] = code[0];
+            out[1] = code[1];
+        }
+    }
+}
+
+VertexStreams sceneVertexStreams(const SceneVertex* vertices) {
+    VertexStreams streams;
+    streams.positions = vertices->position;
+    streams.normals = vertices->normal;
+    streams.uvs = vertices->uv;
+    streams.tangents = vertices->tangent;
+    streams.tangentSigns = vertices->tangent + 3;
+    streams.stride = sizeof(SceneVertex);
+    return streams;
+}
+
+QuantizeDecode quantizeDecode(const float boundsMin[3], const float boundsMax[3]) {
+    QuantizeDecode decode = {};
+    for (int k = 0; k < 3; k++) {
+        float extent = boundsMax[k] - boundsMin[k];
+        decode.offset[k] = boundsMin[k];
+        decode.scale[k] = extent > 0.0f ? extent : 0.0f;
+    }
+    return decode;
+}
+
+static const float* attribute(const float* stream, size_t stride, size_t i) {
+    return (const float*)((const char*)stream + i * stride);
+}
+
+// Angle between two directions, via atan2 in double: acosf can't resolve
+// the hundredths of a degree measured here
+static float angleDegrees(const float a[3], const float b[3]) {
+    double cross[3] = {(double)a[1] * b[2] - (double)a[2] * b[1], (double)a[2] * b[0] - (double)a[0] * b[2],
+                       (double)a[0] * b[1] - (double)a[1] * b[0]};
+    double sine = sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+    double cosine = (double)a[0] * b[0] + (double)a[1] * b[1] + (double)a[2] * b[2];
+    if (sine == 0.0 && cosine == 0.0) return 0.0f;
+    return (float)(atan2(sine, cosine) * (180.0 / M_PI));
+}
+
+QuantizeError quantizeVertices(QuantizedVertex* out, QuantizedTangent* tangentsOut, const VertexStreams& in,
+                               size_t count, const float boundsMin[3], const float boundsMax[3]) {
+    QuantizeError error;
+    QuantizeDecode decode = quantizeDecode(boundsMin, boundsMax);
+    float largest = std::max(decode.scale[0], std::max(decode.scale[1], decode.scale[2]));
+
+    for (size_t i = 0; i < count; i++) {
+        QuantizedVertex& q = out[i];
+        const float* p = attribute(in.positions, in.stride, i);
+        for (int k = 0; k < 3; k++) {
+            float unit = decode.scale[k] > 0.0f ? (p[k] - decode.offset[k]) / decode.scale[k] : 0.0f;
+            q.position[k] = (uint16_t)lrintf(std::clamp(unit, 0.0f, 1.0f) * 65535.0f);
+            float decoded = decode.offset[k] + (q.position[k] / 65535.0f) * decode.scale[k];
+            error.position = std::max(error.position, fabsf(decoded - p[k]));
+        }
+        q.position[3] = 65535;
+
+        float normal[3];
+        const float* n = attribute(in.normals, in.stride, i);
+        octEncode(n, q.normal);
+        octDecode(q.normal, normal);
+        error.normalDegrees = std::max(error.normalDegrees, angleDegrees(normal, n));
+
+        const float* uv = attribute(in.uvs, in.stride, i);
+        for (int k = 0; k < 2; k++) {
+            q.uv[k] = floatToHalf(uv[k]);
+            error.uv = std::max(error.uv, fabsf(halfToFloat(q.uv[k]) - uv[k]));
+        }
+
+        if (!in.tangents) continue;
+        const float* t = attribute(in.tangents, in.stride, i);
+        float tangent[3];
+        octEncode(t, tangentsOut[i].tangent);
+        octDecode(tangentsOut[i].tangent, tangent);
+        error.tangentDegrees = std::max(error.tangentDegrees, angleDegrees(tangent, t));
+
+        // What the shader rebuilds, against the source's own bitangent
+        float cross[3] = {normal[1] * tangent[2] - normal[2] * tangent[1],
+                          normal[2] * tangent[0] - normal[0] * tangent[2],
+                          normal[0] * tangent[1] - normal[1] * tangent[0]};
+        float source[3] = {0.0f, 0.0f, 0.0f};
+        float sign = 1.0f;
+        if (in.bitangents) {
+            const float* b = attribute(in.bitangents, in.stride, i);
+            memcpy(source, b, sizeof(source));
+            sign = cross[0] * b[0] + cross[1] * b[1] + cross[2] * b[2] < 0.0f ? -1.0f : 1.0f;
+        } else if (in.tangentSigns) {
+            sign = *attribute(in.tangentSigns, in.stride, i) < 0.0f ? -1.0f : 1.0f;
+            source[0] = (n[1] * t[2] - n[2] * t[1]) * sign;
+            source[1] = (n[2] * t[0] - n[0] * t[2]) * sign;
+            source[2] = (n[0] * t[1] - n[1] * t[0]) * sign;
+        }
+        if (sign < 0.0f) {
+            q.position[3] = 0;
+            for (int k = 0; k < 3; k++) cross[k] = -cross[k];
+        }
+        float length = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+        if (length > 0.0f) {
+            for (int k = 0; k < 3; k++) cross[k] /= length;
+            error.bitangentDegrees = std::max(error.bitangentDegrees, angleDegrees(cross, source));
+        }
+    }
+    error.positionRelative = largest > 0.0f ? error.position / largest : 0.0f;
+    return error;
+}
+
+void quantizeScene(QuantizedScene& out, const SceneView& scene) {
+    out.vertices.assign(scene.vertexCount, QuantizedVertex());
+    out.tangents.assign(scene.vertexCount, QuantizedTangent());
+    out.decode.assign(scene.meshCount, QuantizeDecode());
+    out.errors.assign(scene.meshCount, QuantizeError());
+    for (size_t m = 0; m < scene.meshCount; m++) {
+        const SceneMesh& mesh = scene.meshes[m];
+        if (mesh.vertexCount == 0) continue;
+        out.decode[m] = quantizeDecode(mesh.boundsMin, mesh.boundsMax);
+        out.errors[m] = quantizeVertices(&out.vertices[mesh.baseVertex], &out.tangents[mesh.baseVertex],
+                                         sceneVertexStreams(&scene.vertices[mesh.baseVertex]), mesh.vertexCount,
+                                         mesh.boundsMin, mesh.boundsMax);
+    }
+}
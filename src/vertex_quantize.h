@@ -0,0 +1,93 @@
+#ifndef VERTEX_QUANTIZE_H
+#define VERTEX_QUANTIZE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scene_loader.h"
+
+// Compact vertex format for upload, decoded in the vertex shader:
+//
+//   position  unorm16 x4  (p - boundsMin) / (boundsMax - boundsMin) of the
+//                         vertex's mesh; w holds the bitangent sign, 0 for -1
+//                         and 65535 for +1, read as aPos.w * 2.0 - 1.0
+//   normal    snorm16 x2  octahedral
+//   uv        half x2
+//
+// plus a second 4-byte stream with the tangent as another snorm16
+// octahedral pair, from which the shader rebuilds the bitangent as
+// cross(normal, tangent) * sign: 20 bytes against SceneVertex's 48, or the
+// 56 of a vertex like game01.cpp's that stores the bitangent too.
+struct QuantizedVertex {
+    uint16_t position[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+};
+
+struct QuantizedTangent {
+    int16_t tangent[2];
+};
+
+// Where quantizeVertices reads each attribute, all `stride` bytes apart.
+// tangents, bitangents and tangentSigns may be null; with tangents set, the
+// bitangent sign comes from bitangents, else from tangentSigns (a glTF
+// tangent's w), else is +1.
+struct VertexStreams {
+    const float* positions = nullptr;
+    const float* normals = nullptr;
+    const float* uvs = nullptr;
+    const float* tangents = nullptr;
+    const float* bitangents = nullptr;
+    const float* tangentSigns = nullptr;
+    size_t stride = 0;
+};
+
+VertexStreams sceneVertexStreams(const SceneVertex* vertices);
+
+// Largest difference between the source and the decoded vertices of a mesh
+struct QuantizeError {
+    float position = 0.0f;         // in the mesh's own units
+    float positionRelative = 0.0f; // over the largest extent of its bounds
+    float normalDegrees = 0.0f;
+    float tangentDegrees = 0.0f;
+    float bitangentDegrees = 0.0f; // reconstructed, against the source's (or cross(n, t) * w for glTF)
+    float uv = 0.0f;
+};
+
+// The per-mesh constants the shader needs: position = offset + aPos.xyz * scale
+struct QuantizeDecode {
+    float offset[4];
+    float scale[4];
+};
+
+QuantizeDecode quantizeDecode(const float boundsMin[3], const float boundsMax[3]);
+
+// Encodes `count` vertices against the given bounds, which must contain them.
+// `tangentsOut` is only written when the streams have tangents. Returns the
+// error measured by decoding the result the way the shaders do.
+QuantizeError quantizeVertices(QuantizedVertex* out, QuantizedTangent* tangentsOut, const VertexStreams& in,
+                               size_t count, const float boundsMin[3], const float boundsMax[3]);
+
+// A scene's vertex buffer re-encoded mesh by mesh, in the same order, so the
+// scene's index buffer and SceneMesh ranges still apply
+struct QuantizedScene {
+    std::vector<QuantizedVertex> vertices;
+    std::vector<QuantizedTangent> tangents; // one per vertex
+    std::vector<QuantizeDecode> decode; // one per mesh
+    std::vector<QuantizeError> errors;  // one per mesh
+};
+
+void quantizeScene(QuantizedScene& out, const SceneView& scene);
+
+// Octahedral mapping (Meyer et al., "On Floating-Point Normal Vectors",
+// 2010) into snorm16. Encoding tries the four neighbouring codes and keeps
+// the one that decodes closest to the input.
+void octEncode(const float v[3], int16_t out[2]);
+void octDecode(const int16_t in[2], float v[3]);
+
+// IEEE half floats, round to nearest even
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t half);
+
+#endif
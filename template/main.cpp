@@ -6,6 +6,7 @@
 #include<assert.h>
 #include<string.h>
 #include <math.h>
+#include "../include/uniform_cache.h"
 #include<cglm/cglm.h>
 
 int initialize();
@@ -20,6 +21,7 @@ SDL_GLContext context;
 unsigned int  vao, vbo, ebo, tex;
 //unsigned int  vert_shader,frag_shader;
 unsigned int shader_prog;
+UniformCache shader_uniforms;
 
 
 void load_identity(float *m){
@@ -286,6 +288,7 @@ int init_shaders(){
     while ((err = glGetError()) != GL_NO_ERROR) {
         printf("OpenGL error: %d\n", err);
     }
+    uniformCacheBuild(shader_uniforms, shader_prog);
     glUseProgram(shader_prog);
     free(vert_src);
     free(frag_src);
@@ -403,7 +406,7 @@ int update(){
     glm_mat4_mul(proj, mvp, mvp);//proj * temp
 
 
-    GLint loc = glGetUniformLocation(shader_prog, "u_MVP");
+    GLint loc = uniformLocation(shader_uniforms, UNIFORM("u_MVP"));
     if (loc != -1) {
         glUniformMatrix4fv(loc, 1, GL_FALSE, (float *)mvp);
     }